@@ -7,15 +7,16 @@
 #include "entrance_control_sys.h"
 #include "comm_sys.h"
 #include "system_config.h"
-#include <WiFiClient.h>
-#include <HTTPClient.h>
+#include "loop_profiler.h"
+#include "signal_sequencer.h"
 
 //===========================================================
 // Globals
 EntranceControlSystem* mainCtrlSys; //< The main control system.
 CommunicationSystem* commSys;       //< The communication system.
-WiFiClient client;
-HTTPClient http;
+LoopProfiler profiler;              //< Measures the execution times of the main loop routines.
+SignalSequencer signals;            //< Plays the signal patterns of the buzzer and status LEDs.
+const DetectorPins detLanes[] = DET_LANE_PINS; //< The detector pins of each entrance lane.
 
 //===========================================================
 // Function implementations
@@ -34,8 +35,8 @@ void setup() {
                                            CLOSED_LED_PIN, 
                                            MAG_SWITCH_PIN, 
                                            BUZZER_PIN,
-                                           OUTER_DET_PIN, 
-                                           INNER_DET_PIN);
+                                           detLanes,
+                                           sizeof(detLanes) / sizeof(detLanes[0]));
      
   mainCtrlSys->reset();
 }
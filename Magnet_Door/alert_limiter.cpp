@@ -0,0 +1,203 @@
+/*************************************************************
+  The implementation of a rate limiter to keep the alerts within the event quota of Blynk.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "alert_limiter.h"
+
+//===========================================================
+// Static data
+
+/**
+ * The names of the alert types in the order of AlertType.
+ */
+static const char* const alertTypeNames[] = {
+  "door",
+  "room",
+  "persons"
+};
+
+/**
+ * The labels of the alert types in the summaries in the order of AlertType.
+ */
+static const char* const alertTypeLabels[] = {
+  "Door state",
+  "Room load",
+  "Persons in room"
+};
+
+//===========================================================
+// Function implementations
+
+/**
+ * Gives the name of an alert type as used in the commands.
+ * @param type The alert type.
+ * @return The name.
+ */
+const char* alertTypeName(AlertType type) {
+  return alertTypeNames[static_cast<uint8_t>(type)];
+}
+
+/**
+ * Parses the name of an alert type.
+ * @param name The name. One of "door", "room" or "persons".
+ * @param[out] type The alert type.
+ * @return
+ *  -true: On success.
+ *  -false: If the name is unknown.
+ */
+bool parseAlertType(const String& name, AlertType& type) {
+  for(uint8_t i = 0; i < ALERT_TYPE_COUNT; i++) {
+    if(name == alertTypeNames[i]) {
+      type = static_cast<AlertType>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+//===========================================================
+// Member function implementations
+
+/**
+ * Adds the tokens gained since the last refill to a bucket.
+ * @param bucket The bucket.
+ * @param now The current time in milli seconds.
+ */
+void AlertLimiter::refill(Bucket& bucket, uint32_t now) {
+  if(bucket.tokens >= bucket.budget) {
+    bucket.lastRefill = now; //A full bucket gains nothing
+    return;
+  }
+  uint32_t interval = ALERT_BUDGET_WINDOW * 1000UL / bucket.budget; //Time to gain one token
+  uint32_t gained = (now - bucket.lastRefill) / interval;
+  if(gained == 0) {
+    return;
+  }
+  if(bucket.tokens + gained >= bucket.budget) {
+    bucket.tokens = bucket.budget;
+    bucket.lastRefill = now;
+  }
+  else {
+    bucket.tokens += gained;
+    bucket.lastRefill += gained * interval; //Keeps the started interval
+  }
+}
+
+/**
+ * Decides whether an alert can be sent right now. Takes a token if so.
+ * Otherwise the alert is coalesced and counted as suppressed.
+ * @param alert The alert.
+ * @param now The current time in milli seconds.
+ * @return
+ *  -true: If the alert can be sent.
+ *  -false: If the alert was coalesced.
+ */
+bool AlertLimiter::admit(const OutboundAlert& alert, uint32_t now) {
+  Bucket& bucket = buckets[static_cast<uint8_t>(alert.type)];
+  refill(bucket, now);
+  if(bucket.pending == 0 && bucket.tokens > 0) {
+    bucket.tokens--;
+    return true;
+  }
+  //Coalesced alerts keep their order, so the summary goes first
+  if(bucket.pending == 0) {
+    bucket.firstPending = alert.timestamp;
+  }
+  bucket.latest = alert;
+  bucket.pending++;
+  bucket.suppressed++;
+  return false;
+}
+
+/**
+ * Gives the summary of coalesced alerts of a type as soon as a token is available. Takes the token.
+ * The coalesced alerts stay pending until the summary is confirmed with confirmSummary().
+ * @param type The alert type.
+ * @param now The current time in milli seconds.
+ * @param[out] alert The latest coalesced alert.
+ * @param[out] summary The description of the summary.
+ * @return
+ *  -true: If a summary should be sent.
+ *  -false: If there is none or no token is available yet.
+ */
+bool AlertLimiter::takeSummary(AlertType type, uint32_t now, OutboundAlert& alert, char (&summary)[ALERT_SUMMARY_SIZE]) {
+  Bucket& bucket = buckets[static_cast<uint8_t>(type)];
+  if(bucket.pending == 0) {
+    return false;
+  }
+  refill(bucket, now);
+  if(bucket.tokens == 0) {
+    return false;
+  }
+  bucket.tokens--;
+  alert = bucket.latest;
+  snprintf(summary, ALERT_SUMMARY_SIZE, "%s changed %u times in the last %lu s, now: %s",
+           alertTypeLabels[static_cast<uint8_t>(type)], bucket.pending,
+           (unsigned long)((now - bucket.firstPending + 999) / 1000), bucket.latest.description);
+  return true;
+}
+
+/**
+ * Clears the coalesced alerts of a type after their summary was sent.
+ * @param type The alert type.
+ */
+void AlertLimiter::confirmSummary(AlertType type) {
+  Bucket& bucket = buckets[static_cast<uint8_t>(type)];
+  bucket.pending = 0;
+  bucket.coalesced++;
+}
+
+/**
+ * Gives back the token of an admitted alert or a summary the server did not take.
+ * @param type The alert type.
+ */
+void AlertLimiter::refund(AlertType type) {
+  Bucket& bucket = buckets[static_cast<uint8_t>(type)];
+  if(bucket.tokens < bucket.budget) {
+    bucket.tokens++;
+  }
+}
+
+/**
+ * Sets the number of alerts per window of an alert type.
+ * @param type The alert type.
+ * @param budget The budget. Between 1 and ALERT_BUDGET_MAX.
+ * @return
+ *  -true: On success.
+ *  -false: If the budget is out of bounds.
+ */
+bool AlertLimiter::setBudget(AlertType type, uint8_t budget) {
+  if(budget < 1 || budget > ALERT_BUDGET_MAX) {
+    return false;
+  }
+  Bucket& bucket = buckets[static_cast<uint8_t>(type)];
+  bucket.budget = budget;
+  if(bucket.tokens > budget) {
+    bucket.tokens = budget;
+  }
+  return true;
+}
+
+/**
+ * Prints the budget, the tokens and the suppressed and coalesced alerts of every type over serial.
+ */
+void AlertLimiter::printStats() const {
+  Serial.printf(" >> Alert budget per %u s (budget/tokens/suppressed/coalesced):\n", ALERT_BUDGET_WINDOW);
+  for(uint8_t i = 0; i < ALERT_TYPE_COUNT; i++) {
+    const Bucket& bucket = buckets[i];
+    Serial.printf("    %-8s %u/%u/%lu/%lu\n", alertTypeNames[i], bucket.budget, bucket.tokens,
+                  (unsigned long)bucket.suppressed, (unsigned long)bucket.coalesced);
+  }
+}
+
+/**
+ * Resets the counters of suppressed and coalesced alerts.
+ */
+void AlertLimiter::resetStats() {
+  for(Bucket& bucket : buckets) {
+    bucket.suppressed = 0;
+    bucket.coalesced = 0;
+  }
+}
@@ -0,0 +1,139 @@
+#pragma once
+/*************************************************************
+  A rate limiter to keep the alerts within the event quota of Blynk.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include "outbound_scheduler.h"
+
+//===========================================================
+// Definitions
+#define ALERT_BUDGET_WINDOW 60            //< The window the alert budget refers to in seconds.
+#define ALERT_BUDGET_DEFAULT 4            //< Default number of alerts per type and window.
+#define ALERT_BUDGET_MAX 60               //< Highest configurable number of alerts per type and window.
+#define ALERT_SUMMARY_SIZE 96             //< Size of the description of a coalesced alert including the terminator.
+
+//===========================================================
+// Data Types
+
+/**
+ * Limits the alerts of every alert type with a token bucket.
+ * A bucket holds up to the budget tokens and gains the budget back over ALERT_BUDGET_WINDOW.
+ * Each sent alert takes one token. An alert without a token is suppressed and coalesced
+ * with the following ones of its type. As soon as a token is available again, one summary
+ * with the latest event and the number of coalesced events is sent instead.
+ * All methods are called by one task.
+ */
+class AlertLimiter {
+  private:
+    /**
+     * The token bucket and the coalesced alerts of one alert type.
+     */
+    struct Bucket {
+      uint8_t budget = ALERT_BUDGET_DEFAULT;  //< Number of alerts per window.
+      uint8_t tokens = ALERT_BUDGET_DEFAULT;  //< Number of alerts which can be sent right now.
+      uint32_t lastRefill = 0;                //< Time the last token was gained in milli seconds.
+      OutboundAlert latest = {};              //< The latest coalesced alert.
+      uint16_t pending = 0;                   //< Number of coalesced alerts not sent yet.
+      uint32_t firstPending = 0;              //< Time of the first coalesced alert not sent yet in milli seconds.
+      uint32_t suppressed = 0;                //< Number of suppressed alerts.
+      uint32_t coalesced = 0;                 //< Number of sent summaries.
+    };
+
+    Bucket buckets[ALERT_TYPE_COUNT];         //< The buckets per alert type.
+
+    /**
+     * Adds the tokens gained since the last refill to a bucket.
+     * @param bucket The bucket.
+     * @param now The current time in milli seconds.
+     */
+    static void refill(Bucket& bucket, uint32_t now);
+
+  public:
+    /**
+     * Decides whether an alert can be sent right now. Takes a token if so.
+     * Otherwise the alert is coalesced and counted as suppressed.
+     * @param alert The alert.
+     * @param now The current time in milli seconds.
+     * @return
+     *  -true: If the alert can be sent.
+     *  -false: If the alert was coalesced.
+     */
+    bool admit(const OutboundAlert& alert, uint32_t now);
+
+    /**
+     * Gives the summary of coalesced alerts of a type as soon as a token is available. Takes the token.
+     * The coalesced alerts stay pending until the summary is confirmed with confirmSummary().
+     * @param type The alert type.
+     * @param now The current time in milli seconds.
+     * @param[out] alert The latest coalesced alert.
+     * @param[out] summary The description of the summary.
+     * @return
+     *  -true: If a summary should be sent.
+     *  -false: If there is none or no token is available yet.
+     */
+    bool takeSummary(AlertType type, uint32_t now, OutboundAlert& alert, char (&summary)[ALERT_SUMMARY_SIZE]);
+
+    /**
+     * Clears the coalesced alerts of a type after their summary was sent.
+     * @param type The alert type.
+     */
+    void confirmSummary(AlertType type);
+
+    /**
+     * Gives back the token of an admitted alert or a summary the server did not take.
+     * @param type The alert type.
+     */
+    void refund(AlertType type);
+
+    /**
+     * Sets the number of alerts per window of an alert type.
+     * @param type The alert type.
+     * @param budget The budget. Between 1 and ALERT_BUDGET_MAX.
+     * @return
+     *  -true: On success.
+     *  -false: If the budget is out of bounds.
+     */
+    bool setBudget(AlertType type, uint8_t budget);
+
+    /**
+     * Gives the number of alerts per window of an alert type.
+     * @param type The alert type.
+     * @return The budget.
+     */
+    uint8_t getBudget(AlertType type) const;
+
+    /**
+     * Prints the budget, the tokens and the suppressed and coalesced alerts of every type over serial.
+     */
+    void printStats() const;
+
+    /**
+     * Resets the counters of suppressed and coalesced alerts.
+     */
+    void resetStats();
+};
+
+//===========================================================
+// Function Declarations
+
+/**
+ * Gives the name of an alert type as used in the commands.
+ * @param type The alert type.
+ * @return The name.
+ */
+const char* alertTypeName(AlertType type);
+
+/**
+ * Parses the name of an alert type.
+ * @param name The name. One of "door", "room" or "persons".
+ * @param[out] type The alert type.
+ * @return
+ *  -true: On success.
+ *  -false: If the name is unknown.
+ */
+bool parseAlertType(const String& name, AlertType& type);
+
+#include "alert_limiter_inline.h"
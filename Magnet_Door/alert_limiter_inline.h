@@ -0,0 +1,15 @@
+//===========================================================
+// included dependencies
+#include "alert_limiter.h"
+
+//===========================================================
+// Inline member function implementations
+
+/**
+ * Gives the number of alerts per window of an alert type.
+ * @param type The alert type.
+ * @return The budget.
+ */
+inline uint8_t AlertLimiter::getBudget(AlertType type) const {
+  return buckets[static_cast<uint8_t>(type)].budget;
+}
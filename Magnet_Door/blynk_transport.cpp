@@ -0,0 +1,124 @@
+/*************************************************************
+  The implementation of a transport to send events to the Blynk cloud.
+*************************************************************/
+
+//===========================================================
+// Blynk definitons
+/* Uncomment this line to enable Serial debug prints */
+#define BLYNK_PRINT Serial
+#define BLYNK_TEMPLATE_ID "TMPL4AnEFpL5p"
+#define BLYNK_TEMPLATE_NAME "Quickstart Device"
+#define BLYNK_AUTH_TOKEN "qEjFtvtSFtEUyFgUdcyLCil66z_tXCc_"
+
+
+//===========================================================
+// included dependencies
+#include "blynk_transport.h"
+#include <BlynkSimpleEsp32.h>
+
+//===========================================================
+// Member function implementations
+
+/**
+ * Gives the name of the transport.
+ * @return The name.
+ */
+const char* BlynkTransport::getName() const {
+  return "blynk";
+}
+
+/**
+ * Configures the Blynk connection and does the handshake if not connected yet.
+ * Waits at most BLYNK_CONNECT_TIMEOUT for the handshake, the TCP connect included.
+ * The reconnects are paced by the caller, e.g. a ReconnectPolicy, and by BLYNK_RETRY_INTERVAL.
+ * @return
+ *  -true: If connected.
+ *  -false: If the last attempt was less than BLYNK_RETRY_INTERVAL ago or the handshake failed.
+ */
+bool BlynkTransport::connect() {
+  if(!configured) {
+    Blynk.config(BLYNK_AUTH_TOKEN);
+    configured = true;
+  }
+  if(Blynk.connected()) {
+    return true;
+  }
+  uint32_t now = millis();
+  if(lastAttempt && now - lastAttempt < BLYNK_RETRY_INTERVAL) {
+    return false;
+  }
+  lastAttempt = now;
+  return Blynk.connect(BLYNK_CONNECT_TIMEOUT);
+}
+
+/**
+ * Sends an event to the Blynk cloud.
+ * @param topic The name of the event.
+ * @param payload The description of the event.
+ * @param contentType Unused.
+ * @return
+ *  -true: If connected.
+ *  -false: otherwise.
+ */
+bool BlynkTransport::publish(const char* topic, const String& payload, const char* contentType) {
+  (void)contentType;
+  lastPublished = Blynk.connected();
+  if(!lastPublished) {
+    failures++;
+    return false;
+  }
+  Blynk.logEvent(topic, payload);
+  published++;
+  return true;
+}
+
+/**
+ * Runs the Blynk library while connected. Never connects, since the library waits for the TCP connect.
+ */
+void BlynkTransport::poll() {
+  if(configured && Blynk.connected()) {
+    Blynk.run();
+  }
+}
+
+/**
+ * Checks whether the Blynk handshake is done.
+ * @return
+ *  -true: If yes.
+ *  -false: otherwise.
+ */
+bool BlynkTransport::isConnected() {
+  return configured && Blynk.connected();
+}
+
+/**
+ * Disconnects from the Blynk cloud.
+ */
+void BlynkTransport::disconnect() {
+  Blynk.disconnect();
+  configured = false;
+  lastAttempt = 0; //The next connect may start right away
+}
+
+/**
+ * Gives a description of the result of the last publish.
+ * @return The description.
+ */
+String BlynkTransport::getLastResult() const {
+  return lastPublished? "sent" : "not connected";
+}
+
+/**
+ * Prints the event counters over serial.
+ */
+void BlynkTransport::printStats() const {
+  Serial.printf(" >> Blynk events: sent %lu, failed %lu\n", (unsigned long)published, (unsigned long)failures);
+}
+
+/**
+ * Resets the event counters.
+ */
+void BlynkTransport::resetStats() {
+  published = 0;
+  failures = 0;
+}
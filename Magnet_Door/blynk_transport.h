@@ -0,0 +1,93 @@
+#pragma once
+/*************************************************************
+  A transport to send events to the Blynk cloud.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include "transport.h"
+
+//===========================================================
+// Definitions
+#define BLYNK_CONNECT_TIMEOUT 1000        //< Time a connect may wait for the Blynk handshake in milli seconds.
+#define BLYNK_RETRY_INTERVAL 5000         //< Minimum time between two connect attempts in milli seconds.
+
+//===========================================================
+// Data Types
+
+/**
+ * Sends events to the Blynk cloud over the Blynk singleton.
+ * The topic of a message is the name of the event and the payload its description.
+ * This is the only place the Blynk library is used.
+ */
+class BlynkTransport: public Transport {
+  private:
+    bool configured = false;            //< If the Blynk connection is configured.
+    uint32_t published = 0;             //< Number of sent events.
+    uint32_t failures = 0;              //< Number of events which could not be sent.
+    bool lastPublished = false;         //< If the last event was sent.
+    uint32_t lastAttempt = 0;           //< Time of the last connect attempt in milli seconds. 0 if none since the last disconnect.
+
+  public:
+    /**
+     * Gives the name of the transport.
+     * @return The name.
+     */
+    const char* getName() const override;
+
+    /**
+     * Configures the Blynk connection and does the handshake if not connected yet.
+     * Waits at most BLYNK_CONNECT_TIMEOUT for the handshake, the TCP connect included.
+     * The reconnects are paced by the caller, e.g. a ReconnectPolicy, and by BLYNK_RETRY_INTERVAL.
+     * @return
+     *  -true: If connected.
+     *  -false: If the last attempt was less than BLYNK_RETRY_INTERVAL ago or the handshake failed.
+     */
+    bool connect() override;
+
+    /**
+     * Sends an event to the Blynk cloud.
+     * @param topic The name of the event.
+     * @param payload The description of the event.
+     * @param contentType Unused.
+     * @return
+     *  -true: If connected.
+     *  -false: otherwise.
+     */
+    bool publish(const char* topic, const String& payload, const char* contentType) override;
+
+    /**
+     * Runs the Blynk library while connected. Never connects, since the library waits for the TCP connect.
+     */
+    void poll() override;
+
+    /**
+     * Checks whether the Blynk handshake is done.
+     * @return
+     *  -true: If yes.
+     *  -false: otherwise.
+     */
+    bool isConnected() override;
+
+    /**
+     * Disconnects from the Blynk cloud.
+     */
+    void disconnect() override;
+
+    /**
+     * Gives a description of the result of the last publish.
+     * @return The description.
+     */
+    String getLastResult() const override;
+
+    /**
+     * Prints the event counters over serial.
+     */
+    void printStats() const override;
+
+    /**
+     * Resets the event counters.
+     */
+    void resetStats() override;
+};
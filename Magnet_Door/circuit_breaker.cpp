@@ -0,0 +1,128 @@
+/*************************************************************
+  The implementation of a circuit breaker to stop sending to a server which fails or responds slowly.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "circuit_breaker.h"
+
+/**
+ * Represents the states of a circuit breaker.
+ */
+enum class BreakerState: uint8_t {
+  closed,         //< Requests are sent.
+  open,           //< Requests are skipped.
+  halfOpen        //< One request is sent as probe.
+};
+
+//===========================================================
+// Static data
+
+static const char* const breakerStateNames[] = {"closed", "open", "half open"};
+
+//===========================================================
+// Member function implementations
+
+/**
+ * Constructs a closed CircuitBreaker.
+ * @param name Name of the guarded requests used in the messages.
+ * @param slowThreshold Duration from which on a request counts as slow in milli seconds.
+ */
+CircuitBreaker::CircuitBreaker(const char* name, uint32_t slowThreshold): name(name),
+                                                                          state(BreakerState::closed),
+                                                                          slowThreshold(slowThreshold) {}
+
+/**
+ * Sets the duration from which on a request counts as slow.
+ * @param val The slow threshold in milli seconds.
+ */
+void CircuitBreaker::setSlowThreshold(uint32_t val) {
+  slowThreshold = val;
+}
+
+/**
+ * Decides whether a request may be sent now. Counts it as skipped if not.
+ * Lets the probe through once the open time is over.
+ * @return
+ *  -true: If the request may be sent.
+ *  -false: If it is skipped.
+ */
+bool CircuitBreaker::allowRequest() {
+  if(state == BreakerState::open) {
+    if(millis() - openedAt < BREAKER_OPEN_TIME) {
+      skipped++;
+      return false;
+    }
+    changeState(BreakerState::halfOpen);
+  }
+  return true;
+}
+
+/**
+ * Records the outcome of an allowed request.
+ * @param success If the request succeeded.
+ * @param duration How long the request took in milli seconds.
+ */
+void CircuitBreaker::recordResult(bool success, uint32_t duration) {
+  bool isSlow = success && duration >= slowThreshold;
+  if(isSlow) {
+    slow++;
+  }
+  if(success && !isSlow) {
+    consecutiveFailures = 0;
+    if(state == BreakerState::halfOpen) {
+      changeState(BreakerState::closed);
+    }
+    return;
+  }
+  if(consecutiveFailures < UINT8_MAX) {
+    consecutiveFailures++;
+  }
+  if(state == BreakerState::halfOpen || consecutiveFailures >= BREAKER_FAILURE_THRESHOLD) {
+    openedAt = millis();
+    opens++;
+    changeState(BreakerState::open);
+  }
+}
+
+/**
+ * Closes the breaker without a probe, e.g. if the server changed.
+ */
+void CircuitBreaker::reset() {
+  consecutiveFailures = 0;
+  if(state != BreakerState::closed) {
+    changeState(BreakerState::closed);
+  }
+}
+
+/**
+ * Changes the state and prints the change over serial.
+ * @param next The new state.
+ */
+void CircuitBreaker::changeState(BreakerState next) {
+  Serial.printf(" >> Info: %s circuit breaker %s -> %s", name,
+                breakerStateNames[static_cast<uint8_t>(state)], breakerStateNames[static_cast<uint8_t>(next)]);
+  if(next == BreakerState::open) {
+    Serial.printf(" after %u failed or slow requests, probing in %u s", consecutiveFailures, BREAKER_OPEN_TIME / 1000);
+  }
+  Serial.println(".");
+  state = next;
+}
+
+/**
+ * Prints the state and the counters over serial.
+ */
+void CircuitBreaker::printStats() const {
+  Serial.printf(" >> %s circuit breaker: %s, failures in a row %u, slow %lu, opened %lu, skipped %lu\n", name,
+                breakerStateNames[static_cast<uint8_t>(state)], consecutiveFailures,
+                (unsigned long)slow, (unsigned long)opens, (unsigned long)skipped);
+}
+
+/**
+ * Resets the counters.
+ */
+void CircuitBreaker::resetStats() {
+  slow = 0;
+  opens = 0;
+  skipped = 0;
+}
@@ -0,0 +1,92 @@
+#pragma once
+/*************************************************************
+  A circuit breaker to stop sending to a server which fails or responds slowly.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+
+//===========================================================
+// Definitions
+#define BREAKER_FAILURE_THRESHOLD 3       //< Number of consecutive failed or slow requests which open the breaker.
+#define BREAKER_OPEN_TIME 30000           //< Time the breaker stays open until it lets a probe through in milli seconds.
+
+//===========================================================
+// forward declared dependencies
+enum class BreakerState: uint8_t;
+
+//===========================================================
+// Data Types
+
+/**
+ * Stops requests to a server which fails or responds slowly, so they do not block the caller.
+ * While closed every request is allowed. BREAKER_FAILURE_THRESHOLD consecutive requests which
+ * failed or took longer than the slow threshold open it. While open every request is skipped.
+ * After BREAKER_OPEN_TIME it is half open and lets one request through as probe. The probe
+ * closes it on success and opens it again otherwise.
+ * Every change of the state is printed over serial.
+ * All methods are called by one task.
+ */
+class CircuitBreaker {
+  private:
+    const char* name;                   //< Name of the guarded requests used in the messages.
+    BreakerState state;                 //< The state of the breaker.
+    uint32_t openedAt = 0;              //< Time the breaker opened in milli seconds.
+    uint32_t slowThreshold;             //< Duration from which on a request counts as slow in milli seconds.
+    uint8_t consecutiveFailures = 0;    //< Number of failed or slow requests in a row.
+    uint32_t slow = 0;                  //< Number of successful but slow requests.
+    uint32_t opens = 0;                 //< Number of times the breaker opened.
+    uint32_t skipped = 0;               //< Number of requests skipped while open.
+
+    /**
+     * Changes the state and prints the change over serial.
+     * @param next The new state.
+     */
+    void changeState(BreakerState next);
+
+  public:
+    /**
+     * Constructs a closed CircuitBreaker.
+     * @param name Name of the guarded requests used in the messages.
+     * @param slowThreshold Duration from which on a request counts as slow in milli seconds.
+     */
+    CircuitBreaker(const char* name, uint32_t slowThreshold);
+
+    /**
+     * Sets the duration from which on a request counts as slow.
+     * @param val The slow threshold in milli seconds.
+     */
+    void setSlowThreshold(uint32_t val);
+
+    /**
+     * Decides whether a request may be sent now. Counts it as skipped if not.
+     * Lets the probe through once the open time is over.
+     * @return
+     *  -true: If the request may be sent.
+     *  -false: If it is skipped.
+     */
+    bool allowRequest();
+
+    /**
+     * Records the outcome of an allowed request.
+     * @param success If the request succeeded.
+     * @param duration How long the request took in milli seconds.
+     */
+    void recordResult(bool success, uint32_t duration);
+
+    /**
+     * Closes the breaker without a probe, e.g. if the server changed.
+     */
+    void reset();
+
+    /**
+     * Prints the state and the counters over serial.
+     */
+    void printStats() const;
+
+    /**
+     * Resets the counters.
+     */
+    void resetStats();
+};
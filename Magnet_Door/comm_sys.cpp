@@ -2,19 +2,10 @@
   The implementation of a system to manage communication to a server via WiFi.
 *************************************************************/
 
-//===========================================================
-// Blynk definitons
-/* Uncomment this line to enable Serial debug prints */
-#define BLYNK_PRINT Serial
-#define BLYNK_TEMPLATE_ID "TMPL4AnEFpL5p"
-#define BLYNK_TEMPLATE_NAME "Quickstart Device"
-#define BLYNK_AUTH_TOKEN "qEjFtvtSFtEUyFgUdcyLCil66z_tXCc_"
-
-
 //===========================================================
 // included dependencies
 #include "comm_sys.h"
-#include <BlynkSimpleEsp32.h>
+#include "loop_profiler.h"
 #include <WiFi.h>
 
 /**
@@ -22,61 +13,42 @@
  */
 enum class CommSysState: uint8_t {
   offline,        //< System is offline.
+  connecting,     //< Establishes a connection step by step.
   online,         //< Does online tasks. 
   reconnect       //< Tries to reconnect.
 };
 
-//===========================================================
-// Static function implementations
-
 /**
- * Tries to establish a connection to a WiFi access point
- * Can fail after a certain timeout.
- * @param ssid The SSID of the WiFi.
- * @param pass The password of the WiFi.
- * @return The Status of the WiFi connection.
- * -WL_CONNECTED: If a connection could be successfully established.
+ * Represents the steps of establishing a connection.
  */
-wl_status_t connectWiFi(const char* ssid, const char* pass) {
-    BLYNK_LOG2(BLYNK_F("Connecting to "), ssid);
-    WiFi.mode(WIFI_STA);
-    if (pass && strlen(pass)) {
-        WiFi.begin(ssid, pass);
-    } 
-    else {
-        WiFi.begin(ssid);
-    }
-    uint16_t wait = 0;
-    const uint16_t delay = 500;
-    wl_status_t wifiStatus = WiFi.status();
-    while (wifiStatus != WL_CONNECTED) {
-        //TODO: Make timeout more accurate
-        if(wait > CONN_TIMEOUT) {
-          return wifiStatus;
-        }
-        wait += delay;
-        BlynkDelay(delay);
-        wifiStatus = WiFi.status();
-    }
-    BLYNK_LOG1(BLYNK_F("Connected to WiFi"));
+enum class ConnectStep: uint8_t {
+  wifi,           //< Associates to the WiFi access point.
+  ip,             //< Waits for an IP address.
+  blynk,          //< Does the Blynk handshake.
+  server          //< Checks if the web server is reachable.
+};
 
-    IPAddress myip = WiFi.localIP();
-    (void)myip; // Eliminate warnings about unused myip
-    BLYNK_LOG_IP("IP: ", myip);
-    return WL_CONNECTED;
-}
+//===========================================================
+// Static function implementations
 
 /**
- * Toggles the connection status LED. 
- * Is called with each interrupt of the connStatusTimer,
- * so it will blink in the configured timer interval.
- * @param connLEDPin Pointer to the pin number of the connection status LED.
+ * Gives the timeout of a connect step.
+ * @param step The connect step.
+ * @return The timeout in milli seconds.
  */
-inline static void connStatusLEDToggle(const uint8_t connLEDPin) {
-  digitalWrite(connLEDPin, !digitalRead(connLEDPin));
+inline static unsigned long connectStepTimeout(ConnectStep step) {
+  switch(step) {
+    case ConnectStep::wifi:
+      return CONN_WIFI_TIMEOUT;
+    case ConnectStep::ip:
+      return CONN_IP_TIMEOUT;
+    case ConnectStep::blynk:
+      return CONN_BLYNK_TIMEOUT;
+    default:
+      return CONN_SERVER_TIMEOUT;
+  }
 }
 
-
 //===========================================================
 // Member function implementations
 
@@ -88,24 +60,124 @@ inline static void connStatusLEDToggle(const uint8_t connLEDPin) {
  */
 CommunicationSystem::CommunicationSystem( uint8_t connButtonPin, 
                                           uint8_t connLEDPin): state(CommSysState::offline),
-                                                               connButtonPin(connButtonPin), 
-                                                               connLEDPin(connLEDPin) {
-  //Setup  
-  pinMode(connButtonPin, INPUT);
-  pinMode(connLEDPin, OUTPUT);
+                                                               connButton(connButtonPin, {DebounceMode::stableTime,
+                                                                                          CONN_BUTTON_HOLD_TIME,
+                                                                                          CONN_BUTTON_SAMPLE_PERIOD}),
+                                                               breaker("Telemetry", SEND_DEADLINE_DEFAULT / 2) {
+  //Setup. The LED is active low.
+  signals.attach(SignalChannel::connLED, connLEDPin, SignalOutput::activeLow);
+  setSendDeadline(SEND_DEADLINE_DEFAULT);
+  health.setEndpoints(&endpoints);
 }
 
 /**
- * Sets the url of the server.
+ * Sets the url of the primary web server.
+ * An "mqtt://" url publishes the telemetry to an MQTT broker instead of posting it over HTTP.
+ * The wire format of the uploaded data can be appended after WIRE_FORMAT_SEPARATOR.
  * @param url The url of the server.
+ * @return
+ *  -true: On success.
+ *  -false: If the wire format is unknown. Json is used then.
  */
-void CommunicationSystem::setServerUrl(const String& url) {
-  serverUrl = url;
+bool CommunicationSystem::setServerUrl(const String& url) {
+  return setEndpointUrl(0, url);
 }
 
 /**
- * Gets the url of the web server.
+ * Sets the url of a fallback web server. It is used if it responds faster than the primary one or that fails.
+ * @param index The number of the fallback, from 1 to ENDPOINT_COUNT - 1.
+ * @param url The url of the server in the form of the primary one. An empty url removes the fallback.
+ * @return
+ *  -true: On success.
+ *  -false: If the wire format is unknown. Json is used then.
+ */
+bool CommunicationSystem::setFallbackUrl(uint8_t index, const String& url) {
+  return setEndpointUrl(index, url);
+}
+
+/**
+ * Sets the url of an endpoint and uses the best endpoint afterwards.
+ * @param index The index of the endpoint. 0 is the primary server.
  * @param url The url of the server.
+ * @return
+ *  -true: On success.
+ *  -false: If the wire format is unknown. Json is used then.
+ */
+bool CommunicationSystem::setEndpointUrl(uint8_t index, const String& url) {
+  String target;
+  WireFormat format;
+  bool known = splitServerUrl(url, target, format);
+  if(!endpoints.setUrl(index, url)) {
+    Serial.println("Error: The host name of the server url is too long to be monitored!");
+  }
+  if(index == endpoints.getActive()) {
+    serverUrl = ""; //Applies the url of the active endpoint again
+  }
+  endpoints.select();
+  useEndpoint(endpoints.getActive(), false);
+  return known;
+}
+
+/**
+ * Sends the telemetry to an endpoint from now on. Does nothing if it is in use already.
+ * @param index The index of the endpoint.
+ * @param reachable If the endpoint is known to be reachable.
+ */
+void CommunicationSystem::useEndpoint(uint8_t index, bool reachable) {
+  const String& url = endpoints.getUrl(index);
+  if(url == serverUrl && !serverUrl.isEmpty()) {
+    return;
+  }
+  String target;
+  splitServerUrl(url, target, wireFormat);
+  serverUrl = url;
+  //The scheme of the url selects the transport
+  Transport* transport = &http;
+  if(target.startsWith("mqtt://")) {
+    if(mqtt.setUrl(target)) {
+      transport = &mqtt;
+    }
+    else {
+      Serial.println("Error: Malformed MQTT broker url! Should be mqtt://host[:port][/topic][?qos=0|1].");
+    }
+  }
+  else {
+    http.setUrl(target);
+  }
+  if(transport != telemetryTransport) {
+    telemetryTransport->disconnect();
+    telemetryTransport = transport;
+  }
+  health.setServer(target, reachable); //A host name which is too long was reported when it was set
+  breaker.reset(); //The failures of the former server say nothing about the new one
+}
+
+/**
+ * Switches over to the best endpoint if it changed.
+ */
+void CommunicationSystem::selectEndpoint() {
+  if(endpoints.select()) {
+    uint8_t index = endpoints.getActive();
+    Serial.printf(" >> Info: Switched telemetry to endpoint %u: %s\n", index, endpoints.getUrl(index).c_str());
+    useEndpoint(index, true); //Only endpoints reached by the survey are selected
+  }
+}
+
+/**
+ * Sets the time sending data may block. It bounds the connect and the wait for the response.
+ * A response which takes more than half of it counts as slow for the circuit breaker.
+ * @param deadline The deadline in milli seconds.
+ */
+void CommunicationSystem::setSendDeadline(uint16_t deadline) {
+  sendDeadline = deadline;
+  http.setDeadline(deadline);
+  mqtt.setDeadline(deadline);
+  breaker.setSlowThreshold(deadline / 2);
+}
+
+/**
+ * Gets the url of the web server in use.
+ * @return The url of the server.
  */
 const String& CommunicationSystem::getServerUrl() const {
   return serverUrl;
@@ -124,10 +196,12 @@ void CommunicationSystem::setPrintStatus(bool val) {
  * Monitores the connection button and changes.
  * Gives a connection request status back if pressed in offline mode otherwise it will disconnect.
  * Needs the WiFi credentials in case the system wants to connect after connection button press.
- * System tries to reconnect after connection is lost until timeout is reached.
+ * System tries to reconnect after connection is lost until it is back or the connection button is pressed.
+ * The attempts back off as told by the reconnect policy.
  * @return The connection status.
  */
 ConnectionStatus CommunicationSystem::run() {
+  ProfileTimer timer(profiler, ProfilePoint::commSysRun);
   ConnectionStatus status;
   switch(state) {
     case CommSysState::offline:
@@ -144,11 +218,28 @@ ConnectionStatus CommunicationSystem::run() {
         }
       }
       break;
+    case CommSysState::connecting:
+      if(checkConnButton()) {
+        //Connecting cancelled
+        disconnect();
+        state = CommSysState::offline;
+        status = ConnectionStatus::disconnected;
+      }
+      else {
+        status = doConnectStep();
+      }
+      break;
     case CommSysState::online:
       if(online) {
         //Connected
+        health.setFlags(HEALTH_BLYNK, blynk.isConnected(), HealthFailure::blynkLost);
         if(isConnected()) {
-          Blynk.run();
+          selectEndpoint();
+          blynk.poll();
+          telemetryTransport->poll();
+          if(!telemetryTransport->isConnected()) {
+            telemetryTransport->connect(); //Rate limited by the transport
+          }
           if(checkConnButton()) {
             disconnect();
             status = ConnectionStatus::disconnected;
@@ -158,7 +249,8 @@ ConnectionStatus CommunicationSystem::run() {
         else {
           //Connection lost. Try to reconnect.
           state = CommSysState::reconnect;
-          startConnLEDBlink();
+          reconnectPolicy.start();
+          startConnLEDBlink(reconnectSignal);
           status = ConnectionStatus::connectionLost;
         }
       }
@@ -174,26 +266,37 @@ ConnectionStatus CommunicationSystem::run() {
         state = CommSysState::offline;
       }
       else {
-        if(millis() - lastTimeOnline <= CONN_TIMEOUT) {
+        status = ConnectionStatus::connectionLost;
+        selectEndpoint(); //Another endpoint may still be reachable
+        if(reconnectPolicy.isAttempting()) {
+          health.setFlags(HEALTH_BLYNK, blynk.isConnected(), HealthFailure::blynkLost);
           if(isConnected()) {
             //Connection reestablished
-            lastTimeOnline = millis();
+            reconnectPolicy.succeed();
             state = CommSysState::online;
             status = ConnectionStatus::connected;
-            endConnLEDBlink();
-            digitalWrite(connLEDPin, LOW); //Setting connection status LED on
+            endConnLEDBlink(true); //Setting connection status LED on
+          }
+          else if(reconnectPolicy.isAttemptOver()) {
+            pauseReconnect();
           }
           else {
             //Connection still lost. Try to reconnect.
-            Blynk.run();
-            status = ConnectionStatus::connectionLost;
+            blynk.poll();
+            if((health.getHealth() & HEALTH_IP) && !blynk.isConnected()) {
+              blynk.connect(); //Rate limited by the transport
+            }
+            telemetryTransport->poll();
+            if((health.getHealth() & HEALTH_SERVER) && !telemetryTransport->isConnected()) {
+              telemetryTransport->connect(); //Rate limited by the transport
+            }
+            if(!health.isProbePending()) {
+              health.requestProbe(); //Notice the return of the web server soon
+            }
           }
         }
-        else {
-          //Connection still lost after timeout. Falling back to offline mode.
-          disconnect();
-          state = CommSysState::offline;
-          status = ConnectionStatus::connectionTimeout;
+        else if(reconnectPolicy.isAttemptDue()) {
+          beginReconnectAttempt();
         }
       }
       break;
@@ -207,53 +310,173 @@ void CommunicationSystem::reset() {
 }
 
 /**
- * Connects to WiFi and to the server.
+ * Starts to connect to WiFi and to the server.
+ * The connection is established step by step by run(), which reports
+ * connecting until the connection is established or failed.
  * Updates status LED accordingly.
- * Blocks until connection was established.
  * @param wifiCred The WiFi credentials.
- * @return The connection status.
  */
-ConnectionStatus CommunicationSystem::connect(const WifiCredentials& wifiCred) {
-  startConnLEDBlink();
-  wl_status_t wifiStatus = connectWiFi(wifiCred.ssid.c_str(), wifiCred.pass.c_str());
-  //httpClient.connect()
-  ConnectionStatus connStatus = ConnectionStatus::connectionTimeout; //start assumtion connection failes with timeout
-  switch(wifiStatus) {
-    case WL_CONNECTED:
-      Blynk.config(BLYNK_AUTH_TOKEN);
-      if(Blynk.connect(CONN_TIMEOUT)) {
-        //Successfully connected
-        lastTimeOnline = millis();
-        online = true;
-        endConnLEDBlink();
-        digitalWrite(connLEDPin, LOW); //Setting connection status LED on
-        return ConnectionStatus::connected;
+void CommunicationSystem::connect(const WifiCredentials& wifiCred) {
+  startConnLEDBlink(connectSignal);
+  if(!health.begin()) {
+    Serial.println("Error: Failed to start the connection health monitor!");
+  }
+  health.reset();
+  Serial.printf("[CommSys]: Connecting to %s\n", wifiCred.ssid.c_str());
+  WiFi.mode(WIFI_STA);
+  if(wifiCred.pass.length()) {
+    WiFi.begin(wifiCred.ssid.c_str(), wifiCred.pass.c_str());
+  }
+  else {
+    WiFi.begin(wifiCred.ssid.c_str());
+  }
+  state = CommSysState::connecting;
+  beginConnectStep(ConnectStep::wifi);
+}
+
+/**
+ * Goes on to the next step of establishing a connection.
+ * @param step The next step.
+ */
+void CommunicationSystem::beginConnectStep(ConnectStep step) {
+  connectStep = step;
+  connectStepStart = millis();
+}
+
+/**
+ * Advances the connect state machine by one step if its condition is met.
+ * Does not block. The web server is probed by the health monitor.
+ * @return The connection status. Connecting as long as the connection is not established or failed.
+ */
+ConnectionStatus CommunicationSystem::doConnectStep() {
+  ConnectionStatus failure = ConnectionStatus::connecting;
+  bool timeout = (millis() - connectStepStart > connectStepTimeout(connectStep));
+  switch(connectStep) {
+    case ConnectStep::wifi:
+      if((health.getHealth() & HEALTH_WIFI) || WiFi.status() == WL_CONNECTED) {
+        beginConnectStep(ConnectStep::ip);
+      }
+      else if(timeout) {
+        switch(WiFi.status()) {
+          case WL_NO_SSID_AVAIL:
+            failure = ConnectionStatus::noSSIDAvail;
+            break;
+          case WL_DISCONNECTED:
+            failure = ConnectionStatus::wifiAuthFailed;
+            break;
+          default:
+            failure = ConnectionStatus::wifiFailed;
+            break;
+        }
       }
       break;
-    case WL_NO_SSID_AVAIL:
-      connStatus = ConnectionStatus::noSSIDAvail;
+    case ConnectStep::ip:
+      if(health.getHealth() & HEALTH_IP) {
+        Serial.printf("[CommSys]: Connected to WiFi. IP: %s\n", WiFi.localIP().toString().c_str());
+        blynk.connect();
+        beginConnectStep(ConnectStep::blynk);
+      }
+      else if(timeout) {
+        failure = ConnectionStatus::wifiFailed;
+      }
       break;
-    case WL_DISCONNECTED:
-      connStatus = ConnectionStatus::wifiAuthFailed;
+    case ConnectStep::blynk:
+      if(blynk.connect()) { //Rate limited by the transport
+        health.setFlags(HEALTH_BLYNK, true, HealthFailure::none);
+        health.requestProbe();
+        beginConnectStep(ConnectStep::server);
+      }
+      else if(timeout) {
+        failure = ConnectionStatus::connectionTimeout;
+      }
       break;
-    default:
-      connStatus = ConnectionStatus::wifiFailed;
+    case ConnectStep::server:
+      blynk.poll();
+      telemetryTransport->poll();
+      health.setFlags(HEALTH_BLYNK, blynk.isConnected(), HealthFailure::none);
+      if(health.isHealthy() && telemetryTransport->isConnected()) {
+        //Successfully connected
+        health.arm(true);
+        online = true;
+        state = CommSysState::online;
+        endConnLEDBlink(true); //Setting connection status LED on
+        return ConnectionStatus::connected;
+      }
+      else if(timeout) {
+        if(statusMessages && !(health.getHealth() & HEALTH_SERVER)) {
+          Serial.printf("[CommSys]: Web server %s not reachable.\n", serverUrl.c_str());
+        }
+        else if(statusMessages && !telemetryTransport->isConnected()) {
+          Serial.printf("[CommSys]: No %s session to %s.\n", telemetryTransport->getName(), serverUrl.c_str());
+        }
+        failure = ConnectionStatus::connectionTimeout;
+      }
+      else if(health.isHealthy()) {
+        telemetryTransport->connect(); //The server is reachable, start the session
+      }
+      else if(!health.isProbePending()) {
+        health.requestProbe(); //Probe again until the timeout
+      }
       break;
   }
-  //Failed to connect
-  online = false;
-  endConnLEDBlink();
-  return connStatus;
+
+  if(failure != ConnectionStatus::connecting) {
+    //Failed to connect
+    disconnect();
+    state = CommSysState::offline;
+  }
+  return failure;
+}
+
+/**
+ * Starts a reconnect attempt. Restarts the parts of the connection which are down.
+ */
+void CommunicationSystem::beginReconnectAttempt() {
+  reconnectPolicy.beginAttempt();
+  if(statusMessages) {
+    Serial.printf("[CommSys]: Reconnect attempt %u.\n", reconnectPolicy.getAttempt());
+  }
+  if(!(health.getHealth() & HEALTH_WIFI)) {
+    WiFi.reconnect();
+  }
+  if(health.getHealth() & HEALTH_IP) {
+    blynk.connect(); //Otherwise run() connects once the IP is back
+  }
+  health.requestProbe();
+}
+
+/**
+ * Ends a failed reconnect attempt. Stops the parts of the connection which are down,
+ * so they do not retry on their own until the next attempt.
+ */
+void CommunicationSystem::pauseReconnect() {
+  uint32_t pause = reconnectPolicy.fail();
+  if(statusMessages) {
+    Serial.printf("[CommSys]: Reconnect attempt %u failed. Next attempt in %lu s.\n",
+                  reconnectPolicy.getAttempt(), (unsigned long)pause / 1000);
+  }
+  if(!telemetryTransport->isConnected()) {
+    telemetryTransport->disconnect();
+  }
+  if(!blynk.isConnected()) {
+    blynk.disconnect();
+  }
+  if(!(health.getHealth() & HEALTH_WIFI)) {
+    WiFi.disconnect(); //Keeps the driver from retrying the access point on its own
+  }
 }
 
 /**
  * Disconnects from the server and updates status LED.
  */
 void CommunicationSystem::disconnect() {
-  Blynk.disconnect();
+  health.reset(); //Losses from now on are no flaps
+  reconnectPolicy.stop();
+  telemetryTransport->disconnect();
+  blynk.disconnect();
   WiFi.disconnect();
   online = false;
-  endConnLEDBlink();
+  endConnLEDBlink(false);
 }
 
 /**
@@ -263,137 +486,115 @@ void CommunicationSystem::disconnect() {
  *  -false: otherwise.
  */
 bool CommunicationSystem::checkConnButton() {
-  if(digitalRead(connButtonPin) == HIGH) {//Check if connection button pressed
-    //If not pressed
-    lastConnButtonTime = millis();
-    connButton = false;
-  }
-  else { //If pressed
-    //Checks if there was no registered press before and if it was pressed for at least connButtonInterval milli seconds
-    if(!connButton && millis() - lastConnButtonTime > connButtonInterval) { 
-      connButton = true;
-      return true;
-    }
-  }
-  return false; //No unhandled button press
+  InputEdge edge;
+  //A press counts once the button is held low for CONN_BUTTON_HOLD_TIME
+  return connButton.update(edge) && edge.level == LOW;
+}
+
+/**
+ * Checks whether events can be logged right now, i.e. online, not reconnecting
+ * and the Blynk handshake is done.
+ * @return
+ *  -true: If yes.
+ *  -false: otherwise.
+ */
+bool CommunicationSystem::canLogEvents() {
+  return online && state != CommSysState::reconnect && blynk.isConnected();
 }
 
 /**
  * Logs an event with a description to the server if online.
  * @param eventName The identifier name of the event.
  * @param description A discription which is send with the event.
+ * @return
+ *  -true: If the server took the event.
+ *  -false: otherwise.
  */
-void CommunicationSystem::logEvent(const String& eventName, const String& description) const {
-  Blynk.logEvent(eventName, description);
+bool CommunicationSystem::logEvent(const String& eventName, const String& description) {
+  return blynk.publish(eventName.c_str(), description, nullptr);
 }
 
 /**
  * Sends data to the connected server.
- * @param jsonData The data which should be send. Data is expected to be in json format.
+ * Blocks at most about the send deadline. Skipped while the circuit breaker is open.
+ * @param data The data which should be send. Data is expected to be in the wire format of the server url.
  * @return Was the sending of data successful?
  *  -true: If yes.
  *  -false: otherwise.
  */
-bool CommunicationSystem::sendData(const String& jsonData) {
-  if(online && state != CommSysState::reconnect) {
-    // Preparing HTTP post request
-    http.begin(client, serverUrl.c_str());
-    http.addHeader("Content-Type", "application/json");
-
-    // send data
-    int httpResponseCode = http.POST(jsonData);
-
-    if(statusMessages) {
-      if (httpResponseCode > 0) {
-        Serial.printf("[CommSys]: HTTP Response Code: %d\n", httpResponseCode);
-        String response = http.getString();
-        Serial.println("[CommSys]: Server responds:");
-        Serial.println(response);
-        http.end();
-        return true;
-      } 
-      else {
-        Serial.printf("[CommSys]: HTTP POST error: %s\n", http.errorToString(httpResponseCode).c_str());
+bool CommunicationSystem::sendData(const String& data) {
+  ProfileTimer timer(profiler, ProfilePoint::sendData);
+  if(online && state != CommSysState::reconnect && breaker.allowRequest()) {
+    uint32_t start = millis();
+    bool sent = telemetryTransport->publish(TELEMETRY_TOPIC, data, wireFormatContentType(wireFormat));
+    breaker.recordResult(sent, millis() - start);
+    endpoints.recordSend(endpoints.getActive(), sent);
+    if(sent) {
+      health.reportServer(true);
+      if(statusMessages) {
+        Serial.printf("[CommSys]: Data sent over %s: %s\n", telemetryTransport->getName(),
+                      telemetryTransport->getLastResult().c_str());
       }
+      return true;
     }
-    else {
-      if (httpResponseCode > 0) {
-        http.end();
-        return true;
-      } 
+    if(statusMessages) {
+      Serial.printf("[CommSys]: Sending data over %s failed: %s\n", telemetryTransport->getName(),
+                    telemetryTransport->getLastResult().c_str());
     }
-    http.end();
+    //The web server may be gone. The health monitor decides after some more failures.
+    health.reportServer(false);
   }
   return false;
 }
 
 /**
  * Starts the blinking process of the connection status LED.
- * Uses a hardware timer, which executes the LED toggling routine periodically.
- * Can execute the LED blinking in parallel to other tasks.
+ * The pattern is played by the signal sequencer in parallel to other tasks.
+ * @param pattern The blink pattern.
  */
-void CommunicationSystem::startConnLEDBlink() {
-  uint64_t alarmLimit = 1500000; 
-  connStatusTimer = timerBegin(1000000); // timer frequency
-  timerAttachInterruptArg(connStatusTimer, 
-                       [](void* commSys){
-                        const uint8_t connLEDPin = static_cast<CommunicationSystem*>(commSys)->connLEDPin;
-                        connStatusLEDToggle(connLEDPin);
-                       }, 
-                       this);
-  timerAlarm(connStatusTimer, alarmLimit, true, 0);
+void CommunicationSystem::startConnLEDBlink(const SignalPattern& pattern) {
+  signals.stop(SignalChannel::connLED); //Replaces a running blink right away
+  signals.setIdle(SignalChannel::connLED, false);
+  signals.play(SignalChannel::connLED, pattern);
 }
 
 /**
  * Stops the blinking process of the connection status LED.
+ * @param on If the LED should stay on afterwards.
  */
-void CommunicationSystem::endConnLEDBlink() {
-  if(connStatusTimer) {
-    timerEnd(connStatusTimer); //Stop blinking
-    connStatusTimer = nullptr;
-  }
-  digitalWrite(connLEDPin, HIGH); //Setting connection status LED off
+void CommunicationSystem::endConnLEDBlink(bool on) {
+  signals.stop(SignalChannel::connLED);
+  signals.setIdle(SignalChannel::connLED, on);
 }
 
 /**
  * Checks whether there exists a connection to WiFi and server.
+ * Reads the health word of the health monitor and prints what is missing.
  * @return Are we connected?
  *  -true: If yes.
  *  -false: otherwise.
  */
 inline bool CommunicationSystem::isConnected() {
-  bool conn = true;
-  bool longEnough = false; //If the last status message was long enough ago.
-  if(millis() - lastConnStatusMessage >= connStatusMessageInterval) {
-    longEnough = true;
+  uint8_t flags = health.getHealth();
+  if(flags == HEALTH_ALL) {
+    return true;
   }
 
-  if(WiFi.status() == WL_CONNECTED) {
-      if(!Blynk.connected()) {
-        conn = false;
-        if(statusMessages && longEnough) {
-          Serial.println("[CommSys]: Lost connection to Blynk server.");
-          lastConnStatusMessage = millis();
-        }
+  if(statusMessages && millis() - lastConnStatusMessage >= connStatusMessageInterval) {
+    lastConnStatusMessage = millis();
+    if((flags & (HEALTH_WIFI | HEALTH_IP)) != (HEALTH_WIFI | HEALTH_IP)) {
+      Serial.println("[CommSys]: Lost connection to WiFi.");
+    }
+    else {
+      if(!(flags & HEALTH_BLYNK)) {
+        Serial.println("[CommSys]: Lost connection to Blynk server.");
       }
-      http.begin(client, serverUrl.c_str());
-      if(!http.connected()) {
-        conn = false;
-        if(statusMessages && longEnough) {
-          Serial.println("[CommSys]: Lost connection to web server.");
-          lastConnStatusMessage = millis();
-        }
+      if(!(flags & HEALTH_SERVER)) {
+        Serial.println("[CommSys]: Lost connection to web server.");
       }
-      http.end();
-  }
-  else {
-    conn = false;
-    if(statusMessages && longEnough) {
-      Serial.println("[CommSys]: Lost connection to WiFi.");
-      lastConnStatusMessage = millis();
     }
   }
-  return conn;
+  return false;
 }
 
 // void printWifiStatus() {
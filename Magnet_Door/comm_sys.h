@@ -6,18 +6,34 @@
 //===========================================================
 // included dependencies
 #include "Arduino.h"
-#include <WiFiClient.h>
-#include <HTTPClient.h>
+#include "input_filter.h"
+#include "signal_sequencer.h"
+#include "health_monitor.h"
+#include "blynk_transport.h"
+#include "telemetry_session.h"
+#include "mqtt_transport.h"
+#include "reconnect_policy.h"
+#include "circuit_breaker.h"
+#include "endpoint_set.h"
+#include "wire_format.h"
 
 //===========================================================
 // Definitons
-#define CONN_TIMEOUT 20000        //< Timeout until the system tries to reconnect.
+#define CONN_WIFI_TIMEOUT 15000   //< Timeout for the association to the WiFi access point in milli seconds.
+#define CONN_IP_TIMEOUT 10000     //< Timeout for getting an IP address in milli seconds.
+#define CONN_BLYNK_TIMEOUT 20000  //< Timeout for the Blynk handshake in milli seconds.
+#define CONN_SERVER_TIMEOUT 10000 //< Timeout for reaching the web server in milli seconds.
+#define CONN_BUTTON_SAMPLE_PERIOD 5000   //< Time between two samples of the connection button in micro seconds.
+#define CONN_BUTTON_HOLD_TIME 500000     //< Duration the connection button needs to be pressed in micro seconds.
+#define TELEMETRY_TOPIC "telemetry"      //< Topic the telemetry is published under.
+#define SEND_DEADLINE_DEFAULT 1000       //< Default time sending data may block in milli seconds.
+#define SEND_DEADLINE_MIN 100            //< Lowest configurable send deadline in milli seconds.
+#define SEND_DEADLINE_MAX 2000           //< Highest configurable send deadline in milli seconds. Well below the sampling interval.
 
 //===========================================================
 // forward declared dependencies
 enum class CommSysState: uint8_t;
-extern WiFiClient client;
-extern HTTPClient http;
+enum class ConnectStep: uint8_t;
 
 //===========================================================
 // Data Types
@@ -41,7 +57,8 @@ enum class ConnectionStatus: uint8_t {
   wifiFailed,                        //< WiFi connection failed for an unknown reason.
   connectionLost,                    //< Lost the connection to the server.
   connectionTimeout,                 //< Failed to connect to the server after timeout.
-  connectionRequest                  //< Communication system request a connect.
+  connectionRequest,                 //< Communication system request a connect.
+  connecting                         //< A connection is being established.
 };
 
 /**
@@ -50,31 +67,38 @@ enum class ConnectionStatus: uint8_t {
  */
 class CommunicationSystem {
   private: 
-    hw_timer_t* connStatusTimer = NULL;                        //< Hardware timer to handle connection status LED update task.
-    unsigned long lastConnButtonTime = 0;                      //< Records the last time the connection button was not pressed.
-    const unsigned long connButtonInterval = 500;              //< Duration the connection button needs to be pressed in milli seconds.
     CommSysState state;                                        //< The current state of the communication system FSM.
+    ConnectStep connectStep;                                   //< The current step of establishing a connection.
+    unsigned long connectStepStart = 0;                        //< Time the current connect step started in milli seconds.
     bool online = false;                                       //< Online state
-    bool connButton = false;                                   //< Registeres a press of the connection button.
-    unsigned long lastTimeOnline = 0;                          //< Record of last time the system was online.
-    String serverUrl = "";                                     //< Url to the web server.
+    DigitalInput connButton;                                   //< The debounced connection button.
+    HealthMonitor health;                                      //< Monitors the connection health.
+    BlynkTransport blynk;                                      //< The transport of the events to the Blynk cloud.
+    TelemetrySession http;                                     //< The keep-alive HTTP session to the web server.
+    MqttTransport mqtt;                                        //< The session to the MQTT broker.
+    Transport* telemetryTransport = &http;                     //< The transport of the telemetry. Selected by the server url.
+    uint16_t sendDeadline = SEND_DEADLINE_DEFAULT;             //< Time sending data may block in milli seconds.
+    CircuitBreaker breaker;                                    //< Skips sending data while the server fails or is slow.
+    ReconnectPolicy reconnectPolicy;                           //< Decides when to try to reconnect.
+    EndpointSet endpoints;                                     //< The web servers the telemetry can be sent to.
+    String serverUrl = "";                                     //< Url of the web server in use.
+    WireFormat wireFormat = WireFormat::json;                  //< The wire format of the uploaded data.
     bool statusMessages = false;                               //< If status  messages should be printed over serial.
     unsigned long lastConnStatusMessage = 0;                   //< To record the timestamp of the last connection status message.
     const unsigned long connStatusMessageInterval = 3000;      //< Time interval between two connection status messages in milli seconds.
-    const uint8_t connButtonPin;                               //< Connection button pin.
-    const uint8_t connLEDPin;                                  //< Connection LED pin.
 
     /**
     * Starts the blinking process of the connection status LED.
-    * Uses a hardware timer, which executes the LED toggling routine periodically.
-    * Can execute the LED blinking in parallel to other tasks.
+    * The pattern is played by the signal sequencer in parallel to other tasks.
+    * @param pattern The blink pattern.
     */  
-    void startConnLEDBlink();
+    void startConnLEDBlink(const SignalPattern& pattern);
 
     /**
     * Stops the blinking process of the connection status LED.
+    * @param on If the LED should stay on afterwards.
     */
-    void endConnLEDBlink();
+    void endConnLEDBlink(bool on);
 
     /**
      * Checks whether there was an unhandled press of the connection button.
@@ -86,11 +110,58 @@ class CommunicationSystem {
 
     /**
      * Checks whether there exists a connection to wifi and server.
+     * Reads the health word of the health monitor and prints what is missing.
      * @return Are we connected?
      *  -true: If yes.
      *  -false: otherwise.
      */
      bool isConnected();
+
+    /**
+     * Goes on to the next step of establishing a connection.
+     * @param step The next step.
+     */
+    void beginConnectStep(ConnectStep step);
+
+    /**
+     * Advances the connect state machine by one step if its condition is met.
+     * Does not block. The web server is probed by the health monitor.
+     * @return The connection status. Connecting as long as the connection is not established or failed.
+     */
+    ConnectionStatus doConnectStep();
+
+    /**
+     * Sets the url of an endpoint and uses the best endpoint afterwards.
+     * @param index The index of the endpoint. 0 is the primary server.
+     * @param url The url of the server.
+     * @return
+     *  -true: On success.
+     *  -false: If the wire format is unknown. Json is used then.
+     */
+    bool setEndpointUrl(uint8_t index, const String& url);
+
+    /**
+     * Sends the telemetry to an endpoint from now on. Does nothing if it is in use already.
+     * @param index The index of the endpoint.
+     * @param reachable If the endpoint is known to be reachable.
+     */
+    void useEndpoint(uint8_t index, bool reachable);
+
+    /**
+     * Switches over to the best endpoint if it changed.
+     */
+    void selectEndpoint();
+
+    /**
+     * Starts a reconnect attempt. Restarts the parts of the connection which are down.
+     */
+    void beginReconnectAttempt();
+
+    /**
+     * Ends a failed reconnect attempt. Stops the parts of the connection which are down,
+     * so they do not retry on their own until the next attempt.
+     */
+    void pauseReconnect();
     
   public:
 
@@ -104,17 +175,57 @@ class CommunicationSystem {
                          uint8_t connLEDPin);
 
     /**
-     * Sets the url of the web server.
+     * Sets the url of the primary web server.
+     * An "mqtt://" url publishes the telemetry to an MQTT broker instead of posting it over HTTP.
+     * The wire format of the uploaded data can be appended after WIRE_FORMAT_SEPARATOR.
      * @param url The url of the server.
+     * @return
+     *  -true: On success.
+     *  -false: If the wire format is unknown. Json is used then.
      */
-    void setServerUrl(const String& url);
+    bool setServerUrl(const String& url);
 
     /**
-     * Gets the url of the web server.
-     * @param url The url of the server.
+     * Sets the url of a fallback web server. It is used if it responds faster than the primary one or that fails.
+     * @param index The number of the fallback, from 1 to ENDPOINT_COUNT - 1.
+     * @param url The url of the server in the form of the primary one. An empty url removes the fallback.
+     * @return
+     *  -true: On success.
+     *  -false: If the wire format is unknown. Json is used then.
+     */
+    bool setFallbackUrl(uint8_t index, const String& url);
+
+    /**
+     * Sets the time sending data may block. It bounds the connect and the wait for the response.
+     * A response which takes more than half of it counts as slow for the circuit breaker.
+     * @param deadline The deadline in milli seconds.
+     */
+    void setSendDeadline(uint16_t deadline);
+
+    /**
+     * Gives the time sending data may block.
+     * @return The deadline in milli seconds.
+     */
+    uint16_t getSendDeadline() const;
+
+    /**
+     * Gets the url of the web server in use.
+     * @return The url of the server.
      */
     const String& getServerUrl() const;
 
+    /**
+     * Gives access to the web servers the telemetry can be sent to.
+     * @return The endpoints.
+     */
+    const EndpointSet& getEndpoints() const;
+
+    /**
+     * Gives the wire format of the uploaded data, which is selected by the server url.
+     * @return The wire format.
+     */
+    WireFormat getWireFormat() const;
+
     /**
      * Set whether status messages should be printed over serial.
      * Can be activated for debugging.
@@ -122,6 +233,36 @@ class CommunicationSystem {
      */
     void setPrintStatus(bool val);
 
+    /**
+     * Gives access to the connection health monitor.
+     * @return The health monitor.
+     */
+    HealthMonitor& getHealthMonitor();
+
+    /**
+     * Gives access to the reconnect policy.
+     * @return The reconnect policy.
+     */
+    ReconnectPolicy& getReconnectPolicy();
+
+    /**
+     * Gives access to the circuit breaker of the telemetry.
+     * @return The circuit breaker.
+     */
+    CircuitBreaker& getCircuitBreaker();
+
+    /**
+     * Gives access to the transport of the telemetry.
+     * @return The transport.
+     */
+    Transport& getTelemetryTransport();
+
+    /**
+     * Gives access to the transport of the events to the Blynk cloud.
+     * @return The transport.
+     */
+    Transport& getEventTransport();
+
     /**
      * Returns the online state of the communication system.
      * @return
@@ -131,12 +272,21 @@ class CommunicationSystem {
     bool isOnline() const;
 
     /**
-     * Connects to WiFi and to the server.
-     * Blocks until connection was established.
+     * Checks whether events can be logged right now, i.e. online, not reconnecting
+     * and the Blynk handshake is done.
+     * @return
+     *  -true: If yes.
+     *  -false: otherwise.
+     */
+    bool canLogEvents();
+
+    /**
+     * Starts to connect to WiFi and to the server.
+     * The connection is established step by step by run(), which reports
+     * connecting until the connection is established or failed.
      * @param wifiCred The WiFi credentials.
-     * @return The connection status.
      */
-    ConnectionStatus connect(const WifiCredentials& wifiCred);
+    void connect(const WifiCredentials& wifiCred);
 
     /**
      * Disconnects from the server and updates status LED.
@@ -147,24 +297,30 @@ class CommunicationSystem {
      * Logs an event with a description to the server if online.
      * @param eventName The identifier name of the event.
      * @param description A discription which is send with the event.
+     * @return
+     *  -true: If the server took the event.
+     *  -false: otherwise.
      */
-    void logEvent(const String& eventName, const String& description) const;
+    bool logEvent(const String& eventName, const String& description);
 
     /**
      * Sends data to the connected server.
-     * @param jsonData The data which should be send. Data is expected to be in json format.
+     * Blocks at most about the send deadline. Skipped while the circuit breaker is open.
+     * @param data The data which should be send. Data is expected to be in the wire format of the server url.
      * @return Was the sending of data successful?
      *  -true: If yes.
      *  -false: otherwise.
      */
-    bool sendData(const String& jsonData);
+    bool sendData(const String& data);
 
     /**
      * Executes the communication system state machine.
      * Monitores the connection button and changes.
      * Gives a connection request status back if pressed in offline mode otherwise it will disconnect.
      * Needs the WiFi credentials in case the system wants to connect after connection button press.
-     * System tries to reconnect after connection is lost until timeout is reached.
+     * System tries to reconnect after connection is lost until it is back or the connection button is pressed.
+     * The attempts back off as told by the reconnect policy.
+     * Establishes a requested connection without blocking.
      * @return The connection status.
      */
     ConnectionStatus run();
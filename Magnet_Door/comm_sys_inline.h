@@ -13,4 +13,68 @@
  */
 inline bool CommunicationSystem::isOnline() const {
   return online;
-}
\ No newline at end of file
+}
+
+/**
+ * Gives the wire format of the uploaded data, which is selected by the server url.
+ * @return The wire format.
+ */
+inline WireFormat CommunicationSystem::getWireFormat() const {
+  return wireFormat;
+}
+
+/**
+ * Gives access to the connection health monitor.
+ * @return The health monitor.
+ */
+inline HealthMonitor& CommunicationSystem::getHealthMonitor() {
+  return health;
+}
+
+/**
+ * Gives access to the reconnect policy.
+ * @return The reconnect policy.
+ */
+inline ReconnectPolicy& CommunicationSystem::getReconnectPolicy() {
+  return reconnectPolicy;
+}
+
+/**
+ * Gives access to the web servers the telemetry can be sent to.
+ * @return The endpoints.
+ */
+inline const EndpointSet& CommunicationSystem::getEndpoints() const {
+  return endpoints;
+}
+
+/**
+ * Gives the time sending data may block.
+ * @return The deadline in milli seconds.
+ */
+inline uint16_t CommunicationSystem::getSendDeadline() const {
+  return sendDeadline;
+}
+
+/**
+ * Gives access to the circuit breaker of the telemetry.
+ * @return The circuit breaker.
+ */
+inline CircuitBreaker& CommunicationSystem::getCircuitBreaker() {
+  return breaker;
+}
+
+/**
+ * Gives access to the transport of the telemetry.
+ * @return The transport.
+ */
+inline Transport& CommunicationSystem::getTelemetryTransport() {
+  return *telemetryTransport;
+}
+
+/**
+ * Gives access to the transport of the events to the Blynk cloud.
+ * @return The transport.
+ */
+inline Transport& CommunicationSystem::getEventTransport() {
+  return blynk;
+}
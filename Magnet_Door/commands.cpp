@@ -8,9 +8,101 @@
 #include "commands.h"
 #include "entrance_control_sys.h"
 
+//===========================================================
+// Data Types
+
+/**
+ * The argument of the alert budget command.
+ */
+struct AlertBudgetArg {
+  AlertType type;             //< The alert type.
+  long int budget;            //< The number of alerts per window.
+};
+
+/**
+ * The argument of the fallback url command.
+ */
+struct FallbackUrlArg {
+  long int index;             //< The number of the fallback.
+  String url;                 //< The url. Empty to remove the fallback.
+};
+
+/**
+ * Describes a config command with one integer parameter.
+ */
+struct NumericConfig {
+  const char* name;                                   //< The name of the setting in the command.
+  CommandType type;                                   //< The type of the command.
+  long int min;                                       //< The lowest allowed value.
+  long int max;                                       //< The highest allowed value.
+  bool (EntranceControlSystem::*apply)(uint16_t val); //< Configures and saves the value.
+};
+
+/**
+ * The config commands with one integer parameter.
+ * The batch size is bounded by TELEMETRY_BATCH_CAPACITY, which fits the uint8_t record counts of an upload.
+ */
+static const NumericConfig numericConfigs[] = {
+  {"RoomCap", CommandType::confRoomCap, 1, UINT16_MAX, &EntranceControlSystem::configRoomCap},
+  {"BatchSize", CommandType::confBatchSize, 1, TELEMETRY_BATCH_CAPACITY, &EntranceControlSystem::configBatchSize},
+  {"FlushInterval", CommandType::confFlushInterval, 1, TELEMETRY_FLUSH_INTERVAL_MAX, &EntranceControlSystem::configFlushInterval},
+  {"Heartbeat", CommandType::confHeartbeat, 1, TELEMETRY_HEARTBEAT_MAX, &EntranceControlSystem::configHeartbeat},
+  {"SendDeadline", CommandType::confSendDeadline, SEND_DEADLINE_MIN, SEND_DEADLINE_MAX, &EntranceControlSystem::configSendDeadline}
+};
+
 //===========================================================
 // Function implementations
 
+/**
+ * Searches the config command with one integer parameter by the name of its setting.
+ * @param name The name of the setting.
+ * @return The description of the command or nullptr if there is none.
+ */
+static const NumericConfig* findNumericConfig(const String& name) {
+  for(const NumericConfig& config: numericConfigs) {
+    if(name == config.name) {
+      return &config;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * Searches the config command with one integer parameter by its type.
+ * @param type The type of the command.
+ * @return The description of the command or nullptr if there is none.
+ */
+static const NumericConfig* findNumericConfig(CommandType type) {
+  for(const NumericConfig& config: numericConfigs) {
+    if(type == config.type) {
+      return &config;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * Checks if a parameter is within its bounds and prints an error if not.
+ * @param val The parameter.
+ * @param min The lowest allowed value.
+ * @param max The highest allowed value.
+ * @return
+ *  -true: If the parameter is within its bounds.
+ *  -false: otherwise.
+ */
+template <typename T>
+static bool checkBounds(T val, T min, T max) {
+  if(val >= min && val <= max) {
+    return true;
+  }
+  Serial.print("Error: Parameter out of bounds. Should be between ");
+  Serial.print(min);
+  Serial.print(" and ");
+  Serial.print(max);
+  Serial.println(".");
+  return false;
+}
+
 /**
  * Tries to parse a given command.
  * @param cmdStr The command string which should be parsed.
@@ -43,6 +135,18 @@ bool parseCommand(const String &cmdStr, Command *&cmd) {
     if(cmdStr == "Show Config") {
       cmd = new Command(CommandType::showConfig, cmdStr); done = true;
     }
+    else if(cmdStr == "Show Stats") {
+      cmd = new Command(CommandType::showStats, cmdStr); done = true;
+    }
+    else if(cmdStr == "Show Backlog") {
+      cmd = new Command(CommandType::showBacklog, cmdStr); done = true;
+    }
+    else if(cmdStr == "Show Endpoints") {
+      cmd = new Command(CommandType::showEndpoints, cmdStr); done = true;
+    }
+    else if(cmdStr == "Reset Stats") {
+      cmd = new Command(CommandType::resetStats, cmdStr); done = true;
+    }
     else if(cmdStr == "Config Wifi") {
       cmd = new Command(CommandType::confWifi, cmdStr); done = true;
     }
@@ -53,13 +157,14 @@ bool parseCommand(const String &cmdStr, Command *&cmd) {
         indexTo = cmdStr.indexOf(" ", indexFrom);
         if(indexTo != -1) { //If there was a space found, read next token
           String subCmd = cmdStr.substring(indexFrom, indexTo);
-          if(subCmd == "RoomCap") {
+          const NumericConfig* numeric = findNumericConfig(subCmd);
+          if(numeric) {
             indexFrom = indexTo + 1;
             indexTo = cmdStr.indexOf(" ", indexFrom);
             //Check if there follows something after expected parameter
             if(indexTo == -1) {
               subCmd = cmdStr.substring(indexFrom); //Read parameter
-              cmd = new ArgCommand<long int>(CommandType::confRoomCap, cmdStr, subCmd.toInt());
+              cmd = new ArgCommand<long int>(numeric->type, cmdStr, subCmd.toInt());
               done = true;
             }
           }
@@ -79,6 +184,62 @@ bool parseCommand(const String &cmdStr, Command *&cmd) {
               }
             }
           }
+          else if(subCmd == "TelemetryMode") {
+            indexFrom = indexTo + 1;
+            indexTo = cmdStr.indexOf(" ", indexFrom);
+            //Check if there follows something after expected parameter
+            if(indexTo == -1) {
+              subCmd = cmdStr.substring(indexFrom); //Read parameter
+              TelemetryMode mode;
+              if(parseTelemetryMode(subCmd, mode)) {
+                cmd = new ArgCommand<TelemetryMode>(CommandType::confTelemetryMode, cmdStr, mode);
+                done = true;
+              }
+            }
+          }
+          else if(subCmd == "TemperatureDelta") {
+            indexFrom = indexTo + 1;
+            indexTo = cmdStr.indexOf(" ", indexFrom);
+            //Check if there follows something after expected parameter
+            if(indexTo == -1) {
+              subCmd = cmdStr.substring(indexFrom); //Read parameter
+              cmd = new ArgCommand<float>(CommandType::confTempDelta, cmdStr, subCmd.toFloat());
+              done = true;
+            }
+          }
+          else if(subCmd == "AlertBudget") {
+            indexFrom = indexTo + 1;
+            indexTo = cmdStr.indexOf(" ", indexFrom);
+            AlertType type;
+            //Check if the alert type is followed by exactly one parameter
+            if(indexTo != -1 && parseAlertType(cmdStr.substring(indexFrom, indexTo), type)) {
+              indexFrom = indexTo + 1;
+              indexTo = cmdStr.indexOf(" ", indexFrom);
+              if(indexTo == -1) {
+                subCmd = cmdStr.substring(indexFrom); //Read parameter
+                cmd = new ArgCommand<AlertBudgetArg>(CommandType::confAlertBudget, cmdStr, {type, subCmd.toInt()});
+                done = true;
+              }
+            }
+          }
+          else if(subCmd == "FallbackUrl") {
+            indexFrom = indexTo + 1;
+            indexTo = cmdStr.indexOf(" ", indexFrom);
+            //Check if the number of the fallback is followed by exactly one parameter
+            if(indexTo != -1) {
+              long int index = cmdStr.substring(indexFrom, indexTo).toInt();
+              indexFrom = indexTo + 1;
+              indexTo = cmdStr.indexOf(" ", indexFrom);
+              if(indexTo == -1) {
+                subCmd = cmdStr.substring(indexFrom); //Read parameter
+                if(subCmd == "none") {
+                  subCmd = ""; //Removes the fallback
+                }
+                cmd = new ArgCommand<FallbackUrlArg>(CommandType::confFallbackUrl, cmdStr, {index, subCmd});
+                done = true;
+              }
+            }
+          }
           else if(subCmd == "ServerUrl") {
             indexFrom = indexTo + 1;
             indexTo = cmdStr.indexOf(" ", indexFrom);
@@ -143,16 +304,17 @@ bool executeCommand(EntranceControlSystem &entCtrlSys, const Command &cmd) {
     case CommandType::confWifi:
       entCtrlSys.configWifi();
       return true;
-    case CommandType::confRoomCap: {
+    case CommandType::confRoomCap:
+    case CommandType::confBatchSize:
+    case CommandType::confFlushInterval:
+    case CommandType::confHeartbeat:
+    case CommandType::confSendDeadline: {
+      const NumericConfig* numeric = findNumericConfig(cmd.type);
       long int arg = static_cast<const ArgCommand<long int>&>(cmd).arg;
-      if(arg > 0 && arg <= 255) {
-        entCtrlSys.configRoomCap(arg);
-        return true;
-      }
-      else {
-        Serial.println("Error: Parameter out of bounds. Should be between 0 and 255.");
+      if(!numeric || !checkBounds(arg, numeric->min, numeric->max)) {
         return false;
       }
+      return (entCtrlSys.*numeric->apply)(arg);
     }
     case CommandType::confVerbose: {
       bool arg = static_cast<const ArgCommand<bool>&>(cmd).arg;
@@ -164,9 +326,47 @@ bool executeCommand(EntranceControlSystem &entCtrlSys, const Command &cmd) {
       entCtrlSys.configServerUrl(arg);
       return true;
     }
+    case CommandType::confTelemetryMode: {
+      TelemetryMode arg = static_cast<const ArgCommand<TelemetryMode>&>(cmd).arg;
+      entCtrlSys.configTelemetryMode(arg);
+      return true;
+    }
+    case CommandType::confTempDelta: {
+      float arg = static_cast<const ArgCommand<float>&>(cmd).arg;
+      if(!checkBounds(arg, static_cast<float>(TELEMETRY_TEMP_DELTA_MIN), static_cast<float>(TELEMETRY_TEMP_DELTA_MAX))) {
+        return false;
+      }
+      return entCtrlSys.configTemperatureDelta(arg);
+    }
+    case CommandType::confAlertBudget: {
+      const AlertBudgetArg& arg = static_cast<const ArgCommand<AlertBudgetArg>&>(cmd).arg;
+      if(!checkBounds(arg.budget, 1L, static_cast<long int>(ALERT_BUDGET_MAX))) {
+        return false;
+      }
+      return entCtrlSys.configAlertBudget(arg.type, arg.budget);
+    }
+    case CommandType::confFallbackUrl: {
+      const FallbackUrlArg& arg = static_cast<const ArgCommand<FallbackUrlArg>&>(cmd).arg;
+      if(!checkBounds(arg.index, 1L, static_cast<long int>(ENDPOINT_COUNT - 1))) {
+        return false;
+      }
+      return entCtrlSys.configFallbackUrl(arg.index, arg.url);
+    }
     case CommandType::showConfig:
       entCtrlSys.printConfig();
       return true;
+    case CommandType::showStats:
+      entCtrlSys.printStats();
+      return true;
+    case CommandType::showBacklog:
+      entCtrlSys.printBacklog();
+      return true;
+    case CommandType::showEndpoints:
+      entCtrlSys.printEndpoints();
+      return true;
+    case CommandType::resetStats:
+      entCtrlSys.resetStats();
+      return true;
     case CommandType::resetWifi:
       entCtrlSys.resetWifiConfig();
       return true;
@@ -23,7 +23,19 @@ enum class CommandType: uint16_t {
   resetWifi,                  //< To reset the wifi configuration
   confVerbose,                //< To configure verbose status messaging
   confServerUrl,              //< To configure the url of the web server
-  showConfig                  //< To show the current configuration in terminal
+  showConfig,                 //< To show the current configuration in terminal
+  showStats,                  //< To show the runtime statistics in terminal
+  resetStats,                 //< To reset the runtime statistics
+  confBatchSize,              //< To configure the number of records per telemetry upload
+  confFlushInterval,          //< To configure the maximum age of a record before the telemetry is uploaded
+  showBacklog,                //< To show the telemetry records waiting on flash in terminal
+  confTelemetryMode,          //< To configure whether the telemetry is recorded periodically or on change
+  confHeartbeat,              //< To configure the time without change until a heartbeat is recorded
+  confTempDelta,              //< To configure the temperature change which is recorded in change mode
+  confAlertBudget,            //< To configure the number of alerts of a type per budget window
+  confSendDeadline,           //< To configure the time sending data to the server may block
+  confFallbackUrl,            //< To configure the url of a fallback web server
+  showEndpoints               //< To show the web servers and their measurements in terminal
 };
 
 /**
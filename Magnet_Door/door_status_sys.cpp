@@ -21,68 +21,55 @@
 DoorStatusSystem::DoorStatusSystem( uint8_t openLEDPin, 
                                     uint8_t closedLEDPin, 
                                     uint8_t magSwitchPin, 
-                                    uint8_t buzzerPin): openLEDPin(openLEDPin),
-                                                        closedLEDPin(closedLEDPin),
-                                                        magSwitchPin(magSwitchPin),
-                                                        buzzerPin(buzzerPin) {
-  //Setup pins
-  pinMode(openLEDPin, OUTPUT);
-  pinMode(closedLEDPin, OUTPUT);
-  pinMode(magSwitchPin, INPUT);
-  pinMode(buzzerPin, OUTPUT);
-
-  //Set initial LED state
-  setStatusLEDs(false);
+                                    uint8_t buzzerPin): magSwitch(magSwitchPin, {DebounceMode::integrating,
+                                                                                 MAG_SWITCH_DEBOUNCE_SAMPLES,
+                                                                                 MAG_SWITCH_SAMPLE_PERIOD / 2}) {
+  //The door check runs every MAG_SWITCH_SAMPLE_PERIOD. The filter takes a sample on each check,
+  //the shorter minimum time between two samples only keeps a late check from skipping the next one.
+  //Setup pins. The LEDs are active low. Initially entering is not allowed.
+  signals.attach(SignalChannel::openLED, openLEDPin, SignalOutput::activeLow, false);
+  signals.attach(SignalChannel::closedLED, closedLEDPin, SignalOutput::activeLow, true);
+  signals.attach(SignalChannel::buzzer, buzzerPin, SignalOutput::tone);
 }
 
 /**
- * Determines the current door state by reading the magnatic switch input
+ * Determines the current door state by reading the debounced magnatic switch input
  * and registeres door state change events. Updates status LEDs accordingly 
- * and performs acoustic signalling on door state change events.
+ * and queues acoustic signals on door state change events.
  * Also checks if persons are still in the room if the door was closed.
- * Calls the callback on door closed and door opened events.
+ * Publishes door closed, door opened and persons in room events.
  * @param passSys A reference to the door passing system.
- * @param eventCallback A callback which will be called if a door status event was registered.
+ * @param eventBus The event bus registered door status events are published to.
  */
-void DoorStatusSystem::doDoorStatusCheck(RoomLoadSystem& loadSys, std::function<void (DoorStatusEvent)> eventCallback) {
-  bool doorReading = digitalRead(magSwitchPin);
+void DoorStatusSystem::doDoorStatusCheck(RoomLoadSystem& loadSys, DoorStatusEventBus& eventBus) {
+  InputEdge edge;
+  magSwitch.update(edge);
 
-  // Check if sensor value is below threshold to indicate door is opened
-  if (doorOpen != doorReading && (millis() - lastDoorEventTime >= DoorEventInterval)) {
-    doorOpen = doorReading;
+  //Also takes over the level the switch had at start up
+  if(doorOpen != magSwitch.getLevel()) {
+    doorOpen = magSwitch.getLevel();
     if(doorOpen) {
       Serial.println("Door state change event: opened");
-      eventCallback(DoorStatusEvent::doorOpened); //Register the event
+      eventBus.publish(DoorStatusEvent::doorOpened, millis()); //Register the event
 
       if(!loadSys.isRoomFull()) {
         setStatusLEDs(true);
       }
 
       //acoustic signal
-      doDoorStateChangedAcousticSignal();
+      signals.play(SignalChannel::buzzer, doorOpenedSignal);
     }
     else {
       Serial.println("Door state change event: closed");
-      eventCallback(DoorStatusEvent::doorClosed); //Register the event
+      eventBus.publish(DoorStatusEvent::doorClosed, millis()); //Register the event
 
       if(loadSys.getPersonCount() > 0) {
         Serial.println("Alert: There are still persons in the room!");
-        eventCallback(DoorStatusEvent::PersonsInRoom); //Register the event
+        eventBus.publish(DoorStatusEvent::PersonsInRoom, millis()); //Register the event
       }
 
       setStatusLEDs(false);
-      doDoorStateChangedAcousticSignal();
+      signals.play(SignalChannel::buzzer, doorClosedSignal);
     }
-    // Update the time of the last door event
-    lastDoorEventTime = millis();
   }
 }
-
-/**
- * Performs an acoustic signalling for door state change events.
- */
-void DoorStatusSystem::doDoorStateChangedAcousticSignal() const {
-  tone(buzzerPin, 100);
-  delay(1000);
-  noTone(buzzerPin);
-}
\ No newline at end of file
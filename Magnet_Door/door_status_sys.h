@@ -6,12 +6,22 @@
 //===========================================================
 // included dependencies
 #include <cstdint>
-#include <functional>
+#include <atomic>
+#include "event_bus.h"
+#include "input_filter.h"
+#include "signal_sequencer.h"
 
 //===========================================================
 // forward declared dependencies
 class RoomLoadSystem;
 
+//===========================================================
+// Definitions
+#define DOOR_STATUS_EVENT_QUEUE_SIZE 8      //< Number of door status events which can be queued.
+#define DOOR_STATUS_EVENT_SUBSCRIBERS 4     //< Maximum number of door status event subscribers.
+#define MAG_SWITCH_SAMPLE_PERIOD 5000       //< Time between two samples of the magnetic switch in micro seconds.
+#define MAG_SWITCH_DEBOUNCE_SAMPLES 4       //< Number of samples the magnetic switch needs to settle, so it settles within 20 ms.
+
 //===========================================================
 // Data Types
 
@@ -21,27 +31,24 @@ class RoomLoadSystem;
 enum DoorStatusEvent: uint8_t {
   doorOpened,                //< If the door was opened.
   doorClosed,                //< If the door was closed.
-  PersonsInRoom              //< If the door was closed, but there were still persons in the room.
+  PersonsInRoom,             //< If the door was closed, but there were still persons in the room.
+  doorStatusEventCount       //< Number of door status events. Has to stay the last entry.
 };
 
+/**
+ * The event bus door status events are published to.
+ */
+typedef EventBus<DoorStatusEvent, DOOR_STATUS_EVENT_QUEUE_SIZE, DOOR_STATUS_EVENT_SUBSCRIBERS> DoorStatusEventBus;
+
 /**
  * Manages the door state by providing methods to detect door state change events and
  * signalling of those via status LEDs and sound through a buzzer.
+ * The LEDs and the buzzer are driven by the signal sequencer, so signalling does not block.
  */
 class DoorStatusSystem {
   private:
-    unsigned long lastDoorEventTime = 0;          //< For registering last time a door event happened.
-    const unsigned long DoorEventInterval = 1000; //< The time interval between two door events can happen in milli seconds.
-    bool doorOpen = false;                        //< Current door state
-    const uint8_t openLEDPin;                     //< The door open status LED pin.
-    const uint8_t closedLEDPin;                   //< The door closed status LED pin.
-    const uint8_t magSwitchPin;                   //< The magnatic switch pin.
-    const uint8_t buzzerPin;                      //< The buzzer pin.
-
-    /**
-     * Performs an acoustic signalling for door state change events.
-     */
-    void doDoorStateChangedAcousticSignal() const;
+    std::atomic<bool> doorOpen{false};            //< Current door state. Read by the detector task.
+    DigitalInput magSwitch;                       //< The debounced magnatic switch.
 
   public:
     /**
@@ -65,15 +72,15 @@ class DoorStatusSystem {
     bool isDoorOpen() const;
 
     /**
-     * Determines the current door state by reading the magnatic switch input
+     * Determines the current door state by reading the debounced magnatic switch input
      * and registeres door state change events. Updates status LEDs accordingly 
-     * and performs acoustic signalling on door state change events.
+     * and queues acoustic signals on door state change events.
      * Also checks if persons are still in the room if the door was closed.
-     * Calls the callback on door closed and door opened events.
+     * Publishes door closed, door opened and persons in room events.
      * @param passSys A reference to the door passing system.
-     * @param eventCallback A callback which will be called if a door status event was registered.
+     * @param eventBus The event bus registered door status events are published to.
      */
-    void doDoorStatusCheck(RoomLoadSystem& loadSys, std::function<void (DoorStatusEvent)> eventCallback);
+    void doDoorStatusCheck(RoomLoadSystem& loadSys, DoorStatusEventBus& eventBus);
 
     /**
     * Sets the state of the door status LEDs to signal if someone can enter or not.
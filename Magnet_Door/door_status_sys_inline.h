@@ -21,7 +21,6 @@ inline bool DoorStatusSystem::isDoorOpen() const {
  * @param ent If entering is allowed or not.
  */
 inline void DoorStatusSystem::setStatusLEDs(bool ent) const {
-  //The logic of the LEDs is inverted
-  digitalWrite(closedLEDPin, ent);
-  digitalWrite(openLEDPin, !ent);
+  signals.setIdle(SignalChannel::openLED, ent);
+  signals.setIdle(SignalChannel::closedLED, !ent);
 }
\ No newline at end of file
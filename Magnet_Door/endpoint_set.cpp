@@ -0,0 +1,263 @@
+/*************************************************************
+  The implementation of a list of web servers the telemetry can be sent to, ranked by latency and errors.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "endpoint_set.h"
+#include "wire_format.h"
+
+//===========================================================
+// Static data
+
+static const char* const endpointRoleNames[ENDPOINT_COUNT] = {"primary", "fallback 1", "fallback 2"};
+
+//===========================================================
+// Function implementations
+
+/**
+ * Gives host and port of a server url. The port defaults to the one of the scheme.
+ * @param url The url without the wire format.
+ * @param[out] host The host name.
+ * @param[out] port The port.
+ */
+void parseServerAddress(const String& url, String& host, uint16_t& port) {
+  int hostStart = url.indexOf("://");
+  hostStart = (hostStart < 0)? 0 : hostStart + 3;
+  int hostEnd = url.indexOf("/", hostStart);
+  int queryStart = url.indexOf("?", hostStart);
+  if(queryStart >= 0 && (hostEnd < 0 || queryStart < hostEnd)) {
+    hostEnd = queryStart;
+  }
+  host = (hostEnd < 0)? url.substring(hostStart) : url.substring(hostStart, hostEnd);
+  port = url.startsWith("https")? 443 : url.startsWith("mqtt")? 1883 : 80;
+  int portStart = host.indexOf(":");
+  if(portStart >= 0) {
+    port = host.substring(portStart + 1).toInt();
+    host = host.substring(0, portStart);
+  }
+}
+
+//===========================================================
+// Member function implementations
+
+/**
+ * Sets the url of an endpoint and forgets its measurements.
+ * Not to be called by more than one task.
+ * @param index The index of the endpoint. 0 is the primary server.
+ * @param url The url. The wire format may be appended. An empty url removes the endpoint.
+ * @return
+ *  -true: On success.
+ *  -false: If the host name is too long. The endpoint is not surveyed then.
+ */
+bool EndpointSet::setUrl(uint8_t index, const String& url) {
+  urls[index] = url;
+  String target;
+  WireFormat format;
+  splitServerUrl(url, target, format);
+  String host;
+  uint16_t port;
+  parseServerAddress(target, host, port);
+  bool fits = host.length() < ENDPOINT_HOST_MAX_LENGTH;
+
+  Target next;
+  strcpy(next.host, fits? host.c_str() : "");
+  next.port = port;
+  Score& score = scores[index];
+  portENTER_CRITICAL(&targetLock);
+  targets[index] = next;
+  //The measurements of the former url say nothing about the new one
+  score.address = 0;
+  score.resolvedAt = 0;
+  score.roundTrip = 0;
+  score.failureRate = 0;
+  score.failuresInRow = 0;
+  score.probes = 0;
+  score.failures = 0;
+  portEXIT_CRITICAL(&targetLock);
+  requestSurvey();
+  return fits;
+}
+
+/**
+ * Checks whether an endpoint can be selected.
+ * @param index The index of the endpoint.
+ * @return
+ *  -true: If it is configured, was reached and did not fail ENDPOINT_FAILURE_LIMIT times in a row.
+ *  -false: otherwise.
+ */
+bool EndpointSet::isHealthy(uint8_t index) const {
+  return !urls[index].isEmpty() && scores[index].roundTrip != 0 &&
+         scores[index].failuresInRow < ENDPOINT_FAILURE_LIMIT;
+}
+
+/**
+ * Gives the score of an endpoint. Lower is better.
+ * @param index The index of the endpoint.
+ * @return The score in micro seconds.
+ */
+uint32_t EndpointSet::getScore(uint8_t index) const {
+  return scores[index].roundTrip + scores[index].failureRate * (uint32_t)ENDPOINT_ERROR_PENALTY;
+}
+
+/**
+ * Makes the best healthy endpoint the active one.
+ * Falls back to the first configured endpoint if the active one is not configured anymore.
+ * @return
+ *  -true: If the active endpoint changed.
+ *  -false: otherwise.
+ */
+bool EndpointSet::select() {
+  uint8_t best = active;
+  if(urls[active].isEmpty()) {
+    best = 0;
+    for(uint8_t i = 0; i < ENDPOINT_COUNT; i++) {
+      if(!urls[i].isEmpty()) {
+        best = i;
+        break;
+      }
+    }
+  }
+  bool keep = isHealthy(best);
+  uint64_t bestScore = keep? getScore(best) : UINT64_MAX;
+  for(uint8_t i = 0; i < ENDPOINT_COUNT; i++) {
+    if(i == best || !isHealthy(i)) {
+      continue;
+    }
+    uint64_t score = getScore(i);
+    //A healthy active endpoint is only replaced by a clearly better one
+    bool better = keep? score * 100 < bestScore * (100 - ENDPOINT_SWITCH_MARGIN) : score < bestScore;
+    if(better) {
+      best = i;
+      bestScore = score;
+      keep = false;
+    }
+  }
+  if(best == active) {
+    return false;
+  }
+  active = best;
+  return true;
+}
+
+/**
+ * Adds the outcome of a probe or send to the measurements of an endpoint.
+ * Called by the sending and the survey task, so it takes targetLock.
+ * @param index The index of the endpoint.
+ * @param success If the probe or send succeeded.
+ * @param roundTrip Time of the TCP connect of a successful probe in micro seconds. 0 if not measured.
+ */
+void EndpointSet::recordOutcome(uint8_t index, bool success, uint32_t roundTrip) {
+  Score& score = scores[index];
+  portENTER_CRITICAL(&targetLock);
+  if(roundTrip != 0) {
+    uint32_t former = score.roundTrip;
+    score.roundTrip = (former == 0)? roundTrip :
+                      (former * (ENDPOINT_RTT_SMOOTHING - 1) + roundTrip) / ENDPOINT_RTT_SMOOTHING;
+  }
+  score.probes++;
+  uint8_t sample = success? 0 : 100;
+  score.failureRate = (score.failureRate * (ENDPOINT_RTT_SMOOTHING - 1) + sample) / ENDPOINT_RTT_SMOOTHING;
+  if(success) {
+    score.failuresInRow = 0;
+  }
+  else {
+    score.failures++;
+    if(score.failuresInRow < UINT8_MAX) {
+      score.failuresInRow++;
+    }
+  }
+  portEXIT_CRITICAL(&targetLock);
+}
+
+/**
+ * Records the outcome of a send to an endpoint.
+ * @param index The index of the endpoint.
+ * @param success If the send succeeded.
+ */
+void EndpointSet::recordSend(uint8_t index, bool success) {
+  recordOutcome(index, success);
+  if(!success) {
+    requestSurvey(); //Find out soon whether another endpoint does better
+  }
+}
+
+/**
+ * Checks whether a survey is requested or ENDPOINT_SURVEY_PERIOD is over.
+ * @return
+ *  -true: If due.
+ *  -false: otherwise.
+ */
+bool EndpointSet::isSurveyDue() const {
+  return surveyRequest || millis() - lastSurvey >= ENDPOINT_SURVEY_PERIOD;
+}
+
+/**
+ * Resolves the hosts whose address expired and measures the TCP connect to each endpoint.
+ * Blocks for up to ENDPOINT_PROBE_TIMEOUT per endpoint plus the DNS lookups, so it is done by a background task.
+ * @param client The client used for the probes.
+ */
+void EndpointSet::survey(WiFiClient& client) {
+  surveyRequest = false;
+  lastSurvey = millis();
+  for(uint8_t i = 0; i < ENDPOINT_COUNT; i++) {
+    portENTER_CRITICAL(&targetLock);
+    Target target = targets[i];
+    portEXIT_CRITICAL(&targetLock);
+    if(target.host[0] == '\0') {
+      continue;
+    }
+    Score& score = scores[i];
+
+    //Resolve the host again once the address expired. A stale address is better than none.
+    if(score.address == 0 || millis() - score.resolvedAt >= ENDPOINT_DNS_TTL) {
+      IPAddress resolved;
+      if(WiFi.hostByName(target.host, resolved) == 1 && (uint32_t)resolved != 0) {
+        portENTER_CRITICAL(&targetLock);
+        if(strcmp(targets[i].host, target.host) == 0) { //The url may have changed during the lookup
+          score.address = (uint32_t)resolved;
+          score.resolvedAt = millis();
+        }
+        portEXIT_CRITICAL(&targetLock);
+      }
+    }
+    if(score.address == 0) {
+      recordOutcome(i, false);
+      continue;
+    }
+
+    uint32_t start = micros();
+    bool reachable = client.connect(IPAddress((uint32_t)score.address), target.port, ENDPOINT_PROBE_TIMEOUT);
+    uint32_t roundTrip = micros() - start;
+    client.stop();
+    recordOutcome(i, reachable, reachable? roundTrip : 0);
+  }
+}
+
+/**
+ * Prints the endpoints with their measurements over serial.
+ */
+void EndpointSet::printEndpoints() const {
+  Serial.println("-----------Endpoints-----------");
+  uint32_t now = millis();
+  for(uint8_t i = 0; i < ENDPOINT_COUNT; i++) {
+    Serial.printf(" >> %c %-10s %s\n", (i == active)? '*' : ' ', endpointRoleNames[i],
+                  urls[i].isEmpty()? "none" : urls[i].c_str());
+    if(urls[i].isEmpty()) {
+      continue;
+    }
+    const Score& score = scores[i];
+    if(score.address != 0) {
+      Serial.printf("    address %s, resolved %lu s ago\n", IPAddress((uint32_t)score.address).toString().c_str(),
+                    (unsigned long)(now - score.resolvedAt) / 1000);
+    }
+    else {
+      Serial.println("    address not resolved");
+    }
+    Serial.printf("    rtt %lu us, failed %lu of %lu (%u %%), score %lu, %s\n",
+                  (unsigned long)score.roundTrip, (unsigned long)score.failures, (unsigned long)score.probes,
+                  score.failureRate.load(), (unsigned long)getScore(i), isHealthy(i)? "healthy" : "down");
+  }
+  Serial.printf(" >> Last survey %lu s ago\n", (unsigned long)(now - lastSurvey) / 1000);
+  Serial.println("-------------------------------");
+}
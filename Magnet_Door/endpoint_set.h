@@ -0,0 +1,172 @@
+#pragma once
+/*************************************************************
+  A list of web servers the telemetry can be sent to, ranked by latency and errors.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include <WiFi.h>
+#include <WiFiClient.h>
+#include <atomic>
+
+//===========================================================
+// Definitions
+#define ENDPOINT_COUNT 3                  //< Number of endpoints. The primary server and its fallbacks.
+#define ENDPOINT_HOST_MAX_LENGTH 128      //< Maximum length of a host name including the terminator.
+#define ENDPOINT_SURVEY_PERIOD 60000      //< Time between two surveys of all endpoints in milli seconds.
+#define ENDPOINT_PROBE_TIMEOUT 500        //< Timeout of the TCP connect to an endpoint in milli seconds.
+#define ENDPOINT_DNS_TTL 300000           //< Time a resolved address is used until it is resolved again in milli seconds.
+#define ENDPOINT_FAILURE_LIMIT 2          //< Number of failures in a row which take an endpoint out of the selection.
+#define ENDPOINT_RTT_SMOOTHING 8          //< Weight of the former round trip time against a new sample.
+#define ENDPOINT_ERROR_PENALTY 10000      //< Added to the score per percent of failures in micro seconds.
+#define ENDPOINT_SWITCH_MARGIN 20         //< Percentage an endpoint has to be better than the active one to replace it.
+
+//===========================================================
+// Data Types
+
+/**
+ * The web servers the telemetry can be sent to. The first one is the primary server, the others are fallbacks.
+ * A survey in the background resolves the host names and measures the time of a TCP connect to each endpoint.
+ * The survey keeps the addresses for its probes for ENDPOINT_DNS_TTL. The sends resolve the host name
+ * themselves, since TLS checks the certificate against it. The sends to the active endpoint add their success.
+ * The score of an endpoint is its smoothed round trip time plus a penalty for its smoothed failure rate.
+ * select() makes the healthy endpoint with the lowest score the active one. The active endpoint is only
+ * replaced by a healthy one if that scores ENDPOINT_SWITCH_MARGIN percent better, or if it fails itself.
+ * The urls are set by one task, the survey is done by another one.
+ */
+class EndpointSet {
+  private:
+    /**
+     * Host and port of an endpoint.
+     */
+    struct Target {
+      char host[ENDPOINT_HOST_MAX_LENGTH] = "";  //< The host name. Empty if the endpoint is not configured.
+      uint16_t port = 80;                        //< The port.
+    };
+
+    /**
+     * The measurements of an endpoint.
+     */
+    struct Score {
+      std::atomic<uint32_t> address{0};         //< The address of the host the survey probes. 0 if not resolved.
+      std::atomic<uint32_t> resolvedAt{0};      //< Time the host was resolved in milli seconds.
+      std::atomic<uint32_t> roundTrip{0};       //< Smoothed time of a TCP connect in micro seconds. 0 if not measured yet.
+      std::atomic<uint8_t> failureRate{0};      //< Smoothed share of failed probes and sends in percent.
+      std::atomic<uint8_t> failuresInRow{0};    //< Number of failed probes and sends in a row.
+      std::atomic<uint32_t> probes{0};          //< Number of probes and sends.
+      std::atomic<uint32_t> failures{0};        //< Number of failed probes and sends.
+    };
+
+    String urls[ENDPOINT_COUNT];                //< The configured urls. Empty if not configured.
+    Target targets[ENDPOINT_COUNT];             //< The surveyed hosts. Guarded by targetLock.
+    portMUX_TYPE targetLock = portMUX_INITIALIZER_UNLOCKED; //< Guards targets and the updates of scores, which are done by different tasks.
+    Score scores[ENDPOINT_COUNT];               //< The measurements per endpoint. Read without lock, updated under targetLock.
+    uint8_t active = 0;                         //< Index of the active endpoint.
+    std::atomic<bool> surveyRequest{true};      //< If a survey was requested.
+    std::atomic<uint32_t> lastSurvey{0};        //< Time of the last survey in milli seconds.
+
+    /**
+     * Adds the outcome of a probe or send to the measurements of an endpoint.
+     * Called by the sending and the survey task, so it takes targetLock.
+     * @param index The index of the endpoint.
+     * @param success If the probe or send succeeded.
+     * @param roundTrip Time of the TCP connect of a successful probe in micro seconds. 0 if not measured.
+     */
+    void recordOutcome(uint8_t index, bool success, uint32_t roundTrip = 0);
+
+    /**
+     * Checks whether an endpoint can be selected.
+     * @param index The index of the endpoint.
+     * @return
+     *  -true: If it is configured, was reached and did not fail ENDPOINT_FAILURE_LIMIT times in a row.
+     *  -false: otherwise.
+     */
+    bool isHealthy(uint8_t index) const;
+
+    /**
+     * Gives the score of an endpoint. Lower is better.
+     * @param index The index of the endpoint.
+     * @return The score in micro seconds.
+     */
+    uint32_t getScore(uint8_t index) const;
+
+  public:
+    /**
+     * Sets the url of an endpoint and forgets its measurements.
+     * Not to be called by more than one task.
+     * @param index The index of the endpoint. 0 is the primary server.
+     * @param url The url. The wire format may be appended. An empty url removes the endpoint.
+     * @return
+     *  -true: On success.
+     *  -false: If the host name is too long. The endpoint is not surveyed then.
+     */
+    bool setUrl(uint8_t index, const String& url);
+
+    /**
+     * Gives the url of an endpoint.
+     * @param index The index of the endpoint. 0 is the primary server.
+     * @return The url. Empty if not configured.
+     */
+    const String& getUrl(uint8_t index) const;
+
+    /**
+     * Gives the index of the active endpoint.
+     * @return The index.
+     */
+    uint8_t getActive() const;
+
+    /**
+     * Makes the best healthy endpoint the active one.
+     * Falls back to the first configured endpoint if the active one is not configured anymore.
+     * @return
+     *  -true: If the active endpoint changed.
+     *  -false: otherwise.
+     */
+    bool select();
+
+    /**
+     * Records the outcome of a send to an endpoint.
+     * @param index The index of the endpoint.
+     * @param success If the send succeeded.
+     */
+    void recordSend(uint8_t index, bool success);
+
+    /**
+     * Requests a survey as soon as possible, e.g. after a failed send.
+     */
+    void requestSurvey();
+
+    /**
+     * Checks whether a survey is requested or ENDPOINT_SURVEY_PERIOD is over.
+     * @return
+     *  -true: If due.
+     *  -false: otherwise.
+     */
+    bool isSurveyDue() const;
+
+    /**
+     * Resolves the hosts whose address expired and measures the TCP connect to each endpoint.
+     * Blocks for up to ENDPOINT_PROBE_TIMEOUT per endpoint plus the DNS lookups, so it is done by a background task.
+     * @param client The client used for the probes.
+     */
+    void survey(WiFiClient& client);
+
+    /**
+     * Prints the endpoints with their measurements over serial.
+     */
+    void printEndpoints() const;
+};
+
+//===========================================================
+// Function Declarations
+
+/**
+ * Gives host and port of a server url. The port defaults to the one of the scheme.
+ * @param url The url without the wire format.
+ * @param[out] host The host name.
+ * @param[out] port The port.
+ */
+void parseServerAddress(const String& url, String& host, uint16_t& port);
+
+#include "endpoint_set_inline.h"
@@ -0,0 +1,30 @@
+//===========================================================
+// included dependencies
+#include "endpoint_set.h"
+
+//===========================================================
+// Inline member function implementations
+
+/**
+ * Gives the url of an endpoint.
+ * @param index The index of the endpoint. 0 is the primary server.
+ * @return The url. Empty if not configured.
+ */
+inline const String& EndpointSet::getUrl(uint8_t index) const {
+  return urls[index];
+}
+
+/**
+ * Gives the index of the active endpoint.
+ * @return The index.
+ */
+inline uint8_t EndpointSet::getActive() const {
+  return active;
+}
+
+/**
+ * Requests a survey as soon as possible, e.g. after a failed send.
+ */
+inline void EndpointSet::requestSurvey() {
+  surveyRequest = true;
+}
@@ -8,7 +8,8 @@
 #include "persistence.h"
 #include "commands.h"
 #include "serial_access.h"
-#include <ArduinoJson.h>
+#include "loop_profiler.h"
+#include "signal_sequencer.h"
 
 //===========================================================
 // Data Types
@@ -22,45 +23,113 @@ enum class EntranceControlState: uint8_t {
   reconnect         //< Connection lost. Communication System tries to reconnect.
 };
 
+/**
+ * Represents the steps of a WiFi configuration over serial terminal.
+ */
+enum class WifiDialogState: uint8_t {
+  idle,             //< No configuration running. Inputted lines are commands.
+  ssid,             //< Waiting for the SSID.
+  pass              //< Waiting for the password.
+};
+
+
+//===========================================================
+// Static data
+
+/**
+ * The names of the door status events in the order of DoorStatusEvent.
+ */
+static const char* const doorStatusEventNames[] = {
+  "door_opened",
+  "door_closed",
+  "persons_in_room"
+};
+static_assert(sizeof(doorStatusEventNames) / sizeof(doorStatusEventNames[0]) == doorStatusEventCount,
+              "Every door status event needs a name.");
+
+/**
+ * The names of the room load events in the order of RoomLoadEvent.
+ */
+static const char* const roomLoadEventNames[] = {
+  "room_full",
+  "room_not_full",
+  "person_entered",
+  "person_left"
+};
+static_assert(sizeof(roomLoadEventNames) / sizeof(roomLoadEventNames[0]) == static_cast<uint8_t>(RoomLoadEvent::count),
+              "Every room load event needs a name.");
 
 //===========================================================
 // Static function implementations
 
 /**
- * Handler for room load events.
+ * Handler for room load events. Queues the notification as alert.
  * @param e The event to be handled.
- * @param commSys Reference to the communication system.
+ * @param timestamp Time of the event in milli seconds.
+ * @param outbound Reference to the outbound scheduler.
  */
-inline static void roomLoadEventHandler(RoomLoadEvent e, CommunicationSystem& commSys) {
+inline static void roomLoadEventHandler(RoomLoadEvent e, uint32_t timestamp, OutboundScheduler& outbound) {
     switch(e) {
     case RoomLoadEvent::roomFull:
-      commSys.logEvent("room_full", "Alert: Room is full now.");
+      outbound.pushAlert(AlertType::roomLoad, "room_full", "Alert: Room is full now.", timestamp);
       break;
     case RoomLoadEvent::roomNotFull:
-      commSys.logEvent("room_not_full", "Info: Room is no longer full.");
+      outbound.pushAlert(AlertType::roomLoad, "room_not_full", "Info: Room is no longer full.", timestamp);
+      break;
+    case RoomLoadEvent::personEntered:
+    case RoomLoadEvent::personLeft:
+    default:
       break;
     }
 }
 
 /**
- * Handler for door status events.
+ * Handler for door status events. Queues the notification as alert.
  * @param e The event to be handled.
- * @param commSys Reference to the communication system.
+ * @param timestamp Time of the event in milli seconds.
+ * @param outbound Reference to the outbound scheduler.
  */
-inline static void doorStatusEventHandler(DoorStatusEvent e, CommunicationSystem& commSys) {
+inline static void doorStatusEventHandler(DoorStatusEvent e, uint32_t timestamp, OutboundScheduler& outbound) {
   switch(e) {
     case DoorStatusEvent::doorClosed:
-      commSys.logEvent("door_closed", "Info: Room was closed.");
+      outbound.pushAlert(AlertType::door, "door_closed", "Info: Room was closed.", timestamp);
       break;
     case DoorStatusEvent::doorOpened:
-      commSys.logEvent("door_opened", "Info: You can come in.");
+      outbound.pushAlert(AlertType::door, "door_opened", "Info: You can come in.", timestamp);
       break;
     case DoorStatusEvent::PersonsInRoom:
-      commSys.logEvent("persons_in_room", "Alert: There are still persons in the room!");
+      outbound.pushAlert(AlertType::personsInRoom, "persons_in_room", "Alert: There are still persons in the room!", timestamp);
+      break;
+    default:
       break;
   }
 }
 
+/**
+ * Prints why connecting to WiFi and server failed.
+ * @param status The connection status connecting ended with.
+ */
+static void printConnectFailure(ConnectionStatus status) {
+  switch(status) {
+    case ConnectionStatus::connectionTimeout:
+      Serial.println("Alert: Connection to server failed.");
+      break;
+    case ConnectionStatus::noSSIDAvail:
+      Serial.println("Alert: Connection to WiFi failed.");
+      Serial.println("  >> Reason: SSID not available.");
+      break;
+    case ConnectionStatus::wifiAuthFailed:
+      Serial.println("Alert: Connection to WiFi failed.");
+      Serial.println("  >> Reason: Authentication failed.");
+      break;
+    default:
+      Serial.println("Alert: Connection to WiFi failed.");
+      Serial.println("  >> Reason: Unknown.");
+      break;
+  }
+  Serial.println("  >> Result: Falling back to offline mode.");
+}
+
 //===========================================================
 // Member function implementations
 
@@ -72,8 +141,8 @@ inline static void doorStatusEventHandler(DoorStatusEvent e, CommunicationSystem
  * @param closedLEDPin The door closed status LED pin.
  * @param magSwitchPin The magnatic switch pin.
  * @param buzzerPin The buzzer pin.
- * @param outerDetPin The outer detector pin.
- * @param innerDetPin The inner detector pin.
+ * @param detLanes The detector pins of each lane.
+ * @param detLaneCount The number of lanes.
  */
 EntranceControlSystem::EntranceControlSystem( CommunicationSystem& commSys,
                                               uint8_t termPin,
@@ -81,14 +150,50 @@ EntranceControlSystem::EntranceControlSystem( CommunicationSystem& commSys,
                                               uint8_t closedLEDPin, 
                                               uint8_t magSwitchPin, 
                                               uint8_t buzzerPin,
-                                              uint8_t outerDetPin, 
-                                              uint8_t innerDetPin): state(EntranceControlState::offline),
+                                              const DetectorPins* detLanes,
+                                              uint8_t detLaneCount): state(EntranceControlState::offline),
+                                                                    wifiDialog(WifiDialogState::idle),
                                                                     termPin(termPin),
                                                                     commSys(commSys),
                                                                     doorSys(openLEDPin, closedLEDPin, magSwitchPin, buzzerPin),
-                                                                    roomLoadSys(outerDetPin, innerDetPin) {
+                                                                    roomLoadSys(detLanes, detLaneCount) {
   initMemory();
-  pinMode(termPin, INPUT);                       
+  pinMode(termPin, INPUT);
+  setupEventSubscribers();
+  setupTasks();
+  if(!telemetryLog.begin()) {
+    Serial.println("Error: Failed to start the telemetry log task!");
+  }
+}
+
+/**
+ * Registers the periodic tasks of the system in the scheduler.
+ * Performing processing of commands, doing door status and passing checks,
+ * temperature measurements, data logging and communication tasks each with its own period.
+ */
+void EntranceControlSystem::setupTasks() {
+  //Period and deadline are given in micro seconds. Higher priorities are dispatched first.
+  scheduler.addTask("events",
+                    [](void* sys) { static_cast<EntranceControlSystem*>(sys)->doEventDispatch(); },
+                    this, EVENT_TASK_PERIOD, EVENT_TASK_PERIOD, 5);
+  scheduler.addTask("door",
+                    [](void* sys) { static_cast<EntranceControlSystem*>(sys)->doDoorCheck(); },
+                    this, DOOR_TASK_PERIOD, DOOR_TASK_PERIOD / 2, 4);
+  scheduler.addTask("network",
+                    [](void* sys) { static_cast<EntranceControlSystem*>(sys)->doCommunication(); },
+                    this, NETWORK_TASK_PERIOD, NETWORK_TASK_PERIOD, 3);
+  scheduler.addTask("console",
+                    [](void* sys) { static_cast<EntranceControlSystem*>(sys)->processCommand(); },
+                    this, CONSOLE_TASK_PERIOD, CONSOLE_TASK_PERIOD, 2);
+  scheduler.addTask("temperature",
+                    [](void* sys) { static_cast<EntranceControlSystem*>(sys)->doTemperatureCheck(); },
+                    this, TEMPERATURE_TASK_PERIOD, TEMPERATURE_TASK_PERIOD, 1);
+  scheduler.addTask("telemetry",
+                    [](void* sys) { static_cast<EntranceControlSystem*>(sys)->logData(); },
+                    this, dataLogInterval * 1000, dataLogInterval * 1000, 1);
+  scheduler.addTask("sender",
+                    [](void* sys) { static_cast<EntranceControlSystem*>(sys)->doSending(); },
+                    this, SENDER_TASK_PERIOD, SENDER_TASK_PERIOD, 0);
 }
 
 /**
@@ -108,22 +213,36 @@ void EntranceControlSystem::activateVerboseMessaging(bool val) {
 }
 
 /**
- * Executes the system state machine.
+ * Executes the next due task of the system.
+ * Sleeps until the next task is due if there is nothing to do.
  */
 void EntranceControlSystem::run() {
+  scheduler.run();
+}
+
+/**
+ * Executes the communication system and determines the next state of the system FSM.
+ */
+void EntranceControlSystem::doCommunication() {
   //Determine next state of the system FSM
   switch(state) {
     case EntranceControlState::offline: {
-      doMainRoutine();
       ConnectionStatus status = commSys.run();
       switch(status) {
         case ConnectionStatus::connectionRequest:
           doConnect();
           break;
         case ConnectionStatus::connected:
+          Serial.println(" >> Connection established.");
           Serial.println("-----------Going online-----------");
           state = EntranceControlState::online;
           break;
+        case ConnectionStatus::connectionTimeout:
+        case ConnectionStatus::noSSIDAvail:
+        case ConnectionStatus::wifiAuthFailed:
+        case ConnectionStatus::wifiFailed:
+          printConnectFailure(status);
+          break;
         case ConnectionStatus::connectionLost:
           Serial.println("-----------Going online-----------");
           Serial.println(" >> Info: Connection lost! Try to reconnect.");
@@ -133,7 +252,6 @@ void EntranceControlSystem::run() {
       break;
     }
     case EntranceControlState::online: {
-      doMainRoutine();
       ConnectionStatus status = commSys.run();
       switch(status) {
         case ConnectionStatus::connectionTimeout:
@@ -153,14 +271,8 @@ void EntranceControlSystem::run() {
       break;
     }
     case EntranceControlState::reconnect: {
-      doMainRoutine();
       ConnectionStatus status = commSys.run();
       switch(status) {
-        case ConnectionStatus::connectionTimeout:
-          Serial.println("Alert: Connection Timout. Falling back to offline mode.");
-          Serial.println("-----------Going offline-----------");
-          state = EntranceControlState::offline;
-          break;
         case ConnectionStatus::connected:
           Serial.println("Info: Connection reestablished.");
           Serial.println("-----------Back online-----------");
@@ -187,35 +299,12 @@ bool EntranceControlSystem::isOnline() const {
 }
 
 /**
- * Tells the communication system to connect WiFi and server.
+ * Tells the communication system to start connecting WiFi and server.
  */
 void EntranceControlSystem::doConnect() const {
   if(!wifiCred.ssid.isEmpty()) {
     Serial.println("-----------Connecting to WiFi and Server-----------");
-    ConnectionStatus connStatus = commSys.connect(wifiCred);
-    switch(connStatus) {
-      case ConnectionStatus::connected:
-        //Successfully connected
-        Serial.println(" >> Connection established.");
-        return;
-      case ConnectionStatus::connectionTimeout:
-        Serial.println("Alert: Connection to server failed.");
-        break;
-      case ConnectionStatus::noSSIDAvail:
-        Serial.println("Alert: Connection to WiFi failed.");
-        Serial.println("  >> Reason: SSID not available.");
-        break;
-      case ConnectionStatus::wifiAuthFailed:
-        Serial.println("Alert: Connection to WiFi failed.");
-        Serial.println("  >> Reason: Authentication failed.");
-        break;
-      default:
-        Serial.println("Alert: Connection to WiFi failed.");
-        Serial.println("  >> Reason: Unknown.");
-        break;
-    }
-  //Connecting failed
-  Serial.println("  >> Result: Falling back to offline mode.");
+    commSys.connect(wifiCred); //Established in the background by the communication system
   }
   else {
     Serial.println("Error: Connecting failed.");
@@ -232,20 +321,194 @@ void EntranceControlSystem::doDisconnect() const {
 }
 
 /**
- * The main routine of the entrance control system.
- * Performing processing of commands, doing door status and passing checks
- * and doing communication tasks using the communication system.
- * @param online If set to true, will be in online mode.
+ * Determines the current door state and registers door status events.
  */
-void EntranceControlSystem::doMainRoutine() {
-  if(!processCommand()) { //Check if command is inputted and process it
-    //In case no command to process
-    doTemperatureCheck();
-    doorSys.doDoorStatusCheck(roomLoadSys, [this](DoorStatusEvent e) {doorStatusEventHandler(e, commSys);});
-    if(doorSys.isDoorOpen()) {
-      roomLoadSys.doDoorPassingCheck(doorSys, [this](RoomLoadEvent e) {roomLoadEventHandler(e, commSys);});
+void EntranceControlSystem::doDoorCheck() {
+  ProfileTimer timer(profiler, ProfilePoint::doorStatusCheck);
+  doorSys.doDoorStatusCheck(roomLoadSys, doorEvents);
+}
+
+/**
+ * Processes the captured detector edges.
+ * Runs in the detector task. Publishes room load events to the event bus.
+ */
+void EntranceControlSystem::doDetectorCheck() {
+  ProfileTimer timer(profiler, ProfilePoint::doorPassingCheck);
+  roomLoadSys.doDoorPassingCheck(doorSys, roomLoadEvents);
+}
+
+/**
+ * Starts the detector task pinned to its own core.
+ * The task processes the captured detector edges periodically independent of the main loop.
+ * Started by reset() once the config is loaded. Does nothing if the task is already running.
+ */
+void EntranceControlSystem::startDetectorTask() {
+  if(detectorTask) {
+    return;
+  }
+  BaseType_t created = xTaskCreatePinnedToCore(
+      [](void* sys) {
+        TickType_t lastWake = xTaskGetTickCount();
+        while(true) {
+          static_cast<EntranceControlSystem*>(sys)->doDetectorCheck();
+          xTaskDelayUntil(&lastWake, pdMS_TO_TICKS(DETECTOR_TASK_PERIOD / 1000));
+        }
+      },
+      "detectors",
+      DETECTOR_TASK_STACK_SIZE,
+      this,
+      DETECTOR_TASK_PRIORITY,
+      &detectorTask,
+      DETECTOR_TASK_CORE);
+  if(created != pdPASS) {
+    detectorTask = nullptr;
+    Serial.println("Error: Failed to start the detector task!");
+  }
+}
+
+/**
+ * Registers the subscribers of the door status and room load events.
+ * Events are queued as Blynk alerts, forwarded to the data logging, to the serial log, to the signals and status LEDs and to the statistics.
+ */
+void EntranceControlSystem::setupEventSubscribers() {
+  //Blynk alerts
+  doorEvents.subscribe([](const TimedEvent<DoorStatusEvent>& e, void* sys) {
+    doorStatusEventHandler(e.event, e.timestamp, static_cast<EntranceControlSystem*>(sys)->outbound);
+  }, this);
+  roomLoadEvents.subscribe([](const TimedEvent<RoomLoadUpdate>& e, void* sys) {
+    roomLoadEventHandler(e.event.event, e.timestamp, static_cast<EntranceControlSystem*>(sys)->outbound);
+  }, this);
+
+  //Data logging
+  doorEvents.subscribe([](const TimedEvent<DoorStatusEvent>& e, void* sys) {
+    EntranceControlSystem* entCtrlSys = static_cast<EntranceControlSystem*>(sys);
+    entCtrlSys->recordTelemetry({e.timestamp,
+                                 doorStatusEventNames[e.event],
+                                 entCtrlSys->doorSys.isDoorOpen(),
+                                 entCtrlSys->roomLoadSys.getPersonCount(),
+                                 entCtrlSys->roomLoadSys.isRoomFull(),
+                                 entCtrlSys->temperature,
+                                 entCtrlSys->telemetryMode});
+  }, this);
+  roomLoadEvents.subscribe([](const TimedEvent<RoomLoadUpdate>& e, void* sys) {
+    EntranceControlSystem* entCtrlSys = static_cast<EntranceControlSystem*>(sys);
+    entCtrlSys->recordTelemetry({e.timestamp,
+                                 roomLoadEventNames[static_cast<uint8_t>(e.event.event)],
+                                 entCtrlSys->doorSys.isDoorOpen(),
+                                 e.event.personCount,
+                                 entCtrlSys->roomLoadSys.isRoomFull(),
+                                 entCtrlSys->temperature,
+                                 entCtrlSys->telemetryMode});
+  }, this);
+
+  //Serial log
+  doorEvents.subscribe([](const TimedEvent<DoorStatusEvent>& e, void* sys) {
+    if(static_cast<EntranceControlSystem*>(sys)->verbose) {
+      Serial.printf("[EntrCtrl] Event %s at %lu ms\n",
+                    doorStatusEventNames[e.event], (unsigned long)e.timestamp);
+    }
+  }, this);
+  roomLoadEvents.subscribe([](const TimedEvent<RoomLoadUpdate>& e, void* sys) {
+    if(static_cast<EntranceControlSystem*>(sys)->verbose) {
+      Serial.printf("[EntrCtrl] Event %s at %lu ms: %u persons\n",
+                    roomLoadEventNames[static_cast<uint8_t>(e.event.event)],
+                    (unsigned long)e.timestamp,
+                    e.event.personCount);
+    }
+  }, this);
+
+  //Signalling
+  roomLoadEvents.subscribe([](const TimedEvent<RoomLoadUpdate>& e, void* sys) {
+    if(e.event.event == RoomLoadEvent::roomFull) {
+      static_cast<EntranceControlSystem*>(sys)->doorSys.setStatusLEDs(false);
+      signals.play(SignalChannel::buzzer, roomFullSignal);
+      signals.play(SignalChannel::closedLED, roomFullSignal);
+    }
+    else if(e.event.event == RoomLoadEvent::roomNotFull) {
+      static_cast<EntranceControlSystem*>(sys)->doorSys.setStatusLEDs(true);
     }
-    logData();
+  }, this);
+
+  //Statistics
+  doorEvents.subscribe([](const TimedEvent<DoorStatusEvent>& e, void* sys) {
+    static_cast<EntranceControlSystem*>(sys)->doorEventCounts[e.event]++;
+  }, this);
+  roomLoadEvents.subscribe([](const TimedEvent<RoomLoadUpdate>& e, void* sys) {
+    static_cast<EntranceControlSystem*>(sys)->roomLoadEventCounts[static_cast<uint8_t>(e.event.event)]++;
+  }, this);
+}
+
+/**
+ * Prints the log of the passing check and dispatches all queued door status and room load events to their subscribers.
+ * The subscribers only queue alerts and records, nothing is sent here.
+ */
+void EntranceControlSystem::doEventDispatch() {
+  roomLoadSys.printLog(); //The detector task does not print itself
+  doorEvents.drain();
+  roomLoadEvents.drain();
+}
+
+/**
+ * Sends the outbound traffic. Alerts go first, bulk data only if no alert can be sent.
+ * Runs as the task with the lowest priority, so waiting for the server never holds back
+ * the door checks and the event dispatching once they are released.
+ */
+void EntranceControlSystem::doSending() {
+  sendAlerts();
+  bool telemetryDue = isTelemetryDue(millis());
+  //Alerts wait in the queue while they cannot be sent. The telemetry goes its own way meanwhile.
+  if(commSys.canLogEvents() && outbound.hasAlerts()) {
+    if(telemetryDue) {
+      outbound.recordDeferred(TrafficClass::bulk);
+    }
+    return;
+  }
+  if(telemetryDue) {
+    flushTelemetry();
+  }
+  else {
+    replayTelemetry(); //Live data goes first
+  }
+}
+
+/**
+ * Sends the waiting alerts while events can be logged. At most OUTBOUND_ALERT_BURST per call,
+ * so the loop stays responsive. Alerts wait in the queue while the server is not reachable.
+ * Alerts beyond the budget of their type are coalesced and sent as one summary later.
+ * An alert leaves the queue only once the server took it. If not, its token is given back
+ * and it waits with the rest for the next call.
+ */
+void EntranceControlSystem::sendAlerts() {
+  if(!commSys.canLogEvents()) {
+    return;
+  }
+  uint32_t now = millis();
+  uint8_t sent = 0;
+  OutboundAlert alert;
+  //Summaries first, they are older than the queued alerts of their type
+  char summary[ALERT_SUMMARY_SIZE];
+  for(uint8_t i = 0; i < ALERT_TYPE_COUNT && sent < OUTBOUND_ALERT_BURST; i++) {
+    AlertType type = static_cast<AlertType>(i);
+    if(alertLimiter.takeSummary(type, now, alert, summary)) {
+      if(!commSys.logEvent(alert.name, summary)) {
+        alertLimiter.refund(type); //The summary stays pending
+        return; //The server is gone, the rest waits for the next call
+      }
+      alertLimiter.confirmSummary(type);
+      outbound.recordSent(TrafficClass::alert, millis() - alert.timestamp);
+      sent++;
+    }
+  }
+  while(sent < OUTBOUND_ALERT_BURST && outbound.peekAlert(alert)) {
+    if(alertLimiter.admit(alert, now)) {
+      if(!commSys.logEvent(alert.name, alert.description)) {
+        alertLimiter.refund(alert.type); //The alert stays queued
+        return;
+      }
+      outbound.recordSent(TrafficClass::alert, millis() - alert.timestamp);
+      sent++;
+    }
+    outbound.popAlert(alert); //Sent or coalesced
   }
 }
 
@@ -265,6 +528,10 @@ void EntranceControlSystem::reset() {
   commSys.reset();
   roomLoadSys.reset();
   doorSys.setStatusLEDs(false); //resetting of door status LEDs
+
+  //Release all tasks from now on, the config is loaded
+  startDetectorTask();
+  scheduler.start();
 }
 
 /**
@@ -274,7 +541,7 @@ void EntranceControlSystem::reset() {
  *  -true: On success.
  *  -false: otherwise.
  */
-bool EntranceControlSystem::configRoomCap(uint8_t val) {
+bool EntranceControlSystem::configRoomCap(uint16_t val) {
   if(storeRoomCapConfig(val)) { //Try to set the room capacity
     roomLoadSys.setRoomCap(val);
   }
@@ -287,8 +554,130 @@ bool EntranceControlSystem::configRoomCap(uint8_t val) {
   return true;
 }
 
+/**
+ * Configures and saves the number of records which trigger a telemetry upload.
+ * @param val The batch size which should be configured.
+ * @return 
+ *  -true: On success.
+ *  -false: otherwise.
+ */
+bool EntranceControlSystem::configBatchSize(uint16_t val) {
+  if(!storeTelemetryConfig(val, telemetryBatch.getFlushInterval()) || !telemetryBatch.setBatchSize(val)) {
+    Serial.println("Error: Failed to set telemetry batch size!");
+    return false;
+  }
+  Serial.print(" >> Successfully set telemetry batch size to: ");
+  Serial.println(val);
+  return true;
+}
+
+/**
+ * Configures and saves the age of the oldest record which triggers a telemetry upload.
+ * @param val The flush interval in seconds which should be configured.
+ * @return 
+ *  -true: On success.
+ *  -false: otherwise.
+ */
+bool EntranceControlSystem::configFlushInterval(uint16_t val) {
+  if(!storeTelemetryConfig(telemetryBatch.getBatchSize(), val) || !telemetryBatch.setFlushInterval(val)) {
+    Serial.println("Error: Failed to set telemetry flush interval!");
+    return false;
+  }
+  Serial.printf(" >> Successfully set telemetry flush interval to: %u s\n", val);
+  return true;
+}
+
+/**
+ * Configures and saves how the telemetry is recorded.
+ * @param val The telemetry mode which should be configured.
+ * @return 
+ *  -true: On success.
+ *  -false: otherwise.
+ */
+bool EntranceControlSystem::configTelemetryMode(TelemetryMode val) {
+  if(!storeTelemetryReportConfig(static_cast<uint8_t>(val), heartbeatInterval, temperatureDelta)) {
+    Serial.println("Error: Failed to set telemetry mode!");
+    return false;
+  }
+  telemetryMode = val;
+  Serial.print(" >> Successfully set telemetry mode to: ");
+  Serial.println(telemetryModeName(val));
+  return true;
+}
+
+/**
+ * Configures and saves the time without change until a heartbeat is recorded in change mode.
+ * @param val The heartbeat interval in seconds which should be configured.
+ * @return 
+ *  -true: On success.
+ *  -false: otherwise.
+ */
+bool EntranceControlSystem::configHeartbeat(uint16_t val) {
+  if(!storeTelemetryReportConfig(static_cast<uint8_t>(telemetryMode), val, temperatureDelta)) {
+    Serial.println("Error: Failed to set telemetry heartbeat interval!");
+    return false;
+  }
+  heartbeatInterval = val;
+  Serial.printf(" >> Successfully set telemetry heartbeat interval to: %u s\n", val);
+  return true;
+}
+
+/**
+ * Configures and saves the temperature change which is recorded in change mode.
+ * @param val The temperature delta in °C which should be configured.
+ * @return 
+ *  -true: On success.
+ *  -false: otherwise.
+ */
+bool EntranceControlSystem::configTemperatureDelta(float val) {
+  if(!storeTelemetryReportConfig(static_cast<uint8_t>(telemetryMode), heartbeatInterval, val)) {
+    Serial.println("Error: Failed to set telemetry temperature delta!");
+    return false;
+  }
+  temperatureDelta = val;
+  Serial.printf(" >> Successfully set telemetry temperature delta to: %.1f °C\n", val);
+  return true;
+}
+
+/**
+ * Configures and saves the number of alerts of a type which are sent per ALERT_BUDGET_WINDOW.
+ * @param type The alert type.
+ * @param val The budget which should be configured.
+ * @return 
+ *  -true: On success.
+ *  -false: otherwise.
+ */
+bool EntranceControlSystem::configAlertBudget(AlertType type, uint8_t val) {
+  if(!storeAlertBudgetConfig(static_cast<uint8_t>(type), val) || !alertLimiter.setBudget(type, val)) {
+    Serial.println("Error: Failed to set alert budget!");
+    return false;
+  }
+  Serial.printf(" >> Successfully set %s alert budget to: %u per %u s\n",
+                alertTypeName(type), val, ALERT_BUDGET_WINDOW);
+  return true;
+}
+
+/**
+ * Configures and saves the time sending data to the server may block.
+ * @param val The send deadline in milli seconds which should be configured.
+ * @return 
+ *  -true: On success.
+ *  -false: otherwise.
+ */
+bool EntranceControlSystem::configSendDeadline(uint16_t val) {
+  if(!storeSendDeadlineConfig(val)) {
+    Serial.println("Error: Failed to set send deadline!");
+    return false;
+  }
+  commSys.setSendDeadline(val);
+  Serial.printf(" >> Successfully set send deadline to: %u ms\n", val);
+  return true;
+}
+
 /**
  * Configures and saves the new server URL into flash memory.
+ * The wire format of the uploaded telemetry can be appended after WIRE_FORMAT_SEPARATOR,
+ * e.g. "http://host/live-data/#msgpack".
  * @param val Server URL value which should be configured.
  * @return 
  *  -true: On success.
@@ -300,6 +689,12 @@ bool EntranceControlSystem::configServerUrl(const String& val) {
                   SERVER_URL_MAX_SIZE);
     return false;
   }
+  String target;
+  WireFormat format;
+  if(!splitServerUrl(val, target, format)) {
+    Serial.println("Error: Unknown wire format! Should be json, msgpack or cbor.");
+    return false;
+  }
   if(storeServerUrlConfig(val)) { //Try to set the room capacity
     commSys.setServerUrl(val);
   }
@@ -313,28 +708,74 @@ bool EntranceControlSystem::configServerUrl(const String& val) {
 }
 
 /**
- * Performs a WiFi configuration over serial terminal.
- * Stores the new configuration into flash memory.
- * Disconnects the WiFi and server connections beforehand.
+ * Configures and saves the url of a fallback server into flash memory.
+ * @param index The number of the fallback, from 1 to FALLBACK_URL_COUNT.
+ * @param val Server URL value which should be configured. An empty url removes the fallback.
  * @return 
- * -true: If configuration could be successfully stored.
- * -false: otherwise.
+ *  -true: On success.
+ *  -false: otherwise.
+ */
+bool EntranceControlSystem::configFallbackUrl(uint8_t index, const String& val) {
+  if(val.length() > SERVER_URL_MAX_SIZE) {
+    Serial.printf("Error: URL is to long! The maximum allowed length is %d characters.\n", 
+                  SERVER_URL_MAX_SIZE);
+    return false;
+  }
+  String target;
+  WireFormat format;
+  if(!splitServerUrl(val, target, format)) {
+    Serial.println("Error: Unknown wire format! Should be json, msgpack or cbor.");
+    return false;
+  }
+  if(storeFallbackUrlConfig(index, val)) {
+    commSys.setFallbackUrl(index, val);
+  }
+  else {
+    Serial.println("Error: Failed to set fallback url!");
+    return false;
+  }
+  Serial.printf(" >> Successfully set fallback url %u to: %s\n", index, val.isEmpty()? "none" : val.c_str());
+  return true;
+}
+
+/**
+ * Starts a WiFi configuration over serial terminal.
+ * Disconnects the WiFi and server connections beforehand.
+ * The SSID and the password are taken from the next inputted lines without blocking the system.
  */
-bool EntranceControlSystem::configWifi() {
+void EntranceControlSystem::configWifi() {
   Serial.println("-----------WiFi Configuration-----------");
   doDisconnect();
-  //Reading SSID from terminal
-  inputStringFromSerial(
-      wifiCred.ssid, 
-      SSID_MAX_SIZE, 
-      "Enter WiFi SSID:");
-
-  //Reading password from terminal
-  inputStringFromSerial(
-      wifiCred.pass, 
-      PASS_MAX_SIZE, 
-      "Enter WiFi password:");
+  Serial.println("Enter WiFi SSID:");
+  wifiDialog = WifiDialogState::ssid;
+}
 
+/**
+ * Takes the next input of the running WiFi configuration.
+ * Stores the new configuration into flash memory once the password was entered.
+ * @param input The inputted line.
+ * @return
+ *   -true: If the input was accepted.
+ *   -false: If it was too long or the configuration could not be stored.
+ */
+bool EntranceControlSystem::continueWifiConfig(const String& input) {
+  //The stored strings need a terminator
+  unsigned int maxLength = (wifiDialog == WifiDialogState::ssid)? SSID_MAX_SIZE - 1 : PASS_MAX_SIZE - 1;
+  if(input.length() > maxLength) {
+    Serial.println("Error: Input exceeds maximum allowed size. Try again.");
+    return false;
+  }
+  Serial.print("Entered: ");
+  Serial.println(input);
+  if(wifiDialog == WifiDialogState::ssid) {
+    enteredSsid = input;
+    Serial.println("Enter WiFi password:");
+    wifiDialog = WifiDialogState::pass;
+    return true;
+  }
+  wifiDialog = WifiDialogState::idle;
+  wifiCred.ssid = enteredSsid;
+  wifiCred.pass = input;
   if(storeWifiConfig(wifiCred)) { //Try to store the WiFi configuration
     Serial.println(" >> WiFi configuration successfully stored.");
     Serial.println("----------------------------------------");
@@ -355,14 +796,102 @@ void EntranceControlSystem::printConfig() {
   Serial.print(" >> WiFi password: ");
   Serial.println(wifiCred.pass);
   Serial.print(" >> Web Server URL: ");
-  Serial.println(commSys.getServerUrl());
+  Serial.println(commSys.getEndpoints().getUrl(0));
+  for(uint8_t i = 1; i <= FALLBACK_URL_COUNT; i++) {
+    const String& url = commSys.getEndpoints().getUrl(i);
+    Serial.printf(" >> Fallback URL %u: %s\n", i, url.isEmpty()? "none" : url.c_str());
+  }
+  Serial.print(" >> Telemetry Wire Format: ");
+  Serial.println(wireFormatName(commSys.getWireFormat()));
   Serial.print(" >> Room Capacity: ");
   Serial.println(roomLoadSys.getRoomCap());
+  Serial.print(" >> Telemetry Batch Size: ");
+  Serial.println(telemetryBatch.getBatchSize());
+  Serial.printf(" >> Telemetry Flush Interval: %u s\n", telemetryBatch.getFlushInterval());
+  Serial.print(" >> Telemetry Mode: ");
+  Serial.println(telemetryModeName(telemetryMode));
+  Serial.printf(" >> Telemetry Heartbeat Interval: %u s\n", heartbeatInterval);
+  Serial.printf(" >> Telemetry Temperature Delta: %.1f °C\n", temperatureDelta);
+  for(uint8_t i = 0; i < ALERT_TYPE_COUNT; i++) {
+    AlertType type = static_cast<AlertType>(i);
+    Serial.printf(" >> Alert Budget %s: %u per %u s\n", alertTypeName(type),
+                  alertLimiter.getBudget(type), ALERT_BUDGET_WINDOW);
+  }
+  Serial.printf(" >> Send Deadline: %u ms\n", commSys.getSendDeadline());
   Serial.print(" >> Verbose Status Messaging: ");
   verbose? Serial.println("true"):Serial.println("false");
   Serial.println("-------------------------------------------");
 }
 
+/**
+ * To print the runtime statistics over serial.
+ */
+void EntranceControlSystem::printStats() const {
+  Serial.println("-----------Runtime Statistics-----------");
+  profiler.printStats();
+  Serial.println(" >> Task deadline misses:");
+  for(uint8_t i = 0; i < scheduler.getTaskCount(); i++) {
+    const SchedulerTask& task = scheduler.getTask(i);
+    Serial.printf("    %-18s %10lu\n", task.name, (unsigned long)task.deadlineMisses);
+  }
+  Serial.println(" >> Dispatched events:");
+  for(uint8_t i = 0; i < doorStatusEventCount; i++) {
+    Serial.printf("    %-18s %10lu\n", doorStatusEventNames[i], (unsigned long)doorEventCounts[i]);
+  }
+  for(uint8_t i = 0; i < static_cast<uint8_t>(RoomLoadEvent::count); i++) {
+    Serial.printf("    %-18s %10lu\n", roomLoadEventNames[i], (unsigned long)roomLoadEventCounts[i]);
+  }
+  Serial.printf(" >> Dropped events: door status %lu, room load %lu\n",
+                (unsigned long)doorEvents.getDropped(),
+                (unsigned long)roomLoadEvents.getDropped());
+  roomLoadSys.printLaneStats();
+  Serial.printf(" >> Dropped detector edges: %lu\n", (unsigned long)roomLoadSys.getDroppedEdges());
+  telemetryBatch.printStats();
+  outbound.printStats(telemetryBatch.getCount() + telemetryLog.getDepth());
+  alertLimiter.printStats();
+  commSys.getHealthMonitor().printStats();
+  commSys.getReconnectPolicy().printStats();
+  commSys.getTelemetryTransport().printStats();
+  commSys.getCircuitBreaker().printStats();
+  commSys.getEventTransport().printStats();
+  Serial.println("----------------------------------------");
+}
+
+/**
+ * To print the state of the telemetry log over serial.
+ */
+void EntranceControlSystem::printBacklog() const {
+  telemetryLog.printBacklog();
+}
+
+/**
+ * To print the web servers the telemetry can be sent to with their measurements over serial.
+ */
+void EntranceControlSystem::printEndpoints() const {
+  commSys.getEndpoints().printEndpoints();
+}
+
+/**
+ * Resets the runtime statistics.
+ */
+void EntranceControlSystem::resetStats() {
+  profiler.reset();
+  scheduler.resetStats();
+  memset(doorEventCounts, 0, sizeof(doorEventCounts));
+  memset(roomLoadEventCounts, 0, sizeof(roomLoadEventCounts));
+  doorEvents.resetDropped();
+  roomLoadEvents.resetDropped();
+  commSys.getHealthMonitor().resetStats();
+  commSys.getReconnectPolicy().resetStats();
+  telemetryBatch.resetStats();
+  outbound.resetStats();
+  alertLimiter.resetStats();
+  commSys.getTelemetryTransport().resetStats();
+  commSys.getCircuitBreaker().resetStats();
+  commSys.getEventTransport().resetStats();
+  Serial.println(" >> Runtime statistics resetted.");
+}
+
 /**
  * Loads the system configuration from flash memory.
  */
@@ -370,21 +899,60 @@ inline void EntranceControlSystem::loadConfig() {
   loadWifiConfig(wifiCred);
   String serverUrl;
   loadServerUrlConfig(serverUrl);
-  commSys.setServerUrl(serverUrl);
+  if(!commSys.setServerUrl(serverUrl)) {
+    Serial.println("Error: Unknown wire format in the server url. Json is used instead!");
+  }
   roomLoadSys.setRoomCap(loadRoomCapConfig());
+  uint16_t batchSize, flushInterval;
+  loadTelemetryConfig(batchSize, flushInterval);
+  //Unset or invalid values keep the defaults
+  telemetryBatch.setBatchSize(batchSize);
+  telemetryBatch.setFlushInterval(flushInterval);
+  uint8_t mode;
+  uint16_t heartbeat;
+  float delta;
+  loadTelemetryReportConfig(mode, heartbeat, delta);
+  telemetryMode = mode == static_cast<uint8_t>(TelemetryMode::onChange)? TelemetryMode::onChange : TelemetryMode::periodic;
+  if(heartbeat >= 1 && heartbeat <= TELEMETRY_HEARTBEAT_MAX) {
+    heartbeatInterval = heartbeat;
+  }
+  if(delta >= TELEMETRY_TEMP_DELTA_MIN && delta <= TELEMETRY_TEMP_DELTA_MAX) { //Also false for an unset value
+    temperatureDelta = delta;
+  }
+  for(uint8_t i = 0; i < ALERT_TYPE_COUNT; i++) {
+    alertLimiter.setBudget(static_cast<AlertType>(i), loadAlertBudgetConfig(i)); //Invalid values keep the default
+  }
+  for(uint8_t i = 1; i <= FALLBACK_URL_COUNT; i++) {
+    String url;
+    loadFallbackUrlConfig(i, url);
+    String target;
+    WireFormat format;
+    if(!url.isEmpty() && splitServerUrl(url, target, format)) {
+      commSys.setFallbackUrl(i, url);
+    }
+  }
+  uint16_t deadline = loadSendDeadlineConfig();
+  if(deadline >= SEND_DEADLINE_MIN && deadline <= SEND_DEADLINE_MAX) {
+    commSys.setSendDeadline(deadline);
+  }
 }
 
 /**
  * Helper method to processes commands inputted over serial terminal.
+ * Takes the characters available without waiting. While a WiFi configuration runs the lines are its input.
  * @return
  *   -true: If a command was processed successfully.
  *   -false: otherwise.
  */
 inline bool EntranceControlSystem::processCommand() {
+  ProfileTimer timer(profiler, ProfilePoint::processCommand);
   String cmdStr;
   Command *command = nullptr;
 
-  if(readStringFromSerial(cmdStr)) { //Check serial input
+  if(console.readLine(cmdStr)) { //Check serial input
+    if(wifiDialog != WifiDialogState::idle) {
+      return continueWifiConfig(cmdStr);
+    }
     if(parseCommand(cmdStr, command)) {
       if(executeCommand(*this, *command)) {
         return true;
@@ -403,6 +971,7 @@ inline bool EntranceControlSystem::processCommand() {
  * Determines the temperature at the entrance.
  */
 void EntranceControlSystem::doTemperatureCheck() {
+  ProfileTimer timer(profiler, ProfilePoint::temperatureCheck);
   uint16_t read = analogRead(termPin); //Read thermistor
   float voltage = (float)read/4096 * 3.3; //Voltage of thermistor
   float Rt = 10 * voltage/(3.3 - voltage); //Resistance of thermistor
@@ -412,37 +981,150 @@ void EntranceControlSystem::doTemperatureCheck() {
 }
 
 /**
- * Logs all collected data to the web server.
+ * Logs a sample of all collected data into the telemetry batch.
+ * In change mode the sample is only logged if it differs from the last record or as heartbeat.
  * Prints data information into serial if verbose messaging is enabled.
  */
 void EntranceControlSystem::logData() {
-  // Allocate the JSON document
-  JsonDocument doc;
-  if(millis() - lastDataLog >= dataLogInterval) {
-    lastDataLog = millis();
+  ProfileTimer timer(profiler, ProfilePoint::logData);
+  uint32_t now = millis();
+  TelemetryRecord sample = {now,
+                            nullptr,
+                            doorSys.isDoorOpen(),
+                            roomLoadSys.getPersonCount(),
+                            roomLoadSys.isRoomFull(),
+                            temperature,
+                            telemetryMode};
+  if(telemetryMode == TelemetryMode::onChange) {
+    if(hasTelemetryChanged(sample)) {
+      sample.event = "change";
+    }
+    else if(now - lastRecord.timestamp >= heartbeatInterval * 1000UL) {
+      sample.event = "heartbeat"; //Proves that the device is alive in a quiet room
+    }
+    else {
+      return;
+    }
+  }
+  if(verbose) {
+    Serial.println("[EntrCtrl] Logged data:");
+    Serial.print(" >> log time: ");
+    Serial.println(String(now));
+    Serial.print(" >> door state: ");
+    Serial.println(String(doorSys.isDoorOpen()));
+    Serial.print(" >> Person Count: ");
+    Serial.println(String(roomLoadSys.getPersonCount()));
+    Serial.print(" >> Temperature: ");
+    Serial.print(String(temperature));
+    Serial.println(" °C");
+  }
+  recordTelemetry(sample); //Uploaded by the sender task
+}
 
-    if(verbose) {
-      Serial.println("[EntrCtrl] Logged data:");
-      Serial.print(" >> log time: ");
-      Serial.println(String(lastDataLog));
-      Serial.print(" >> door state: ");
-      Serial.println(String(doorSys.isDoorOpen()));
-      Serial.print(" >> Person Count: ");
-      Serial.println(String(roomLoadSys.getPersonCount()));
-      Serial.print(" >> Temperature: ");
-      Serial.print(String(temperature));
-      Serial.println(" °C");
+/**
+ * Adds a record to the telemetry batch and remembers it for the change detection.
+ * @param record The record.
+ */
+void EntranceControlSystem::recordTelemetry(const TelemetryRecord& record) {
+  telemetryBatch.add(record);
+  lastRecord = record;
+}
+
+/**
+ * Checks whether a sample differs from the last record.
+ * The temperature counts as changed if it moved by more than the configured delta.
+ * @param sample The sample.
+ * @return
+ *  -true: If the door state, the person count, the room full state or the temperature changed.
+ *  -false: otherwise.
+ */
+bool EntranceControlSystem::hasTelemetryChanged(const TelemetryRecord& sample) const {
+  return sample.doorOpen != lastRecord.doorOpen ||
+         sample.personCount != lastRecord.personCount ||
+         sample.roomFull != lastRecord.roomFull ||
+         fabsf(sample.temperature - lastRecord.temperature) > temperatureDelta;
+}
+
+/**
+ * Checks whether the telemetry batch should be uploaded.
+ * In change mode every record is uploaded right away.
+ * @param now The current time in milli seconds.
+ * @return
+ *  -true: If an upload is due.
+ *  -false: otherwise.
+ */
+bool EntranceControlSystem::isTelemetryDue(uint32_t now) const {
+  if(telemetryMode == TelemetryMode::onChange && telemetryBatch.getCount() > 0) {
+    return true;
+  }
+  return telemetryBatch.isDue(now);
+}
+
+/**
+ * Uploads the telemetry batch to the web server as one array.
+ * Does nothing while offline or if the last upload attempt was less than dataLogInterval ago.
+ * The records are kept if the upload fails.
+ * @return
+ *  -true: If the records were uploaded.
+ *  -false: otherwise.
+ */
+bool EntranceControlSystem::flushTelemetry() {
+  if(millis() - lastDataLog < dataLogInterval) {
+    return false;
+  }
+  lastDataLog = millis();
+  if(commSys.isOnline()) {
+    String data; //Data to be send
+    uint8_t records;
+    {
+      ProfileTimer timer(profiler, ProfilePoint::serializeTelemetry); //Compares the wire formats on the device
+      records = telemetryBatch.serialize(TELEMETRY_ROOM, commSys.getWireFormat(), data);
     }
-    // Add values to the json document
-    // doc["log_time"] = String(lastDataLog);
-    doc["room"] = "Conference";
-    doc["door_state"] = doorSys.isDoorOpen();
-    doc["people_count"] = String(roomLoadSys.getPersonCount());
-    // doc["temperature"] = "23";
+    if(commSys.sendData(data)) {
+      outbound.recordSent(TrafficClass::bulk, millis() - telemetryBatch.getRecord(0).timestamp);
+      telemetryBatch.commit(records);
+      if(verbose) {
+        Serial.printf("[EntrCtrl] Uploaded %u telemetry records.\n", records);
+      }
+      return true;
+    }
+  }
 
-    String jsonData; //Data to be send
-    serializeJson(doc, jsonData);
-    commSys.sendData(jsonData);
+  //The link is down. Keep the records to replay them later.
+  uint8_t records = telemetryBatch.getCount();
+  for(uint8_t i = 0; i < records; i++) {
+    telemetryLog.append(telemetryBatch.getRecord(i));
+  }
+  telemetryBatch.divert(records); //Not uploaded, so no flush
+  if(verbose) {
+    Serial.printf("[EntrCtrl] Stored %u telemetry records for later upload.\n", records);
+  }
+  return false;
+}
+
+/**
+ * Uploads the next batch of the telemetry log while online.
+ * Rate limited to one batch per TELEMETRY_REPLAY_INTERVAL and only done while no live batch is due.
+ */
+void EntranceControlSystem::replayTelemetry() {
+  if(!commSys.isOnline() || telemetryLog.getDepth() == 0 || millis() - lastReplay < TELEMETRY_REPLAY_INTERVAL) {
+    return;
+  }
+  String data;
+  uint8_t records;
+  {
+    ProfileTimer timer(profiler, ProfilePoint::serializeTelemetry);
+    records = telemetryLog.serializeReplay(TELEMETRY_ROOM, commSys.getWireFormat(), data);
+  }
+  if(records == 0) {
+    return; //The log task prepares the batch in the background
+  }
+  lastReplay = millis();
+  if(commSys.sendData(data)) {
+    telemetryLog.ackReplay();
+    if(verbose) {
+      Serial.printf("[EntrCtrl] Replayed %u logged telemetry records.\n", records);
+    }
   }
 }
 
@@ -472,6 +1154,66 @@ bool EntranceControlSystem::restoreFactorySettings() {
     Serial.println("Error: Failed restore server URL to default value!");
     success = false;
   }
+  if(storeTelemetryConfig(TELEMETRY_BATCH_SIZE_DEFAULT, TELEMETRY_FLUSH_INTERVAL_DEFAULT)) {
+    telemetryBatch.setBatchSize(TELEMETRY_BATCH_SIZE_DEFAULT);
+    telemetryBatch.setFlushInterval(TELEMETRY_FLUSH_INTERVAL_DEFAULT);
+    Serial.println(" >> Telemetry batching successfuly restored to default values.");
+  }
+  else {
+    Serial.println("Error: Failed restore telemetry batching to default values!");
+    success = false;
+  }
+  if(storeTelemetryReportConfig(static_cast<uint8_t>(TelemetryMode::periodic),
+                                TELEMETRY_HEARTBEAT_DEFAULT, TELEMETRY_TEMP_DELTA_DEFAULT)) {
+    telemetryMode = TelemetryMode::periodic;
+    heartbeatInterval = TELEMETRY_HEARTBEAT_DEFAULT;
+    temperatureDelta = TELEMETRY_TEMP_DELTA_DEFAULT;
+    Serial.println(" >> Telemetry reporting successfuly restored to default values.");
+  }
+  else {
+    Serial.println("Error: Failed restore telemetry reporting to default values!");
+    success = false;
+  }
+  bool budgetsStored = true;
+  for(uint8_t i = 0; i < ALERT_TYPE_COUNT; i++) {
+    if(storeAlertBudgetConfig(i, ALERT_BUDGET_DEFAULT)) {
+      alertLimiter.setBudget(static_cast<AlertType>(i), ALERT_BUDGET_DEFAULT);
+    }
+    else {
+      budgetsStored = false;
+    }
+  }
+  if(budgetsStored) {
+    Serial.println(" >> Alert budgets successfuly restored to default values.");
+  }
+  else {
+    Serial.println("Error: Failed restore alert budgets to default values!");
+    success = false;
+  }
+  bool fallbacksStored = true;
+  for(uint8_t i = 1; i <= FALLBACK_URL_COUNT; i++) {
+    if(storeFallbackUrlConfig(i, "")) {
+      commSys.setFallbackUrl(i, "");
+    }
+    else {
+      fallbacksStored = false;
+    }
+  }
+  if(fallbacksStored) {
+    Serial.println(" >> Fallback URLs successfuly removed.");
+  }
+  else {
+    Serial.println("Error: Failed to remove fallback URLs!");
+    success = false;
+  }
+  if(storeSendDeadlineConfig(SEND_DEADLINE_DEFAULT)) {
+    commSys.setSendDeadline(SEND_DEADLINE_DEFAULT);
+    Serial.println(" >> Send deadline successfuly restored to default value.");
+  }
+  else {
+    Serial.println("Error: Failed restore send deadline to default value!");
+    success = false;
+  }
   if(!success) {
     Serial.println("Error: Failed to restored factory settings!");
     return false;
@@ -1,4 +1,4 @@
-#pragma oncecommSys
+#pragma once
 /*************************************************************
   A system to handle the access of an entrance.
 *************************************************************/
@@ -9,10 +9,32 @@
 #include "room_load_sys.h"
 #include "door_status_sys.h"
 #include "comm_sys.h"
+#include "scheduler.h"
+#include "telemetry_batcher.h"
+#include "telemetry_log.h"
+#include "outbound_scheduler.h"
+#include "alert_limiter.h"
+#include "serial_access.h"
+
+//===========================================================
+// Definitions
+#define DETECTOR_TASK_PERIOD 1000         //< Period of the detector edge processing in micro seconds.
+#define DETECTOR_TASK_PRIORITY 5          //< FreeRTOS priority of the detector task. Above the loop task.
+#define DETECTOR_TASK_CORE 1              //< The core the detector task is pinned to.
+#define DETECTOR_TASK_STACK_SIZE 4096     //< Stack size of the detector task in bytes.
+#define EVENT_TASK_PERIOD 10000           //< Period of the event dispatching in micro seconds.
+#define DOOR_TASK_PERIOD MAG_SWITCH_SAMPLE_PERIOD //< Period of the door status check in micro seconds. Each check takes one sample of the magnetic switch.
+#define NETWORK_TASK_PERIOD 10000         //< Period of the communication tasks in micro seconds.
+#define CONSOLE_TASK_PERIOD 50000         //< Period of the serial command processing in micro seconds.
+#define TEMPERATURE_TASK_PERIOD 1000000   //< Period of the temperature measurement in micro seconds.
+#define SENDER_TASK_PERIOD 10000          //< Period of the outbound traffic to the servers in micro seconds.
+#define TELEMETRY_ROOM "Conference"       //< The room name sent with every telemetry record.
+#define TELEMETRY_REPLAY_INTERVAL 2000    //< Minimum time between two replayed batches of the telemetry log in milli seconds.
 
 //===========================================================
 // forward declared dependencies
 enum class EntranceControlState: uint8_t;
+enum class WifiDialogState: uint8_t;
 
 //===========================================================
 // Data Types
@@ -26,19 +48,87 @@ class EntranceControlSystem {
     CommunicationSystem& commSys;                //< A reference to the communication system.
     DoorStatusSystem doorSys;                    //< The door state sub system.
     RoomLoadSystem roomLoadSys;                  //< The room load sub system.
+    Scheduler scheduler;                         //< Schedules the periodic tasks of the system.
+    TaskHandle_t detectorTask = nullptr;         //< The FreeRTOS task sampling the detectors.
+    DoorStatusEventBus doorEvents;               //< Door status events published by the door status sub system.
+    RoomLoadEventBus roomLoadEvents;             //< Room load events published by the detector task.
+    uint32_t doorEventCounts[doorStatusEventCount] = {};                             //< Number of dispatched door status events per event type.
+    uint32_t roomLoadEventCounts[static_cast<uint8_t>(RoomLoadEvent::count)] = {};   //< Number of dispatched room load events per event type.
+    OutboundScheduler outbound;                  //< Orders the outbound alerts and bulk data.
+    AlertLimiter alertLimiter;                   //< Keeps the alerts within the event quota.
+    TelemetryBatcher telemetryBatch;             //< Collects the telemetry records until they are uploaded.
+    TelemetryLog telemetryLog;                   //< Keeps the telemetry records on flash while they can't be uploaded.
+    TelemetryMode telemetryMode = TelemetryMode::periodic;       //< How the telemetry is recorded.
+    uint16_t heartbeatInterval = TELEMETRY_HEARTBEAT_DEFAULT;    //< Time without change until a heartbeat is recorded in seconds.
+    float temperatureDelta = TELEMETRY_TEMP_DELTA_DEFAULT;       //< Temperature change which is recorded in change mode in °C.
+    TelemetryRecord lastRecord = {};             //< The last recorded telemetry. Reference of the change detection.
+    unsigned long lastReplay = 0;                //< Time of the last replayed batch of the telemetry log.
     WifiCredentials wifiCred;                    //< Saves the current WiFi credentials.
+    LineReader console;                          //< Assembles the lines inputted over serial terminal.
+    WifiDialogState wifiDialog;                  //< Step of the running WiFi configuration.
+    String enteredSsid = "";                     //< The SSID entered in the running WiFi configuration.
     bool verbose = false;                        //< Whether verbose status messaging is activated.
-    unsigned long lastDataLog = 0;               //< records the last logging of data.
-    const unsigned long dataLogInterval = 3000; //< Time interval between two data loggings in milli seconds.
+    unsigned long lastDataLog = 0;               //< records the last upload attempt of the logged data.
+    const unsigned long dataLogInterval = 3000; //< Time interval between two data samples and minimum time between two uploads in milli seconds.
     const uint8_t termPin;                       //< The pin of the thermistor.
     float temperature = 0;                       //< The current temperature in °C at the door position.
 
     /**
-     * The main routine of the entrance control system.
-     * Performing processing of commands, doing door status and passing checks
-     * and doing communication tasks using the communication system.
+     * Registers the periodic tasks of the system in the scheduler.
+     * Performing processing of commands, doing door status and passing checks,
+     * temperature measurements, data logging and communication tasks each with its own period.
+     */
+    void setupTasks();
+
+    /**
+     * Executes the communication system and determines the next state of the system FSM.
+     */
+    void doCommunication();
+
+    /**
+     * Determines the current door state and registers door status events.
+     */
+    void doDoorCheck();
+
+    /**
+     * Processes the captured detector edges.
+     * Runs in the detector task. Publishes room load events to the event bus.
+     */
+    void doDetectorCheck();
+
+    /**
+     * Starts the detector task pinned to its own core.
+     * The task processes the captured detector edges periodically independent of the main loop.
+     * Started by reset() once the config is loaded. Does nothing if the task is already running.
      */
-    void doMainRoutine();
+    void startDetectorTask();
+
+    /**
+     * Registers the subscribers of the door status and room load events.
+     * Events are queued as Blynk alerts, forwarded to the data logging, to the serial log, to the signals and status LEDs and to the statistics.
+     */
+    void setupEventSubscribers();
+
+    /**
+     * Prints the log of the passing check and dispatches all queued door status and room load events to their subscribers.
+     * The subscribers only queue alerts and records, nothing is sent here.
+     */
+    void doEventDispatch();
+
+    /**
+     * Sends the outbound traffic. Alerts go first, bulk data only if no alert can be sent.
+     * Runs as the task with the lowest priority, so waiting for the server never holds back
+     * the door checks and the event dispatching once they are released.
+     */
+    void doSending();
+
+    /**
+     * Sends the waiting alerts while online. At most OUTBOUND_ALERT_BURST per call,
+     * so the loop stays responsive. Alerts wait in the queue while offline.
+     * Alerts beyond the budget of their type are coalesced and sent as one summary later.
+     * If the server does not take an alert, it is counted as dropped and the rest waits for the next call.
+     */
+    void sendAlerts();
 
     /**
      * Loads the system configuration from flash memory.
@@ -47,6 +137,7 @@ class EntranceControlSystem {
 
     /**
      * Processes commands inputted over serial terminal.
+     * Takes the characters available without waiting. While a WiFi configuration runs the lines are its input.
      * @return
      *   -true: If a command was processed successfully.
      *   -false: otherwise.
@@ -54,11 +145,64 @@ class EntranceControlSystem {
     bool processCommand();
 
     /**
-     * Logs all collected data to the web server.
+     * Takes the next input of the running WiFi configuration.
+     * Stores the new configuration into flash memory once the password was entered.
+     * @param input The inputted line.
+     * @return
+     *   -true: If the input was accepted.
+     *   -false: If it was too long or the configuration could not be stored.
+     */
+    bool continueWifiConfig(const String& input);
+
+    /**
+     * Logs a sample of all collected data into the telemetry batch.
+     * In change mode the sample is only logged if it differs from the last record or as heartbeat.
      * Prints data information into serial if verbose messaging is enabled.
      */
     void logData();
 
+    /**
+     * Adds a record to the telemetry batch and remembers it for the change detection.
+     * @param record The record.
+     */
+    void recordTelemetry(const TelemetryRecord& record);
+
+    /**
+     * Checks whether a sample differs from the last record.
+     * The temperature counts as changed if it moved by more than the configured delta.
+     * @param sample The sample.
+     * @return
+     *  -true: If the door state, the person count, the room full state or the temperature changed.
+     *  -false: otherwise.
+     */
+    bool hasTelemetryChanged(const TelemetryRecord& sample) const;
+
+    /**
+     * Checks whether the telemetry batch should be uploaded.
+     * In change mode every record is uploaded right away.
+     * @param now The current time in milli seconds.
+     * @return
+     *  -true: If an upload is due.
+     *  -false: otherwise.
+     */
+    bool isTelemetryDue(uint32_t now) const;
+
+    /**
+     * Uploads the telemetry batch to the web server as one array.
+     * Does nothing if the last upload attempt was less than dataLogInterval ago.
+     * While offline or if the upload fails, the records are moved into the telemetry log.
+     * @return
+     *  -true: If the records were uploaded.
+     *  -false: otherwise.
+     */
+    bool flushTelemetry();
+
+    /**
+     * Uploads the next batch of the telemetry log while online.
+     * Rate limited to one batch per TELEMETRY_REPLAY_INTERVAL and only done while no live batch is due.
+     */
+    void replayTelemetry();
+
     /**
      * Determines the temperature at the entrance.
      */
@@ -73,8 +217,8 @@ class EntranceControlSystem {
      * @param closedLEDPin The door closed status LED pin.
      * @param magSwitchPin The magnatic switch pin.
      * @param buzzerPin The buzzer pin.
-     * @param outerDetPin The outer detector pin.
-     * @param innerDetPin The inner detector pin.
+     * @param detLanes The detector pins of each lane.
+     * @param detLaneCount The number of lanes.
      */
     EntranceControlSystem( CommunicationSystem& commSys,
                            uint8_t termPin,
@@ -82,8 +226,8 @@ class EntranceControlSystem {
                            uint8_t closedLEDPin, 
                            uint8_t magSwitchPin, 
                            uint8_t buzzerPin,
-                           uint8_t outerDetPin, 
-                           uint8_t innerDetPin);
+                           const DetectorPins* detLanes,
+                           uint8_t detLaneCount);
 
     /**
      * Sets whether verbose status messages should be printed.
@@ -93,7 +237,8 @@ class EntranceControlSystem {
     void activateVerboseMessaging(bool val);
 
     /**
-     * Executes the system state machine.
+     * Executes the next due task of the system.
+     * Sleeps until the next task is due if there is nothing to do.
      */
     void run();
 
@@ -103,7 +248,7 @@ class EntranceControlSystem {
     void reset();
 
     /**
-     * Tells the communication system to connect WiFi and server.
+     * Tells the communication system to start connecting WiFi and server.
      */
     void doConnect() const;
 
@@ -127,17 +272,78 @@ class EntranceControlSystem {
      *  -true: If configuration could be successfully stored.
      *  -false: otherwise.
      */
-    bool configRoomCap(uint8_t val);
+    bool configRoomCap(uint16_t val);
 
     /**
-     * Performs a WiFi configuration over serial terminal.
-     * Stores the new configuration into flash memory.
-     * Disconnects the WiFi and server connections beforehand.
+     * Configures and saves the number of records which trigger a telemetry upload.
+     * @param val The batch size which should be configured.
+     * @return 
+     *  -true: If configuration could be successfully stored.
+     *  -false: otherwise.
+     */
+    bool configBatchSize(uint16_t val);
+
+    /**
+     * Configures and saves the age of the oldest record which triggers a telemetry upload.
+     * @param val The flush interval in seconds which should be configured.
+     * @return 
+     *  -true: If configuration could be successfully stored.
+     *  -false: otherwise.
+     */
+    bool configFlushInterval(uint16_t val);
+
+    /**
+     * Configures and saves how the telemetry is recorded.
+     * @param val The telemetry mode which should be configured.
+     * @return 
+     *  -true: If configuration could be successfully stored.
+     *  -false: otherwise.
+     */
+    bool configTelemetryMode(TelemetryMode val);
+
+    /**
+     * Configures and saves the time without change until a heartbeat is recorded in change mode.
+     * @param val The heartbeat interval in seconds which should be configured.
+     * @return 
+     *  -true: If configuration could be successfully stored.
+     *  -false: otherwise.
+     */
+    bool configHeartbeat(uint16_t val);
+
+    /**
+     * Configures and saves the temperature change which is recorded in change mode.
+     * @param val The temperature delta in °C which should be configured.
+     * @return 
+     *  -true: If configuration could be successfully stored.
+     *  -false: otherwise.
+     */
+    bool configTemperatureDelta(float val);
+
+    /**
+     * Configures and saves the number of alerts of a type which are sent per ALERT_BUDGET_WINDOW.
+     * @param type The alert type.
+     * @param val The budget which should be configured.
+     * @return 
+     *  -true: If configuration could be successfully stored.
+     *  -false: otherwise.
+     */
+    bool configAlertBudget(AlertType type, uint8_t val);
+
+    /**
+     * Configures and saves the time sending data to the server may block.
+     * @param val The send deadline in milli seconds which should be configured.
      * @return 
-     * -true: If configuration could be successfully stored.
-     * -false: otherwise.
+     *  -true: If configuration could be successfully stored.
+     *  -false: otherwise.
+     */
+    bool configSendDeadline(uint16_t val);
+
+    /**
+     * Starts a WiFi configuration over serial terminal.
+     * Disconnects the WiFi and server connections beforehand.
+     * The SSID and the password are taken from the next inputted lines without blocking the system.
      */
-    bool configWifi();
+    void configWifi();
 
     /**
      * Configures and saves the new server URL into flash memory.
@@ -148,11 +354,41 @@ class EntranceControlSystem {
      */
     bool configServerUrl(const String& val);
 
+    /**
+     * Configures and saves the url of a fallback server into flash memory.
+     * @param index The number of the fallback, from 1 to FALLBACK_URL_COUNT.
+     * @param val Server URL value which should be configured. An empty url removes the fallback.
+     * @return 
+     *  -true: On success.
+     *  -false: otherwise.
+     */
+    bool configFallbackUrl(uint8_t index, const String& val);
+
     /**
      * To print the current configuration over serial.
      */
     void printConfig();
 
+    /**
+     * To print the runtime statistics over serial.
+     */
+    void printStats() const;
+
+    /**
+     * To print the state of the telemetry log over serial.
+     */
+    void printBacklog() const;
+
+    /**
+     * To print the web servers the telemetry can be sent to with their measurements over serial.
+     */
+    void printEndpoints() const;
+
+    /**
+     * Resets the runtime statistics.
+     */
+    void resetStats();
+
     /**
      * Resets the system to factory Settings.
      * @return 
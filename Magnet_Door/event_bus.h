@@ -0,0 +1,135 @@
+#pragma once
+/*************************************************************
+  A typed event bus with a fixed capacity.
+  Only depends on the C++ standard library, so it can also be built on a host.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include "spsc_ring.h"
+
+//===========================================================
+// Data Types
+
+/**
+ * An event together with the time it was published.
+ * @tparam Event The type of the event.
+ */
+template <typename Event>
+struct TimedEvent {
+  Event event;                       //< The published event.
+  uint32_t timestamp;                //< Time the event was published in milli seconds.
+};
+
+/**
+ * Queues published events and dispatches them to the subscribers later on.
+ * Publishing only appends the event to a ring buffer, so it is cheap and bounded
+ * and can be done from a time critical path. Draining calls all subscribers
+ * for each queued event and should be done outside of time critical paths.
+ * Events are published by one producer and drained by one consumer.
+ * @tparam Event The type of the events.
+ * @tparam Capacity The number of events which can be queued. Has to be a power of two.
+ * @tparam MaxSubscribers The maximum number of subscribers.
+ */
+template <typename Event, size_t Capacity, size_t MaxSubscribers>
+class EventBus {
+  public:
+    /**
+     * Handles a dispatched event.
+     * @param e The event.
+     * @param arg The argument registered together with the handler.
+     */
+    typedef void (*Handler)(const TimedEvent<Event>& e, void* arg);
+
+  private:
+    /**
+     * A registered subscriber.
+     */
+    struct Subscriber {
+      Handler handler;               //< The handler which is called for each event.
+      void* arg;                     //< The argument passed to the handler.
+    };
+
+    SpscRing<TimedEvent<Event>, Capacity> queue;   //< The queued events.
+    Subscriber subscribers[MaxSubscribers];        //< The registered subscribers.
+    size_t subscriberCount = 0;                    //< Number of registered subscribers.
+    std::atomic<uint32_t> dropped{0};              //< Number of events lost because the queue was full.
+
+  public:
+    /**
+     * Registers a subscriber.
+     * Subscribers should be registered before events are published.
+     * @param handler The handler which is called for each event.
+     * @param arg The argument passed to the handler.
+     * @return
+     *  -true: On success.
+     *  -false: If the maximum number of subscribers is reached.
+     */
+    bool subscribe(Handler handler, void* arg) {
+      if(subscriberCount >= MaxSubscribers) {
+        return false;
+      }
+      subscribers[subscriberCount++] = {handler, arg};
+      return true;
+    }
+
+    /**
+     * Publishes an event.
+     * May only be called by the producer.
+     * @param e The event.
+     * @param timestamp Time the event occurred in milli seconds.
+     * @return
+     *  -true: On success.
+     *  -false: If the queue is full and the event was dropped.
+     */
+    bool publish(const Event& e, uint32_t timestamp) {
+      if(!queue.push({e, timestamp})) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      return true;
+    }
+
+    /**
+     * Dispatches the queued events to all subscribers.
+     * May only be called by the consumer.
+     * @return Number of dispatched events.
+     */
+    size_t drain() {
+      size_t count = 0;
+      TimedEvent<Event> e;
+      while(queue.pop(e)) {
+        for(size_t i = 0; i < subscriberCount; i++) {
+          subscribers[i].handler(e, subscribers[i].arg);
+        }
+        count++;
+      }
+      return count;
+    }
+
+    /**
+     * Gives the number of events waiting to be dispatched.
+     * @return Number of queued events.
+     */
+    size_t getPending() const {
+      return queue.size();
+    }
+
+    /**
+     * Gives the number of events lost because the queue was full.
+     * @return Number of dropped events.
+     */
+    uint32_t getDropped() const {
+      return dropped.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Resets the counter of dropped events.
+     */
+    void resetDropped() {
+      dropped.store(0, std::memory_order_relaxed);
+    }
+};
\ No newline at end of file
@@ -0,0 +1,257 @@
+/*************************************************************
+  The implementation of a monitor of the connection health to WiFi, Blynk and the web server.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "health_monitor.h"
+
+//===========================================================
+// Globals
+static HealthMonitor* wifiEventMonitor = nullptr;  //< The monitor the WiFi events are forwarded to.
+
+static const char* const healthFlagNames[HEALTH_FLAG_COUNT] = {"WiFi", "IP", "Blynk", "Web server"};
+static const char* const healthFailureNames[] = {"none", "WiFi disconnected", "IP lost",
+                                                 "Blynk connection lost", "Web server unreachable"};
+
+//===========================================================
+// Member function implementations
+
+/**
+ * Registers the WiFi event handlers and starts the probe task if not done yet.
+ * @return
+ *  -true: On success.
+ *  -false: If the probe task could not be started.
+ */
+bool HealthMonitor::begin() {
+  if(probeTask) {
+    return true;
+  }
+  if(!wifiEventMonitor) {
+    wifiEventMonitor = this;
+    WiFi.onEvent(onWifiEvent, ARDUINO_EVENT_WIFI_STA_CONNECTED);
+    WiFi.onEvent(onWifiEvent, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+    WiFi.onEvent(onWifiEvent, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    WiFi.onEvent(onWifiEvent, ARDUINO_EVENT_WIFI_STA_LOST_IP);
+  }
+  BaseType_t created = xTaskCreatePinnedToCore(
+      [](void* mon) {
+        HealthMonitor* monitor = static_cast<HealthMonitor*>(mon);
+        TickType_t lastProbe = xTaskGetTickCount();
+        while(true) {
+          vTaskDelay(pdMS_TO_TICKS(HEALTH_TASK_TICK));
+          if(monitor->probeRequest || xTaskGetTickCount() - lastProbe >= pdMS_TO_TICKS(HEALTH_PROBE_PERIOD)) {
+            lastProbe = xTaskGetTickCount();
+            monitor->probe();
+          }
+          monitor->survey();
+        }
+      },
+      "health",
+      HEALTH_TASK_STACK_SIZE,
+      this,
+      HEALTH_TASK_PRIORITY,
+      &probeTask,
+      HEALTH_TASK_CORE);
+  if(created != pdPASS) {
+    probeTask = nullptr;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Sets the endpoints which are surveyed by the probe task.
+ * To be called before begin().
+ * @param set The endpoints.
+ */
+void HealthMonitor::setEndpoints(EndpointSet* set) {
+  endpoints = set;
+}
+
+/**
+ * Sets the web server which is probed.
+ * Not to be called by more than one task.
+ * @param url The url of the web server. An empty url disables probing, the server flag stays set.
+ * @param reachable If the server is known to be reachable. The server flag is kept then until the next probe.
+ * @return
+ *  -true: On success.
+ *  -false: If the host name is too long.
+ */
+bool HealthMonitor::setServer(const String& url, bool reachable) {
+  String host;
+  uint16_t port;
+  parseServerAddress(url, host, port);
+  if(host.length() >= SERVER_HOST_MAX_LENGTH) {
+    return false;
+  }
+
+  ProbeTarget next;
+  strcpy(next.host, host.c_str());
+  next.port = port;
+  portENTER_CRITICAL(&targetLock);
+  target = next;
+  portEXIT_CRITICAL(&targetLock);
+  hasServer = !host.isEmpty();
+  serverFailures = 0;
+
+  //The old result says nothing about the new server, unless the caller knows it
+  if(host.isEmpty() || reachable) {
+    health |= HEALTH_SERVER;
+  }
+  else {
+    health &= ~HEALTH_SERVER;
+  }
+  if(!host.isEmpty()) {
+    requestProbe();
+  }
+  return true;
+}
+
+/**
+ * Clears all health flags without counting flaps and disarms the monitor.
+ */
+void HealthMonitor::reset() {
+  armed = false;
+  health = hasServer? 0 : HEALTH_SERVER;
+  serverFailures = 0;
+}
+
+/**
+ * Sets or clears health flags.
+ * A cleared flag counts as flap if it was set and the monitor is armed.
+ * @param flags The flags which change.
+ * @param up If the flags are set or cleared.
+ * @param failure The reason which is recorded if a flag is lost.
+ */
+void HealthMonitor::setFlags(uint8_t flags, bool up, HealthFailure failure) {
+  if(up) {
+    health |= flags;
+    return;
+  }
+  uint8_t lost = health.fetch_and(~flags) & flags;
+  if(!lost || !armed) {
+    return;
+  }
+  for(uint8_t i = 0; i < HEALTH_FLAG_COUNT; i++) {
+    if(lost & (1 << i)) {
+      flaps[i]++;
+    }
+  }
+  lastFailure = failure;
+  lastFailureTime = millis();
+}
+
+/**
+ * Handles the events of the WiFi driver.
+ * @param event The event id.
+ * @param info The event information.
+ */
+void HealthMonitor::onWifiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  HealthMonitor* monitor = wifiEventMonitor;
+  switch(event) {
+    case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+      monitor->setFlags(HEALTH_WIFI, true, HealthFailure::none);
+      break;
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+      monitor->lastDisconnectReason = info.wifi_sta_disconnected.reason;
+      monitor->setFlags(HEALTH_WIFI | HEALTH_IP, false, HealthFailure::wifiDisconnected);
+      if(monitor->hasServer) {
+        monitor->health &= ~HEALTH_SERVER; //Has to be probed again, but is no flap of its own
+      }
+      break;
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+      monitor->setFlags(HEALTH_IP, true, HealthFailure::none);
+      monitor->requestProbe();
+      break;
+    case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+      monitor->setFlags(HEALTH_IP, false, HealthFailure::ipLost);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * Tries to open a connection to the web server once and reports the result.
+ * Called by the probe task.
+ */
+void HealthMonitor::probe() {
+  probeRequest = false; //Cleared first, so a request made during the probe is kept
+  if((health & (HEALTH_WIFI | HEALTH_IP)) == (HEALTH_WIFI | HEALTH_IP)) {
+    portENTER_CRITICAL(&targetLock);
+    ProbeTarget probed = target;
+    portEXIT_CRITICAL(&targetLock);
+    if(probed.host[0] == '\0') {
+      setFlags(HEALTH_SERVER, true, HealthFailure::none); //Nothing to reach
+    }
+    else {
+      bool reachable = probeClient.connect(probed.host, probed.port, SERVER_PROBE_TIMEOUT);
+      probeClient.stop();
+      reportServer(reachable);
+    }
+  }
+}
+
+/**
+ * Reports whether a probe or a send reached the web server.
+ * The server flag is set on success and cleared after SERVER_FAILURE_LIMIT failures in a row.
+ * A failure before that requests a probe to confirm it.
+ * @param reachable If the web server was reached.
+ */
+void HealthMonitor::reportServer(bool reachable) {
+  if(reachable) {
+    serverFailures = 0;
+    setFlags(HEALTH_SERVER, true, HealthFailure::none);
+    return;
+  }
+  if(serverFailures.fetch_add(1) + 1 >= SERVER_FAILURE_LIMIT) {
+    setFlags(HEALTH_SERVER, false, HealthFailure::serverUnreachable);
+  }
+  else {
+    requestProbe();
+  }
+}
+
+/**
+ * Surveys the endpoints if due and WiFi is up.
+ * Called by the probe task.
+ */
+void HealthMonitor::survey() {
+  if(endpoints && (health & (HEALTH_WIFI | HEALTH_IP)) == (HEALTH_WIFI | HEALTH_IP) && endpoints->isSurveyDue()) {
+    endpoints->survey(probeClient);
+  }
+}
+
+/**
+ * Prints the health word, the flap counters and the last failure over serial.
+ */
+void HealthMonitor::printStats() const {
+  uint8_t flags = health;
+  Serial.println(" >> Connection health (state/flaps):");
+  for(uint8_t i = 0; i < HEALTH_FLAG_COUNT; i++) {
+    Serial.printf("    %-18s %4s %10lu\n", healthFlagNames[i],
+                  (flags & (1 << i))? "up" : "down", (unsigned long)flaps[i]);
+  }
+  HealthFailure failure = lastFailure;
+  if(failure == HealthFailure::none) {
+    Serial.println(" >> Last connection failure: none");
+  }
+  else {
+    Serial.printf(" >> Last connection failure: %s, %lu s ago (WiFi reason %u)\n",
+                  healthFailureNames[static_cast<uint8_t>(failure)],
+                  (millis() - lastFailureTime) / 1000,
+                  lastDisconnectReason.load());
+  }
+}
+
+/**
+ * Resets the flap counters and the last failure.
+ */
+void HealthMonitor::resetStats() {
+  for(std::atomic<uint32_t>& count : flaps) {
+    count = 0;
+  }
+  lastFailure = HealthFailure::none;
+  lastDisconnectReason = 0;
+}
@@ -0,0 +1,195 @@
+#pragma once
+/*************************************************************
+  A monitor of the connection health to WiFi, Blynk and the web server.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include <WiFi.h>
+#include <WiFiClient.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "endpoint_set.h"
+
+//===========================================================
+// Definitions
+#define HEALTH_WIFI 0x01                  //< Associated to the WiFi access point.
+#define HEALTH_IP 0x02                    //< Got an IP address.
+#define HEALTH_BLYNK 0x04                 //< Connected to the Blynk server.
+#define HEALTH_SERVER 0x08                //< The web server is reachable.
+#define HEALTH_ALL 0x0F                   //< All parts of the connection are healthy.
+#define HEALTH_FLAG_COUNT 4               //< Number of health flags.
+
+#define HEALTH_PROBE_PERIOD 15000         //< Time between two probes of the web server in milli seconds.
+#define HEALTH_TASK_TICK 100              //< Time between two checks for a requested probe in milli seconds.
+#define HEALTH_TASK_PRIORITY 1            //< FreeRTOS priority of the probe task. Same as the loop task.
+#define HEALTH_TASK_CORE 0                //< The core the probe task is pinned to. The one of the WiFi stack.
+#define HEALTH_TASK_STACK_SIZE 4096       //< Stack size of the probe task in bytes.
+#define SERVER_PROBE_TIMEOUT 500          //< Timeout of one attempt to reach the web server in milli seconds.
+#define SERVER_FAILURE_LIMIT 3            //< Number of failed probes and sends in a row which mark the web server unreachable.
+#define SERVER_HOST_MAX_LENGTH ENDPOINT_HOST_MAX_LENGTH //< Maximum length of the web server host name including the terminator.
+
+//===========================================================
+// Data Types
+
+/**
+ * The reasons the connection health can fail for.
+ */
+enum class HealthFailure: uint8_t {
+  none,                        //< No failure so far.
+  wifiDisconnected,            //< Lost the association to the access point.
+  ipLost,                      //< Lost the IP address.
+  blynkLost,                   //< Lost the connection to the Blynk server.
+  serverUnreachable            //< The web server could not be reached.
+};
+
+/**
+ * Monitors the health of the connection to WiFi, Blynk and the web server.
+ * The WiFi part follows the events of the WiFi driver, the Blynk part is reported by the owner
+ * and the web server is probed by a background task at a low frequency or on request.
+ * The same task surveys the endpoints the web server can be chosen from.
+ * The web server is only marked unreachable after SERVER_FAILURE_LIMIT failed probes and sends in a row,
+ * each failure requests a probe to confirm it soon.
+ * The result is published as a health word, which can be read in constant time by any task.
+ * While armed, every loss of a health flag is counted as a flap and its reason is recorded.
+ */
+class HealthMonitor {
+  private:
+    /**
+     * Host and port of the web server.
+     */
+    struct ProbeTarget {
+      char host[SERVER_HOST_MAX_LENGTH] = "";  //< The host name. Empty if there is no web server.
+      uint16_t port = 80;                      //< The port.
+    };
+
+    std::atomic<uint8_t> health{0};                       //< The health word made of the health flags.
+    std::atomic<bool> armed{false};                       //< If flaps are counted.
+    std::atomic<bool> probeRequest{false};                //< If a probe of the web server was requested.
+    std::atomic<uint32_t> flaps[HEALTH_FLAG_COUNT] = {};  //< Number of losses per health flag while armed.
+    std::atomic<HealthFailure> lastFailure{HealthFailure::none}; //< The reason of the last loss.
+    std::atomic<unsigned long> lastFailureTime{0};        //< Time of the last loss in milli seconds.
+    std::atomic<uint8_t> lastDisconnectReason{0};         //< The reason code of the WiFi driver for the last disconnect.
+    std::atomic<uint8_t> serverFailures{0};               //< Number of failed probes and sends in a row.
+    ProbeTarget target;                                   //< The probed web server. Guarded by targetLock.
+    portMUX_TYPE targetLock = portMUX_INITIALIZER_UNLOCKED; //< Guards target, which is set and probed by different tasks.
+    std::atomic<bool> hasServer{false};                   //< If a web server is set.
+    TaskHandle_t probeTask = nullptr;                     //< Handle of the probe task.
+    WiFiClient probeClient;                               //< Client used by the probe task only.
+    EndpointSet* endpoints = nullptr;                     //< The surveyed endpoints. None if nullptr.
+
+    /**
+     * Handles the events of the WiFi driver.
+     * @param event The event id.
+     * @param info The event information.
+     */
+    static void onWifiEvent(arduino_event_id_t event, arduino_event_info_t info);
+
+    /**
+     * Tries to open a connection to the web server once and reports the result.
+     * Called by the probe task.
+     */
+    void probe();
+
+    /**
+     * Surveys the endpoints if due and WiFi is up.
+     * Called by the probe task.
+     */
+    void survey();
+
+  public:
+    /**
+     * Registers the WiFi event handlers and starts the probe task if not done yet.
+     * @return
+     *  -true: On success.
+     *  -false: If the probe task could not be started.
+     */
+    bool begin();
+
+    /**
+     * Sets the endpoints which are surveyed by the probe task.
+     * To be called before begin().
+     * @param set The endpoints.
+     */
+    void setEndpoints(EndpointSet* set);
+
+    /**
+     * Sets the web server which is probed.
+     * Not to be called by more than one task.
+     * @param url The url of the web server. An empty url disables probing, the server flag stays set.
+     * @param reachable If the server is known to be reachable. The server flag is kept then until the next probe.
+     * @return
+     *  -true: On success.
+     *  -false: If the host name is too long.
+     */
+    bool setServer(const String& url, bool reachable = false);
+
+    /**
+     * Clears all health flags without counting flaps and disarms the monitor.
+     */
+    void reset();
+
+    /**
+     * Starts or stops counting flaps.
+     * @param val If flaps should be counted.
+     */
+    void arm(bool val);
+
+    /**
+     * Requests a probe of the web server as soon as possible.
+     */
+    void requestProbe();
+
+    /**
+     * Returns whether a requested probe was not done yet.
+     * @return
+     *  -true: If pending.
+     *  -false: otherwise.
+     */
+    bool isProbePending() const;
+
+    /**
+     * Reports whether a probe or a send reached the web server.
+     * The server flag is set on success and cleared after SERVER_FAILURE_LIMIT failures in a row.
+     * A failure before that requests a probe to confirm it.
+     * @param reachable If the web server was reached.
+     */
+    void reportServer(bool reachable);
+
+    /**
+     * Sets or clears health flags.
+     * A cleared flag counts as flap if it was set and the monitor is armed.
+     * @param flags The flags which change.
+     * @param up If the flags are set or cleared.
+     * @param failure The reason which is recorded if a flag is lost.
+     */
+    void setFlags(uint8_t flags, bool up, HealthFailure failure);
+
+    /**
+     * Returns the health word.
+     * @return The health flags.
+     */
+    uint8_t getHealth() const;
+
+    /**
+     * Returns whether all parts of the connection are healthy.
+     * @return
+     *  -true: If healthy.
+     *  -false: otherwise.
+     */
+    bool isHealthy() const;
+
+    /**
+     * Prints the health word, the flap counters and the last failure over serial.
+     */
+    void printStats() const;
+
+    /**
+     * Resets the flap counters and the last failure.
+     */
+    void resetStats();
+};
+
+#include "health_monitor_inline.h"
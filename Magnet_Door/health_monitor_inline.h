@@ -0,0 +1,49 @@
+//===========================================================
+// included dependencies
+#include "health_monitor.h"
+
+//===========================================================
+// Inline member function implementations
+
+/**
+ * Starts or stops counting flaps.
+ * @param val If flaps should be counted.
+ */
+inline void HealthMonitor::arm(bool val) {
+  armed = val;
+}
+
+/**
+ * Requests a probe of the web server as soon as possible.
+ */
+inline void HealthMonitor::requestProbe() {
+  probeRequest = true;
+}
+
+/**
+ * Returns whether a requested probe was not done yet.
+ * @return
+ *  -true: If pending.
+ *  -false: otherwise.
+ */
+inline bool HealthMonitor::isProbePending() const {
+  return probeRequest;
+}
+
+/**
+ * Returns the health word.
+ * @return The health flags.
+ */
+inline uint8_t HealthMonitor::getHealth() const {
+  return health;
+}
+
+/**
+ * Returns whether all parts of the connection are healthy.
+ * @return
+ *  -true: If healthy.
+ *  -false: otherwise.
+ */
+inline bool HealthMonitor::isHealthy() const {
+  return health == HEALTH_ALL;
+}
@@ -0,0 +1,120 @@
+/*************************************************************
+  The implementation of filters to condition digital inputs.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "input_filter.h"
+#include "Arduino.h"
+
+//===========================================================
+// Member function implementations
+
+/**
+ * Constructs an InputFilter.
+ * @param config The configuration.
+ * @param level The initial level.
+ */
+InputFilter::InputFilter(const InputFilterConfig& config, bool level): config(config) {
+  reset(level);
+}
+
+/**
+ * Feeds a raw sample or raw level change into the filter.
+ * @param raw The raw level.
+ * @param now Time of the sample in micro seconds.
+ * @param[out] edge The stable edge if there was one.
+ * @return
+ *  -true: If the level became stable with this sample.
+ *  -false: otherwise.
+ */
+bool InputFilter::sample(bool raw, uint32_t now, InputEdge& edge) {
+  if(config.mode == DebounceMode::integrating) {
+    if(integrator == (level? config.threshold : 0) && raw != level) {
+      candidateTime = now; //Starts to leave the stable level
+    }
+    if(raw && integrator < config.threshold) {
+      integrator++;
+    }
+    else if(!raw && integrator > 0) {
+      integrator--;
+    }
+    if(integrator == (level? 0 : config.threshold)) {
+      level = !level;
+      edge = {level, candidateTime};
+      return true;
+    }
+    return false;
+  }
+
+  //Stable time mode: the previous raw level may have become stable before this change
+  bool stable = poll(now, edge);
+  if(raw != candidate) {
+    candidate = raw;
+    candidateTime = now;
+  }
+  return stable;
+}
+
+/**
+ * Checks whether the last raw level persisted long enough to be stable.
+ * Only used in stable time mode, where no further samples arrive while the raw level stays the same.
+ * @param now The current time in micro seconds.
+ * @param[out] edge The stable edge if there was one.
+ * @return
+ *  -true: If the level became stable.
+ *  -false: otherwise.
+ */
+bool InputFilter::poll(uint32_t now, InputEdge& edge) {
+  if(config.mode != DebounceMode::stableTime || candidate == level) {
+    return false;
+  }
+  if(static_cast<int32_t>(now - candidateTime) < static_cast<int32_t>(config.threshold)) {
+    return false; //Not stable yet. Also covers samples taken after now.
+  }
+  level = candidate;
+  edge = {level, candidateTime};
+  return true;
+}
+
+/**
+ * Sets the stable level without registering an edge.
+ * @param val The level which should be set.
+ */
+void InputFilter::reset(bool val) {
+  level = val;
+  candidate = val;
+  integrator = val? config.threshold : 0;
+}
+
+/**
+ * Constructs a DigitalInput and takes the current level as stable level.
+ * @param pin The input pin.
+ * @param config The configuration of the filter.
+ */
+DigitalInput::DigitalInput(uint8_t pin, const InputFilterConfig& config): pin(pin),
+                                                                          filter(config) {
+  pinMode(pin, INPUT);
+  filter.reset(digitalRead(pin));
+  lastSample = micros();
+}
+
+/**
+ * Samples the pin if the sample period is over and checks for a stable edge.
+ * The sample period is the minimum time between two samples. If called more often, only the filter is polled.
+ * @param[out] edge The stable edge if there was one.
+ * @return
+ *  -true: If the level became stable.
+ *  -false: otherwise.
+ */
+bool DigitalInput::update(InputEdge& edge) {
+  uint32_t now = micros();
+  if(now - lastSample < filter.getConfig().samplePeriod) {
+    return filter.poll(now, edge);
+  }
+  lastSample = now;
+  if(filter.sample(digitalRead(pin), now, edge)) {
+    return true;
+  }
+  return filter.poll(now, edge);
+}
@@ -0,0 +1,135 @@
+#pragma once
+/*************************************************************
+  Filters to condition digital inputs.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include <cstdint>
+
+//===========================================================
+// Data Types
+
+/**
+ * The ways a digital input can be debounced.
+ */
+enum class DebounceMode: uint8_t {
+  integrating,                 //< Counts samples up on high and down on low. The level changes once the count saturates.
+  stableTime                   //< The level changes once a new raw level persisted for the debounce time.
+};
+
+/**
+ * The configuration of an input filter.
+ */
+struct InputFilterConfig {
+  DebounceMode mode;           //< The debounce mode.
+  uint32_t threshold;          //< Number of samples in integrating mode or debounce time in micro seconds in stable time mode.
+  uint32_t samplePeriod;       //< Time between two samples of a polled input in micro seconds.
+};
+
+/**
+ * A stable level change of a filtered input.
+ */
+struct InputEdge {
+  bool level;                  //< The level after the change.
+  uint32_t timestamp;          //< Time the raw level started to change in micro seconds.
+};
+
+/**
+ * Debounces a digital input and gives timestamped stable level changes.
+ * Can be fed by periodic samples or by the raw level changes of an interrupt.
+ * The timestamp of a stable edge is the time the raw level first took its new value,
+ * so the filter delays the edge but not its timestamp.
+ */
+class InputFilter {
+  private:
+    InputFilterConfig config;          //< The configuration.
+    bool level;                        //< The stable level.
+    bool candidate;                    //< The last raw level.
+    uint32_t candidateTime = 0;        //< Time the raw level changed to the candidate in micro seconds.
+    uint32_t integrator;               //< The sample count in integrating mode.
+
+  public:
+    /**
+     * Constructs an InputFilter.
+     * @param config The configuration.
+     * @param level The initial level.
+     */
+    InputFilter(const InputFilterConfig& config = {DebounceMode::stableTime, 0, 0}, bool level = true);
+
+    /**
+     * Feeds a raw sample or raw level change into the filter.
+     * @param raw The raw level.
+     * @param now Time of the sample in micro seconds.
+     * @param[out] edge The stable edge if there was one.
+     * @return
+     *  -true: If the level became stable with this sample.
+     *  -false: otherwise.
+     */
+    bool sample(bool raw, uint32_t now, InputEdge& edge);
+
+    /**
+     * Checks whether the last raw level persisted long enough to be stable.
+     * Only used in stable time mode, where no further samples arrive while the raw level stays the same.
+     * @param now The current time in micro seconds.
+     * @param[out] edge The stable edge if there was one.
+     * @return
+     *  -true: If the level became stable.
+     *  -false: otherwise.
+     */
+    bool poll(uint32_t now, InputEdge& edge);
+
+    /**
+     * Sets the stable level without registering an edge.
+     * @param val The level which should be set.
+     */
+    void reset(bool val);
+
+    /**
+     * Gives the stable level.
+     * @return The stable level.
+     */
+    bool getLevel() const;
+
+    /**
+     * Gives the configuration.
+     * @return The configuration.
+     */
+    const InputFilterConfig& getConfig() const;
+};
+
+/**
+ * A digital input pin which is sampled and debounced by an input filter.
+ */
+class DigitalInput {
+  private:
+    const uint8_t pin;                 //< The input pin.
+    InputFilter filter;                //< The filter of the pin.
+    uint32_t lastSample = 0;           //< Time of the last sample in micro seconds.
+
+  public:
+    /**
+     * Constructs a DigitalInput and takes the current level as stable level.
+     * @param pin The input pin.
+     * @param config The configuration of the filter.
+     */
+    DigitalInput(uint8_t pin, const InputFilterConfig& config);
+
+    /**
+     * Samples the pin if the sample period is over and checks for a stable edge.
+     * The sample period is the minimum time between two samples. If called more often, only the filter is polled.
+     * @param[out] edge The stable edge if there was one.
+     * @return
+     *  -true: If the level became stable.
+     *  -false: otherwise.
+     */
+    bool update(InputEdge& edge);
+
+    /**
+     * Gives the stable level.
+     * @return The stable level.
+     */
+    bool getLevel() const;
+};
+
+#include "input_filter_inline.h"
@@ -0,0 +1,30 @@
+//===========================================================
+// included dependencies
+#include "input_filter.h"
+
+//===========================================================
+// Inline member function implementations
+
+/**
+ * Gives the stable level.
+ * @return The stable level.
+ */
+inline bool InputFilter::getLevel() const {
+  return level;
+}
+
+/**
+ * Gives the configuration.
+ * @return The configuration.
+ */
+inline const InputFilterConfig& InputFilter::getConfig() const {
+  return config;
+}
+
+/**
+ * Gives the stable level.
+ * @return The stable level.
+ */
+inline bool DigitalInput::getLevel() const {
+  return filter.getLevel();
+}
@@ -0,0 +1,114 @@
+/*************************************************************
+  The implementation of a profiler to measure the execution times of the main loop routines.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "loop_profiler.h"
+
+//===========================================================
+// Static data
+
+/**
+ * The names of the profile points in the order of ProfilePoint.
+ */
+static const char* const profilePointNames[] = {
+  "processCommand",
+  "temperatureCheck",
+  "doorStatusCheck",
+  "doorPassingCheck",
+  "logData",
+  "commSysRun",
+  "sendData",
+  "serializeTelemetry"
+};
+
+//===========================================================
+// Member function implementations
+
+/**
+ * Constructs an empty histogram.
+ */
+LatencyHistogram::LatencyHistogram() {
+  reset();
+}
+
+/**
+ * Records a latency.
+ * @param latency The latency in micro seconds.
+ */
+void LatencyHistogram::record(uint32_t latency) {
+  uint8_t bucket = latency? 31 - __builtin_clz(latency) : 0; //floor(log2(latency))
+  buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  //Another task may record at the same time, so only replace a bound which is still exceeded
+  uint32_t bound = min.load(std::memory_order_relaxed);
+  while(latency < bound && !min.compare_exchange_weak(bound, latency, std::memory_order_relaxed)) {}
+  bound = max.load(std::memory_order_relaxed);
+  while(latency > bound && !max.compare_exchange_weak(bound, latency, std::memory_order_relaxed)) {}
+  count.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Removes all recorded latencies.
+ */
+void LatencyHistogram::reset() {
+  for(std::atomic<uint32_t>& bucket: buckets) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  count.store(0, std::memory_order_relaxed);
+  min.store(UINT32_MAX, std::memory_order_relaxed);
+  max.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * Gives an upper bound of a percentile of the recorded latencies.
+ * The resolution is limited to the bucket size.
+ * @param percent The percentile between 0 and 100.
+ * @return The upper bound of the percentile in micro seconds.
+ */
+uint32_t LatencyHistogram::getPercentile(uint8_t percent) const {
+  uint32_t total = getCount();
+  if(!total) {
+    return 0;
+  }
+  uint64_t rank = ((uint64_t)total * percent + 99) / 100; //Number of latencies which have to be covered
+  if(rank == 0) {
+    rank = 1;
+  }
+  uint64_t covered = 0;
+  for(uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+    covered += buckets[i].load(std::memory_order_relaxed);
+    if(covered >= rank) {
+      uint32_t upper = (i < 31)? (1UL << (i + 1)) - 1 : UINT32_MAX; //Highest latency of the bucket
+      return upper < getMax()? upper : getMax();
+    }
+  }
+  return getMax();
+}
+
+/**
+ * Removes all recorded latencies.
+ */
+void LoopProfiler::reset() {
+  for(LatencyHistogram& histogram: histograms) {
+    histogram.reset();
+  }
+}
+
+/**
+ * Prints the statistics of all profile points over serial.
+ */
+void LoopProfiler::printStats() const {
+  Serial.println(" >> Latencies in micro seconds:");
+  Serial.printf("    %-18s %10s %10s %10s %10s %10s\n", "routine", "count", "min", "p50", "p99", "max");
+  for(uint8_t i = 0; i < static_cast<uint8_t>(ProfilePoint::count); i++) {
+    const LatencyHistogram& histogram = histograms[i];
+    Serial.printf("    %-18s %10lu %10lu %10lu %10lu %10lu\n",
+                  profilePointNames[i],
+                  (unsigned long)histogram.getCount(),
+                  (unsigned long)histogram.getMin(),
+                  (unsigned long)histogram.getPercentile(50),
+                  (unsigned long)histogram.getPercentile(99),
+                  (unsigned long)histogram.getMax());
+  }
+}
\ No newline at end of file
@@ -0,0 +1,152 @@
+#pragma once
+/*************************************************************
+  A profiler to measure the execution times of the main loop routines.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include <atomic>
+
+//===========================================================
+// Definitions
+#define LATENCY_BUCKETS 32          //< Number of log2 scaled buckets of a latency histogram.
+
+//===========================================================
+// Data Types
+
+/**
+ * The routines which are measured by the profiler.
+ */
+enum class ProfilePoint: uint8_t {
+  processCommand,                   //< Processing of serial commands.
+  temperatureCheck,                 //< Measuring the temperature.
+  doorStatusCheck,                  //< Checking the door status.
+  doorPassingCheck,                 //< Checking the detectors for door passings.
+  logData,                          //< Logging data to the web server.
+  commSysRun,                       //< Executing the communication system.
+  sendData,                         //< Sending data to the web server.
+  serializeTelemetry,               //< Serializing a telemetry batch in the wire format of the server.
+  count                             //< Number of profile points. Has to stay the last entry.
+};
+
+/**
+ * A histogram of latencies measured in micro seconds.
+ * Bucket i counts all latencies between 2^i and 2^(i+1)-1 micro seconds.
+ * The counters are atomic, so the routines of several tasks can record into it
+ * while another task prints it.
+ */
+class LatencyHistogram {
+  private:
+    std::atomic<uint32_t> buckets[LATENCY_BUCKETS];    //< The histogram buckets.
+    std::atomic<uint32_t> count;                       //< Number of recorded latencies.
+    std::atomic<uint32_t> min;                         //< Lowest recorded latency in micro seconds.
+    std::atomic<uint32_t> max;                         //< Highest recorded latency in micro seconds.
+
+  public:
+    /**
+     * Constructs an empty histogram.
+     */
+    LatencyHistogram();
+
+    /**
+     * Records a latency.
+     * @param latency The latency in micro seconds.
+     */
+    void record(uint32_t latency);
+
+    /**
+     * Removes all recorded latencies.
+     */
+    void reset();
+
+    /**
+     * Gives the number of recorded latencies.
+     * @return The number of recorded latencies.
+     */
+    uint32_t getCount() const;
+
+    /**
+     * Gives the lowest recorded latency.
+     * @return The lowest latency in micro seconds.
+     */
+    uint32_t getMin() const;
+
+    /**
+     * Gives the highest recorded latency.
+     * @return The highest latency in micro seconds.
+     */
+    uint32_t getMax() const;
+
+    /**
+     * Gives an upper bound of a percentile of the recorded latencies.
+     * The resolution is limited to the bucket size.
+     * @param percent The percentile between 0 and 100.
+     * @return The upper bound of the percentile in micro seconds.
+     */
+    uint32_t getPercentile(uint8_t percent) const;
+};
+
+/**
+ * Collects a latency histogram for each profile point.
+ * Uses the 64 bit micro second timer, so long stalls are measured correctly.
+ * Latencies above UINT32_MAX micro seconds are recorded as UINT32_MAX.
+ */
+class LoopProfiler {
+  private:
+    LatencyHistogram histograms[static_cast<uint8_t>(ProfilePoint::count)]; //< A histogram for each profile point.
+
+  public:
+    /**
+     * Records a latency for a profile point.
+     * @param point The profile point.
+     * @param latency The latency in micro seconds.
+     */
+    void record(ProfilePoint point, uint32_t latency);
+
+    /**
+     * Gives the histogram of a profile point.
+     * @param point The profile point.
+     * @return The histogram.
+     */
+    const LatencyHistogram& getHistogram(ProfilePoint point) const;
+
+    /**
+     * Removes all recorded latencies.
+     */
+    void reset();
+
+    /**
+     * Prints the statistics of all profile points over serial.
+     */
+    void printStats() const;
+};
+
+/**
+ * Measures the execution time of a scope and records it in the profiler.
+ */
+class ProfileTimer {
+  private:
+    LoopProfiler& profiler;                  //< The profiler the measurement is recorded to.
+    const ProfilePoint point;                //< The measured profile point.
+    const int64_t start;                     //< The time at the start of the measurement in micro seconds.
+
+  public:
+    /**
+     * Starts a measurement.
+     * @param profiler The profiler the measurement is recorded to.
+     * @param point The measured profile point.
+     */
+    ProfileTimer(LoopProfiler& profiler, ProfilePoint point);
+
+    /**
+     * Stops the measurement and records it.
+     */
+    ~ProfileTimer();
+};
+
+//===========================================================
+// Globals
+extern LoopProfiler profiler;
+
+#include "loop_profiler_inline.h"
\ No newline at end of file
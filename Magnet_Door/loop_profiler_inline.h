@@ -0,0 +1,66 @@
+//===========================================================
+// included dependencies
+#include "loop_profiler.h"
+#include <esp_timer.h>
+
+//===========================================================
+// Inline member function implementations
+
+/**
+ * Gives the number of recorded latencies.
+ * @return The number of recorded latencies.
+ */
+inline uint32_t LatencyHistogram::getCount() const {
+  return count.load(std::memory_order_relaxed);
+}
+
+/**
+ * Gives the lowest recorded latency.
+ * @return The lowest latency in micro seconds.
+ */
+inline uint32_t LatencyHistogram::getMin() const {
+  return getCount()? min.load(std::memory_order_relaxed) : 0;
+}
+
+/**
+ * Gives the highest recorded latency.
+ * @return The highest latency in micro seconds.
+ */
+inline uint32_t LatencyHistogram::getMax() const {
+  return max.load(std::memory_order_relaxed);
+}
+
+/**
+ * Records a latency for a profile point.
+ * @param point The profile point.
+ * @param latency The latency in micro seconds.
+ */
+inline void LoopProfiler::record(ProfilePoint point, uint32_t latency) {
+  histograms[static_cast<uint8_t>(point)].record(latency);
+}
+
+/**
+ * Gives the histogram of a profile point.
+ * @param point The profile point.
+ * @return The histogram.
+ */
+inline const LatencyHistogram& LoopProfiler::getHistogram(ProfilePoint point) const {
+  return histograms[static_cast<uint8_t>(point)];
+}
+
+/**
+ * Starts a measurement.
+ * @param profiler The profiler the measurement is recorded to.
+ * @param point The measured profile point.
+ */
+inline ProfileTimer::ProfileTimer(LoopProfiler& profiler, ProfilePoint point): profiler(profiler),
+                                                                               point(point),
+                                                                               start(esp_timer_get_time()) {}
+
+/**
+ * Stops the measurement and records it.
+ */
+inline ProfileTimer::~ProfileTimer() {
+  int64_t latency = esp_timer_get_time() - start;
+  profiler.record(point, (latency < UINT32_MAX)? (uint32_t)latency : UINT32_MAX);
+}
\ No newline at end of file
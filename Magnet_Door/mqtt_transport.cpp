@@ -0,0 +1,544 @@
+/*************************************************************
+  The implementation of a transport to publish data to an MQTT broker.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "mqtt_transport.h"
+
+//===========================================================
+// Definitions
+#define MQTT_CONNECT 0x10                 //< Packet type of a session request.
+#define MQTT_CONNACK 0x20                 //< Packet type of a session acknowledgement.
+#define MQTT_PUBLISH 0x30                 //< Packet type of a message.
+#define MQTT_PUBACK 0x40                  //< Packet type of a QoS 1 acknowledgement.
+#define MQTT_PINGREQ 0xC0                 //< Packet type of a ping.
+#define MQTT_PINGRESP 0xD0                //< Packet type of a ping answer.
+#define MQTT_DISCONNECT 0xE0              //< Packet type of a session end.
+#define MQTT_PUBLISH_QOS1 0x02            //< Flag of a message with QoS 1.
+#define MQTT_PUBLISH_DUP 0x08             //< Flag of a message which may have been sent before.
+
+//===========================================================
+// Data Types
+
+/**
+ * The states of an MQTT session.
+ */
+enum class MqttState: uint8_t {
+  disconnected,     //< No connection to the broker.
+  connecting,       //< Waits for the broker to accept the session.
+  connected         //< The session is established.
+};
+
+/**
+ * The results of a publish.
+ */
+enum class MqttResult: uint8_t {
+  none,             //< Nothing published yet.
+  sent,             //< Written to the connection.
+  acked,            //< Acknowledged by the broker.
+  notConnected,     //< No session established.
+  topicTooLong,     //< The topic is longer than MQTT_TOPIC_MAX_LENGTH.
+  writeFailed,      //< The connection failed while writing.
+  inFlight,         //< Written, waits for the acknowledgement.
+  busy              //< The last QoS 1 message is not acknowledged yet.
+};
+
+/**
+ * The parts of a received packet.
+ */
+enum class MqttRxStep: uint8_t {
+  header,           //< The first byte of the fixed header.
+  length,           //< The remaining length.
+  body              //< The bytes after the fixed header.
+};
+
+//===========================================================
+// Member function implementations
+
+/**
+ * Constructs a MqttTransport without broker.
+ */
+MqttTransport::MqttTransport(): state(MqttState::disconnected),
+                                lastResult(MqttResult::none),
+                                rxStep(MqttRxStep::header) {
+  snprintf(clientId, MQTT_CLIENT_ID_SIZE, "ubis-%012llx", (unsigned long long)ESP.getEfuseMac());
+}
+
+/**
+ * Sets the broker. Closes the session to a former broker.
+ * @param url The url of the broker: "mqtt://host[:port][/topic][?qos=0|1]".
+ * @return
+ *  -true: On success.
+ *  -false: If the url is malformed.
+ */
+bool MqttTransport::setUrl(const String& url) {
+  if(!url.startsWith("mqtt://")) {
+    return false;
+  }
+  String rest = url.substring(7);
+  uint8_t newQos = 0;
+  int queryStart = rest.indexOf("?");
+  if(queryStart >= 0) {
+    String query = rest.substring(queryStart + 1);
+    rest = rest.substring(0, queryStart);
+    if(query == "qos=1") {
+      newQos = 1;
+    }
+    else if(query != "qos=0") {
+      return false;
+    }
+  }
+  String newTopic = MQTT_TOPIC_DEFAULT;
+  int pathStart = rest.indexOf("/");
+  if(pathStart >= 0) {
+    if(pathStart + 1 < (int)rest.length()) {
+      newTopic = rest.substring(pathStart + 1);
+    }
+    rest = rest.substring(0, pathStart);
+  }
+  uint16_t newPort = MQTT_PORT_DEFAULT;
+  int portStart = rest.indexOf(":");
+  if(portStart >= 0) {
+    newPort = rest.substring(portStart + 1).toInt();
+    rest = rest.substring(0, portStart);
+  }
+  if(rest.isEmpty() || newPort == 0) {
+    return false;
+  }
+  if(rest != host || newPort != port || newTopic != baseTopic || newQos != qos) {
+    disconnect();
+    host = rest;
+    port = newPort;
+    baseTopic = newTopic;
+    qos = newQos;
+  }
+  return true;
+}
+
+/**
+ * Sets the time the broker gets to answer.
+ * The TCP connect gets half of it. A QoS 1 message is sent again if it is not acknowledged within all of it.
+ * @param deadline The deadline in milli seconds.
+ */
+void MqttTransport::setDeadline(uint16_t deadline) {
+  connectTimeout = deadline / 2;
+  ackTimeout = deadline;
+}
+
+/**
+ * Gives the name of the transport.
+ * @return The name.
+ */
+const char* MqttTransport::getName() const {
+  return "mqtt";
+}
+
+/**
+ * Opens the connection to the broker and requests a session.
+ * The broker accepts the session in poll(). Waits at most the connect timeout for the TCP connection.
+ * @return
+ *  -true: If the session is established or requested.
+ *  -false: If there is no broker, the last attempt was less than MQTT_RETRY_INTERVAL ago or the broker is not reachable.
+ */
+bool MqttTransport::connect() {
+  if(state != MqttState::disconnected) {
+    return true;
+  }
+  uint32_t now = millis();
+  if(host.isEmpty() || (lastAttempt && now - lastAttempt < MQTT_RETRY_INTERVAL)) {
+    return false;
+  }
+  lastAttempt = now;
+  if(!client.connect(host.c_str(), port, connectTimeout)) {
+    return false;
+  }
+  client.setNoDelay(true); //The packets are small, don't wait for more
+
+  //Protocol name, level 4 (3.1.1), clean session, keep alive and the client id
+  size_t idLength = strlen(clientId);
+  uint8_t head[12 + MQTT_CLIENT_ID_SIZE] = {0, 4, 'M', 'Q', 'T', 'T', 4, 0x02,
+                                            MQTT_KEEP_ALIVE >> 8, MQTT_KEEP_ALIVE & 0xFF,
+                                            uint8_t(idLength >> 8), uint8_t(idLength)};
+  memcpy(head + 12, clientId, idLength);
+  if(!writePacket(MQTT_CONNECT, head, 12 + idLength)) {
+    drop();
+    return false;
+  }
+  state = MqttState::connecting;
+  connectStart = now;
+  return true;
+}
+
+/**
+ * Publishes a message with the configured quality of service.
+ * @param topic The topic of the message below the base topic.
+ * @param payload The message. May be binary.
+ * @param contentType Unused. MQTT 3.1.1 has no content type.
+ * @return
+ *  -true: If the message was written. With QoS 1 it is kept in flight until it is acknowledged.
+ *  -false: If there is no session or the last QoS 1 message is not acknowledged yet.
+ */
+bool MqttTransport::publish(const char* topic, const String& payload, const char* contentType) {
+  (void)contentType;
+  if(state != MqttState::connected) {
+    lastResult = MqttResult::notConnected;
+    failures++;
+    return false;
+  }
+  if(qos == 1 && pendingId) {
+    lastResult = MqttResult::busy; //The caller keeps the data until the broker caught up
+    failures++;
+    return false;
+  }
+
+  //Topic and packet id
+  size_t baseLength = baseTopic.length();
+  size_t topicLength = baseLength + 1 + strlen(topic);
+  if(topicLength > MQTT_TOPIC_MAX_LENGTH) {
+    lastResult = MqttResult::topicTooLong;
+    failures++;
+    return false;
+  }
+  uint8_t head[2 + MQTT_TOPIC_MAX_LENGTH + 2];
+  head[0] = topicLength >> 8;
+  head[1] = topicLength;
+  memcpy(head + 2, baseTopic.c_str(), baseLength);
+  head[2 + baseLength] = '/';
+  memcpy(head + 3 + baseLength, topic, topicLength - baseLength - 1);
+  size_t headLength = 2 + topicLength;
+  uint16_t packetId = 0;
+  if(qos == 1) {
+    packetId = nextPacketId++;
+    if(nextPacketId == 0) {
+      nextPacketId = 1; //0 is no valid packet id
+    }
+    head[headLength++] = packetId >> 8;
+    head[headLength++] = packetId;
+  }
+
+  if(qos == 1) {
+    memcpy(pendingHead, head, headLength);
+    pendingHeadLength = headLength;
+    pendingPayload = payload;
+    pendingId = packetId;
+    pendingSends = 0;
+    if(!sendPending(false)) {
+      pendingId = 0; //The caller keeps the data
+      pendingPayload = "";
+      lastResult = MqttResult::writeFailed;
+      failures++;
+      return false;
+    }
+    published++;
+    lastResult = MqttResult::inFlight;
+    return true;
+  }
+  if(!writePacket(MQTT_PUBLISH, head, headLength,
+                  reinterpret_cast<const uint8_t*>(payload.c_str()), payload.length())) {
+    lastResult = MqttResult::writeFailed;
+    failures++;
+    drop();
+    return false;
+  }
+  published++;
+  lastResult = MqttResult::sent;
+  return true;
+}
+
+/**
+ * Handles the packets from the broker, sends the message in flight again if its acknowledgement
+ * is missing and keeps the session alive with pings. Drops the session if the broker does not answer.
+ */
+void MqttTransport::poll() {
+  if(state == MqttState::disconnected) {
+    return;
+  }
+  if(!client.connected()) {
+    drop();
+    return;
+  }
+  receive();
+  uint32_t now = millis();
+  if(state == MqttState::connecting) {
+    if(now - connectStart > MQTT_CONNACK_TIMEOUT) {
+      drop();
+    }
+  }
+  else if(state == MqttState::connected) {
+    if(pendingId && now - pendingSent >= ackTimeout) {
+      if(pendingSends > MQTT_MAX_RETRANSMITS) {
+        drop(); //The broker is stuck. The message is sent again in the next session.
+        return;
+      }
+      retransmits++;
+      if(!sendPending(true)) {
+        return;
+      }
+    }
+    if(pingPending) {
+      if(now - pingSent > MQTT_KEEP_ALIVE * 1000UL) {
+        drop(); //The broker stopped answering
+      }
+    }
+    else if(now - lastSent >= MQTT_KEEP_ALIVE * 1000UL / 2) {
+      if(writePacket(MQTT_PINGREQ, nullptr, 0)) {
+        pingPending = true;
+        pingSent = now;
+      }
+      else {
+        drop();
+      }
+    }
+  }
+}
+
+/**
+ * Checks whether the session is established.
+ * @return
+ *  -true: If yes.
+ *  -false: otherwise.
+ */
+bool MqttTransport::isConnected() {
+  return state == MqttState::connected;
+}
+
+/**
+ * Ends the session. A message in flight is sent again in the next session.
+ */
+void MqttTransport::disconnect() {
+  if(state == MqttState::connected) {
+    writePacket(MQTT_DISCONNECT, nullptr, 0);
+  }
+  drop();
+  lastAttempt = 0; //The next connect may start right away
+}
+
+/**
+ * Checks whether a QoS 1 message waits for its acknowledgement.
+ * @return
+ *  -true: If yes.
+ *  -false: otherwise.
+ */
+bool MqttTransport::isInFlight() const {
+  return pendingId != 0;
+}
+
+/**
+ * Gives a description of the result of the last publish.
+ * @return The description.
+ */
+String MqttTransport::getLastResult() const {
+  switch(lastResult) {
+    case MqttResult::sent:
+      return "sent";
+    case MqttResult::acked:
+      return "acknowledged";
+    case MqttResult::notConnected:
+      return "not connected";
+    case MqttResult::topicTooLong:
+      return "topic too long";
+    case MqttResult::writeFailed:
+      return "connection failed";
+    case MqttResult::inFlight:
+      return "waiting for acknowledgement";
+    case MqttResult::busy:
+      return "last message not acknowledged yet";
+    default:
+      return "none";
+  }
+}
+
+/**
+ * Prints the message counters and round trip times over serial.
+ */
+void MqttTransport::printStats() const {
+  Serial.printf(" >> MQTT messages (QoS %u): published %lu, acknowledged %lu, sent again %lu, in flight %u, failed %lu, sessions %lu\n",
+                qos, (unsigned long)published, (unsigned long)acked, (unsigned long)retransmits,
+                pendingId? 1 : 0, (unsigned long)failures, (unsigned long)connections);
+  if(acked) {
+    Serial.printf(" >> MQTT round trip (last/min/avg/max): %lu/%lu/%lu/%lu us\n",
+                  (unsigned long)lastRoundTrip, (unsigned long)minRoundTrip,
+                  (unsigned long)(sumRoundTrip / acked), (unsigned long)maxRoundTrip);
+  }
+}
+
+/**
+ * Resets the message counters and round trip times.
+ */
+void MqttTransport::resetStats() {
+  lastRoundTrip = 0;
+  minRoundTrip = UINT32_MAX;
+  maxRoundTrip = 0;
+  sumRoundTrip = 0;
+  published = 0;
+  acked = 0;
+  retransmits = 0;
+  failures = 0;
+  connections = 0;
+}
+
+/**
+ * Writes a packet to the connection.
+ * @param header The first byte of the fixed header.
+ * @param head The variable header.
+ * @param headLength The length of the variable header.
+ * @param payload The payload.
+ * @param payloadLength The length of the payload.
+ * @return
+ *  -true: On success.
+ *  -false: If the connection failed.
+ */
+bool MqttTransport::writePacket(uint8_t header, const uint8_t* head, size_t headLength,
+                                const uint8_t* payload, size_t payloadLength) {
+  //Fixed header with the remaining length as variable length integer
+  uint8_t fixed[5] = {header};
+  size_t fixedLength = 1;
+  size_t remaining = headLength + payloadLength;
+  do {
+    uint8_t digit = remaining % 128;
+    remaining /= 128;
+    fixed[fixedLength++] = remaining? digit | 0x80 : digit;
+  } while(remaining && fixedLength < sizeof(fixed));
+  if(remaining) {
+    return false; //More than the 256 MB MQTT allows
+  }
+  if(client.write(fixed, fixedLength) != fixedLength ||
+     (headLength && client.write(head, headLength) != headLength) ||
+     (payloadLength && client.write(payload, payloadLength) != payloadLength)) {
+    return false;
+  }
+  lastSent = millis();
+  return true;
+}
+
+/**
+ * Sends the message in flight.
+ * @param dup If the message may have been sent before.
+ * @return
+ *  -true: On success.
+ *  -false: If the connection failed. The session is dropped then.
+ */
+bool MqttTransport::sendPending(bool dup) {
+  uint8_t header = MQTT_PUBLISH | MQTT_PUBLISH_QOS1 | (dup? MQTT_PUBLISH_DUP : 0);
+  pendingSent = millis();
+  pendingStart = micros();
+  pendingSends++;
+  if(!writePacket(header, pendingHead, pendingHeadLength,
+                  reinterpret_cast<const uint8_t*>(pendingPayload.c_str()), pendingPayload.length())) {
+    drop();
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Reads the bytes which arrived from the broker without waiting for more.
+ * A packet is handled once it is complete, so it may be read over several calls.
+ */
+void MqttTransport::receive() {
+  while(state != MqttState::disconnected && client.available()) {
+    uint8_t value = client.read();
+    switch(rxStep) {
+      case MqttRxStep::header:
+        rxHeader = value;
+        rxLength = 0;
+        rxCount = 0;
+        rxShift = 0;
+        rxStep = MqttRxStep::length;
+        break;
+      case MqttRxStep::length:
+        rxLength |= uint32_t(value & 0x7F) << rxShift;
+        rxShift += 7;
+        if(value & 0x80) {
+          if(rxShift >= 28) {
+            drop(); //The stream is out of sync
+          }
+        }
+        else if(rxLength == 0) {
+          rxStep = MqttRxStep::header;
+          handlePacket(rxHeader, rxBody, 0);
+        }
+        else {
+          rxStep = MqttRxStep::body;
+        }
+        break;
+      case MqttRxStep::body:
+        if(rxCount < MQTT_PACKET_BUFFER_SIZE) { //Bytes beyond the buffer are skipped
+          rxBody[rxCount] = value;
+        }
+        rxCount++;
+        if(rxCount == rxLength) {
+          rxStep = MqttRxStep::header;
+          handlePacket(rxHeader, rxBody, rxCount < MQTT_PACKET_BUFFER_SIZE? rxCount : MQTT_PACKET_BUFFER_SIZE);
+        }
+        break;
+    }
+  }
+}
+
+/**
+ * Handles a packet from the broker.
+ * @param header The first byte of the fixed header.
+ * @param body The start of the packet after the fixed header.
+ * @param length The number of stored bytes of the body.
+ */
+void MqttTransport::handlePacket(uint8_t header, const uint8_t* body, size_t length) {
+  switch(header & 0xF0) {
+    case MQTT_CONNACK:
+      if(state == MqttState::connecting) {
+        if(length >= 2 && body[1] == 0) {
+          state = MqttState::connected;
+          connections++;
+          if(pendingId) {
+            pendingSends = 0;
+            retransmits++;
+            sendPending(true); //The broker may have got it before the connection was lost
+          }
+        }
+        else {
+          drop(); //Refused by the broker
+        }
+      }
+      break;
+    case MQTT_PUBACK:
+      if(pendingId && length >= 2 && ((body[0] << 8) | body[1]) == pendingId) {
+        recordRoundTrip(micros() - pendingStart);
+        acked++;
+        pendingId = 0;
+        pendingPayload = "";
+        lastResult = MqttResult::acked;
+      }
+      break;
+    case MQTT_PINGRESP:
+      pingPending = false;
+      break;
+    default:
+      break; //Nothing else is expected without subscriptions
+  }
+}
+
+/**
+ * Closes the connection without telling the broker.
+ */
+void MqttTransport::drop() {
+  client.stop();
+  state = MqttState::disconnected;
+  rxStep = MqttRxStep::header;
+  pingPending = false;
+}
+
+/**
+ * Records the round trip time of an acknowledged message.
+ * @param roundTrip The round trip time in micro seconds.
+ */
+void MqttTransport::recordRoundTrip(uint32_t roundTrip) {
+  lastRoundTrip = roundTrip;
+  if(roundTrip < minRoundTrip) {
+    minRoundTrip = roundTrip;
+  }
+  if(roundTrip > maxRoundTrip) {
+    maxRoundTrip = roundTrip;
+  }
+  sumRoundTrip += roundTrip;
+}
@@ -0,0 +1,227 @@
+#pragma once
+/*************************************************************
+  A transport to publish data to an MQTT broker.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include <WiFiClient.h>
+#include "transport.h"
+
+//===========================================================
+// Definitions
+#define MQTT_PORT_DEFAULT 1883            //< Port of the broker if the url has none.
+#define MQTT_TOPIC_DEFAULT "ubis"         //< Base topic if the url has none.
+#define MQTT_TOPIC_MAX_LENGTH 128         //< Maximum length of a complete topic.
+#define MQTT_CLIENT_ID_SIZE 24            //< Size of the client id including the terminator.
+#define MQTT_KEEP_ALIVE 60                //< Keep alive interval announced to the broker in seconds.
+#define MQTT_CONNECT_TIMEOUT 500          //< Timeout of the TCP connect until a deadline is set in milli seconds.
+#define MQTT_CONNACK_TIMEOUT 5000         //< Timeout for the broker to accept the session in milli seconds.
+#define MQTT_ACK_TIMEOUT 2000             //< Time a QoS 1 message waits for its acknowledgement until it is sent again, until a deadline is set, in milli seconds.
+#define MQTT_MAX_RETRANSMITS 3            //< Number of times a QoS 1 message is sent again in one session before the session is dropped.
+#define MQTT_RETRY_INTERVAL 5000          //< Minimum time between two connect attempts in milli seconds.
+#define MQTT_PACKET_BUFFER_SIZE 8         //< Stored bytes of a received packet. Only acknowledgements are expected.
+
+//===========================================================
+// forward declared dependencies
+enum class MqttState: uint8_t;
+enum class MqttResult: uint8_t;
+enum class MqttRxStep: uint8_t;
+
+//===========================================================
+// Data Types
+
+/**
+ * Publishes data to an MQTT broker over one persistent MQTT 3.1.1 session.
+ * The broker is given as url "mqtt://host[:port][/topic][?qos=0|1]". Every message is
+ * published to the base topic of the url followed by the topic of the message.
+ * With QoS 0 a message counts as sent once it is written to the connection.
+ * With QoS 1 publish() does not wait for the broker either. The message is kept in flight until
+ * poll() receives its acknowledgement. It is sent again with the DUP flag if the acknowledgement
+ * is missing for the acknowledgement timeout and once a new session is established after the
+ * connection was lost. So it arrives at least once, maybe twice. One message is in flight at a time,
+ * publish() fails while the last one is not acknowledged, so the caller keeps its data.
+ * Nothing waits for the broker except the TCP connect.
+ * Only publishing is supported. Nothing is subscribed.
+ */
+class MqttTransport: public Transport {
+  private:
+    WiFiClient client;                  //< The TCP connection to the broker.
+    String host = "";                   //< Host name of the broker.
+    uint16_t port = MQTT_PORT_DEFAULT;  //< Port of the broker.
+    String baseTopic = MQTT_TOPIC_DEFAULT; //< Topic all messages are published under.
+    uint8_t qos = 0;                    //< The quality of service of the published messages.
+    char clientId[MQTT_CLIENT_ID_SIZE]; //< The client id of the session. Derived from the MAC address.
+    MqttState state;                    //< The state of the session.
+    MqttResult lastResult;              //< The result of the last publish.
+    MqttRxStep rxStep;                  //< The part of the received packet which is read next.
+    uint8_t rxHeader = 0;               //< The first byte of the received packet.
+    uint32_t rxLength = 0;              //< The remaining length of the received packet.
+    uint32_t rxCount = 0;               //< Number of read bytes of the remaining length.
+    uint8_t rxShift = 0;                //< Position of the next digit of the remaining length.
+    uint8_t rxBody[MQTT_PACKET_BUFFER_SIZE]; //< Stored bytes of the received packet after the fixed header.
+    uint8_t pendingHead[2 + MQTT_TOPIC_MAX_LENGTH + 2]; //< Variable header of the message in flight.
+    size_t pendingHeadLength = 0;       //< Length of the variable header of the message in flight.
+    String pendingPayload = "";         //< Payload of the message in flight.
+    uint16_t pendingId = 0;             //< Packet id of the message in flight. 0 if there is none.
+    uint8_t pendingSends = 0;           //< Number of times the message in flight was sent in this session.
+    uint32_t pendingSent = 0;           //< Time the message in flight was sent last in milli seconds.
+    uint32_t pendingStart = 0;          //< Time the message in flight was sent last in micro seconds.
+    uint32_t connectStart = 0;          //< Time the session was requested in milli seconds.
+    uint32_t lastAttempt = 0;           //< Time of the last connect attempt in milli seconds.
+    uint32_t lastSent = 0;              //< Time of the last sent packet in milli seconds.
+    uint32_t pingSent = 0;              //< Time of the last unanswered ping in milli seconds.
+    bool pingPending = false;           //< If a ping is not answered yet.
+    uint16_t nextPacketId = 1;          //< The id of the next QoS 1 message.
+    uint16_t connectTimeout = MQTT_CONNECT_TIMEOUT; //< Timeout of the TCP connect in milli seconds.
+    uint16_t ackTimeout = MQTT_ACK_TIMEOUT;         //< Time a QoS 1 message waits for its acknowledgement until it is sent again in milli seconds.
+    uint32_t lastRoundTrip = 0;         //< Time until the last QoS 1 message was acknowledged in micro seconds.
+    uint32_t minRoundTrip = UINT32_MAX; //< Lowest round trip time in micro seconds.
+    uint32_t maxRoundTrip = 0;          //< Highest round trip time in micro seconds.
+    uint64_t sumRoundTrip = 0;          //< Sum of all round trip times in micro seconds.
+    uint32_t published = 0;             //< Number of published messages.
+    uint32_t acked = 0;                 //< Number of acknowledged messages.
+    uint32_t retransmits = 0;           //< Number of QoS 1 messages sent again.
+    uint32_t failures = 0;              //< Number of messages which could not be published.
+    uint32_t connections = 0;           //< Number of established sessions.
+
+    /**
+     * Writes a packet to the connection.
+     * @param header The first byte of the fixed header.
+     * @param head The variable header.
+     * @param headLength The length of the variable header.
+     * @param payload The payload.
+     * @param payloadLength The length of the payload.
+     * @return
+     *  -true: On success.
+     *  -false: If the connection failed.
+     */
+    bool writePacket(uint8_t header, const uint8_t* head, size_t headLength,
+                     const uint8_t* payload = nullptr, size_t payloadLength = 0);
+
+    /**
+     * Sends the message in flight.
+     * @param dup If the message may have been sent before.
+     * @return
+     *  -true: On success.
+     *  -false: If the connection failed. The session is dropped then.
+     */
+    bool sendPending(bool dup);
+
+    /**
+     * Reads the bytes which arrived from the broker without waiting for more.
+     * A packet is handled once it is complete, so it may be read over several calls.
+     */
+    void receive();
+
+    /**
+     * Handles a packet from the broker.
+     * @param header The first byte of the fixed header.
+     * @param body The start of the packet after the fixed header.
+     * @param length The number of stored bytes of the body.
+     */
+    void handlePacket(uint8_t header, const uint8_t* body, size_t length);
+
+    /**
+     * Closes the connection without telling the broker.
+     */
+    void drop();
+
+    /**
+     * Records the round trip time of an acknowledged message.
+     * @param roundTrip The round trip time in micro seconds.
+     */
+    void recordRoundTrip(uint32_t roundTrip);
+
+  public:
+    /**
+     * Constructs a MqttTransport without broker.
+     */
+    MqttTransport();
+
+    /**
+     * Sets the broker. Closes the session to a former broker.
+     * @param url The url of the broker: "mqtt://host[:port][/topic][?qos=0|1]".
+     * @return
+     *  -true: On success.
+     *  -false: If the url is malformed.
+     */
+    bool setUrl(const String& url);
+
+    /**
+     * Sets the time the broker gets to answer.
+     * The TCP connect gets half of it. A QoS 1 message is sent again if it is not acknowledged within all of it.
+     * @param deadline The deadline in milli seconds.
+     */
+    void setDeadline(uint16_t deadline);
+
+    /**
+     * Gives the name of the transport.
+     * @return The name.
+     */
+    const char* getName() const override;
+
+    /**
+     * Opens the connection to the broker and requests a session.
+     * The broker accepts the session in poll(). Waits at most the connect timeout for the TCP connection.
+     * @return
+     *  -true: If the session is established or requested.
+     *  -false: If there is no broker, the last attempt was less than MQTT_RETRY_INTERVAL ago or the broker is not reachable.
+     */
+    bool connect() override;
+
+    /**
+     * Publishes a message with the configured quality of service.
+     * @param topic The topic of the message below the base topic.
+     * @param payload The message. May be binary.
+     * @param contentType Unused. MQTT 3.1.1 has no content type.
+     * @return
+     *  -true: If the message was written. With QoS 1 it is kept in flight until it is acknowledged.
+     *  -false: If there is no session or the last QoS 1 message is not acknowledged yet.
+     */
+    bool publish(const char* topic, const String& payload, const char* contentType) override;
+
+    /**
+     * Handles the packets from the broker, sends the message in flight again if its acknowledgement
+     * is missing and keeps the session alive with pings. Drops the session if the broker does not answer.
+     */
+    void poll() override;
+
+    /**
+     * Checks whether the session is established.
+     * @return
+     *  -true: If yes.
+     *  -false: otherwise.
+     */
+    bool isConnected() override;
+
+    /**
+     * Ends the session. A message in flight is sent again in the next session.
+     */
+    void disconnect() override;
+
+    /**
+     * Checks whether a QoS 1 message waits for its acknowledgement.
+     * @return
+     *  -true: If yes.
+     *  -false: otherwise.
+     */
+    bool isInFlight() const;
+
+    /**
+     * Gives a description of the result of the last publish.
+     * @return The description.
+     */
+    String getLastResult() const override;
+
+    /**
+     * Prints the message counters and round trip times over serial.
+     */
+    void printStats() const override;
+
+    /**
+     * Resets the message counters and round trip times.
+     */
+    void resetStats() override;
+};
@@ -0,0 +1,85 @@
+/*************************************************************
+  The implementation of a scheduler to prioritize the outbound traffic to the servers.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "outbound_scheduler.h"
+
+//===========================================================
+// Static data
+
+/**
+ * The names of the traffic classes in the order of TrafficClass.
+ */
+static const char* const trafficClassNames[] = {
+  "alert",
+  "bulk"
+};
+
+//===========================================================
+// Member function implementations
+
+/**
+ * Queues an alert. Drops the oldest alert if the queue is full.
+ * @param type The type of the alert.
+ * @param name The identifier name of the event. Has to stay valid until the alert is sent.
+ * @param description The description of the event. Has to stay valid until the alert is sent.
+ * @param timestamp Time of the event in milli seconds.
+ */
+void OutboundScheduler::pushAlert(AlertType type, const char* name, const char* description, uint32_t timestamp) {
+  OutboundAlert alert = {type, name, description, timestamp};
+  if(!alerts.push(alert)) {
+    OutboundAlert oldest;
+    alerts.pop(oldest); //Producer and consumer are the same task here
+    alerts.push(alert);
+    recordDropped(TrafficClass::alert);
+  }
+}
+
+/**
+ * Records a sent item.
+ * @param trafficClass The traffic class of the item.
+ * @param latency Time from the creation of the item until it was sent in milli seconds.
+ */
+void OutboundScheduler::recordSent(TrafficClass trafficClass, uint32_t latency) {
+  ClassStats& classStats = stats[static_cast<uint8_t>(trafficClass)];
+  classStats.sent++;
+  classStats.lastLatency = latency;
+  if(latency > classStats.maxLatency) {
+    classStats.maxLatency = latency;
+  }
+  classStats.sumLatency += latency;
+  if(trafficClass == TrafficClass::alert && latency > OUTBOUND_ALERT_SLO) {
+    classStats.sloMisses++;
+  }
+}
+
+/**
+ * Prints the queue depth, the counters and the latencies of every traffic class over serial.
+ * @param bulkDepth Number of bulk records waiting in the telemetry buffers.
+ */
+void OutboundScheduler::printStats(uint32_t bulkDepth) const {
+  Serial.println(" >> Outbound traffic (queued/sent/dropped/deferred, latency last/avg/max):");
+  for(uint8_t i = 0; i < TRAFFIC_CLASS_COUNT; i++) {
+    const ClassStats& classStats = stats[i];
+    uint32_t depth = i == static_cast<uint8_t>(TrafficClass::alert)? alerts.size() : bulkDepth;
+    Serial.printf("    %-6s %lu/%lu/%lu/%lu, %lu/%lu/%lu ms\n", trafficClassNames[i],
+                  (unsigned long)depth, (unsigned long)classStats.sent,
+                  (unsigned long)classStats.dropped, (unsigned long)classStats.deferred,
+                  (unsigned long)classStats.lastLatency,
+                  (unsigned long)(classStats.sent? classStats.sumLatency / classStats.sent : 0),
+                  (unsigned long)classStats.maxLatency);
+  }
+  Serial.printf(" >> Alerts later than %u ms: %lu\n", OUTBOUND_ALERT_SLO,
+                (unsigned long)stats[static_cast<uint8_t>(TrafficClass::alert)].sloMisses);
+}
+
+/**
+ * Resets the counters and latencies.
+ */
+void OutboundScheduler::resetStats() {
+  for(ClassStats& classStats : stats) {
+    classStats = ClassStats();
+  }
+}
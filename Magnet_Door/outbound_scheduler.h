@@ -0,0 +1,142 @@
+#pragma once
+/*************************************************************
+  A scheduler to prioritize the outbound traffic to the servers.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include "spsc_ring.h"
+
+//===========================================================
+// Definitions
+#define OUTBOUND_ALERT_QUEUE_SIZE 16      //< Number of alerts which can wait to be sent. Has to be a power of two.
+#define OUTBOUND_ALERT_BURST 4            //< Maximum number of alerts sent per dispatch.
+#define OUTBOUND_ALERT_SLO 2000           //< Latency objective of an alert from its event until it is sent in milli seconds.
+#define TRAFFIC_CLASS_COUNT 2             //< Number of traffic classes.
+#define ALERT_TYPE_COUNT 3                //< Number of alert types.
+
+//===========================================================
+// Data Types
+
+/**
+ * The classes of outbound traffic in the order of their priority.
+ */
+enum class TrafficClass: uint8_t {
+  alert,                              //< Event notifications. Always sent first.
+  bulk                                //< Telemetry and its backlog. Deferred while alerts are waiting.
+};
+
+/**
+ * The types of alerts. Related events share a type, e.g. the door opened and closed events.
+ */
+enum class AlertType: uint8_t {
+  door,                               //< The door was opened or closed.
+  roomLoad,                           //< The room became full or not full.
+  personsInRoom                       //< There are persons in the closed room.
+};
+
+/**
+ * An event notification waiting to be sent.
+ */
+struct OutboundAlert {
+  AlertType type;                     //< The type of the alert.
+  const char* name;                   //< The identifier name of the event.
+  const char* description;            //< The description which is sent with the event.
+  uint32_t timestamp;                 //< Time of the event in milli seconds.
+};
+
+/**
+ * Decides the order of the outbound traffic.
+ * Alerts are queued and always sent before any bulk data. Bulk data is deferred as long as
+ * alerts are waiting to be sent, its own buffers drop the oldest data under pressure.
+ * If the alert queue runs full, the oldest alert is dropped.
+ * Counts the sent, dropped and deferred items and the end-to-end latency per traffic class.
+ * All methods are called by one task.
+ */
+class OutboundScheduler {
+  private:
+    /**
+     * The statistics of one traffic class.
+     */
+    struct ClassStats {
+      uint32_t sent = 0;              //< Number of sent items.
+      uint32_t dropped = 0;           //< Number of dropped items.
+      uint32_t deferred = 0;          //< Number of times the class had to wait for a higher class.
+      uint32_t sloMisses = 0;         //< Number of items sent later than their latency objective.
+      uint32_t lastLatency = 0;       //< Latency of the last sent item in milli seconds.
+      uint32_t maxLatency = 0;        //< Highest latency in milli seconds.
+      uint64_t sumLatency = 0;        //< Sum of all latencies in milli seconds.
+    };
+
+    SpscRing<OutboundAlert, OUTBOUND_ALERT_QUEUE_SIZE> alerts;  //< The alerts waiting to be sent.
+    ClassStats stats[TRAFFIC_CLASS_COUNT];                      //< The statistics per traffic class.
+
+  public:
+    /**
+     * Queues an alert. Drops the oldest alert if the queue is full.
+     * @param type The type of the alert.
+     * @param name The identifier name of the event. Has to stay valid until the alert is sent.
+     * @param description The description of the event. Has to stay valid until the alert is sent.
+     * @param timestamp Time of the event in milli seconds.
+     */
+    void pushAlert(AlertType type, const char* name, const char* description, uint32_t timestamp);
+
+    /**
+     * Takes the oldest waiting alert out of the queue.
+     * @param[out] alert The alert.
+     * @return
+     *  -true: On success.
+     *  -false: If no alert is waiting.
+     */
+    bool popAlert(OutboundAlert& alert);
+
+    /**
+     * Reads the oldest waiting alert without taking it out of the queue.
+     * @param[out] alert The alert.
+     * @return
+     *  -true: On success.
+     *  -false: If no alert is waiting.
+     */
+    bool peekAlert(OutboundAlert& alert);
+
+    /**
+     * Checks whether alerts are waiting to be sent.
+     * @return
+     *  -true: If yes.
+     *  -false: otherwise.
+     */
+    bool hasAlerts() const;
+
+    /**
+     * Records a sent item.
+     * @param trafficClass The traffic class of the item.
+     * @param latency Time from the creation of the item until it was sent in milli seconds.
+     */
+    void recordSent(TrafficClass trafficClass, uint32_t latency);
+
+    /**
+     * Records that a due item of a traffic class had to wait for a higher class.
+     * @param trafficClass The traffic class of the item.
+     */
+    void recordDeferred(TrafficClass trafficClass);
+
+    /**
+     * Records an item which was given up, e.g. the oldest alert of a full queue.
+     * @param trafficClass The traffic class of the item.
+     */
+    void recordDropped(TrafficClass trafficClass);
+
+    /**
+     * Prints the queue depth, the counters and the latencies of every traffic class over serial.
+     * @param bulkDepth Number of bulk records waiting in the telemetry buffers.
+     */
+    void printStats(uint32_t bulkDepth) const;
+
+    /**
+     * Resets the counters and latencies.
+     */
+    void resetStats();
+};
+
+#include "outbound_scheduler_inline.h"
@@ -0,0 +1,54 @@
+//===========================================================
+// included dependencies
+#include "outbound_scheduler.h"
+
+//===========================================================
+// Inline member function implementations
+
+/**
+ * Takes the oldest waiting alert out of the queue.
+ * @param[out] alert The alert.
+ * @return
+ *  -true: On success.
+ *  -false: If no alert is waiting.
+ */
+inline bool OutboundScheduler::popAlert(OutboundAlert& alert) {
+  return alerts.pop(alert);
+}
+
+/**
+ * Reads the oldest waiting alert without taking it out of the queue.
+ * @param[out] alert The alert.
+ * @return
+ *  -true: On success.
+ *  -false: If no alert is waiting.
+ */
+inline bool OutboundScheduler::peekAlert(OutboundAlert& alert) {
+  return alerts.peek(alert);
+}
+
+/**
+ * Checks whether alerts are waiting to be sent.
+ * @return
+ *  -true: If yes.
+ *  -false: otherwise.
+ */
+inline bool OutboundScheduler::hasAlerts() const {
+  return !alerts.isEmpty();
+}
+
+/**
+ * Records that a due item of a traffic class had to wait for a higher class.
+ * @param trafficClass The traffic class of the item.
+ */
+inline void OutboundScheduler::recordDeferred(TrafficClass trafficClass) {
+  stats[static_cast<uint8_t>(trafficClass)].deferred++;
+}
+
+/**
+ * Records an item which was given up, e.g. the oldest alert of a full queue.
+ * @param trafficClass The traffic class of the item.
+ */
+inline void OutboundScheduler::recordDropped(TrafficClass trafficClass) {
+  stats[static_cast<uint8_t>(trafficClass)].dropped++;
+}
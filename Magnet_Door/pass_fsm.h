@@ -0,0 +1,135 @@
+#pragma once
+/*************************************************************
+  A table driven state machine to follow door passings with two detectors.
+  Only depends on the C++ standard library, so it can also be built on a host.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include <cstdint>
+#include "table_fsm.h"
+
+//===========================================================
+// Definitions
+#define PASS_CODE_NONE 0           //< No detector is passed.
+#define PASS_CODE_OUTER 1          //< Only the outer detector is passed.
+#define PASS_CODE_INNER 2          //< Only the inner detector is passed.
+#define PASS_CODE_BOTH 3           //< Both detectors are passed.
+
+//===========================================================
+// Data Types
+
+/**
+ * Represents the states the door passing FSM can be in.
+ */
+enum class PassState: uint8_t {
+  idle,           //< Nothing happens
+  startEntering,  //< Someone starts to enter by passing the outer detector.
+  entering1,      //< Someone who enters stepped further in and now passes both detectors at the same time.
+  entering2,      //< Someone who enters stepped further in and now passes only the inner detector.
+  entered,        //< Someone fully entered.
+  startLeaving,   //< Someone starts to leave by passing the inner detector.
+  leaving1,       //< Someone who leaves stepped further out and now passes both detectors at the same time.
+  leaving2,       //< Someone who leaves stepped further out and now passes only the outer detector.
+  left            //< Someone fully left.
+};
+
+/**
+ * The events a step of the door passing FSM can register.
+ */
+enum class PassEvent: uint8_t {
+  none,           //< Nothing to register.
+  entered,        //< Someone fully entered.
+  left,           //< Someone fully left.
+  enteringError,  //< The detectors were passed in an order not allowed during entering.
+  leavingError    //< The detectors were passed in an order not allowed during leaving.
+};
+
+/**
+ * The description of the door passing FSM for TableFsm.
+ * The input is one consistent sample of both detectors as a 2 bit code.
+ * Entered and left behave like idle, so the next passing can start right away.
+ * Assumes that only one person can pass the door at the same time.
+ */
+struct PassFsmDescription {
+  typedef PassState State;
+  typedef PassEvent Event;
+  static constexpr PassState initial = PassState::idle;   //< The state the FSM starts in.
+  static constexpr uint8_t inputCount = 4;                //< Number of detector codes.
+
+  /**
+   * The transition table indexed by the state and the detector code.
+   * Columns are ordered by PASS_CODE_NONE, PASS_CODE_OUTER, PASS_CODE_INNER and PASS_CODE_BOTH.
+   */
+  static constexpr FsmTransition<PassState, PassEvent> table[9][4] = {
+    //idle
+    {{PassState::idle, PassEvent::none},
+     {PassState::startEntering, PassEvent::none},
+     {PassState::startLeaving, PassEvent::none},
+     {PassState::idle, PassEvent::none}},
+    //startEntering
+    {{PassState::idle, PassEvent::none},                   //Stepped back from entering
+     {PassState::startEntering, PassEvent::none},
+     {PassState::idle, PassEvent::enteringError},
+     {PassState::entering1, PassEvent::none}},
+    //entering1
+    {{PassState::idle, PassEvent::enteringError},
+     {PassState::startEntering, PassEvent::none},          //Stepped back
+     {PassState::entering2, PassEvent::none},
+     {PassState::entering1, PassEvent::none}},
+    //entering2
+    {{PassState::entered, PassEvent::entered},
+     {PassState::idle, PassEvent::enteringError},
+     {PassState::entering2, PassEvent::none},
+     {PassState::entering1, PassEvent::none}},             //Stepped back
+    //entered
+    {{PassState::idle, PassEvent::none},
+     {PassState::startEntering, PassEvent::none},
+     {PassState::startLeaving, PassEvent::none},
+     {PassState::idle, PassEvent::none}},
+    //startLeaving
+    {{PassState::idle, PassEvent::none},                   //Stepped back from leaving
+     {PassState::idle, PassEvent::leavingError},
+     {PassState::startLeaving, PassEvent::none},
+     {PassState::leaving1, PassEvent::none}},
+    //leaving1
+    {{PassState::idle, PassEvent::leavingError},
+     {PassState::leaving2, PassEvent::none},
+     {PassState::startLeaving, PassEvent::none},           //Stepped back
+     {PassState::leaving1, PassEvent::none}},
+    //leaving2
+    {{PassState::left, PassEvent::left},
+     {PassState::leaving2, PassEvent::none},
+     {PassState::idle, PassEvent::leavingError},
+     {PassState::leaving1, PassEvent::none}},              //Stepped back
+    //left
+    {{PassState::idle, PassEvent::none},
+     {PassState::startEntering, PassEvent::none},
+     {PassState::startLeaving, PassEvent::none},
+     {PassState::idle, PassEvent::none}}
+  };
+};
+
+/**
+ * An entry of the transition table of the door passing FSM.
+ */
+typedef FsmTransition<PassState, PassEvent> PassTransition;
+
+/**
+ * Follows door passings by a state machine with a constant transition table.
+ * Each step takes one consistent sample of both detectors as a 2 bit code
+ * and determines the next state with a single table lookup.
+ */
+class PassFsm: public TableFsm<PassFsmDescription> {
+  public:
+    /**
+     * Encodes the detector levels into a 2 bit code.
+     * The detectors are active low, so a low level means the detector is passed.
+     * @param outerLevel Level of the outer detector.
+     * @param innerLevel Level of the inner detector.
+     * @return The detector code.
+     */
+    static constexpr uint8_t encode(bool outerLevel, bool innerLevel) {
+      return (outerLevel? 0 : PASS_CODE_OUTER) | (innerLevel? 0 : PASS_CODE_INNER);
+    }
+};
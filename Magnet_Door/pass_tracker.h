@@ -0,0 +1,272 @@
+#pragma once
+/*************************************************************
+  A tracker to follow several overlapping door passings with two detectors.
+  Only depends on the C++ standard library, so it can also be built on a host.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include <cstdint>
+#include "pass_fsm.h"
+
+//===========================================================
+// Definitions
+#define PASS_TRACKER_MAX_TRACKS 4            //< Maximum number of door passings which can be followed at the same time.
+#define PASS_TRACKER_SETTLE_TIME 1500000     //< Time after which a passing which could still be a step back is counted in micro seconds.
+
+//===========================================================
+// Data Types
+
+/**
+ * The door passings resolved by the tracker.
+ */
+struct PassTrackResult {
+  uint8_t entered = 0;                 //< Number of persons who fully entered.
+  uint8_t left = 0;                    //< Number of persons who fully left.
+  uint8_t lost = 0;                    //< Number of passings which could not be followed any longer.
+  uint8_t aborted = 0;                 //< Number of passings which did not finish before the door closed.
+};
+
+/**
+ * Follows several door passings at the same time by the edges of the two detectors.
+ * Each beam break is owned by one passing. A passing starts with a break of the
+ * detector on its side and reaches the other detector with the next break there.
+ * Persons pass the door in order, so a break of the second detector is assigned to the
+ * oldest passing waiting for it and a release to the oldest passing owning the detector.
+ * A passing is registered once both of its detectors were released after reaching the
+ * second one. If a younger passing in the same direction still waits at the first detector,
+ * it can also be the same person stepping back. Then the registration is delayed
+ * until the younger passing reaches the second detector, it steps back as well or
+ * PASS_TRACKER_SETTLE_TIME is over.
+ * Persons occluding a detector without a gap in between can not be told apart.
+ */
+class PassTracker {
+  private:
+    /**
+     * A door passing which is followed.
+     */
+    struct Track {
+      bool entering;                   //< If the passing started at the outer detector.
+      bool holdsFirst;                 //< If the detector the passing started at is occluded by it.
+      bool holdsSecond;                //< If the detector the passing ends at is occluded by it.
+      bool reachedSecond;              //< If the passing reached the detector it ends at.
+      bool passed;                     //< If the passing released both detectors and waits for its registration.
+      uint32_t passTime;               //< Time both detectors were released in micro seconds.
+    };
+
+    Track tracks[PASS_TRACKER_MAX_TRACKS];   //< The followed passings ordered from oldest to youngest.
+    uint8_t trackCount = 0;                  //< Number of followed passings.
+
+    /**
+     * Gives the detector a passing starts at.
+     * @param track The passing.
+     * @return The detector code.
+     */
+    static uint8_t firstOf(const Track& track) {
+      return track.entering? PASS_CODE_OUTER : PASS_CODE_INNER;
+    }
+
+    /**
+     * Gives the detector a passing ends at.
+     * @param track The passing.
+     * @return The detector code.
+     */
+    static uint8_t secondOf(const Track& track) {
+      return track.entering? PASS_CODE_INNER : PASS_CODE_OUTER;
+    }
+
+    /**
+     * Adds a passing to the result.
+     * @param track The passing.
+     * @param[out] result The result the passing is added to.
+     */
+    static void count(const Track& track, PassTrackResult& result) {
+      if(track.entering) {
+        result.entered++;
+      }
+      else {
+        result.left++;
+      }
+    }
+
+    /**
+     * Stops following a passing.
+     * @param index The index of the passing.
+     */
+    void remove(uint8_t index) {
+      for(uint8_t i = index + 1; i < trackCount; i++) {
+        tracks[i - 1] = tracks[i];
+      }
+      trackCount--;
+    }
+
+    /**
+     * Checks whether a younger passing in the same direction still waits at its first detector.
+     * @param index The index of the passing.
+     * @return
+     *  -true: If there is such a passing.
+     *  -false: otherwise.
+     */
+    bool hasWaitingSuccessor(uint8_t index) const {
+      for(uint8_t i = index + 1; i < trackCount; i++) {
+        if(tracks[i].entering == tracks[index].entering && tracks[i].holdsFirst && !tracks[i].reachedSecond) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /**
+     * Handles a break of a detector beam.
+     * @param code The detector code of the detector.
+     * @param[out] result The resolved passings.
+     */
+    void onBreak(uint8_t code, PassTrackResult& result) {
+      //The oldest passing waiting for the detector reaches it
+      for(uint8_t i = 0; i < trackCount; i++) {
+        Track& track = tracks[i];
+        if(!track.passed && secondOf(track) == code && !track.holdsSecond) {
+          track.holdsSecond = true;
+          track.reachedSecond = true;
+          //Older passings waiting for their registration could not have been a step back of this one
+          for(uint8_t j = i; j-- > 0;) {
+            if(tracks[j].passed && tracks[j].entering == track.entering) {
+              count(tracks[j], result);
+              remove(j);
+            }
+          }
+          return;
+        }
+      }
+
+      //Someone starts a new passing
+      if(trackCount >= PASS_TRACKER_MAX_TRACKS) {
+        if(tracks[0].passed) {
+          count(tracks[0], result);
+        }
+        else {
+          result.lost++;
+        }
+        remove(0);
+      }
+      tracks[trackCount++] = {code == PASS_CODE_OUTER, true, false, false, false, 0};
+    }
+
+    /**
+     * Handles a release of a detector beam.
+     * @param code The detector code of the detector.
+     * @param timestamp Time of the release in micro seconds.
+     * @param[out] result The resolved passings.
+     */
+    void onRelease(uint8_t code, uint32_t timestamp, PassTrackResult& result) {
+      for(uint8_t i = 0; i < trackCount; i++) {
+        Track& track = tracks[i];
+        if(track.holdsSecond && secondOf(track) == code) {
+          track.holdsSecond = false;
+          if(!track.holdsFirst) { //Passed both detectors
+            if(hasWaitingSuccessor(i)) {
+              track.passed = true;
+              track.passTime = timestamp;
+            }
+            else {
+              count(track, result);
+              remove(i);
+            }
+          }
+          return;
+        }
+        if(track.holdsFirst && firstOf(track) == code) {
+          track.holdsFirst = false;
+          if(!track.holdsSecond) { //Stepped back out of the door
+            if(!track.reachedSecond) {
+              //Can be the step back of the youngest passing waiting for its registration
+              for(uint8_t j = i; j-- > 0;) {
+                if(tracks[j].passed && tracks[j].entering == track.entering) {
+                  remove(i);
+                  remove(j);
+                  return;
+                }
+              }
+            }
+            remove(i);
+          }
+          return;
+        }
+      }
+      //Release of a break which was not followed, e.g. occluded before start up
+    }
+
+  public:
+    /**
+     * Handles a level change of a detector.
+     * The detectors are active low, so a low level means the detector is passed.
+     * @param code The detector code of the detector, PASS_CODE_OUTER or PASS_CODE_INNER.
+     * @param level Level of the detector after the change.
+     * @param timestamp Time of the change in micro seconds.
+     * @return The resolved passings.
+     */
+    PassTrackResult onEdge(uint8_t code, bool level, uint32_t timestamp) {
+      PassTrackResult result = update(timestamp);
+      if(!level) {
+        onBreak(code, result);
+      }
+      else {
+        onRelease(code, timestamp, result);
+      }
+      return result;
+    }
+
+    /**
+     * Registers passings which waited longer than PASS_TRACKER_SETTLE_TIME.
+     * @param now The current time in micro seconds.
+     * @return The resolved passings.
+     */
+    PassTrackResult update(uint32_t now) {
+      PassTrackResult result;
+      for(uint8_t i = 0; i < trackCount;) {
+        if(tracks[i].passed && now - tracks[i].passTime >= PASS_TRACKER_SETTLE_TIME) {
+          count(tracks[i], result);
+          remove(i);
+        }
+        else {
+          i++;
+        }
+      }
+      return result;
+    }
+
+    /**
+     * Ends all passings, e.g. when the door closes.
+     * Passings which only wait for their registration are registered, all others are aborted.
+     * Otherwise a passing which did not finish could be continued by an unrelated edge after the door opens again.
+     * @return The resolved passings.
+     */
+    PassTrackResult finish() {
+      PassTrackResult result;
+      for(uint8_t i = 0; i < trackCount; i++) {
+        if(tracks[i].passed) {
+          count(tracks[i], result);
+        }
+        else {
+          result.aborted++;
+        }
+      }
+      trackCount = 0;
+      return result;
+    }
+
+    /**
+     * Gives the number of followed passings.
+     * @return Number of passings.
+     */
+    uint8_t getTrackCount() const {
+      return trackCount;
+    }
+
+    /**
+     * Stops following all passings.
+     */
+    void reset() {
+      trackCount = 0;
+    }
+};
@@ -62,22 +62,25 @@ bool deleteWifiConfig() {
 
 /**
  * Loads the room capacity configuration from the flash memory.
- * @param count The value to be loaded.
+ * The low byte stays at its former address, the high byte is appended to the layout.
  * @return The loaded max person count.
  */
-uint8_t loadRoomCapConfig() {
-  return EEPROM.readByte(ROOM_CAP_START_ADRR);
+uint16_t loadRoomCapConfig() {
+  //The EEPROM emulation fills grown memory with 0, so a former one byte capacity reads unchanged
+  return EEPROM.readByte(ROOM_CAP_START_ADRR) | (EEPROM.readByte(ROOM_CAP_HIGH_START_ADDR) << 8);
 }
 
 /**
  * Stores the room capacity configuration into the flash memory.
+ * The low byte stays at its former address, the high byte is appended to the layout.
  * @param count The value to be stored.
  * @return 
  * -true: On success.
  * -false: otherwise.
  */
-bool storeRoomCapConfig(uint8_t count) {
-  EEPROM.writeByte(ROOM_CAP_START_ADRR,count);
+bool storeRoomCapConfig(uint16_t count) {
+  EEPROM.writeByte(ROOM_CAP_START_ADRR,count & 0xFF);
+  EEPROM.writeByte(ROOM_CAP_HIGH_START_ADDR,count >> 8);
   return EEPROM.commit();
 }
 
@@ -107,6 +110,127 @@ bool storeServerUrlConfig(const String& serverUrl) {
   return EEPROM.commit();
 }
 
+/**
+ * Loads the telemetry batching configuration from the flash memory.
+ * @param[out] batchSize The number of records which trigger an upload.
+ * @param[out] flushInterval The age of the oldest record which triggers an upload in seconds.
+ */
+void loadTelemetryConfig(uint16_t& batchSize, uint16_t& flushInterval) {
+  batchSize = EEPROM.readUShort(TELEMETRY_CONFIG_START_ADDR);
+  flushInterval = EEPROM.readUShort(TELEMETRY_CONFIG_START_ADDR + 2);
+}
+
+/**
+ * Stores the telemetry batching configuration into the flash memory.
+ * @param batchSize The number of records which trigger an upload.
+ * @param flushInterval The age of the oldest record which triggers an upload in seconds.
+ * @return 
+ * -true: On success.
+ * -false: otherwise.
+ */
+bool storeTelemetryConfig(uint16_t batchSize, uint16_t flushInterval) {
+  EEPROM.writeUShort(TELEMETRY_CONFIG_START_ADDR, batchSize);
+  EEPROM.writeUShort(TELEMETRY_CONFIG_START_ADDR + 2, flushInterval);
+  return EEPROM.commit();
+}
+
+/**
+ * Loads the telemetry reporting configuration from the flash memory.
+ * @param[out] mode The telemetry mode.
+ * @param[out] heartbeat The time without change until a heartbeat is recorded in seconds.
+ * @param[out] temperatureDelta The temperature change which is recorded in change mode in °C.
+ */
+void loadTelemetryReportConfig(uint8_t& mode, uint16_t& heartbeat, float& temperatureDelta) {
+  mode = EEPROM.readByte(TELEMETRY_REPORT_START_ADDR);
+  heartbeat = EEPROM.readUShort(TELEMETRY_REPORT_START_ADDR + 1);
+  temperatureDelta = EEPROM.readFloat(TELEMETRY_REPORT_START_ADDR + 3);
+}
+
+/**
+ * Stores the telemetry reporting configuration into the flash memory.
+ * @param mode The telemetry mode.
+ * @param heartbeat The time without change until a heartbeat is recorded in seconds.
+ * @param temperatureDelta The temperature change which is recorded in change mode in °C.
+ * @return 
+ * -true: On success.
+ * -false: otherwise.
+ */
+bool storeTelemetryReportConfig(uint8_t mode, uint16_t heartbeat, float temperatureDelta) {
+  EEPROM.writeByte(TELEMETRY_REPORT_START_ADDR, mode);
+  EEPROM.writeUShort(TELEMETRY_REPORT_START_ADDR + 1, heartbeat);
+  EEPROM.writeFloat(TELEMETRY_REPORT_START_ADDR + 3, temperatureDelta);
+  return EEPROM.commit();
+}
+
+/**
+ * Loads the alert budget of an alert type from the flash memory.
+ * @param type The number of the alert type.
+ * @return The number of alerts per window.
+ */
+uint8_t loadAlertBudgetConfig(uint8_t type) {
+  return EEPROM.readByte(ALERT_BUDGET_START_ADDR + type);
+}
+
+/**
+ * Stores the alert budget of an alert type into the flash memory.
+ * @param type The number of the alert type.
+ * @param budget The number of alerts per window.
+ * @return 
+ * -true: On success.
+ * -false: otherwise.
+ */
+bool storeAlertBudgetConfig(uint8_t type, uint8_t budget) {
+  EEPROM.writeByte(ALERT_BUDGET_START_ADDR + type, budget);
+  return EEPROM.commit();
+}
+
+/**
+ * Loads the send deadline from the flash memory.
+ * @return The send deadline in milli seconds.
+ */
+uint16_t loadSendDeadlineConfig() {
+  return EEPROM.readUShort(SEND_DEADLINE_START_ADDR);
+}
+
+/**
+ * Stores the send deadline into the flash memory.
+ * @param deadline The send deadline in milli seconds.
+ * @return 
+ * -true: On success.
+ * -false: otherwise.
+ */
+bool storeSendDeadlineConfig(uint16_t deadline) {
+  EEPROM.writeUShort(SEND_DEADLINE_START_ADDR, deadline);
+  return EEPROM.commit();
+}
+
+/**
+ * Loads the url of a fallback server from the flash memory.
+ * @param index The number of the fallback, from 1 to FALLBACK_URL_COUNT.
+ * @param[out] url The loaded url.
+ * @return The number of read bytes.
+ */
+unsigned int loadFallbackUrlConfig(uint8_t index, String& url) {
+  char readUrl[SERVER_URL_MAX_SIZE]; //read buffer
+  unsigned int bytesRead = EEPROM.readString(FALLBACK_URL_START_ADDR + (index - 1) * SERVER_URL_MAX_SIZE,
+                                             readUrl,
+                                             SERVER_URL_MAX_SIZE - 1);
+  url = readUrl;
+  return bytesRead;
+}
+
+/**
+ * Stores the url of a fallback server into the flash memory.
+ * @param index The number of the fallback, from 1 to FALLBACK_URL_COUNT.
+ * @param url The url to be saved.
+ * @return 
+ * -true: On success.
+ * -false: otherwise.
+ */
+bool storeFallbackUrlConfig(uint8_t index, const String& url) {
+  EEPROM.writeString(FALLBACK_URL_START_ADDR + (index - 1) * SERVER_URL_MAX_SIZE, url);
+  return EEPROM.commit();
+}
 
 /**
  * Erases the complete flash memory.
@@ -22,7 +22,20 @@ struct WifiCredentials;
 #define ROOM_CAP_SIZE 1
 #define SERVER_URL_MAX_SIZE 256
 #define SERVER_URL_START_ADDR (WIFI_CONFIG_SIZE+ROOM_CAP_SIZE)
-#define EEPROM_SIZE (WIFI_CONFIG_SIZE+ROOM_CAP_SIZE+SERVER_URL_MAX_SIZE)
+#define TELEMETRY_CONFIG_START_ADDR (SERVER_URL_START_ADDR+SERVER_URL_MAX_SIZE)
+#define TELEMETRY_CONFIG_SIZE 4
+#define TELEMETRY_REPORT_START_ADDR (TELEMETRY_CONFIG_START_ADDR+TELEMETRY_CONFIG_SIZE)
+#define TELEMETRY_REPORT_SIZE 7
+#define ALERT_BUDGET_START_ADDR (TELEMETRY_REPORT_START_ADDR+TELEMETRY_REPORT_SIZE)
+#define ALERT_BUDGET_SIZE 3
+#define SEND_DEADLINE_START_ADDR (ALERT_BUDGET_START_ADDR+ALERT_BUDGET_SIZE)
+#define SEND_DEADLINE_SIZE 2
+#define FALLBACK_URL_COUNT 2
+#define FALLBACK_URL_START_ADDR (SEND_DEADLINE_START_ADDR+SEND_DEADLINE_SIZE)
+#define FALLBACK_URL_SIZE (FALLBACK_URL_COUNT*SERVER_URL_MAX_SIZE)
+#define ROOM_CAP_HIGH_START_ADDR (FALLBACK_URL_START_ADDR+FALLBACK_URL_SIZE)
+#define ROOM_CAP_HIGH_SIZE 1
+#define EEPROM_SIZE (WIFI_CONFIG_SIZE+ROOM_CAP_SIZE+SERVER_URL_MAX_SIZE+TELEMETRY_CONFIG_SIZE+TELEMETRY_REPORT_SIZE+ALERT_BUDGET_SIZE+SEND_DEADLINE_SIZE+FALLBACK_URL_SIZE+ROOM_CAP_HIGH_SIZE)
 
 //===========================================================
 // Function Declarations
@@ -55,19 +68,20 @@ bool deleteWifiConfig();
 
 /**
  * Loads the room capacity configuration from the flash memory.
- * @param count The value to be loaded.
+ * The low byte stays at its former address, the high byte is appended to the layout.
  * @return The loaded max person count.
  */
-uint8_t loadRoomCapConfig();
+uint16_t loadRoomCapConfig();
 
 /**
  * Stores the room capacity configuration into the flash memory.
+ * The low byte stays at its former address, the high byte is appended to the layout.
  * @param count The value to be stored.
  * @return 
  * -true: On success.
  * -false: otherwise.
  */
-bool storeRoomCapConfig(uint8_t count);
+bool storeRoomCapConfig(uint16_t count);
 
 /**
  * Loads the server url from the flash memory.
@@ -85,6 +99,92 @@ unsigned int loadServerUrlConfig(String& serverUrl);
  */
 bool storeServerUrlConfig(const String& serverUrl);
 
+/**
+ * Loads the telemetry batching configuration from the flash memory.
+ * @param[out] batchSize The number of records which trigger an upload.
+ * @param[out] flushInterval The age of the oldest record which triggers an upload in seconds.
+ */
+void loadTelemetryConfig(uint16_t& batchSize, uint16_t& flushInterval);
+
+/**
+ * Stores the telemetry batching configuration into the flash memory.
+ * @param batchSize The number of records which trigger an upload.
+ * @param flushInterval The age of the oldest record which triggers an upload in seconds.
+ * @return 
+ * -true: On success.
+ * -false: otherwise.
+ */
+bool storeTelemetryConfig(uint16_t batchSize, uint16_t flushInterval);
+
+/**
+ * Loads the telemetry reporting configuration from the flash memory.
+ * @param[out] mode The telemetry mode.
+ * @param[out] heartbeat The time without change until a heartbeat is recorded in seconds.
+ * @param[out] temperatureDelta The temperature change which is recorded in change mode in °C.
+ */
+void loadTelemetryReportConfig(uint8_t& mode, uint16_t& heartbeat, float& temperatureDelta);
+
+/**
+ * Stores the telemetry reporting configuration into the flash memory.
+ * @param mode The telemetry mode.
+ * @param heartbeat The time without change until a heartbeat is recorded in seconds.
+ * @param temperatureDelta The temperature change which is recorded in change mode in °C.
+ * @return 
+ * -true: On success.
+ * -false: otherwise.
+ */
+bool storeTelemetryReportConfig(uint8_t mode, uint16_t heartbeat, float temperatureDelta);
+
+/**
+ * Loads the alert budget of an alert type from the flash memory.
+ * @param type The number of the alert type.
+ * @return The number of alerts per window.
+ */
+uint8_t loadAlertBudgetConfig(uint8_t type);
+
+/**
+ * Stores the alert budget of an alert type into the flash memory.
+ * @param type The number of the alert type.
+ * @param budget The number of alerts per window.
+ * @return 
+ * -true: On success.
+ * -false: otherwise.
+ */
+bool storeAlertBudgetConfig(uint8_t type, uint8_t budget);
+
+/**
+ * Loads the send deadline from the flash memory.
+ * @return The send deadline in milli seconds.
+ */
+uint16_t loadSendDeadlineConfig();
+
+/**
+ * Stores the send deadline into the flash memory.
+ * @param deadline The send deadline in milli seconds.
+ * @return 
+ * -true: On success.
+ * -false: otherwise.
+ */
+bool storeSendDeadlineConfig(uint16_t deadline);
+
+/**
+ * Loads the url of a fallback server from the flash memory.
+ * @param index The number of the fallback, from 1 to FALLBACK_URL_COUNT.
+ * @param[out] url The loaded url.
+ * @return The number of read bytes.
+ */
+unsigned int loadFallbackUrlConfig(uint8_t index, String& url);
+
+/**
+ * Stores the url of a fallback server into the flash memory.
+ * @param index The number of the fallback, from 1 to FALLBACK_URL_COUNT.
+ * @param url The url to be saved.
+ * @return 
+ * -true: On success.
+ * -false: otherwise.
+ */
+bool storeFallbackUrlConfig(uint8_t index, const String& url);
+
 /**
  * Erases the complete flash memory.
  * @return 
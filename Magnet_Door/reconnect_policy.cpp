@@ -0,0 +1,164 @@
+/*************************************************************
+  The implementation of a policy when to try to reconnect after the connection was lost.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "reconnect_policy.h"
+#include <algorithm>
+
+/**
+ * Represents what the reconnect policy is doing.
+ */
+enum class ReconnectPhase: uint8_t {
+  idle,           //< The connection is not lost.
+  attempt,        //< An attempt is running.
+  pause           //< Waits for the next attempt.
+};
+
+//===========================================================
+// Static data
+
+static const char* const reconnectPhaseNames[] = {"idle", "attempt", "pause"};
+
+//===========================================================
+// Static function implementations
+
+/**
+ * Draws the pause after a failed attempt.
+ * @param failed The number of failed attempts since the connection was lost.
+ * @return The pause in milli seconds.
+ */
+static uint32_t drawPause(uint16_t failed) {
+  uint32_t bound = RECONNECT_BACKOFF_BASE;
+  for(uint16_t i = 1; i < failed && bound < RECONNECT_BACKOFF_MAX; i++) {
+    bound *= 2;
+  }
+  bound = std::min(bound, (uint32_t)RECONNECT_BACKOFF_MAX);
+  //At least half of the bound, so the pauses still grow
+  return bound / 2 + random(bound / 2 + 1);
+}
+
+//===========================================================
+// Member function implementations
+
+/**
+ * Constructs an idle ReconnectPolicy.
+ */
+ReconnectPolicy::ReconnectPolicy(): phase(ReconnectPhase::idle) {}
+
+/**
+ * Starts the first attempt after the connection was lost.
+ */
+void ReconnectPolicy::start() {
+  outageStart = millis();
+  attempt = 0;
+  beginAttempt();
+}
+
+/**
+ * Stops trying without a reconnect, e.g. if the user disconnects.
+ */
+void ReconnectPolicy::stop() {
+  phase = ReconnectPhase::idle;
+  attempt = 0;
+}
+
+/**
+ * Checks whether an attempt is running.
+ * @return
+ *  -true: If yes.
+ *  -false: otherwise.
+ */
+bool ReconnectPolicy::isAttempting() const {
+  return phase == ReconnectPhase::attempt;
+}
+
+/**
+ * Checks whether the running attempt used up its time budget.
+ * @return
+ *  -true: If yes.
+ *  -false: otherwise.
+ */
+bool ReconnectPolicy::isAttemptOver() const {
+  return phase == ReconnectPhase::attempt && millis() - phaseStart > RECONNECT_ATTEMPT_BUDGET;
+}
+
+/**
+ * Checks whether the pause is over and the next attempt is due.
+ * @return
+ *  -true: If yes.
+ *  -false: otherwise.
+ */
+bool ReconnectPolicy::isAttemptDue() const {
+  return phase == ReconnectPhase::pause && millis() - phaseStart >= pause;
+}
+
+/**
+ * Starts the next attempt after a pause.
+ */
+void ReconnectPolicy::beginAttempt() {
+  phase = ReconnectPhase::attempt;
+  phaseStart = millis();
+  attempt++;
+  attempts++;
+}
+
+/**
+ * Ends the running attempt as failed and starts a pause.
+ * @return The duration of the pause in milli seconds.
+ */
+uint32_t ReconnectPolicy::fail() {
+  phase = ReconnectPhase::pause;
+  phaseStart = millis();
+  pause = drawPause(attempt);
+  return pause;
+}
+
+/**
+ * Ends trying with a successful reconnect.
+ */
+void ReconnectPolicy::succeed() {
+  uint32_t outage = millis() - outageStart;
+  if(outage > longestOutage) {
+    longestOutage = outage;
+  }
+  reconnects++;
+  stop();
+}
+
+/**
+ * Prints the state and the counters over serial.
+ */
+void ReconnectPolicy::printStats() const {
+  uint32_t now = millis();
+  uint32_t elapsed = now - phaseStart;
+  Serial.printf(" >> Reconnect: %s", reconnectPhaseNames[static_cast<uint8_t>(phase)]);
+  switch(phase) {
+    case ReconnectPhase::attempt:
+      elapsed = std::min(elapsed, (uint32_t)RECONNECT_ATTEMPT_BUDGET);
+      Serial.printf(" %u, %lu s left", attempt, (unsigned long)(RECONNECT_ATTEMPT_BUDGET - elapsed) / 1000);
+      break;
+    case ReconnectPhase::pause:
+      elapsed = std::min(elapsed, pause);
+      Serial.printf(" after attempt %u, next in %lu s", attempt, (unsigned long)(pause - elapsed) / 1000);
+      break;
+    default:
+      break;
+  }
+  if(phase != ReconnectPhase::idle) {
+    Serial.printf(", offline for %lu s", (unsigned long)(now - outageStart) / 1000);
+  }
+  Serial.println();
+  Serial.printf(" >> Reconnect attempts: %lu, reconnects: %lu, longest outage: %lu s\n",
+                (unsigned long)attempts, (unsigned long)reconnects, (unsigned long)longestOutage / 1000);
+}
+
+/**
+ * Resets the counters.
+ */
+void ReconnectPolicy::resetStats() {
+  attempts = 0;
+  reconnects = 0;
+  longestOutage = 0;
+}
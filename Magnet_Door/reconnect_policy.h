@@ -0,0 +1,116 @@
+#pragma once
+/*************************************************************
+  A policy when to try to reconnect after the connection was lost.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+
+//===========================================================
+// Definitions
+#define RECONNECT_ATTEMPT_BUDGET 20000    //< Time one reconnect attempt may take in milli seconds.
+#define RECONNECT_BACKOFF_BASE 5000       //< Upper bound of the pause after the first failed attempt in milli seconds.
+#define RECONNECT_BACKOFF_MAX 300000      //< Highest upper bound of the pause between two attempts in milli seconds.
+
+//===========================================================
+// forward declared dependencies
+enum class ReconnectPhase: uint8_t;
+
+//===========================================================
+// Data Types
+
+/**
+ * Decides when to try to reconnect after the connection was lost. Never gives up.
+ * The first attempt starts right away and may take RECONNECT_ATTEMPT_BUDGET.
+ * After every failed attempt it pauses. The upper bound of the pause doubles with every
+ * failed attempt from RECONNECT_BACKOFF_BASE up to RECONNECT_BACKOFF_MAX. The pause itself
+ * is drawn at random from the upper half of the bound, so devices which lost the same
+ * access point at the same time spread their attempts.
+ * Does not wait for anything. The owner asks it what is due.
+ */
+class ReconnectPolicy {
+  private:
+    ReconnectPhase phase;               //< What is going on right now.
+    uint32_t phaseStart = 0;            //< Time the phase started in milli seconds.
+    uint32_t pause = 0;                 //< Duration of the current pause in milli seconds.
+    uint32_t outageStart = 0;           //< Time the connection was lost in milli seconds.
+    uint16_t attempt = 0;               //< Number of the current attempt since the connection was lost.
+    uint32_t attempts = 0;              //< Number of attempts.
+    uint32_t reconnects = 0;            //< Number of successful reconnects.
+    uint32_t longestOutage = 0;         //< Longest time until a reconnect in milli seconds.
+
+  public:
+    /**
+     * Constructs an idle ReconnectPolicy.
+     */
+    ReconnectPolicy();
+
+    /**
+     * Starts the first attempt after the connection was lost.
+     */
+    void start();
+
+    /**
+     * Stops trying without a reconnect, e.g. if the user disconnects.
+     */
+    void stop();
+
+    /**
+     * Checks whether an attempt is running.
+     * @return
+     *  -true: If yes.
+     *  -false: otherwise.
+     */
+    bool isAttempting() const;
+
+    /**
+     * Checks whether the running attempt used up its time budget.
+     * @return
+     *  -true: If yes.
+     *  -false: otherwise.
+     */
+    bool isAttemptOver() const;
+
+    /**
+     * Checks whether the pause is over and the next attempt is due.
+     * @return
+     *  -true: If yes.
+     *  -false: otherwise.
+     */
+    bool isAttemptDue() const;
+
+    /**
+     * Starts the next attempt after a pause.
+     */
+    void beginAttempt();
+
+    /**
+     * Ends the running attempt as failed and starts a pause.
+     * @return The duration of the pause in milli seconds.
+     */
+    uint32_t fail();
+
+    /**
+     * Ends trying with a successful reconnect.
+     */
+    void succeed();
+
+    /**
+     * Gives the number of the current attempt since the connection was lost.
+     * @return The number of the attempt. 0 if the connection was not lost.
+     */
+    uint16_t getAttempt() const;
+
+    /**
+     * Prints the state and the counters over serial.
+     */
+    void printStats() const;
+
+    /**
+     * Resets the counters.
+     */
+    void resetStats();
+};
+
+#include "reconnect_policy_inline.h"
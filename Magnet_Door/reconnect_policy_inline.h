@@ -0,0 +1,14 @@
+//===========================================================
+// included dependencies
+#include "reconnect_policy.h"
+
+//===========================================================
+// Inline member function implementations
+
+/**
+ * Gives the number of the current attempt since the connection was lost.
+ * @return The number of the attempt. 0 if the connection was not lost.
+ */
+inline uint16_t ReconnectPolicy::getAttempt() const {
+  return attempt;
+}
@@ -0,0 +1,106 @@
+/*************************************************************
+  The implementation of a TLS connection which resumes the TLS session of the former connection.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "resumable_tls_client.h"
+
+//===========================================================
+// Member function implementations
+
+/**
+ * Constructs a ResumableTlsClient without session.
+ */
+ResumableTlsClient::ResumableTlsClient() {
+  mbedtls_ssl_session_init(&session);
+}
+
+/**
+ * Frees the session.
+ */
+ResumableTlsClient::~ResumableTlsClient() {
+  mbedtls_ssl_session_free(&session);
+}
+
+/**
+ * Sets the CA certificate the certificate of the server is verified against.
+ * Forgets the session, a resumed handshake would skip the verification.
+ * @param rootCA The PEM of the CA certificate. Has to stay valid.
+ */
+void ResumableTlsClient::setCACert(const char* rootCA) {
+  forgetSession();
+  WiFiClientSecure::setCACert(rootCA);
+}
+
+/**
+ * Opens a TLS connection and offers the session of the last handshake.
+ * @param host The host name. The certificate has to be issued for it.
+ * @param port The port.
+ * @param timeout The timeout of the TCP connect in milli seconds.
+ * @return
+ *  -1: On success.
+ *  -0: If the server could not be reached or the handshake failed. The session is forgotten then.
+ */
+int ResumableTlsClient::connect(const char* host, uint16_t port, int32_t timeout) {
+  resumed = false;
+  certificateSeen = false;
+  setPlainStart(); //Sets up the TLS context without the handshake
+  if(!WiFiClientSecure::connect(host, port, timeout)) {
+    return 0;
+  }
+  mbedtls_ssl_context* ssl = &sslclient->ssl_ctx;
+  mbedtls_ssl_set_verify(ssl, onCertificate, this);
+  if(hasSession && mbedtls_ssl_set_session(ssl, &session) != 0) {
+    forgetSession();
+  }
+  if(!startTLS()) {
+    forgetSession(); //Don't offer the session again, it may be the cause
+    return 0;
+  }
+  //A resumed handshake has no certificate
+  resumed = hasSession && !certificateSeen;
+
+  //Keep the session of this handshake, the server may have issued a new ticket
+  mbedtls_ssl_session_free(&session);
+  mbedtls_ssl_session_init(&session);
+  hasSession = mbedtls_ssl_get_session(ssl, &session) == 0;
+  return 1;
+}
+
+/**
+ * Closes the connection. Tells the server with a close notify, since some servers
+ * drop the session of a connection which ends without.
+ */
+void ResumableTlsClient::stop() {
+  if(!stillInPlainStart() && connected()) {
+    mbedtls_ssl_close_notify(&sslclient->ssl_ctx);
+  }
+  WiFiClientSecure::stop();
+}
+
+/**
+ * Forgets the session, so the next connect does a full handshake.
+ */
+void ResumableTlsClient::forgetSession() {
+  mbedtls_ssl_session_free(&session);
+  mbedtls_ssl_session_init(&session);
+  hasSession = false;
+}
+
+/**
+ * Notes that the server sent its certificate, so the handshake is a full one.
+ * Called by mbedtls for every certificate of the chain. Leaves the verification to mbedtls.
+ * @param client The ResumableTlsClient.
+ * @param certificate The certificate.
+ * @param depth The depth of the certificate in the chain.
+ * @param flags The verification result so far.
+ * @return 0 to go on with the verification.
+ */
+int ResumableTlsClient::onCertificate(void* client, mbedtls_x509_crt* certificate, int depth, uint32_t* flags) {
+  (void)certificate;
+  (void)depth;
+  (void)flags;
+  static_cast<ResumableTlsClient*>(client)->certificateSeen = true;
+  return 0;
+}
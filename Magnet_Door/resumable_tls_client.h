@@ -0,0 +1,95 @@
+#pragma once
+/*************************************************************
+  A TLS connection which resumes the TLS session of the former connection.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include <WiFiClientSecure.h>
+#include <mbedtls/ssl.h>
+
+//===========================================================
+// Data Types
+
+/**
+ * A TLS connection which keeps the TLS session of its last handshake and offers it
+ * to the server on the next connect, by session id and, if the server issued one, by session ticket.
+ * If the server resumes the session, the handshake skips the certificate and the key exchange,
+ * which take most of the handshake time of the ESP32. If not, a full handshake is done.
+ * WiFiClientSecure has no interface for sessions, so the connection is started without the
+ * handshake, the session is handed to mbedtls, and the handshake is done by startTLS().
+ * The certificate of the server is always verified. Without a CA certificate the connect fails.
+ * Only to be used for one server. The session is to be forgotten with forgetSession() if the server changes.
+ */
+class ResumableTlsClient: public WiFiClientSecure {
+  private:
+    mbedtls_ssl_session session;        //< The session of the last handshake.
+    bool hasSession = false;            //< If there is a session to offer.
+    bool certificateSeen = false;       //< If the server sent its certificate in the current handshake.
+    bool resumed = false;               //< If the last handshake resumed the session.
+
+    /**
+     * Notes that the server sent its certificate, so the handshake is a full one.
+     * Called by mbedtls for every certificate of the chain. Leaves the verification to mbedtls.
+     * @param client The ResumableTlsClient.
+     * @param certificate The certificate.
+     * @param depth The depth of the certificate in the chain.
+     * @param flags The verification result so far.
+     * @return 0 to go on with the verification.
+     */
+    static int onCertificate(void* client, mbedtls_x509_crt* certificate, int depth, uint32_t* flags);
+
+  public:
+    /**
+     * Constructs a ResumableTlsClient without session.
+     */
+    ResumableTlsClient();
+
+    /**
+     * Frees the session.
+     */
+    ~ResumableTlsClient();
+
+    ResumableTlsClient(const ResumableTlsClient&) = delete;
+    ResumableTlsClient& operator=(const ResumableTlsClient&) = delete;
+
+    /**
+     * Sets the CA certificate the certificate of the server is verified against.
+     * Forgets the session, a resumed handshake would skip the verification.
+     * @param rootCA The PEM of the CA certificate. Has to stay valid.
+     */
+    void setCACert(const char* rootCA);
+
+    /**
+     * Opens a TLS connection and offers the session of the last handshake.
+     * @param host The host name. The certificate has to be issued for it.
+     * @param port The port.
+     * @param timeout The timeout of the TCP connect in milli seconds.
+     * @return
+     *  -1: On success.
+     *  -0: If the server could not be reached or the handshake failed. The session is forgotten then.
+     */
+    int connect(const char* host, uint16_t port, int32_t timeout);
+
+    /**
+     * Closes the connection. Tells the server with a close notify, since some servers
+     * drop the session of a connection which ends without.
+     */
+    void stop() override;
+
+    /**
+     * Checks whether the last handshake resumed the former session.
+     * @return
+     *  -true: If yes.
+     *  -false: If it was a full handshake.
+     */
+    bool isResumed() const;
+
+    /**
+     * Forgets the session, so the next connect does a full handshake.
+     */
+    void forgetSession();
+};
+
+#include "resumable_tls_client_inline.h"
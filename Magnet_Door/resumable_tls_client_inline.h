@@ -0,0 +1,16 @@
+//===========================================================
+// included dependencies
+#include "resumable_tls_client.h"
+
+//===========================================================
+// Inline member function implementations
+
+/**
+ * Checks whether the last handshake resumed the former session.
+ * @return
+ *  -true: If yes.
+ *  -false: If it was a full handshake.
+ */
+inline bool ResumableTlsClient::isResumed() const {
+  return resumed;
+}
@@ -6,213 +6,416 @@
 // included dependencies
 #include "room_load_sys.h"
 #include "door_status_sys.h"
+#include "Arduino.h"
 
 //===========================================================
-// Data Types
+// Static function implementations
 
 /**
- * Represents the states the door passing FSM can be in.
+ * Prints why a door passing could not be detected correctly.
+ * @param state The passing state in which the error was registered.
  */
-enum class PassState: uint8_t {
-  idle,           //< Nothing happens
-  startEntering,  //< Someone starts to enter by passing the outer detector.
-  entering1,      //< Someone who enters stepped further in and now passes both detectors at the same time.
-  entering2,      //< Someone who enters stepped further in and now passes only the inner detector.
-  entered,        //< Someone fully entered.
-  startLeaving,   //< Someone starts to leave by passing the inner detector.
-  leaving1,       //< Someone who leaves stepped further out and now passes both detectors at the same time.
-  leaving2,       //< Someone who leaves stepped further out and now passes only the outer detector.
-  left            //< Someone fully left.
-};
+static void printPassError(PassState state) {
+  bool entering = (state == PassState::startEntering ||
+                   state == PassState::entering1 ||
+                   state == PassState::entering2);
+  Serial.println(entering? "Error: During entering event!" : "Error: During leaving event!");
+  switch(state) {
+    case PassState::startEntering:
+      Serial.println("  >> Reason: Only inner detector is passed, but both detectors were not passed before.");
+      break;
+    case PassState::startLeaving:
+      Serial.println("  >> Reason: Only outer detector is passed, but both detectors were not passed before.");
+      break;
+    case PassState::entering1:
+    case PassState::leaving1:
+      Serial.println("  >> Reason: Both detectors were passed, but now no detector is passed.");
+      break;
+    case PassState::entering2:
+      Serial.println("  >> Reason: Someone passed the inner detector, but now only the outer detector is passed.");
+      break;
+    case PassState::leaving2:
+      Serial.println("  >> Reason: Someone passed the outer detector, but now only the inner detector is passed.");
+      break;
+    default:
+      break;
+  }
+  Serial.println(entering? "  >> Result: Could not detect entering correctly. Falling back to idle."
+                         : "  >> Result: Could not detect leaving correctly. Falling back to idle.");
+}
 
 //===========================================================
 // Member function implementations
 
 /**
  * Constructs a RoomLoadSystem with the used hardware pins.
- * @param outerDetPin The outer detector pin.
- * @param innerDetPin The inner detector pin.
+ * @param lanePins The detector pins of each lane.
+ * @param laneCount The number of lanes. Limited to MAX_DET_LANES.
+ */
+RoomLoadSystem::RoomLoadSystem(  const DetectorPins* lanePins,
+                                 uint8_t laneCount): laneCount(laneCount < MAX_DET_LANES? laneCount : MAX_DET_LANES) {
+  for(uint8_t i = 0; i < this->laneCount; i++) {
+    Lane& lane = lanes[i];
+    lane.pins = lanePins[i];
+
+    //Setup pins
+    pinMode(lane.pins.outerDetPin, INPUT);
+    pinMode(lane.pins.innerDetPin, INPUT);
+    lane.outerFilter = InputFilter({DebounceMode::stableTime, DETECTOR_DEBOUNCE_TIME, 0}, digitalRead(lane.pins.outerDetPin));
+    lane.innerFilter = InputFilter({DebounceMode::stableTime, DETECTOR_DEBOUNCE_TIME, 0}, digitalRead(lane.pins.innerDetPin));
+
+    //Capture all level changes of the detectors
+    isrArgs[2 * i] = {this, i, Detector::outer, lane.pins.outerDetPin};
+    isrArgs[2 * i + 1] = {this, i, Detector::inner, lane.pins.innerDetPin};
+    attachInterruptArg(lane.pins.outerDetPin, onDetectorEdge, &isrArgs[2 * i], CHANGE);
+    attachInterruptArg(lane.pins.innerDetPin, onDetectorEdge, &isrArgs[2 * i + 1], CHANGE);
+  }
+}
+
+/**
+ * Interrupt handler for level changes of a detector.
+ * Captures the current level of the detector with a timestamp into the edge queue.
+ * All detector interrupts are served on the same core, so they are the only producer of the queue.
+ * @param arg Pointer to the DetectorIsrArg of the detector.
  */
-RoomLoadSystem::RoomLoadSystem(  uint8_t outerDetPin,
-                                 uint8_t innerDetPin): outerDetPin(outerDetPin), 
-                                                       innerDetPin(innerDetPin),
-                                                       passState(PassState::idle) {
-  //Setup pins
-  pinMode(outerDetPin, INPUT);
-  pinMode(innerDetPin, INPUT);
+void ARDUINO_ISR_ATTR RoomLoadSystem::onDetectorEdge(void* arg) {
+  const DetectorIsrArg* det = static_cast<const DetectorIsrArg*>(arg);
+  DetectorEdge edge = {det->lane, det->detector, (bool)digitalRead(det->pin), (uint32_t)micros()};
+  if(!det->sys->edges.push(edge)) {
+    det->sys->droppedEdges++;
+  }
 }
 
 /**
- * Determines the current door passing state by reading the detector inputs
- * and registeres entering and leaving events. 
- * Assumes that only one person can pass the door at the same time.
- * Accesses a DoorStatusSystem to update status LEDs on room full and room not full events respectively and
- * also checks if persons are still in the room if the door was closed.
- * Calls the callback on room full, room not full and persons in the room events.
+ * Prints the number of entries and exits of each lane over serial.
+ */
+void RoomLoadSystem::printLaneStats() const {
+  Serial.println(" >> Lane passings (entered/left):");
+  for(uint8_t i = 0; i < laneCount; i++) {
+    Serial.printf("    Lane %-13u %10lu %10lu\n", i, (unsigned long)lanes[i].entries, (unsigned long)lanes[i].exits);
+  }
+}
+
+/**
+ * Determines the current door passing state of each lane by consuming the captured detector edges
+ * and registeres entering and leaving events. Edges captured while the door is closed are discarded.
+ * The passings which did not finish when the door closes are dropped.
+ * With MULTI_PASS_TRACKING several persons can pass a lane at the same time,
+ * otherwise it is assumed that only one person can pass a lane at the same time.
+ * Reads the door state of a DoorStatusSystem. The status LEDs follow the room full and room not full events.
+ * Publishes room full, room not full, person entered and person left events.
  * @param doorSys A reference to the door status system.
- * @param eventCallback A callback which will be called if a room load event was registered.
- */
-void RoomLoadSystem::doDoorPassingCheck(DoorStatusSystem& doorSys, std::function<void (RoomLoadEvent)> eventCallback) {
-  switch(passState) {
-    case PassState::idle:
-      if(isPassingOuter()) {
-        //Someone starts to enter
-        passState = PassState::startEntering;
-      }
-      else if(isPassingInner()) {
-        //Someone starts to leave
-        passState = PassState::startLeaving;
-      }
-      break;
-    case PassState::startEntering:
-     if(isPassingBoth()) {
-      //Someone who enters stepped further in and now passes both detectors at the same time
-      passState = PassState::entering1;
-     }
-     else if(noPassing()) {
-      //Someone decided to step back from entering
-      passState = PassState::idle;
-     }
-     else if(isPassingInner()) {
-      //Passing only the inner detector is not allowed in this state.
-      Serial.println("Error: During entering event!");
-      Serial.println("  >> Reason: Only inner detector is passed, but both detectors were not passed before.");
-      Serial.println("  >> Result: Could not detect entering correctly. Falling back to idle.");
-      passState = PassState::idle;
-     }
-     break;
-    case PassState::entering1:
-      if(isPassingInner()) {
-        //Someone who enters stepped further in and now passes only the inner detector
-        passState = PassState::entering2;
-      }
-      else if(isPassingOuter()) {
-        //Someone decided to step back
-        passState = PassState::startEntering;
-      }
-      else if(noPassing()) {
-        //No passing of any detector is not allowed in this state.
-        Serial.println("Error: During entering event!");
-        Serial.println("  >> Reason: Both detectors were passed, but now no detector is passed.");
-        Serial.println("  >> Result: Could not detect entering correctly. Falling back to idle.");
-        passState = PassState::idle;
-      }
-      break;
-    case PassState::entering2:
-     if(noPassing()) {
-      //Someone finished entering
-      passState = PassState::entered;
-     }
-     else if(isPassingBoth()) {
-      //Someone decided to step back
-      passState = PassState::entering1;
-     }
-     else if(isPassingOuter()) {
-      //Passing only the outer detector is not allowed in this state.
-      Serial.println("Error: During entering event!");
-      Serial.println("  >> Reason: Someone passed the inner detector, but now only the outer detector is passed.");
-      Serial.println("  >> Result: Could not detect entering correctly. Falling back to idle.");
-      passState = PassState::idle;
-     }
-     break;
-    case PassState::entered:
-      if(personCount < roomCap) {
-        personCount++;
-        Serial.println("Passing event: Someone entered.");
-        Serial.print("  >> Current load: ");
-        Serial.println(personCount);
-      }
-      else {
-        Serial.println("Error: During entering event!");
-        Serial.println("  >> Reason: Room is already full.");
-        Serial.println("  >> Result: Falling back to idle.");
-      }
-      passState = PassState::idle;
-      break;
-    case PassState::startLeaving:
-      if(isPassingBoth()) {
-        //Someone who is leaving steped further out and now passes both detectors at the same time
-        passState = PassState::leaving1;
-      }
-      else if(noPassing()) {
-        //Someone decided to step back from leaving
-        passState = PassState::idle;
-      }
-      else if(isPassingOuter()) {
-        //Passing only the outer detector is not allowed in this state.
-        Serial.println("Error: During leaving event!");
-        Serial.println("  >> Reason: Only outer detector is passed, but both detectors were not passed before.");
-        Serial.println("  >> Result: Could not detect leaving correctly. Falling back to idle.");
-        passState = PassState::idle;
-      }
+ * @param eventBus The event bus registered room load events are published to.
+ */
+void RoomLoadSystem::doDoorPassingCheck(DoorStatusSystem& doorSys, RoomLoadEventBus& eventBus) {
+  if(resetRequest.exchange(false)) {
+    for(uint8_t i = 0; i < laneCount; i++) {
+      dropPassings(i);
+    }
+  }
+
+  bool doorOpen = doorSys.isDoorOpen();
+  if(wasDoorOpen && !doorOpen) {
+    //Edges are discarded while the door is closed, so the current passings can't be finished later
+    for(uint8_t i = 0; i < laneCount; i++) {
+#if MULTI_PASS_TRACKING
+      applyTrackResult(i, lanes[i].passTracker.finish(), eventBus);
+#else
+      dropPassings(i);
+#endif
+    }
+  }
+  wasDoorOpen = doorOpen;
+
+  uint32_t now = micros(); //Taken before consuming, so all edges up to now are seen
+
+  DetectorEdge edge;
+  while(edges.pop(edge)) {
+    //Levels which became stable before this edge happened first
+    pollDetectors(edge.lane, edge.timestamp, doorSys, eventBus);
+    Lane& lane = lanes[edge.lane];
+    InputFilter& filter = (edge.detector == Detector::outer)? lane.outerFilter : lane.innerFilter;
+    InputEdge stable;
+    if(filter.sample(edge.level, edge.timestamp, stable)) {
+      handleDetectorEdge(edge.lane, edge.detector, stable, doorSys, eventBus);
+    }
+  }
+
+  for(uint8_t i = 0; i < laneCount; i++) {
+    pollDetectors(i, now, doorSys, eventBus);
+#if MULTI_PASS_TRACKING
+    //Register passings which are no longer in doubt of being a step back
+    applyTrackResult(i, lanes[i].passTracker.update(now), eventBus);
+#endif
+  }
+
+  uint32_t drops = droppedEdges;
+  if(drops != handledDrops) {
+    //Edges are missing, so the current passings can not be followed any longer
+    handledDrops = drops;
+    log(RoomLoadLog::edgesLost);
+    for(uint8_t i = 0; i < laneCount; i++) {
+      Lane& lane = lanes[i];
+      lane.outerFilter.reset(digitalRead(lane.pins.outerDetPin));
+      lane.innerFilter.reset(digitalRead(lane.pins.innerDetPin));
+      dropPassings(i);
+    }
+  }
+
+  checkRoomFull(eventBus);
+}
+
+/**
+ * Takes over the detector levels of a lane which became stable until a point in time.
+ * The stable edges of both detectors are handled in the order they happened.
+ * @param laneId The index of the lane.
+ * @param time The point in time in micro seconds.
+ * @param doorSys A reference to the door status system.
+ * @param eventBus The event bus registered room load events are published to.
+ */
+void RoomLoadSystem::pollDetectors(uint8_t laneId, uint32_t time, DoorStatusSystem& doorSys, RoomLoadEventBus& eventBus) {
+  Lane& lane = lanes[laneId];
+  InputEdge outerEdge, innerEdge;
+  bool outerChanged = lane.outerFilter.poll(time, outerEdge);
+  bool innerChanged = lane.innerFilter.poll(time, innerEdge);
+  if(outerChanged && innerChanged && static_cast<int32_t>(innerEdge.timestamp - outerEdge.timestamp) < 0) {
+    handleDetectorEdge(laneId, Detector::inner, innerEdge, doorSys, eventBus);
+    innerChanged = false;
+  }
+  if(outerChanged) {
+    handleDetectorEdge(laneId, Detector::outer, outerEdge, doorSys, eventBus);
+  }
+  if(innerChanged) {
+    handleDetectorEdge(laneId, Detector::inner, innerEdge, doorSys, eventBus);
+  }
+}
+
+/**
+ * Follows the door passings of a lane by a stable detector edge.
+ * Edges while the door is closed only update the detector level.
+ * @param laneId The index of the lane.
+ * @param detector The detector which changed.
+ * @param edge The stable edge.
+ * @param doorSys A reference to the door status system.
+ * @param eventBus The event bus registered room load events are published to.
+ */
+void RoomLoadSystem::handleDetectorEdge(uint8_t laneId,
+                                        Detector detector,
+                                        const InputEdge& edge,
+                                        DoorStatusSystem& doorSys,
+                                        RoomLoadEventBus& eventBus) {
+  if(!doorSys.isDoorOpen()) {
+    return;
+  }
+#if MULTI_PASS_TRACKING
+  trackPass(laneId, detector, edge, eventBus);
+#else
+  stepPassState(laneId, eventBus);
+#endif
+}
+
+/**
+ * Forgets the door passings of a lane which are followed right now.
+ * @param laneId The index of the lane.
+ */
+void RoomLoadSystem::dropPassings(uint8_t laneId) {
+#if MULTI_PASS_TRACKING
+  lanes[laneId].passTracker.reset();
+#else
+  lanes[laneId].passFsm.reset();
+#endif
+}
+
+#if MULTI_PASS_TRACKING
+/**
+ * Follows overlapping door passings of a lane by a stable detector edge
+ * and registeres the resolved entering and leaving events.
+ * @param laneId The index of the lane.
+ * @param detector The detector which changed.
+ * @param edge The stable edge.
+ * @param eventBus The event bus registered room load events are published to.
+ */
+void RoomLoadSystem::trackPass(uint8_t laneId, Detector detector, const InputEdge& edge, RoomLoadEventBus& eventBus) {
+  uint8_t code = (detector == Detector::outer)? PASS_CODE_OUTER : PASS_CODE_INNER;
+  applyTrackResult(laneId, lanes[laneId].passTracker.onEdge(code, edge.level, edge.timestamp), eventBus);
+}
+
+/**
+ * Registers the door passings resolved by the tracker of a lane.
+ * @param laneId The index of the lane.
+ * @param result The resolved passings.
+ * @param eventBus The event bus registered room load events are published to.
+ */
+void RoomLoadSystem::applyTrackResult(uint8_t laneId, const PassTrackResult& result, RoomLoadEventBus& eventBus) {
+  for(uint8_t i = 0; i < result.entered; i++) {
+    registerEntered(laneId, eventBus);
+  }
+  for(uint8_t i = 0; i < result.left; i++) {
+    registerLeft(laneId, eventBus);
+  }
+  if(result.lost > 0) {
+    log(RoomLoadLog::passingsLost, laneId, result.lost);
+  }
+  if(result.aborted > 0) {
+    log(RoomLoadLog::passingsAborted, laneId, result.aborted);
+  }
+}
+#else
+/**
+ * Determines the next door passing state of a lane for its current detector levels with one table lookup
+ * and registeres entering and leaving events.
+ * @param laneId The index of the lane.
+ * @param eventBus The event bus registered room load events are published to.
+ */
+void RoomLoadSystem::stepPassState(uint8_t laneId, RoomLoadEventBus& eventBus) {
+  Lane& lane = lanes[laneId];
+  PassState prevState = lane.passFsm.getState();
+  PassEvent passEvent = lane.passFsm.step(PassFsm::encode(lane.outerFilter.getLevel(), lane.innerFilter.getLevel()));
+
+  switch(passEvent) {
+    case PassEvent::none:
       break;
-    case PassState::leaving1:
-      if(isPassingOuter()) {
-        //Someone who is leaving steped further out and now passes only the outer detector
-        passState = PassState::leaving2;
-      }
-      else if(isPassingInner()) {
-        //Someone decided to step back
-        passState = PassState::startLeaving;
-      }
-      else if(noPassing()) {
-        //No passing of any detector is not allowed in this state.
-        Serial.println("Error: During leaving event!");
-        Serial.println("  >> Reason: Both detectors were passed, but now no detector is passed.");
-        Serial.println("  >> Result: Could not detect leaving correctly. Falling back to idle.");
-        passState = PassState::idle;
-      }
+    case PassEvent::entered:
+      registerEntered(laneId, eventBus);
       break;
-    case PassState::leaving2:
-      if(noPassing()) {
-        //Someone finished leaving
-        passState = PassState::left;
-      }
-      else if(isPassingBoth()) {
-        //Someone decided to step back
-        passState = PassState::leaving1;
-      }
-      else if(isPassingInner()) {
-        //Passing only the inner detector is not allowed in this state.
-        Serial.println("Error: During leaving event!");
-        Serial.println("  >> Reason: Someone passed the outer detector, but now only the inner detector is passed.");
-        Serial.println("  >> Result: Could not detect entering correctly. Falling back to idle.");
-        passState = PassState::idle;
-      }
+    case PassEvent::left:
+      registerLeft(laneId, eventBus);
       break;
-    case PassState::left:
-      if(!(personCount == 0)) {
-      personCount--;
-        Serial.println("Passing event: Someone left.");
-        Serial.print("  >> Current load: ");
-        Serial.println(personCount);
-      }
-      else {
-        Serial.println("Error: During leaving event!");
-        Serial.println("  >> Reason: Room was already empty.");
-        Serial.println("  >> Result: Falling back to idle.");
-      }
-      passState = PassState::idle;
+    case PassEvent::enteringError:
+    case PassEvent::leavingError:
+      log(RoomLoadLog::passError, laneId, static_cast<uint8_t>(prevState));
       break;
   }
+}
+#endif
 
+/**
+ * Registers that someone entered through a lane.
+ * @param laneId The index of the lane.
+ * @param eventBus The event bus registered room load events are published to.
+ */
+void RoomLoadSystem::registerEntered(uint8_t laneId, RoomLoadEventBus& eventBus) {
+  if(personCount < roomCap) {
+    personCount++;
+    lanes[laneId].entries++;
+    log(RoomLoadLog::entered, laneId);
+    eventBus.publish({RoomLoadEvent::personEntered, personCount}, millis()); //Register the event
+  }
+  else {
+    log(RoomLoadLog::enteredWhileFull, laneId);
+  }
+}
+
+/**
+ * Registers that someone left through a lane.
+ * @param laneId The index of the lane.
+ * @param eventBus The event bus registered room load events are published to.
+ */
+void RoomLoadSystem::registerLeft(uint8_t laneId, RoomLoadEventBus& eventBus) {
+  if(!(personCount == 0)) {
+    personCount--;
+    lanes[laneId].exits++;
+    log(RoomLoadLog::left, laneId);
+    eventBus.publish({RoomLoadEvent::personLeft, personCount}, millis()); //Register the event
+  }
+  else {
+    log(RoomLoadLog::leftWhileEmpty, laneId);
+  }
+}
+
+/**
+ * Registers room full and room not full events for the current person count.
+ * @param eventBus The event bus registered room load events are published to.
+ */
+void RoomLoadSystem::checkRoomFull(RoomLoadEventBus& eventBus) {
   if(!roomFull && personCount >= roomCap) {
-    Serial.println("Alert: Room is full.");
+    log(RoomLoadLog::roomFull);
     roomFull = true;
-    eventCallback(RoomLoadEvent::roomFull); //Register the event
-    doorSys.setStatusLEDs(false);
+    eventBus.publish({RoomLoadEvent::roomFull, personCount}, millis()); //Register the event
   }
   else if(roomFull && personCount < roomCap) {
-    Serial.println("Info: Room is no longer full.");
+    log(RoomLoadLog::roomNotFull);
     roomFull = false;
-    eventCallback(RoomLoadEvent::roomNotFull); //Register the event
-    doorSys.setStatusLEDs(true);
+    eventBus.publish({RoomLoadEvent::roomNotFull, personCount}, millis()); //Register the event
+  }
+}
+
+/**
+ * Queues a log message of the passing check to be printed by printLog().
+ * @param message The message.
+ * @param lane The lane the message refers to.
+ * @param detail The PassState of a pass error or the number of lost or aborted passings.
+ */
+void RoomLoadSystem::log(RoomLoadLog message, uint8_t lane, uint8_t detail) {
+  if(!logs.push({message, lane, detail, personCount})) {
+    droppedLogs++;
+  }
+}
+
+/**
+ * Prints the queued log messages of the passing check over serial.
+ * May only be called by one task, the one owning the console.
+ */
+void RoomLoadSystem::printLog() {
+  RoomLoadLogEntry entry;
+  while(logs.pop(entry)) {
+    switch(entry.message) {
+      case RoomLoadLog::entered:
+        Serial.printf("Passing event: Someone entered through lane %u.\n", entry.lane);
+        Serial.print("  >> Current load: ");
+        Serial.println(entry.personCount);
+        break;
+      case RoomLoadLog::left:
+        Serial.printf("Passing event: Someone left through lane %u.\n", entry.lane);
+        Serial.print("  >> Current load: ");
+        Serial.println(entry.personCount);
+        break;
+      case RoomLoadLog::enteredWhileFull:
+        Serial.println("Error: During entering event!");
+        Serial.println("  >> Reason: Room is already full.");
+        Serial.println("  >> Result: Falling back to idle.");
+        break;
+      case RoomLoadLog::leftWhileEmpty:
+        Serial.println("Error: During leaving event!");
+        Serial.println("  >> Reason: Room was already empty.");
+        Serial.println("  >> Result: Falling back to idle.");
+        break;
+      case RoomLoadLog::passError:
+        Serial.printf("Lane %u:\n", entry.lane);
+        printPassError(static_cast<PassState>(entry.detail));
+        break;
+      case RoomLoadLog::passingsLost:
+        Serial.printf("Error: Lost track of %u door passing(s) in lane %u!\n", entry.detail, entry.lane);
+        Serial.println("  >> Reason: Too many persons passing the lane at the same time.");
+        break;
+      case RoomLoadLog::passingsAborted:
+        Serial.printf("Info: Dropped %u unfinished door passing(s) in lane %u.\n", entry.detail, entry.lane);
+        Serial.println("  >> Reason: The door closed.");
+        break;
+      case RoomLoadLog::edgesLost:
+        Serial.println("Error: Detector edges lost!");
+        Serial.println("  >> Reason: Edge queue was full.");
+        Serial.println("  >> Result: Falling back to idle.");
+        break;
+      case RoomLoadLog::roomFull:
+        Serial.println("Alert: Room is full.");
+        break;
+      case RoomLoadLog::roomNotFull:
+        Serial.println("Info: Room is no longer full.");
+        break;
+    }
+  }
+  uint32_t drops = droppedLogs;
+  if(drops != printedDrops) {
+    Serial.printf("Error: %lu log messages of the passing check lost!\n", (unsigned long)(drops - printedDrops));
+    printedDrops = drops;
   }
 }
 
 /**
  * Brings the system back in initial state.
+ * Takes effect with the next passing check.
  */
 void RoomLoadSystem::reset() {
-  passState = PassState::idle;
-}
\ No newline at end of file
+  resetRequest = true;
+}
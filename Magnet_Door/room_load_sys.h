@@ -6,16 +6,27 @@
 //===========================================================
 // included dependencies
 #include <cstdint>
-#include <functional>
+#include <atomic>
+#include "event_bus.h"
+#include "spsc_ring.h"
+#include "pass_fsm.h"
+#include "pass_tracker.h"
+#include "input_filter.h"
 
 //===========================================================
 // Included forward dependencies
 class DoorStatusSystem;
-enum class PassState: uint8_t;
 
 //===========================================================
 // Definitions
 #define ROOM_CAP_DEFAULT 5
+#define ROOM_LOAD_EVENT_QUEUE_SIZE 32       //< Number of room load events which can be queued.
+#define ROOM_LOAD_EVENT_SUBSCRIBERS 5       //< Maximum number of room load event subscribers.
+#define DETECTOR_EDGE_QUEUE_SIZE 64         //< Number of captured detector edges which can be queued.
+#define MAX_DET_LANES 4                     //< Maximum number of detector pairs at one entrance.
+#define DETECTOR_DEBOUNCE_TIME 2000         //< Time a detector level has to persist to be taken over in micro seconds.
+#define ROOM_LOAD_LOG_QUEUE_SIZE 16         //< Number of log messages of the passing check which can wait to be printed. Has to be a power of two.
+#define MULTI_PASS_TRACKING 1               //< 1 if overlapping passings of a lane are followed. 0 if only one person can pass a lane at the same time.
 
 //===========================================================
 // Data Types
@@ -25,44 +36,251 @@ enum class PassState: uint8_t;
  */
 enum class RoomLoadEvent: uint8_t {
   roomFull,                    //< If the room capacity was reached, so there is no room for more persons.
-  roomNotFull                  //< If there is room for persons again.
+  roomNotFull,                 //< If there is room for persons again.
+  personEntered,               //< If someone entered the room.
+  personLeft,                  //< If someone left the room.
+  count                        //< Number of room load events. Has to stay the last entry.
+};
+
+/**
+ * A room load event together with the resulting person count.
+ */
+struct RoomLoadUpdate {
+  RoomLoadEvent event;         //< The registered event.
+  uint16_t personCount;        //< The person count after the event.
+};
+
+/**
+ * The event bus room load updates are published to.
+ */
+typedef EventBus<RoomLoadUpdate, ROOM_LOAD_EVENT_QUEUE_SIZE, ROOM_LOAD_EVENT_SUBSCRIBERS> RoomLoadEventBus;
+
+/**
+ * The log messages of the passing check.
+ */
+enum class RoomLoadLog: uint8_t {
+  entered,                     //< Someone entered through a lane.
+  left,                        //< Someone left through a lane.
+  enteredWhileFull,            //< Someone entered through a lane, but the room was already full.
+  leftWhileEmpty,              //< Someone left through a lane, but the room was already empty.
+  passError,                   //< A door passing of a lane could not be detected correctly.
+  passingsLost,                //< The tracker of a lane lost track of door passings.
+  passingsAborted,             //< Unfinished door passings of a lane were dropped since the door closed.
+  edgesLost,                   //< Detector edges were lost since the edge queue was full.
+  roomFull,                    //< The room became full.
+  roomNotFull                  //< The room is no longer full.
+};
+
+/**
+ * A log message of the passing check waiting to be printed.
+ */
+struct RoomLoadLogEntry {
+  RoomLoadLog message;         //< The message.
+  uint8_t lane;                //< The lane the message refers to.
+  uint8_t detail;              //< The PassState of a pass error or the number of lost or aborted passings.
+  uint16_t personCount;        //< The person count when the message was logged.
+};
+
+/**
+ * Identifies a detector.
+ */
+enum class Detector: uint8_t {
+  outer,                       //< The outer detector.
+  inner                        //< The inner detector.
+};
+
+/**
+ * A level change of a detector captured by its interrupt.
+ */
+struct DetectorEdge {
+  uint8_t lane;                //< The lane of the detector.
+  Detector detector;           //< The detector which changed.
+  bool level;                  //< The level of the detector after the change.
+  uint32_t timestamp;          //< Time of the change in micro seconds.
+};
+
+/**
+ * The pins of a detector pair guarding one lane of the entrance, e.g. one door leaf.
+ */
+struct DetectorPins {
+  uint8_t outerDetPin;         //< The outer detector pin.
+  uint8_t innerDetPin;         //< The inner detector pin.
 };
 
 /**
  * Manages the person load in a room.
  * Providing the functionality to detect entering and leaving events by
- * using a two detectors. 
+ * using a pair of two detectors for each lane of the entrance.
  * With two detectors the direction of the door passing can be determined.
+ * All lanes are followed independently and feed one person count of the room.
+ * Persons following each other closely can be told apart with MULTI_PASS_TRACKING.
+ * Level changes of the detectors are captured by interrupts into a queue,
+ * which is consumed by the passing check. So no passing gets lost if the check runs late.
+ * Glitches shorter than DETECTOR_DEBOUNCE_TIME are filtered out before the passings are followed.
+ * The passing check is meant to run in its own task. Person count and room full state
+ * can be read from other tasks, the room capacity can be set from other tasks.
+ * The passing check never prints over serial itself, since it would wait for the console.
+ * Its log messages are queued and printed by printLog() from the task owning the console.
  */
 class RoomLoadSystem {
   private:
-    const uint8_t outerDetPin;            //< The inner detector pin.
-    const uint8_t innerDetPin;            //< The outer detector pin.
-    PassState passState;                  //< Current door passing state
-    uint8_t personCount = 0;              //< number of persons
-    bool roomFull = false;                //< If number of persons inside the room has reached the maximum.
-    uint8_t roomCap = ROOM_CAP_DEFAULT;   //< Capacity of the room
+    /**
+     * The state of one lane of the entrance.
+     */
+    struct Lane {
+      DetectorPins pins;                  //< The detector pins of the lane.
+#if MULTI_PASS_TRACKING
+      PassTracker passTracker;            //< Follows overlapping door passings of the lane.
+#else
+      PassFsm passFsm;                    //< Follows the current door passing of the lane.
+#endif
+      InputFilter outerFilter;            //< Debounces the outer detector. Its level is seen by the passing check.
+      InputFilter innerFilter;            //< Debounces the inner detector. Its level is seen by the passing check.
+      uint32_t entries = 0;               //< Number of persons who entered through the lane.
+      uint32_t exits = 0;                 //< Number of persons who left through the lane.
+    };
+
+    /**
+     * The argument of a detector interrupt.
+     */
+    struct DetectorIsrArg {
+      RoomLoadSystem* sys;                //< The room load system.
+      uint8_t lane;                       //< The lane of the detector.
+      Detector detector;                  //< The detector.
+      uint8_t pin;                        //< The pin of the detector.
+    };
+
+    Lane lanes[MAX_DET_LANES];            //< The lanes of the entrance.
+    const uint8_t laneCount;              //< Number of used lanes.
+    DetectorIsrArg isrArgs[2 * MAX_DET_LANES]; //< The arguments of the detector interrupts.
+    std::atomic<uint16_t> personCount{0}; //< number of persons
+    std::atomic<bool> roomFull{false};    //< If number of persons inside the room has reached the maximum.
+    std::atomic<uint16_t> roomCap{ROOM_CAP_DEFAULT}; //< Capacity of the room
+    std::atomic<bool> resetRequest{false}; //< If the passing state should be resetted by the next passing check.
+    SpscRing<DetectorEdge, DETECTOR_EDGE_QUEUE_SIZE> edges; //< Detector edges captured by the interrupts.
+    std::atomic<uint32_t> droppedEdges{0}; //< Number of detector edges lost because the queue was full.
+    uint32_t handledDrops = 0;            //< Number of lost detector edges the passing check already reacted to.
+    bool wasDoorOpen = false;             //< If the door was open at the last passing check.
+    SpscRing<RoomLoadLogEntry, ROOM_LOAD_LOG_QUEUE_SIZE> logs; //< Log messages of the passing check waiting to be printed.
+    std::atomic<uint32_t> droppedLogs{0}; //< Number of log messages lost because the log queue was full.
+    uint32_t printedDrops = 0;            //< Number of lost log messages already reported by printLog().
+
+    /**
+     * Interrupt handler for level changes of a detector.
+     * Captures the current level of the detector with a timestamp into the edge queue.
+     * All detector interrupts are served on the same core, so they are the only producer of the queue.
+     * @param arg Pointer to the DetectorIsrArg of the detector.
+     */
+    static void onDetectorEdge(void* arg);
+
+    /**
+     * Takes over the detector levels of a lane which became stable until a point in time.
+     * The stable edges of both detectors are handled in the order they happened.
+     * @param laneId The index of the lane.
+     * @param time The point in time in micro seconds.
+     * @param doorSys A reference to the door status system.
+     * @param eventBus The event bus registered room load events are published to.
+     */
+    void pollDetectors(uint8_t laneId, uint32_t time, DoorStatusSystem& doorSys, RoomLoadEventBus& eventBus);
+
+    /**
+     * Follows the door passings of a lane by a stable detector edge.
+     * Edges while the door is closed only update the detector level.
+     * @param laneId The index of the lane.
+     * @param detector The detector which changed.
+     * @param edge The stable edge.
+     * @param doorSys A reference to the door status system.
+     * @param eventBus The event bus registered room load events are published to.
+     */
+    void handleDetectorEdge(uint8_t laneId,
+                            Detector detector,
+                            const InputEdge& edge,
+                            DoorStatusSystem& doorSys,
+                            RoomLoadEventBus& eventBus);
+
+    /**
+     * Forgets the door passings of a lane which are followed right now.
+     * @param laneId The index of the lane.
+     */
+    void dropPassings(uint8_t laneId);
+
+#if MULTI_PASS_TRACKING
+
+    /**
+     * Follows overlapping door passings of a lane by a stable detector edge
+     * and registeres the resolved entering and leaving events.
+     * @param laneId The index of the lane.
+     * @param detector The detector which changed.
+     * @param edge The stable edge.
+     * @param eventBus The event bus registered room load events are published to.
+     */
+    void trackPass(uint8_t laneId, Detector detector, const InputEdge& edge, RoomLoadEventBus& eventBus);
+
+    /**
+     * Registers the door passings resolved by the tracker of a lane.
+     * @param laneId The index of the lane.
+     * @param result The resolved passings.
+     * @param eventBus The event bus registered room load events are published to.
+     */
+    void applyTrackResult(uint8_t laneId, const PassTrackResult& result, RoomLoadEventBus& eventBus);
+#else
+    /**
+     * Determines the next door passing state of a lane for its current detector levels with one table lookup
+     * and registeres entering and leaving events.
+     * @param laneId The index of the lane.
+     * @param eventBus The event bus registered room load events are published to.
+     */
+    void stepPassState(uint8_t laneId, RoomLoadEventBus& eventBus);
+#endif
+
+    /**
+     * Registers that someone entered through a lane.
+     * @param laneId The index of the lane.
+     * @param eventBus The event bus registered room load events are published to.
+     */
+    void registerEntered(uint8_t laneId, RoomLoadEventBus& eventBus);
+
+    /**
+     * Registers that someone left through a lane.
+     * @param laneId The index of the lane.
+     * @param eventBus The event bus registered room load events are published to.
+     */
+    void registerLeft(uint8_t laneId, RoomLoadEventBus& eventBus);
+
+    /**
+     * Registers room full and room not full events for the current person count.
+     * @param eventBus The event bus registered room load events are published to.
+     */
+    void checkRoomFull(RoomLoadEventBus& eventBus);
+
+    /**
+     * Queues a log message of the passing check to be printed by printLog().
+     * @param message The message.
+     * @param lane The lane the message refers to.
+     * @param detail The PassState of a pass error or the number of lost or aborted passings.
+     */
+    void log(RoomLoadLog message, uint8_t lane = 0, uint8_t detail = 0);
 
   public:
 
     /**
      * Constructs a RoomLoadSystem with the used hardware pins.
-     * @param outerDetPin The outer detector pin.
-     * @param innerDetPin The inner detector pin.
+     * @param lanePins The detector pins of each lane.
+     * @param laneCount The number of lanes. Limited to MAX_DET_LANES.
      */
-    RoomLoadSystem(uint8_t outerDetPin, uint8_t innerDetPin);
+    RoomLoadSystem(const DetectorPins* lanePins, uint8_t laneCount);
 
     /**
      * Gives the room capacity.
      * @return room capacity
      */
-    uint8_t getRoomCap() const;
+    uint16_t getRoomCap() const;
 
     /**
      * Sets the room capacity.
      * @param val The room capacity which should be set.
      */
-    void setRoomCap(uint8_t val);
+    void setRoomCap(uint16_t val);
 
     /**
      * Returns whether room is full or not.
@@ -76,56 +294,49 @@ class RoomLoadSystem {
      * Returns the current person count in the room.
      * @return person count
      */
-    uint8_t getPersonCount() const;
+    uint16_t getPersonCount() const;
 
     /**
-     * Brings the system back in initial state.
+     * Returns the number of lanes of the entrance.
+     * @return lane count
      */
-    void reset();
+    uint8_t getLaneCount() const;
 
     /**
-    * If the outer detector is passed.
-    * @return
-    * -true: If so
-    * -false: otherwise
-    */
-    bool isPassingOuter() const;
+     * Prints the number of entries and exits of each lane over serial.
+     */
+    void printLaneStats() const;
 
     /**
-    * If the inner detector is passed.
-    * @return
-    * -true: If so
-    * -false: otherwise
-    */
-    bool isPassingInner() const;
+     * Returns the number of detector edges lost because the edge queue was full.
+     * @return Number of lost edges.
+     */
+    uint32_t getDroppedEdges() const;
 
     /**
-    * If both detector are passed.
-    * @return
-    * -true: If so
-    * -false: otherwise
-    */
-    bool isPassingBoth() const;
+     * Prints the queued log messages of the passing check over serial.
+     * May only be called by one task, the one owning the console.
+     */
+    void printLog();
 
     /**
-    * If no detector is passed.
-    * @return
-    * -true: If so
-    * -false: otherwise
-    */
-    bool noPassing() const;
+     * Brings the system back in initial state.
+     * Takes effect with the next passing check.
+     */
+    void reset();
 
     /**
-     * Determines the current door passing state by reading the detector inputs
-     * and registeres entering and leaving events. 
-     * Assumes that only one person can pass the door at the same time.
-     * Accesses a DoorStatusSystem to update status LEDs on room full and room not full events respectively and
-     * also checks if persons are still in the room if the door was closed.
-     * Calls the callback on room full, room not full and persons in the room events.
+     * Determines the current door passing state of each lane by consuming the captured detector edges
+     * and registeres entering and leaving events. Edges captured while the door is closed are discarded.
+     * The passings which did not finish when the door closes are dropped.
+     * With MULTI_PASS_TRACKING several persons can pass a lane at the same time,
+     * otherwise it is assumed that only one person can pass a lane at the same time.
+     * Reads the door state of a DoorStatusSystem. The status LEDs follow the room full and room not full events.
+     * Publishes room full, room not full, person entered and person left events.
      * @param doorSys A reference to the door status system.
-     * @param eventCallback A callback which will be called if a room load event was registered.
+     * @param eventBus The event bus registered room load events are published to.
      */
-    void doDoorPassingCheck(DoorStatusSystem& doorSys, std::function<void (RoomLoadEvent)> eventCallback);
+    void doDoorPassingCheck(DoorStatusSystem& doorSys, RoomLoadEventBus& eventBus);
 };
 
 #include "room_load_sys_inline.h"
\ No newline at end of file
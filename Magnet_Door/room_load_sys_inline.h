@@ -10,7 +10,7 @@
  * Gives the room capacity.
  * @return room capacity
  */
-inline uint8_t RoomLoadSystem::getRoomCap() const {
+inline uint16_t RoomLoadSystem::getRoomCap() const {
   return roomCap;
 }
 
@@ -18,7 +18,7 @@ inline uint8_t RoomLoadSystem::getRoomCap() const {
  * Sets the room capacity.
  * @param val The room capacity which should be set.
  */
-inline void RoomLoadSystem::setRoomCap(uint8_t val) {
+inline void RoomLoadSystem::setRoomCap(uint16_t val) {
   roomCap = val;
 }
 
@@ -36,54 +36,22 @@ inline bool RoomLoadSystem::isRoomFull() const {
  * Returns the current person count in the room.
  * @return person count
  */
-inline uint8_t RoomLoadSystem::getPersonCount() const {
+inline uint16_t RoomLoadSystem::getPersonCount() const {
   return personCount;
 }
 
 /**
- * If the outer detector is passed.
- * @return
- * -true: If so
- * -false: otherwise
+ * Returns the number of lanes of the entrance.
+ * @return lane count
  */
-inline bool RoomLoadSystem::isPassingOuter() const {
-  if(!digitalRead(outerDetPin) && digitalRead(innerDetPin)) 
-    return true;
-  return false;
+inline uint8_t RoomLoadSystem::getLaneCount() const {
+  return laneCount;
 }
 
 /**
- * If the inner detector is passed.
- * @return
- * -true: If so
- * -false: otherwise
+ * Returns the number of detector edges lost because the edge queue was full.
+ * @return Number of lost edges.
  */
-inline bool RoomLoadSystem::isPassingInner() const {
-  if(digitalRead(outerDetPin) && !digitalRead(innerDetPin)) 
-    return true;
-  return false;
-}
-
-/**
- * If both detector are passed.
- * @return
- * -true: If so
- * -false: otherwise
- */
-inline bool RoomLoadSystem::isPassingBoth() const {
-  if(!digitalRead(outerDetPin) && !digitalRead(innerDetPin)) 
-    return true;
-  return false;
-}
-
-/**
- * If no detector is passed.
- * @return
- * -true: If so
- * -false: otherwise
- */
-inline bool RoomLoadSystem::noPassing() const {
-  if(digitalRead(outerDetPin) && digitalRead(innerDetPin)) 
-    return true;
-  return false;
+inline uint32_t RoomLoadSystem::getDroppedEdges() const {
+  return droppedEdges;
 }
\ No newline at end of file
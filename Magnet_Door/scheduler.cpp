@@ -0,0 +1,149 @@
+/*************************************************************
+  The implementation of a cooperative scheduler to execute periodic tasks by deadline.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "scheduler.h"
+#include "Arduino.h"
+
+//===========================================================
+// Static function implementations
+
+/**
+ * Checks whether a timestamp lies before another one.
+ * Takes care of the overflow of the micro second counter.
+ * @param a The first timestamp.
+ * @param b The second timestamp.
+ * @return
+ *  -true: If a lies before b.
+ *  -false: otherwise.
+ */
+inline static bool isBefore(uint32_t a, uint32_t b) {
+  return static_cast<int32_t>(a - b) < 0;
+}
+
+//===========================================================
+// Member function implementations
+
+/**
+ * Registers a new task in the task table.
+ * @param name The name of the task.
+ * @param routine The routine which is executed on each release.
+ * @param arg The argument passed to the routine.
+ * @param period The time between two releases in micro seconds.
+ * @param deadline The time after a release until the routine has to be finished in micro seconds.
+ * @param priority The priority of the task. Higher values are dispatched first.
+ * @return The id of the task or -1 if the task table is full.
+ */
+int8_t Scheduler::addTask(const char* name,
+                          TaskRoutine routine,
+                          void* arg,
+                          uint32_t period,
+                          uint32_t deadline,
+                          uint8_t priority) {
+  if(taskCount >= SCHEDULER_MAX_TASKS) {
+    return -1;
+  }
+  SchedulerTask& task = tasks[taskCount];
+  task.name = name;
+  task.routine = routine;
+  task.arg = arg;
+  task.period = period;
+  task.deadline = deadline;
+  task.priority = priority;
+  task.nextRelease = micros();
+  task.deadlineMisses = 0;
+  return taskCount++;
+}
+
+/**
+ * Changes the period of a registered task.
+ * Takes effect after the next release of the task.
+ * @param id The id of the task.
+ * @param period The new period in micro seconds.
+ */
+void Scheduler::setPeriod(int8_t id, uint32_t period) {
+  if(id >= 0 && id < taskCount) {
+    tasks[id].period = period;
+  }
+}
+
+/**
+ * Releases all registered tasks at the current point in time.
+ */
+void Scheduler::start() {
+  uint32_t now = micros();
+  for(uint8_t i = 0; i < taskCount; i++) {
+    tasks[i].nextRelease = now;
+  }
+}
+
+/**
+ * Resets the deadline miss counters of all tasks.
+ */
+void Scheduler::resetStats() {
+  for(uint8_t i = 0; i < taskCount; i++) {
+    tasks[i].deadlineMisses = 0;
+  }
+}
+
+/**
+ * Dispatches the next ready task.
+ * Sleeps until the next release if no task is ready.
+ */
+void Scheduler::run() {
+  uint32_t now = micros();
+  uint32_t wakeUp = now + SCHEDULER_MAX_SLEEP; //Earliest release of all tasks which are not ready
+  SchedulerTask* next = nullptr;               //Ready task which will be dispatched
+
+  for(uint8_t i = 0; i < taskCount; i++) {
+    SchedulerTask& task = tasks[i];
+    if(!isBefore(now, task.nextRelease)) { //Task is ready
+      if(!next ||
+         task.priority > next->priority ||
+         (task.priority == next->priority &&
+          isBefore(task.nextRelease + task.deadline, next->nextRelease + next->deadline))) {
+        next = &task;
+      }
+    }
+    else if(isBefore(task.nextRelease, wakeUp)) {
+      wakeUp = task.nextRelease;
+    }
+  }
+
+  if(!next) {
+    //Nothing to do until the next release
+    sleepUntil(wakeUp);
+    return;
+  }
+
+  uint32_t absDeadline = next->nextRelease + next->deadline;
+  next->routine(next->arg);
+  uint32_t finished = micros();
+
+  if(isBefore(absDeadline, finished)) {
+    next->deadlineMisses++;
+  }
+
+  next->nextRelease += next->period;
+  if(isBefore(next->nextRelease, finished)) {
+    //Task fell behind. Skip the missed releases instead of executing them in a burst.
+    next->nextRelease = finished;
+  }
+}
+
+/**
+ * Sleeps until the given point in time is reached.
+ * Gives the CPU to other FreeRTOS tasks for the whole time. The wait is rounded up to full ticks,
+ * so a release is at most one tick late, but the core is never busy waiting.
+ * @param time Timestamp in micro seconds until which should be slept.
+ */
+void Scheduler::sleepUntil(uint32_t time) const {
+  int32_t wait = static_cast<int32_t>(time - micros());
+  if(wait <= 0) {
+    return;
+  }
+  const uint32_t tick = portTICK_PERIOD_MS * 1000; //Length of a tick in micro seconds
+  vTaskDelay((wait + tick - 1) / tick); //Blocks the loop task, so the other tasks can run
+}
\ No newline at end of file
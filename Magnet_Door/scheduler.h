@@ -0,0 +1,114 @@
+#pragma once
+/*************************************************************
+  A cooperative scheduler to execute periodic tasks by deadline.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include <cstdint>
+
+//===========================================================
+// Definitions
+#define SCHEDULER_MAX_TASKS 8        //< Maximum number of tasks the task table can hold.
+#define SCHEDULER_MAX_SLEEP 100000   //< Maximum time the scheduler sleeps at once in micro seconds.
+
+//===========================================================
+// Data Types
+
+/**
+ * The routine of a task.
+ * @param arg The argument registered together with the task.
+ */
+typedef void (*TaskRoutine)(void* arg);
+
+/**
+ * An entry of the task table.
+ */
+struct SchedulerTask {
+  const char* name = nullptr;        //< Name of the task.
+  TaskRoutine routine = nullptr;     //< The routine which is executed on each release of the task.
+  void* arg = nullptr;               //< The argument passed to the routine.
+  uint32_t period = 0;               //< Time between two releases in micro seconds.
+  uint32_t deadline = 0;             //< Time after a release until the routine has to be finished in micro seconds.
+  uint8_t priority = 0;              //< Priority of the task. Higher values are dispatched first.
+  uint32_t nextRelease = 0;          //< Timestamp of the next release in micro seconds.
+  uint32_t deadlineMisses = 0;       //< Number of executions which finished after their deadline.
+};
+
+/**
+ * Executes periodic tasks out of a static task table.
+ * On each run the ready task with the highest priority is dispatched.
+ * Ready tasks with the same priority are dispatched by earliest deadline first.
+ * If no task is ready the scheduler sleeps until the next release.
+ * Tasks are executed cooperatively, so a task can not be preempted by another one.
+ */
+class Scheduler {
+  private:
+    SchedulerTask tasks[SCHEDULER_MAX_TASKS];    //< The task table.
+    uint8_t taskCount = 0;                       //< Number of registered tasks.
+
+    /**
+     * Sleeps until the given point in time is reached.
+     * Gives the CPU to other FreeRTOS tasks for the whole time. The wait is rounded up to full ticks,
+     * so a release is at most one tick late, but the core is never busy waiting.
+     * @param time Timestamp in micro seconds until which should be slept.
+     */
+    void sleepUntil(uint32_t time) const;
+
+  public:
+    /**
+     * Registers a new task in the task table.
+     * @param name The name of the task.
+     * @param routine The routine which is executed on each release.
+     * @param arg The argument passed to the routine.
+     * @param period The time between two releases in micro seconds.
+     * @param deadline The time after a release until the routine has to be finished in micro seconds.
+     * @param priority The priority of the task. Higher values are dispatched first.
+     * @return The id of the task or -1 if the task table is full.
+     */
+    int8_t addTask(const char* name,
+                   TaskRoutine routine,
+                   void* arg,
+                   uint32_t period,
+                   uint32_t deadline,
+                   uint8_t priority);
+
+    /**
+     * Changes the period of a registered task.
+     * Takes effect after the next release of the task.
+     * @param id The id of the task.
+     * @param period The new period in micro seconds.
+     */
+    void setPeriod(int8_t id, uint32_t period);
+
+    /**
+     * Releases all registered tasks at the current point in time.
+     */
+    void start();
+
+    /**
+     * Dispatches the next ready task.
+     * Sleeps until the next release if no task is ready.
+     */
+    void run();
+
+    /**
+     * Resets the deadline miss counters of all tasks.
+     */
+    void resetStats();
+
+    /**
+     * Gives the number of registered tasks.
+     * @return Number of tasks.
+     */
+    uint8_t getTaskCount() const;
+
+    /**
+     * Gives access to a registered task.
+     * @param id The id of the task.
+     * @return The task table entry.
+     */
+    const SchedulerTask& getTask(uint8_t id) const;
+};
+
+#include "scheduler_inline.h"
\ No newline at end of file
@@ -0,0 +1,23 @@
+//===========================================================
+// included dependencies
+#include "scheduler.h"
+
+//===========================================================
+// Inline member function implementations
+
+/**
+ * Gives the number of registered tasks.
+ * @return Number of tasks.
+ */
+inline uint8_t Scheduler::getTaskCount() const {
+  return taskCount;
+}
+
+/**
+ * Gives access to a registered task.
+ * @param id The id of the task.
+ * @return The task table entry.
+ */
+inline const SchedulerTask& Scheduler::getTask(uint8_t id) const {
+  return tasks[id];
+}
\ No newline at end of file
@@ -1,5 +1,5 @@
 /*************************************************************
-  Implementation of some helper functions to process input on the serial interface.
+  Implementation of a helper to read the input on the serial interface line by line.
 *************************************************************/
 
 //===========================================================
@@ -8,65 +8,63 @@
 #include "Arduino.h"
 
 //===========================================================
-// Function implementations
+// Member function implementations
 
 /**
- * Prompts the user to input a string into the serial terminal.
- * Blocks until String was correctly inputted.
- * String is not allowed to be greater than maxLength.
- * @param input The string which was inputted.
- * @param maxLength The maximum allowed length of the string.
- * @param enterMsg The message wich should be printed before the input should be made.
- * @param enteredMsg If set to true prints the entered string into the serial.
- * @param trim If set to true all leading and ending white spaces will be removed from the inputted string.
+ * Reads the available characters from serial until a line is completed.
+ * Never waits for input.
+ * @param[out] line The completed line. Only set if a line was completed.
+ * @param trim If set to true all leading and ending white spaces will be removed from the line.
+ * @return
+ *   -true: If a line was completed.
+ *   -false: otherwise.
  */
-void inputStringFromSerial(
-            String &input, 
-            unsigned int maxLength, 
-            String enterMsg, 
-            bool enteredMsg, 
-            bool trim) {
-
-  bool processed = false;
-  do {
-    Serial.println(enterMsg);
-    while (Serial.available() == 0) {}
-
-    String read = Serial.readString();
-    if(trim) {
-      read.trim(); //Remove carriage return from string
+bool LineReader::readLine(String &line, bool trim) {
+  while(Serial.available() > 0) {
+    char c = Serial.read();
+    char previous = lastChar;
+    lastChar = c;
+    lastInput = millis();
+    if(c == '\n' && previous == '\r') {
+      continue; //Second half of a "\r\n", the line is already completed
     }
-     
-    if(read.length() <= maxLength) {
-      input = read;
-      break; //processed
+    if(c == '\r' || c == '\n') {
+      return finishLine(line, trim);
+    }
+    if(length < SERIAL_LINE_MAX_LENGTH - 1) {
+      buffer[length++] = c;
+    }
+    else {
+      overflow = true; //Drop the rest of the line
     }
-    //failed processing
-    Serial.println("Error: Input exceeds maximum allowed size. Try again.");
   }
-  while(true); //Repeat as long as processing did not succeed
-  if(enteredMsg) {
-    Serial.print("Entered: ");
-    Serial.println(input);
+  //Terminals which send no line ending complete a line by a pause
+  if((length > 0 || overflow) && millis() - lastInput >= SERIAL_LINE_IDLE_TIMEOUT) {
+    return finishLine(line, trim);
   }
+  return false;
 }
 
-
 /**
- * Reads a string input from serial if available.
- * @param read The read string.
- * @param trim If set to true all leading and ending white spaces will be removed from the read string.
- * @return 
- *   -true: If string was available and read.
+ * Completes the line in the buffer and empties it.
+ * @param[out] line The completed line.
+ * @param trim If set to true all leading and ending white spaces will be removed from the line.
+ * @return
+ *   -true: If the line fit into the buffer.
  *   -false: otherwise.
  */
-bool readStringFromSerial(String &read, bool trim) {
-  if(Serial.available() != 0) {
-    read = Serial.readString();
-    if(trim) {
-      read.trim();
-    }
-    return true;
+bool LineReader::finishLine(String &line, bool trim) {
+  bool fits = !overflow;
+  buffer[length] = '\0';
+  length = 0;
+  overflow = false;
+  if(!fits) {
+    Serial.printf("Error: Input exceeds maximum allowed size of %u characters!\n", SERIAL_LINE_MAX_LENGTH - 1);
+    return false;
   }
-  return false;
-}
\ No newline at end of file
+  line = buffer;
+  if(trim) {
+    line.trim();
+  }
+  return true;
+}
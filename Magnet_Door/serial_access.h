@@ -1,6 +1,6 @@
 #pragma once
 /*************************************************************
-  Some helper functions to process input on the serial interface.
+  A helper to read the input on the serial interface line by line.
 *************************************************************/
 
 //===========================================================
@@ -8,32 +8,47 @@
 #include "Arduino.h"
 
 //===========================================================
-// Function declarations
+// Definitions
+#define SERIAL_LINE_MAX_LENGTH 288        //< Maximum length of a line read from serial including the terminator. Fits a command with a full url.
+#define SERIAL_LINE_IDLE_TIMEOUT 1000     //< Time without input which ends a line without line ending in milli seconds.
+
+//===========================================================
+// Data Types
 
 /**
- * Prompts the user to input a string into the serial terminal.
- * Blocks until String was correctly inputted.
- * String is not allowed to be greater than maxLength.
- * @param input The string which was inputted.
- * @param maxLength The maximum allowed length of the string.
- * @param enterMsg The message wich should be printed before the input should be made.
- * @param enteredMsg If set to true prints the entered string into the serial.
- * @param trim If set to true all leading and ending white spaces will be removed from the inputted string.
+ * Assembles the lines inputted over serial without blocking.
+ * Takes the characters which are available and collects them in a fixed buffer
+ * until a line ending ("\n", "\r" or "\r\n") completes the line.
+ * Terminals which send no line ending complete a line by a pause of SERIAL_LINE_IDLE_TIMEOUT.
+ * A line which exceeds the buffer is dropped with an error message.
  */
-void inputStringFromSerial(
-            String &input, 
-            unsigned int maxLength, 
-            String enterMsg = "Please enter something: ", 
-            bool enteredMsg = true, 
-            bool trim = true);
+class LineReader {
+  private:
+    char buffer[SERIAL_LINE_MAX_LENGTH];  //< The characters of the incomplete line.
+    uint16_t length = 0;                  //< Number of characters in the buffer.
+    bool overflow = false;                //< If the incomplete line exceeded the buffer.
+    char lastChar = '\0';                 //< The last read character. To skip the "\n" of a "\r\n".
+    uint32_t lastInput = 0;               //< Time of the last read character in milli seconds.
 
+    /**
+     * Completes the line in the buffer and empties it.
+     * @param[out] line The completed line.
+     * @param trim If set to true all leading and ending white spaces will be removed from the line.
+     * @return
+     *   -true: If the line fit into the buffer.
+     *   -false: otherwise.
+     */
+    bool finishLine(String &line, bool trim);
 
-/**
- * Reads a string input from serial if available.
- * @param read The read string.
- * @param trim If set to true all leading and ending white spaces will be removed from the read string.
- * @return 
- *   -true: If string was available and read.
- *   -false: otherwise.
- */
-bool readStringFromSerial(String &read, bool trim = true);
\ No newline at end of file
+  public:
+    /**
+     * Reads the available characters from serial until a line is completed.
+     * Never waits for input.
+     * @param[out] line The completed line. Only set if a line was completed.
+     * @param trim If set to true all leading and ending white spaces will be removed from the line.
+     * @return
+     *   -true: If a line was completed.
+     *   -false: otherwise.
+     */
+    bool readLine(String &line, bool trim = true);
+};
@@ -0,0 +1,147 @@
+/*************************************************************
+  The implementation of a sequencer to play signal patterns on the buzzer and status LEDs.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "signal_sequencer.h"
+
+//===========================================================
+// Signal patterns
+static const uint16_t doorOpenedPhases[] = {150, 100, 150};
+static const uint16_t doorClosedPhases[] = {400};
+static const uint16_t roomFullPhases[] = {500, 250};
+static const uint16_t connectPhases[] = {1500, 1500};
+static const uint16_t reconnectPhases[] = {200, 200, 200, 1400};
+
+const SignalPattern doorOpenedSignal = {doorOpenedPhases, 3, 1};
+const SignalPattern doorClosedSignal = {doorClosedPhases, 1, 1};
+const SignalPattern roomFullSignal = {roomFullPhases, 2, 3};
+const SignalPattern connectSignal = {connectPhases, 2, 0};
+const SignalPattern reconnectSignal = {reconnectPhases, 4, 0};
+
+//===========================================================
+// Member function implementations
+
+/**
+ * Attaches a pin to a channel and starts the timer if not done yet.
+ * @param channel The channel.
+ * @param pin The pin which should be driven.
+ * @param output How the pin is driven.
+ * @param idle If the output is on while no pattern is played.
+ */
+void SignalSequencer::attach(SignalChannel channel, uint8_t pin, SignalOutput output, bool idle) {
+  Channel& ch = channels[static_cast<uint8_t>(channel)];
+  if(output == SignalOutput::tone) {
+    ledcAttach(pin, SIGNAL_BUZZER_FREQUENCY, SIGNAL_BUZZER_RESOLUTION);
+  }
+  else {
+    pinMode(pin, OUTPUT);
+  }
+  ch.output = output;
+  ch.idle = idle;
+  ch.level = !idle; //Forces the first write
+  ch.pin = pin;     //From now on the channel is stepped
+  write(ch, idle);
+
+  if(!timer) {
+    esp_timer_create_args_t args = {};
+    args.callback = onTick;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK; //The drivers of the outputs are not interrupt safe
+    args.name = "signals";
+    args.skip_unhandled_events = true;     //A late step is not caught up
+    if(esp_timer_create(&args, &timer) != ESP_OK || esp_timer_start_periodic(timer, SIGNAL_TICK_PERIOD) != ESP_OK) {
+      Serial.println("Error: Could not start the signal timer!");
+    }
+  }
+}
+
+/**
+ * Queues a pattern on a channel.
+ * A pattern which is played until stopped is replaced at its end.
+ * @param channel The channel.
+ * @param pattern The pattern. Has to stay valid while it is played.
+ * @return
+ *  -true: On success.
+ *  -false: If the queue of the channel is full.
+ */
+bool SignalSequencer::play(SignalChannel channel, const SignalPattern& pattern) {
+  return channels[static_cast<uint8_t>(channel)].queue.push(&pattern);
+}
+
+/**
+ * Steps all channels. Called by the esp_timer task.
+ * @param sequencer Pointer to the sequencer.
+ */
+void SignalSequencer::onTick(void* sequencer) {
+  SignalSequencer* seq = static_cast<SignalSequencer*>(sequencer);
+  for(Channel& channel : seq->channels) {
+    if(channel.pin >= 0) {
+      seq->step(channel);
+    }
+  }
+}
+
+/**
+ * Steps the played pattern of a channel and drives its output.
+ * @param channel The channel.
+ */
+void SignalSequencer::step(Channel& channel) {
+  if(channel.stopRequest.exchange(false)) {
+    channel.pattern = nullptr;
+  }
+
+  if(channel.pattern) {
+    if(channel.remaining > SIGNAL_TICK_PERIOD) {
+      channel.remaining -= SIGNAL_TICK_PERIOD;
+      return; //Phase goes on
+    }
+    if(++channel.phase >= channel.pattern->length) {
+      channel.phase = 0;
+      channel.repeat++;
+      bool looping = (channel.pattern->repeats == 0);
+      if((looping && !channel.queue.isEmpty()) ||
+         (!looping && channel.repeat >= channel.pattern->repeats)) {
+        channel.pattern = nullptr; //Finished
+      }
+    }
+  }
+
+  if(!channel.pattern && channel.queue.pop(channel.pattern)) {
+    channel.phase = 0;
+    channel.repeat = 0;
+  }
+
+  if(channel.pattern) {
+    channel.remaining = channel.pattern->durations[channel.phase] * 1000UL;
+    write(channel, channel.phase % 2 == 0);
+  }
+  else {
+    write(channel, channel.idle);
+  }
+}
+
+/**
+ * Drives the output of a channel.
+ * @param channel The channel.
+ * @param on If the output should be on.
+ */
+void SignalSequencer::write(Channel& channel, bool on) {
+  if(channel.level == on) {
+    return; //Nothing changes
+  }
+  channel.level = on;
+  uint8_t pin = channel.pin;
+  switch(channel.output) {
+    case SignalOutput::activeHigh:
+      digitalWrite(pin, on? HIGH : LOW);
+      break;
+    case SignalOutput::activeLow:
+      digitalWrite(pin, on? LOW : HIGH);
+      break;
+    case SignalOutput::tone:
+      ledcWrite(pin, on? (1 << (SIGNAL_BUZZER_RESOLUTION - 1)) : 0); //Half duty cycle
+      break;
+  }
+}
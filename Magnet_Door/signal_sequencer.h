@@ -0,0 +1,148 @@
+#pragma once
+/*************************************************************
+  A sequencer to play signal patterns on the buzzer and status LEDs.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include <atomic>
+#include <esp_timer.h>
+#include "spsc_ring.h"
+
+//===========================================================
+// Definitions
+#define SIGNAL_TICK_PERIOD 10000        //< Time between two steps of the sequencer in micro seconds.
+#define SIGNAL_QUEUE_SIZE 4             //< Number of patterns which can be queued per channel.
+#define SIGNAL_BUZZER_FREQUENCY 100     //< Tone frequency of the buzzer in Hz.
+#define SIGNAL_BUZZER_RESOLUTION 8      //< Duty resolution of the buzzer PWM in bits.
+
+//===========================================================
+// Data Types
+
+/**
+ * The outputs the sequencer can drive.
+ */
+enum class SignalChannel: uint8_t {
+  buzzer,                      //< The buzzer.
+  openLED,                     //< The door open status LED.
+  closedLED,                   //< The door closed status LED.
+  connLED,                     //< The connection status LED.
+  count                        //< Number of channels. Has to stay the last entry.
+};
+
+/**
+ * How a channel drives its pin.
+ */
+enum class SignalOutput: uint8_t {
+  activeHigh,                  //< Digital output which is on at high level.
+  activeLow,                   //< Digital output which is on at low level.
+  tone                         //< PWM output which plays a tone while on.
+};
+
+/**
+ * A signal pattern made of alternating on and off phases.
+ * The first phase is on.
+ */
+struct SignalPattern {
+  const uint16_t* durations;   //< Durations of the phases in milli seconds.
+  uint8_t length;              //< Number of phases.
+  uint8_t repeats;             //< Number of times the pattern is played. 0 plays it until the channel is stopped or another pattern is queued.
+};
+
+/**
+ * Plays queued signal patterns on the buzzer and LEDs.
+ * The patterns are stepped by a periodic esp_timer, the buzzer tone is generated by LEDC,
+ * so playing a pattern costs no time of the calling task.
+ * The timer callback runs in the high priority esp_timer task and not in an interrupt,
+ * since the GPIO and LEDC drivers are not safe to be called from an interrupt.
+ * While no pattern is played a channel shows its idle state.
+ * Patterns of a channel are queued by one task. The idle state can be set from any task.
+ */
+class SignalSequencer {
+  private:
+    /**
+     * The state of a channel.
+     */
+    struct Channel {
+      int16_t pin = -1;                                //< The driven pin or -1 if not attached.
+      SignalOutput output = SignalOutput::activeHigh;  //< How the pin is driven.
+      SpscRing<const SignalPattern*, SIGNAL_QUEUE_SIZE> queue; //< The queued patterns.
+      const SignalPattern* pattern = nullptr;          //< The pattern which is played.
+      uint8_t phase = 0;                               //< The phase of the played pattern.
+      uint8_t repeat = 0;                              //< Number of times the played pattern was finished.
+      uint32_t remaining = 0;                          //< Time left in the current phase in micro seconds.
+      bool level = false;                              //< If the output is currently on.
+      std::atomic<bool> idle{false};                   //< If the output is on while no pattern is played.
+      std::atomic<bool> stopRequest{false};            //< If the played pattern should be ended.
+    };
+
+    esp_timer_handle_t timer = nullptr;                 //< Timer which steps the patterns.
+    Channel channels[static_cast<uint8_t>(SignalChannel::count)]; //< The channels.
+
+    /**
+     * Steps all channels. Called by the esp_timer task.
+     * @param sequencer Pointer to the sequencer.
+     */
+    static void onTick(void* sequencer);
+
+    /**
+     * Steps the played pattern of a channel and drives its output.
+     * @param channel The channel.
+     */
+    void step(Channel& channel);
+
+    /**
+     * Drives the output of a channel.
+     * @param channel The channel.
+     * @param on If the output should be on.
+     */
+    void write(Channel& channel, bool on);
+
+  public:
+    /**
+     * Attaches a pin to a channel and starts the timer if not done yet.
+     * @param channel The channel.
+     * @param pin The pin which should be driven.
+     * @param output How the pin is driven.
+     * @param idle If the output is on while no pattern is played.
+     */
+    void attach(SignalChannel channel, uint8_t pin, SignalOutput output, bool idle = false);
+
+    /**
+     * Queues a pattern on a channel.
+     * A pattern which is played until stopped is replaced at its end.
+     * @param channel The channel.
+     * @param pattern The pattern. Has to stay valid while it is played.
+     * @return
+     *  -true: On success.
+     *  -false: If the queue of the channel is full.
+     */
+    bool play(SignalChannel channel, const SignalPattern& pattern);
+
+    /**
+     * Ends the played pattern of a channel. Queued patterns are played afterwards.
+     * Takes effect with the next step of the sequencer.
+     * @param channel The channel.
+     */
+    void stop(SignalChannel channel);
+
+    /**
+     * Sets the state a channel shows while no pattern is played.
+     * @param channel The channel.
+     * @param on If the output should be on.
+     */
+    void setIdle(SignalChannel channel, bool on);
+};
+
+//===========================================================
+// Signal patterns
+extern const SignalPattern doorOpenedSignal;     //< Beep-beep when the door was opened.
+extern const SignalPattern doorClosedSignal;     //< One beep when the door was closed.
+extern const SignalPattern roomFullSignal;       //< Alarm when the room became full.
+extern const SignalPattern connectSignal;        //< Slow blink while connecting.
+extern const SignalPattern reconnectSignal;      //< Double blink while trying to reconnect.
+
+extern SignalSequencer signals;
+
+#include "signal_sequencer_inline.h"
@@ -0,0 +1,24 @@
+//===========================================================
+// included dependencies
+#include "signal_sequencer.h"
+
+//===========================================================
+// Inline member function implementations
+
+/**
+ * Ends the played pattern of a channel. Queued patterns are played afterwards.
+ * Takes effect with the next step of the sequencer.
+ * @param channel The channel.
+ */
+inline void SignalSequencer::stop(SignalChannel channel) {
+  channels[static_cast<uint8_t>(channel)].stopRequest = true;
+}
+
+/**
+ * Sets the state a channel shows while no pattern is played.
+ * @param channel The channel.
+ * @param on If the output should be on.
+ */
+inline void SignalSequencer::setIdle(SignalChannel channel, bool on) {
+  channels[static_cast<uint8_t>(channel)].idle = on;
+}
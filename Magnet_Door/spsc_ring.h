@@ -0,0 +1,103 @@
+#pragma once
+/*************************************************************
+  A wait-free ring buffer to hand over data from one producer to one consumer.
+  Only depends on the C++ standard library, so it can also be built on a host.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include <atomic>
+#include <cstddef>
+
+//===========================================================
+// Data Types
+
+/**
+ * A fixed size single producer single consumer ring buffer.
+ * push() may only be called by one producer and pop() and peek() by one consumer,
+ * which can run on different cores. Neither of them ever blocks.
+ * @tparam T The type of the elements.
+ * @tparam Capacity The number of elements the ring can hold. Has to be a power of two.
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two.");
+
+  private:
+    T buffer[Capacity];                      //< The elements of the ring.
+    std::atomic<size_t> head{0};             //< Number of pushed elements. Only written by the producer.
+    std::atomic<size_t> tail{0};             //< Number of popped elements. Only written by the consumer.
+
+  public:
+    /**
+     * Appends an element to the ring.
+     * May only be called by the producer.
+     * @param item The element to be appended.
+     * @return
+     *  -true: On success.
+     *  -false: If the ring is full.
+     */
+    bool push(const T& item) {
+      size_t h = head.load(std::memory_order_relaxed);
+      if(h - tail.load(std::memory_order_acquire) >= Capacity) {
+        return false; //full
+      }
+      buffer[h & (Capacity - 1)] = item;
+      head.store(h + 1, std::memory_order_release); //Publish the element
+      return true;
+    }
+
+    /**
+     * Takes the oldest element out of the ring.
+     * May only be called by the consumer.
+     * @param[out] item The element taken out.
+     * @return
+     *  -true: On success.
+     *  -false: If the ring is empty.
+     */
+    bool pop(T& item) {
+      size_t t = tail.load(std::memory_order_relaxed);
+      if(t == head.load(std::memory_order_acquire)) {
+        return false; //empty
+      }
+      item = buffer[t & (Capacity - 1)];
+      tail.store(t + 1, std::memory_order_release); //Free the slot
+      return true;
+    }
+
+    /**
+     * Reads the oldest element without taking it out of the ring.
+     * May only be called by the consumer.
+     * @param[out] item The oldest element.
+     * @return
+     *  -true: On success.
+     *  -false: If the ring is empty.
+     */
+    bool peek(T& item) const {
+      size_t t = tail.load(std::memory_order_relaxed);
+      if(t == head.load(std::memory_order_acquire)) {
+        return false; //empty
+      }
+      item = buffer[t & (Capacity - 1)];
+      return true;
+    }
+
+    /**
+     * Gives the number of elements currently in the ring.
+     * @return Number of elements.
+     */
+    size_t size() const {
+      size_t t = tail.load(std::memory_order_acquire); //Read first, so head can only be ahead of it
+      return head.load(std::memory_order_acquire) - t;
+    }
+
+    /**
+     * Gives whether the ring is empty.
+     * @return
+     *  -true: If empty.
+     *  -false: otherwise.
+     */
+    bool isEmpty() const {
+      return size() == 0;
+    }
+};
\ No newline at end of file
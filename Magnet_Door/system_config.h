@@ -6,6 +6,7 @@
 #define BUZZER_PIN 23              //< buzzer pin
 #define INNER_DET_PIN 16           //< inner detector pin
 #define OUTER_DET_PIN 17           //< outer detector pin
+#define DET_LANE_PINS {{OUTER_DET_PIN, INNER_DET_PIN}} //< outer and inner detector pins of each lane, e.g. {{17, 16}, {26, 25}} for a double door
 #define CONN_BUTTON_PIN 4          //< the connection button pin
 #define CONN_LED_PIN 5             //< Connection status LED pin
 #define TERM_PIN 0                 //< Thermistor pin
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+/*************************************************************
+  A generic state machine driven by a constant transition table.
+  Only depends on the C++ standard library, so it can also be built on a host.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include <cstdint>
+
+//===========================================================
+// Data Types
+
+/**
+ * An entry of a transition table.
+ * @tparam State The state type. An enum with values from 0 to the number of states - 1.
+ * @tparam Event The type of the events a transition can register.
+ */
+template <typename State, typename Event>
+struct FsmTransition {
+  State next;                        //< The next state.
+  Event event;                       //< The event registered by the transition.
+};
+
+/**
+ * A state machine which determines each step with a single lookup in a constant table.
+ * The table is indexed by the current state and an input code.
+ * The table is given by a description type which provides:
+ *  - State: The state type. An enum with values from 0 to the number of states - 1.
+ *  - Event: The type of the events a transition can register.
+ *  - initial: The state the machine starts in.
+ *  - inputCount: The number of input codes. Has to be a power of two.
+ *  - table: A constexpr array of FsmTransition<State, Event> with a row per state and a column per input code.
+ * @tparam Description The description type of the state machine.
+ */
+template <typename Description>
+class TableFsm {
+  public:
+    typedef typename Description::State State;
+    typedef typename Description::Event Event;
+    typedef FsmTransition<State, Event> Transition;
+
+  private:
+    static_assert(Description::inputCount > 0 && (Description::inputCount & (Description::inputCount - 1)) == 0,
+                  "The number of input codes has to be a power of two.");
+
+    State state = Description::initial;      //< The current state.
+
+  public:
+    /**
+     * Looks up a transition.
+     * @param state The current state.
+     * @param code The input code. Only the bits below inputCount are used.
+     * @return The transition.
+     */
+    static constexpr Transition transition(State state, uint8_t code) {
+      return Description::table[static_cast<uint8_t>(state)][code & (Description::inputCount - 1)];
+    }
+
+    /**
+     * Determines the next state for an input code.
+     * @param code The input code. Only the bits below inputCount are used.
+     * @return The event registered by the step.
+     */
+    Event step(uint8_t code) {
+      const Transition& t = Description::table[static_cast<uint8_t>(state)][code & (Description::inputCount - 1)];
+      state = t.next;
+      return t.event;
+    }
+
+    /**
+     * Gives the current state.
+     * @return The current state.
+     */
+    State getState() const {
+      return state;
+    }
+
+    /**
+     * Brings the state machine back to its initial state.
+     */
+    void reset() {
+      state = Description::initial;
+    }
+};
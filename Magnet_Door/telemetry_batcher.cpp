@@ -0,0 +1,176 @@
+/*************************************************************
+  The implementation of a batcher to collect telemetry records and upload them together.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "telemetry_batcher.h"
+
+//===========================================================
+// Function implementations
+
+/**
+ * Adds a telemetry record as json object to a json array.
+ * @param batch The json array.
+ * @param room The name of the room.
+ * @param record The record.
+ * @return The added json object.
+ */
+JsonObject serializeTelemetryRecord(JsonArray batch, const char* room, const TelemetryRecord& record) {
+  JsonObject entry = batch.add<JsonObject>();
+  entry["room"] = room;
+  entry["log_time"] = record.timestamp;
+  if(record.event) {
+    entry["event"] = record.event;
+  }
+  entry["door_state"] = record.doorOpen;
+  entry["people_count"] = record.personCount;
+  entry["room_full"] = record.roomFull;
+  entry["temperature"] = record.temperature;
+  entry["mode"] = telemetryModeName(record.mode);
+  return entry;
+}
+
+/**
+ * Gives the name of a telemetry mode as used in the payload and the commands.
+ * @param mode The telemetry mode.
+ * @return The name.
+ */
+const char* telemetryModeName(TelemetryMode mode) {
+  return mode == TelemetryMode::onChange? "change" : "periodic";
+}
+
+/**
+ * Parses the name of a telemetry mode.
+ * @param name The name. Either "periodic" or "change".
+ * @param[out] mode The telemetry mode.
+ * @return
+ *  -true: On success.
+ *  -false: If the name is unknown.
+ */
+bool parseTelemetryMode(const String& name, TelemetryMode& mode) {
+  if(name == "periodic") {
+    mode = TelemetryMode::periodic;
+  }
+  else if(name == "change") {
+    mode = TelemetryMode::onChange;
+  }
+  else {
+    return false;
+  }
+  return true;
+}
+
+//===========================================================
+// Member function implementations
+
+/**
+ * Adds a record. Drops the oldest record if the buffer is full.
+ * @param record The record.
+ */
+void TelemetryBatcher::add(const TelemetryRecord& record) {
+  if(count == TELEMETRY_BATCH_CAPACITY) {
+    discard(1); //Makes room by dropping the oldest record
+    dropped++;
+  }
+  records[(head + count) % TELEMETRY_BATCH_CAPACITY] = record;
+  count++;
+}
+
+/**
+ * Serializes the buffered records into one array.
+ * @param room The name of the room, which is added to every record.
+ * @param format The wire format of the array.
+ * @param[out] out The serialized array.
+ * @return The number of serialized records.
+ */
+uint8_t TelemetryBatcher::serialize(const char* room, WireFormat format, String& out) const {
+  JsonDocument doc;
+  JsonArray batch = doc.to<JsonArray>();
+  for(uint8_t i = 0; i < count; i++) {
+    serializeTelemetryRecord(batch, room, getRecord(i));
+  }
+  serializeWireFormat(doc, format, out);
+  return count;
+}
+
+/**
+ * Removes the oldest records after they were uploaded.
+ * @param n The number of uploaded records.
+ */
+void TelemetryBatcher::commit(uint8_t n) {
+  discard(n);
+  flushes++;
+}
+
+/**
+ * Removes the oldest records after they were stored for a later upload.
+ * Not counted as uploaded batch.
+ * @param n The number of stored records.
+ */
+void TelemetryBatcher::divert(uint8_t n) {
+  if(n > count) {
+    n = count;
+  }
+  discard(n);
+  stored += n;
+}
+
+/**
+ * Removes the oldest records.
+ * @param n The number of records.
+ */
+void TelemetryBatcher::discard(uint8_t n) {
+  if(n > count) {
+    n = count;
+  }
+  head = (head + n) % TELEMETRY_BATCH_CAPACITY;
+  count -= n;
+}
+
+/**
+ * Sets the number of records which trigger a flush.
+ * @param size The batch size. Between 1 and TELEMETRY_BATCH_CAPACITY.
+ * @return
+ *  -true: On success.
+ *  -false: If the size is out of bounds.
+ */
+bool TelemetryBatcher::setBatchSize(uint16_t size) {
+  if(size < 1 || size > TELEMETRY_BATCH_CAPACITY) {
+    return false;
+  }
+  batchSize = size;
+  return true;
+}
+
+/**
+ * Sets the age of the oldest record which triggers a flush.
+ * @param interval The flush interval in seconds. Between 1 and TELEMETRY_FLUSH_INTERVAL_MAX.
+ * @return
+ *  -true: On success.
+ *  -false: If the interval is out of bounds.
+ */
+bool TelemetryBatcher::setFlushInterval(uint16_t interval) {
+  if(interval < 1 || interval > TELEMETRY_FLUSH_INTERVAL_MAX) {
+    return false;
+  }
+  flushInterval = interval;
+  return true;
+}
+
+/**
+ * Prints the buffer fill, the uploaded batches, the stored and the dropped records over serial.
+ */
+void TelemetryBatcher::printStats() const {
+  Serial.printf(" >> Telemetry records: buffered %u, uploaded batches %lu, stored %lu, dropped %lu\n",
+                count, (unsigned long)flushes, (unsigned long)stored, (unsigned long)dropped);
+}
+
+/**
+ * Resets the counters of uploaded batches, stored and dropped records.
+ */
+void TelemetryBatcher::resetStats() {
+  flushes = 0;
+  stored = 0;
+  dropped = 0;
+}
@@ -0,0 +1,193 @@
+#pragma once
+/*************************************************************
+  A batcher to collect telemetry records and upload them together.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include <ArduinoJson.h>
+#include "wire_format.h"
+
+//===========================================================
+// Definitions
+#define TELEMETRY_BATCH_CAPACITY 32             //< Maximum number of buffered records.
+#define TELEMETRY_BATCH_SIZE_DEFAULT 10         //< Default number of records which trigger a flush.
+#define TELEMETRY_FLUSH_INTERVAL_DEFAULT 30     //< Default age of the oldest record which triggers a flush in seconds.
+#define TELEMETRY_FLUSH_INTERVAL_MAX 3600       //< Highest configurable flush interval in seconds.
+#define TELEMETRY_HEARTBEAT_DEFAULT 300         //< Default time without change until a heartbeat is recorded in seconds.
+#define TELEMETRY_HEARTBEAT_MAX 3600            //< Highest configurable heartbeat interval in seconds.
+#define TELEMETRY_TEMP_DELTA_DEFAULT 0.5        //< Default temperature change which is recorded in change mode in °C.
+#define TELEMETRY_TEMP_DELTA_MIN 0.1            //< Lowest configurable temperature change in °C.
+#define TELEMETRY_TEMP_DELTA_MAX 10.0           //< Highest configurable temperature change in °C.
+
+//===========================================================
+// Data Types
+
+/**
+ * The ways the telemetry is recorded.
+ */
+enum class TelemetryMode: uint8_t {
+  periodic,                           //< A sample is recorded every data log interval.
+  onChange                            //< A sample is only recorded on a change or as heartbeat and uploaded right away.
+};
+
+/**
+ * A timestamped telemetry record. Either a periodic sample or an event.
+ */
+struct TelemetryRecord {
+  uint32_t timestamp;                 //< Time of the record in milli seconds.
+  const char* event;                  //< Name of the event or nullptr for a periodic sample.
+  bool doorOpen;                      //< If the door was open.
+  uint16_t personCount;               //< Number of persons in the room.
+  bool roomFull;                      //< If the room capacity was reached.
+  float temperature;                  //< Temperature at the door in °C.
+  TelemetryMode mode;                 //< The telemetry mode the record was taken in.
+};
+
+/**
+ * Collects telemetry records in a bounded buffer and decides when they are uploaded.
+ * A flush is due when the batch size is reached or the oldest record is older than the flush interval.
+ * The records are uploaded as one json array. If the buffer runs full, the oldest record is dropped.
+ */
+class TelemetryBatcher {
+  static_assert(TELEMETRY_BATCH_CAPACITY <= UINT8_MAX, "The records of a batch are counted in uint8_t.");
+
+  private:
+    TelemetryRecord records[TELEMETRY_BATCH_CAPACITY]; //< Ring buffer of the records.
+    uint8_t head = 0;                                  //< Index of the oldest record.
+    uint8_t count = 0;                                 //< Number of buffered records.
+    uint16_t batchSize = TELEMETRY_BATCH_SIZE_DEFAULT;         //< Number of records which trigger a flush.
+    uint16_t flushInterval = TELEMETRY_FLUSH_INTERVAL_DEFAULT; //< Age of the oldest record which triggers a flush in seconds.
+    uint32_t dropped = 0;                              //< Number of records dropped because the buffer was full.
+    uint32_t flushes = 0;                              //< Number of uploaded batches.
+    uint32_t stored = 0;                               //< Number of records moved to the telemetry log instead of uploaded.
+
+    /**
+     * Removes the oldest records.
+     * @param n The number of records.
+     */
+    void discard(uint8_t n);
+
+  public:
+    /**
+     * Adds a record. Drops the oldest record if the buffer is full.
+     * @param record The record.
+     */
+    void add(const TelemetryRecord& record);
+
+    /**
+     * Checks whether the buffered records should be uploaded.
+     * @param now The current time in milli seconds.
+     * @return
+     *  -true: If the batch size or the flush interval is reached.
+     *  -false: otherwise.
+     */
+    bool isDue(uint32_t now) const;
+
+    /**
+     * Serializes the buffered records into one array.
+     * @param room The name of the room, which is added to every record.
+     * @param format The wire format of the array.
+     * @param[out] out The serialized array.
+     * @return The number of serialized records.
+     */
+    uint8_t serialize(const char* room, WireFormat format, String& out) const;
+
+    /**
+     * Gives the number of buffered records.
+     * @return The number of records.
+     */
+    uint8_t getCount() const;
+
+    /**
+     * Gives a buffered record.
+     * @param i The position of the record. 0 is the oldest.
+     * @return The record.
+     */
+    const TelemetryRecord& getRecord(uint8_t i) const;
+
+    /**
+     * Removes the oldest records after they were uploaded.
+     * @param n The number of uploaded records.
+     */
+    void commit(uint8_t n);
+
+    /**
+     * Removes the oldest records after they were stored for a later upload.
+     * Not counted as uploaded batch.
+     * @param n The number of stored records.
+     */
+    void divert(uint8_t n);
+
+    /**
+     * Sets the number of records which trigger a flush.
+     * @param size The batch size. Between 1 and TELEMETRY_BATCH_CAPACITY.
+     * @return
+     *  -true: On success.
+     *  -false: If the size is out of bounds.
+     */
+    bool setBatchSize(uint16_t size);
+
+    /**
+     * Sets the age of the oldest record which triggers a flush.
+     * @param interval The flush interval in seconds. Between 1 and TELEMETRY_FLUSH_INTERVAL_MAX.
+     * @return
+     *  -true: On success.
+     *  -false: If the interval is out of bounds.
+     */
+    bool setFlushInterval(uint16_t interval);
+
+    /**
+     * Gives the number of records which trigger a flush.
+     * @return The batch size.
+     */
+    uint16_t getBatchSize() const;
+
+    /**
+     * Gives the age of the oldest record which triggers a flush.
+     * @return The flush interval in seconds.
+     */
+    uint16_t getFlushInterval() const;
+
+    /**
+     * Prints the buffer fill, the uploaded batches, the stored and the dropped records over serial.
+     */
+    void printStats() const;
+
+    /**
+     * Resets the counters of uploaded batches, stored and dropped records.
+     */
+    void resetStats();
+};
+
+//===========================================================
+// Function Declarations
+
+/**
+ * Adds a telemetry record as json object to a json array.
+ * @param batch The json array.
+ * @param room The name of the room.
+ * @param record The record.
+ * @return The added json object.
+ */
+JsonObject serializeTelemetryRecord(JsonArray batch, const char* room, const TelemetryRecord& record);
+
+/**
+ * Gives the name of a telemetry mode as used in the payload and the commands.
+ * @param mode The telemetry mode.
+ * @return The name.
+ */
+const char* telemetryModeName(TelemetryMode mode);
+
+/**
+ * Parses the name of a telemetry mode.
+ * @param name The name. Either "periodic" or "change".
+ * @param[out] mode The telemetry mode.
+ * @return
+ *  -true: On success.
+ *  -false: If the name is unknown.
+ */
+bool parseTelemetryMode(const String& name, TelemetryMode& mode);
+
+#include "telemetry_batcher_inline.h"
@@ -0,0 +1,53 @@
+//===========================================================
+// included dependencies
+#include "telemetry_batcher.h"
+
+//===========================================================
+// Inline member function implementations
+
+/**
+ * Checks whether the buffered records should be uploaded.
+ * @param now The current time in milli seconds.
+ * @return
+ *  -true: If the batch size or the flush interval is reached.
+ *  -false: otherwise.
+ */
+inline bool TelemetryBatcher::isDue(uint32_t now) const {
+  if(count == 0) {
+    return false;
+  }
+  return count >= batchSize || now - records[head].timestamp >= flushInterval * 1000UL;
+}
+
+/**
+ * Gives the number of buffered records.
+ * @return The number of records.
+ */
+inline uint8_t TelemetryBatcher::getCount() const {
+  return count;
+}
+
+/**
+ * Gives a buffered record.
+ * @param i The position of the record. 0 is the oldest.
+ * @return The record.
+ */
+inline const TelemetryRecord& TelemetryBatcher::getRecord(uint8_t i) const {
+  return records[(head + i) % TELEMETRY_BATCH_CAPACITY];
+}
+
+/**
+ * Gives the number of records which trigger a flush.
+ * @return The batch size.
+ */
+inline uint16_t TelemetryBatcher::getBatchSize() const {
+  return batchSize;
+}
+
+/**
+ * Gives the age of the oldest record which triggers a flush.
+ * @return The flush interval in seconds.
+ */
+inline uint16_t TelemetryBatcher::getFlushInterval() const {
+  return flushInterval;
+}
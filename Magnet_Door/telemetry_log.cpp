@@ -0,0 +1,446 @@
+/*************************************************************
+  The implementation of a log on flash to store telemetry records while offline and replay them later.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "telemetry_log.h"
+#include <LittleFS.h>
+#include <esp_rom_crc.h>
+#include <cstddef>
+#include <algorithm>
+
+//===========================================================
+// Definitions
+#define TELEMETRY_LOG_BOOT_FILE TELEMETRY_LOG_DIR "/boot"      //< File of the boot number.
+#define TELEMETRY_LOG_CURSOR_FILE TELEMETRY_LOG_DIR "/cursor"  //< File of the replay cursor.
+
+//===========================================================
+// Data Types
+
+/**
+ * The replay cursor as it is stored on flash.
+ */
+struct TelemetryLogCursor {
+  uint32_t segment;           //< Segment of the next record to replay.
+  uint32_t record;            //< Position of the next record to replay in its segment.
+  uint32_t crc;               //< CRC32 of the fields above.
+};
+
+//===========================================================
+// Member function implementations
+
+/**
+ * Starts the log task, which mounts the file system, if not done yet.
+ * @return
+ *  -true: On success.
+ *  -false: If the log task could not be started.
+ */
+bool TelemetryLog::begin() {
+  if(logTask) {
+    return true;
+  }
+  BaseType_t created = xTaskCreatePinnedToCore(
+      [](void* log) {
+        TelemetryLog* tlog = static_cast<TelemetryLog*>(log);
+        if(!tlog->mount()) {
+          Serial.println("Error: Failed to mount the telemetry log!");
+          vTaskDelete(nullptr);
+        }
+        tlog->mounted = true;
+        while(true) {
+          tlog->service();
+          vTaskDelay(pdMS_TO_TICKS(TELEMETRY_LOG_TASK_PERIOD));
+        }
+      },
+      "telemetry log",
+      TELEMETRY_LOG_TASK_STACK_SIZE,
+      this,
+      TELEMETRY_LOG_TASK_PRIORITY,
+      &logTask,
+      TELEMETRY_LOG_TASK_CORE);
+  if(created != pdPASS) {
+    logTask = nullptr;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Queues a record to be written to flash. Never blocks.
+ * @param record The record.
+ * @return
+ *  -true: On success.
+ *  -false: If the queue is full. The record is lost.
+ */
+bool TelemetryLog::append(const TelemetryRecord& record) {
+  TelemetryLogEntry entry = {};
+  entry.timestamp = record.timestamp;
+  entry.personCount = record.personCount;
+  entry.temperature = record.temperature;
+  entry.doorOpen = record.doorOpen;
+  entry.roomFull = record.roomFull;
+  entry.mode = static_cast<uint8_t>(record.mode);
+  if(record.event) {
+    strncpy(entry.event, record.event, TELEMETRY_LOG_EVENT_SIZE - 1);
+  }
+  if(!queue.push(entry)) {
+    dropped++;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Serializes the prepared replay batch into one array.
+ * Requests the next batch if none is prepared.
+ * Every record is marked as replayed and carries the boot number it was taken in.
+ * @param room The name of the room, which is added to every record.
+ * @param format The wire format of the array.
+ * @param[out] out The serialized array.
+ * @return The number of serialized records. 0 if no batch is prepared yet.
+ */
+uint8_t TelemetryLog::serializeReplay(const char* room, WireFormat format, String& out) {
+  if(!replayReady || replayAck) {
+    replayRequest = true;
+    return 0;
+  }
+  JsonDocument doc;
+  JsonArray batch = doc.to<JsonArray>();
+  uint8_t count = replayCount;
+  for(uint8_t i = 0; i < count; i++) {
+    const TelemetryLogEntry& entry = replayBatch[i];
+    TelemetryRecord record = {entry.timestamp,
+                              entry.event[0]? entry.event : nullptr,
+                              entry.doorOpen != 0,
+                              entry.personCount,
+                              entry.roomFull != 0,
+                              entry.temperature,
+                              static_cast<TelemetryMode>(entry.mode)};
+    JsonObject json = serializeTelemetryRecord(batch, room, record);
+    json["boot"] = entry.boot;
+    json["replayed"] = true;
+  }
+  serializeWireFormat(doc, format, out);
+  return count;
+}
+
+/**
+ * Confirms the upload of the replay batch. The records are removed from the log.
+ */
+void TelemetryLog::ackReplay() {
+  replayAck = true;
+}
+
+/**
+ * Mounts the file system and restores the state of the log from the files.
+ * @return
+ *  -true: On success.
+ *  -false: If the file system could not be mounted.
+ */
+bool TelemetryLog::mount() {
+  if(!LittleFS.begin(true)) { //Formats the partition if it holds no file system yet
+    return false;
+  }
+  if(!LittleFS.exists(TELEMETRY_LOG_DIR)) {
+    LittleFS.mkdir(TELEMETRY_LOG_DIR);
+  }
+
+  //Count the boots, so records of former boots can be told apart
+  File file = LittleFS.open(TELEMETRY_LOG_BOOT_FILE, "r");
+  if(file) {
+    file.read(reinterpret_cast<uint8_t*>(&boot), sizeof(boot));
+    file.close();
+  }
+  boot++;
+  file = LittleFS.open(TELEMETRY_LOG_BOOT_FILE, "w");
+  if(file) {
+    file.write(reinterpret_cast<const uint8_t*>(&boot), sizeof(boot));
+    file.close();
+  }
+
+  //Find the oldest and the newest segment
+  bool found = false;
+  uint32_t first = UINT32_MAX;
+  uint32_t last = 0;
+  File dir = LittleFS.open(TELEMETRY_LOG_DIR);
+  file = dir.openNextFile();
+  while(file) {
+    const char* name = file.name();
+    if(isdigit(name[0])) {
+      uint32_t segment = strtoul(name, nullptr, 10);
+      first = std::min(first, segment);
+      last = std::max(last, segment);
+      found = true;
+    }
+    file.close();
+    file = dir.openNextFile();
+  }
+  dir.close();
+  headSegment = found? first : 0;
+  //Appending starts with a new segment, so an entry torn by a power loss stays at the end of a closed one
+  tailSegment = found? last + 1 : 0;
+  tailRecords = 0;
+
+  //Restore the replay cursor
+  TelemetryLogCursor cursor = {};
+  file = LittleFS.open(TELEMETRY_LOG_CURSOR_FILE, "r");
+  if(file) {
+    file.read(reinterpret_cast<uint8_t*>(&cursor), sizeof(cursor));
+    file.close();
+  }
+  if(cursor.crc == esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&cursor), offsetof(TelemetryLogCursor, crc)) &&
+     cursor.segment >= headSegment && cursor.segment <= tailSegment) {
+    cursorSegment = cursor.segment;
+    cursorRecord = cursor.record;
+  }
+  else {
+    cursorSegment = headSegment;
+    cursorRecord = 0;
+  }
+
+  //Count the records which were not replayed yet
+  uint32_t records = 0;
+  for(uint32_t segment = cursorSegment; segment < tailSegment; segment++) {
+    file = LittleFS.open(segmentPath(segment), "r");
+    if(file) {
+      records += file.size() / sizeof(TelemetryLogEntry);
+      file.close();
+    }
+  }
+  depth = (records > cursorRecord)? records - cursorRecord : 0;
+  updateOldest();
+  return true;
+}
+
+/**
+ * Writes the queued records, advances the cursor after an uploaded batch
+ * and prepares the next replay batch. Called by the log task.
+ */
+void TelemetryLog::service() {
+  writeQueued();
+
+  if(replayAck) {
+    //The cursor may have been moved by a dropped segment in the meantime
+    if(cursorSegment == replayStartSegment && cursorRecord == replayStartRecord) {
+      while(headSegment < replayEndSegment) {
+        LittleFS.remove(segmentPath(headSegment)); //Replayed completely
+        headSegment++;
+      }
+      cursorSegment = replayEndSegment;
+      cursorRecord = replayEndRecord;
+      depth -= std::min<uint32_t>(depth, replayConsumed);
+      corrupted += replayConsumed - replayCount;
+      storeCursor();
+      updateOldest();
+    }
+    replayAck = false;
+    replayReady = false;
+  }
+
+  if(replayRequest && !replayReady && depth > 0) {
+    replayRequest = false;
+    replayStartSegment = cursorSegment;
+    replayStartRecord = cursorRecord;
+    replayCount = readAtCursor(replayBatch, TELEMETRY_REPLAY_BATCH, replayEndSegment, replayEndRecord, replayConsumed);
+    if(replayConsumed > 0) {
+      replayReady = true;
+      if(replayCount == 0) {
+        replayAck = true; //Only corrupted entries. Skip them with the next service.
+      }
+    }
+  }
+}
+
+/**
+ * Appends the queued records to the tail segment.
+ * A record which could not be written completely is dropped and the log goes on with a new segment,
+ * since the torn part would shift all following records of the segment.
+ */
+void TelemetryLog::writeQueued() {
+  if(queue.isEmpty()) {
+    return;
+  }
+  File file = LittleFS.open(segmentPath(tailSegment), "a");
+  if(!file) {
+    return; //Tries again with the next service
+  }
+  TelemetryLogEntry entry;
+  while(queue.pop(entry)) {
+    entry.boot = boot;
+    entry.crc = entryCrc(entry);
+    if(file.write(reinterpret_cast<const uint8_t*>(&entry), sizeof(entry)) != sizeof(entry)) {
+      dropped++; //Flash full
+      file.close();
+      nextSegment(); //Readers only see whole records, the torn rest is never read
+      return; //The rest waits for the next service
+    }
+    if(depth == 0) {
+      oldestTimestamp = entry.timestamp;
+      oldestBoot = entry.boot;
+    }
+    depth++;
+
+    if(++tailRecords >= TELEMETRY_LOG_SEGMENT_RECORDS) {
+      //Go on with the next segment
+      file.close();
+      nextSegment();
+      file = LittleFS.open(segmentPath(tailSegment), "a");
+      if(!file) {
+        return;
+      }
+    }
+  }
+  file.close();
+}
+
+/**
+ * Goes on with the next segment. Drops the oldest segment if the log is full.
+ */
+void TelemetryLog::nextSegment() {
+  tailSegment++;
+  tailRecords = 0;
+  if(tailSegment - headSegment >= TELEMETRY_LOG_SEGMENTS) {
+    dropHead();
+  }
+}
+
+/**
+ * Deletes the oldest segment to make room for a new one.
+ * Its records which were not replayed yet are lost.
+ */
+void TelemetryLog::dropHead() {
+  if(cursorSegment == headSegment) {
+    File file = LittleFS.open(segmentPath(headSegment), "r");
+    uint32_t records = file? file.size() / sizeof(TelemetryLogEntry) : 0;
+    if(file) {
+      file.close();
+    }
+    uint32_t lost = (records > cursorRecord)? records - cursorRecord : 0;
+    depth -= std::min<uint32_t>(depth, lost);
+    dropped += lost;
+    cursorSegment = headSegment + 1;
+    cursorRecord = 0;
+    storeCursor();
+  }
+  LittleFS.remove(segmentPath(headSegment));
+  headSegment++;
+  updateOldest();
+}
+
+/**
+ * Reads up to max valid entries starting at the cursor. Entries with a wrong CRC are skipped.
+ * Does not move the cursor.
+ * @param[out] entries The read entries.
+ * @param max Maximum number of entries.
+ * @param[out] endSegment Segment behind the last read entry.
+ * @param[out] endRecord Position behind the last read entry in its segment.
+ * @param[out] consumed Number of passed entries including the skipped ones.
+ * @return The number of read entries.
+ */
+uint8_t TelemetryLog::readAtCursor(TelemetryLogEntry* entries, uint8_t max,
+                                   uint32_t& endSegment, uint32_t& endRecord, uint32_t& consumed) {
+  uint8_t count = 0;
+  uint32_t segment = cursorSegment;
+  uint32_t record = cursorRecord;
+  consumed = 0;
+  while(count < max && segment <= tailSegment) {
+    File file = LittleFS.open(segmentPath(segment), "r");
+    uint32_t records = file? file.size() / sizeof(TelemetryLogEntry) : 0;
+    if(record < records && file.seek(record * sizeof(TelemetryLogEntry))) {
+      while(count < max && record < records) {
+        TelemetryLogEntry& entry = entries[count];
+        file.read(reinterpret_cast<uint8_t*>(&entry), sizeof(entry));
+        record++;
+        consumed++;
+        if(entry.crc == entryCrc(entry)) {
+          count++;
+        }
+      }
+    }
+    if(file) {
+      file.close();
+    }
+    if(record < records || segment == tailSegment) {
+      break; //Batch full or reached the end of the log
+    }
+    segment++; //Segment read completely
+    record = 0;
+  }
+  endSegment = segment;
+  endRecord = record;
+  return count;
+}
+
+/**
+ * Stores the cursor in the cursor file.
+ * LittleFS commits the file on close, so a power loss keeps either the old or the new cursor.
+ */
+void TelemetryLog::storeCursor() {
+  TelemetryLogCursor cursor = {cursorSegment, cursorRecord, 0};
+  cursor.crc = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&cursor), offsetof(TelemetryLogCursor, crc));
+  File file = LittleFS.open(TELEMETRY_LOG_CURSOR_FILE, "w");
+  if(file) {
+    file.write(reinterpret_cast<const uint8_t*>(&cursor), sizeof(cursor));
+    file.close();
+  }
+}
+
+/**
+ * Updates the cached time of the oldest record not replayed yet.
+ */
+void TelemetryLog::updateOldest() {
+  TelemetryLogEntry entry;
+  uint32_t endSegment, endRecord, consumed;
+  if(depth > 0 && readAtCursor(&entry, 1, endSegment, endRecord, consumed)) {
+    oldestTimestamp = entry.timestamp;
+    oldestBoot = entry.boot;
+  }
+}
+
+/**
+ * Gives the path of a segment file.
+ * @param segment The number of the segment.
+ * @return The path.
+ */
+String TelemetryLog::segmentPath(uint32_t segment) {
+  char path[24];
+  snprintf(path, sizeof(path), TELEMETRY_LOG_DIR "/%08lu", (unsigned long)segment);
+  return String(path);
+}
+
+/**
+ * Calculates the CRC of an entry.
+ * @param entry The entry.
+ * @return The CRC32 of all fields but the CRC itself.
+ */
+uint32_t TelemetryLog::entryCrc(const TelemetryLogEntry& entry) {
+  return esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&entry), offsetof(TelemetryLogEntry, crc));
+}
+
+/**
+ * Prints the depth of the log, the age of the oldest record and the lost records over serial.
+ */
+void TelemetryLog::printBacklog() const {
+  Serial.println("-----------Telemetry Backlog-----------");
+  if(!mounted) {
+    Serial.println(" >> The telemetry log is not available.");
+  }
+  else {
+    uint32_t records = getDepth();
+    Serial.printf(" >> Depth: %lu records\n", (unsigned long)records);
+    if(depth == 0) {
+      Serial.println(" >> Oldest record: none");
+    }
+    else if(oldestBoot == boot) {
+      Serial.printf(" >> Oldest record: %lu s old\n", (unsigned long)((millis() - oldestTimestamp) / 1000));
+    }
+    else {
+      Serial.printf(" >> Oldest record: from boot %u, %lu s after boot\n",
+                    (unsigned)oldestBoot.load(), (unsigned long)(oldestTimestamp / 1000));
+    }
+  }
+  Serial.printf(" >> Lost records: dropped %lu, corrupted %lu\n",
+                (unsigned long)dropped, (unsigned long)corrupted);
+  Serial.println("---------------------------------------");
+}
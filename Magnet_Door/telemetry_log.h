@@ -0,0 +1,204 @@
+#pragma once
+/*************************************************************
+  A log on flash to store telemetry records while offline and replay them later.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "spsc_ring.h"
+#include "telemetry_batcher.h"
+
+//===========================================================
+// Definitions
+#define TELEMETRY_LOG_DIR "/tlog"                //< Directory of the log files.
+#define TELEMETRY_LOG_SEGMENTS 32                //< Maximum number of segment files. The oldest is deleted when exceeded.
+#define TELEMETRY_LOG_SEGMENT_RECORDS 64         //< Number of records per segment file.
+#define TELEMETRY_LOG_QUEUE_SIZE 64              //< Number of records which can wait to be written. Has to be a power of two.
+#define TELEMETRY_LOG_EVENT_SIZE 16              //< Size of the stored event name including the terminator.
+#define TELEMETRY_REPLAY_BATCH 16                //< Maximum number of records per replayed batch.
+#define TELEMETRY_LOG_TASK_PERIOD 50             //< Period of the log task in milli seconds.
+#define TELEMETRY_LOG_TASK_PRIORITY 1            //< FreeRTOS priority of the log task. Same as the loop task.
+#define TELEMETRY_LOG_TASK_CORE 0                //< The core the log task is pinned to.
+#define TELEMETRY_LOG_TASK_STACK_SIZE 6144       //< Stack size of the log task in bytes.
+
+//===========================================================
+// Data Types
+
+/**
+ * A telemetry record as it is stored on flash.
+ */
+struct TelemetryLogEntry {
+  uint32_t timestamp;                           //< Time of the record in milli seconds since boot.
+  uint16_t boot;                                //< Number of the boot the record was taken in.
+  uint16_t personCount;                         //< Number of persons in the room.
+  float temperature;                            //< Temperature at the door in °C.
+  uint8_t doorOpen;                             //< If the door was open.
+  uint8_t roomFull;                             //< If the room capacity was reached.
+  uint8_t mode;                                 //< The telemetry mode the record was taken in.
+  uint8_t reserved;                             //< Unused. Zero.
+  char event[TELEMETRY_LOG_EVENT_SIZE];         //< Name of the event. Empty for a periodic sample.
+  uint32_t crc;                                 //< CRC32 of all fields above.
+};
+
+/**
+ * An append only ring log of telemetry records in LittleFS.
+ * The log is made of numbered segment files, which are only appended to and deleted as a whole,
+ * which keeps the writes evenly spread over the flash. If the log is full, the oldest segment is dropped.
+ * Every entry carries a CRC, so an entry torn by a power loss is detected and skipped.
+ * The replay position is kept in a small cursor file, which is rewritten after every replayed batch.
+ * A batch lost in between is replayed again after the reboot.
+ *
+ * All flash accesses are done by a background task. The owner only queues records with append()
+ * and picks up prepared replay batches, so it never waits for the flash.
+ * append(), serializeReplay() and ackReplay() are called by one task.
+ */
+class TelemetryLog {
+  static_assert(TELEMETRY_REPLAY_BATCH <= UINT8_MAX, "The records of a replay batch are counted in uint8_t.");
+
+  private:
+    SpscRing<TelemetryLogEntry, TELEMETRY_LOG_QUEUE_SIZE> queue;  //< Records waiting to be written.
+    TelemetryLogEntry replayBatch[TELEMETRY_REPLAY_BATCH];        //< The prepared replay batch.
+    std::atomic<uint8_t> replayCount{0};        //< Number of records in the replay batch.
+    std::atomic<bool> replayReady{false};       //< If the replay batch is prepared. Owned by the owner while set.
+    std::atomic<bool> replayRequest{false};     //< If a replay batch should be prepared.
+    std::atomic<bool> replayAck{false};         //< If the replay batch was uploaded.
+    std::atomic<bool> mounted{false};           //< If the file system is mounted.
+    std::atomic<uint32_t> depth{0};             //< Number of records not replayed yet.
+    std::atomic<uint32_t> oldestTimestamp{0};   //< Time of the oldest record not replayed yet.
+    std::atomic<uint16_t> oldestBoot{0};        //< Boot number of the oldest record not replayed yet.
+    std::atomic<uint32_t> dropped{0};           //< Number of records lost because the queue or the log was full.
+    std::atomic<uint32_t> corrupted{0};         //< Number of skipped entries with a wrong CRC.
+    uint16_t boot = 0;                          //< Number of the current boot.
+    uint32_t headSegment = 0;                   //< Number of the oldest segment.
+    uint32_t tailSegment = 0;                   //< Number of the segment which is appended to.
+    uint32_t tailRecords = 0;                   //< Number of records in the tail segment.
+    uint32_t cursorSegment = 0;                 //< Segment of the next record to replay.
+    uint32_t cursorRecord = 0;                  //< Position of the next record to replay in its segment.
+    uint32_t replayStartSegment = 0;            //< Cursor segment when the replay batch was prepared.
+    uint32_t replayStartRecord = 0;             //< Cursor position when the replay batch was prepared.
+    uint32_t replayEndSegment = 0;              //< Segment behind the replay batch.
+    uint32_t replayEndRecord = 0;               //< Position behind the replay batch in its segment.
+    uint32_t replayConsumed = 0;                //< Number of entries the replay batch passes, including corrupted ones.
+    TaskHandle_t logTask = nullptr;             //< Handle of the log task.
+
+    /**
+     * Mounts the file system and restores the state of the log from the files.
+     * @return
+     *  -true: On success.
+     *  -false: If the file system could not be mounted.
+     */
+    bool mount();
+
+    /**
+     * Writes the queued records, advances the cursor after an uploaded batch
+     * and prepares the next replay batch. Called by the log task.
+     */
+    void service();
+
+    /**
+     * Appends the queued records to the tail segment.
+     * A record which could not be written completely is dropped and the log goes on with a new segment,
+     * since the torn part would shift all following records of the segment.
+     */
+    void writeQueued();
+
+    /**
+     * Goes on with the next segment. Drops the oldest segment if the log is full.
+     */
+    void nextSegment();
+
+    /**
+     * Deletes the oldest segment to make room for a new one.
+     * Its records which were not replayed yet are lost.
+     */
+    void dropHead();
+
+    /**
+     * Reads up to max valid entries starting at the cursor. Entries with a wrong CRC are skipped.
+     * Does not move the cursor.
+     * @param[out] entries The read entries.
+     * @param max Maximum number of entries.
+     * @param[out] endSegment Segment behind the last read entry.
+     * @param[out] endRecord Position behind the last read entry in its segment.
+     * @param[out] consumed Number of passed entries including the skipped ones.
+     * @return The number of read entries.
+     */
+    uint8_t readAtCursor(TelemetryLogEntry* entries, uint8_t max,
+                         uint32_t& endSegment, uint32_t& endRecord, uint32_t& consumed);
+
+    /**
+     * Stores the cursor in the cursor file.
+     * LittleFS commits the file on close, so a power loss keeps either the old or the new cursor.
+     */
+    void storeCursor();
+
+    /**
+     * Updates the cached time of the oldest record not replayed yet.
+     */
+    void updateOldest();
+
+    /**
+     * Gives the path of a segment file.
+     * @param segment The number of the segment.
+     * @return The path.
+     */
+    static String segmentPath(uint32_t segment);
+
+    /**
+     * Calculates the CRC of an entry.
+     * @param entry The entry.
+     * @return The CRC32 of all fields but the CRC itself.
+     */
+    static uint32_t entryCrc(const TelemetryLogEntry& entry);
+
+  public:
+    /**
+     * Starts the log task, which mounts the file system, if not done yet.
+     * @return
+     *  -true: On success.
+     *  -false: If the log task could not be started.
+     */
+    bool begin();
+
+    /**
+     * Queues a record to be written to flash. Never blocks.
+     * @param record The record.
+     * @return
+     *  -true: On success.
+     *  -false: If the queue is full. The record is lost.
+     */
+    bool append(const TelemetryRecord& record);
+
+    /**
+     * Serializes the prepared replay batch into one array.
+     * Requests the next batch if none is prepared.
+     * Every record is marked as replayed and carries the boot number it was taken in.
+     * @param room The name of the room, which is added to every record.
+     * @param format The wire format of the array.
+     * @param[out] out The serialized array.
+     * @return The number of serialized records. 0 if no batch is prepared yet.
+     */
+    uint8_t serializeReplay(const char* room, WireFormat format, String& out);
+
+    /**
+     * Confirms the upload of the replay batch. The records are removed from the log.
+     */
+    void ackReplay();
+
+    /**
+     * Gives the number of records not replayed yet.
+     * @return The number of records.
+     */
+    uint32_t getDepth() const;
+
+    /**
+     * Prints the depth of the log, the age of the oldest record and the lost records over serial.
+     */
+    void printBacklog() const;
+};
+
+#include "telemetry_log_inline.h"
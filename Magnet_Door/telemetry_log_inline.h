@@ -0,0 +1,14 @@
+//===========================================================
+// included dependencies
+#include "telemetry_log.h"
+
+//===========================================================
+// Inline member function implementations
+
+/**
+ * Gives the number of records not replayed yet.
+ * @return The number of records.
+ */
+inline uint32_t TelemetryLog::getDepth() const {
+  return depth + queue.size();
+}
@@ -0,0 +1,314 @@
+/*************************************************************
+  The implementation of a keep-alive HTTP or HTTPS session to post telemetry to the web server.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "telemetry_session.h"
+#include "endpoint_set.h"
+
+//===========================================================
+// TLS definitions
+#define HTTPS_ROOT_CA ""                  //< PEM of the root CA the HTTPS server certificate is verified against. Empty refuses all HTTPS posts.
+
+//===========================================================
+// Member function implementations
+
+/**
+ * Constructs a TelemetrySession without url.
+ */
+TelemetrySession::TelemetrySession(): rootCA(HTTPS_ROOT_CA) {
+  secureClient.setCACert(rootCA);
+  http.setReuse(true); //Asks the server to keep the connection alive
+  http.setConnectTimeout(connectTimeout);
+  http.setTimeout(readTimeout);
+}
+
+/**
+ * Sets the url the data is posted to. Closes the connection to a former url.
+ * The TLS session is kept if the host and the port stay the same.
+ * @param url The url.
+ */
+void TelemetrySession::setUrl(const String& url) {
+  if(url == this->url) {
+    return;
+  }
+  close();
+  this->url = url;
+  secure = url.startsWith("https");
+  String newHost;
+  uint16_t newPort;
+  parseServerAddress(url, newHost, newPort);
+  if(newHost != host || newPort != port) {
+    secureClient.forgetSession(); //Only the server which issued it can resume it
+    host = newHost;
+    port = newPort;
+  }
+  if(secure && rootCA[0] == '\0') {
+    Serial.println(" >> Error: No root CA set, HTTPS posts are refused!");
+  }
+}
+
+/**
+ * Sets the root CA the certificate of a HTTPS web server is verified against. Defaults to HTTPS_ROOT_CA.
+ * Closes the connection and forgets the TLS session.
+ * @param rootCA The PEM of the root CA. Has to stay valid. Empty refuses all HTTPS posts.
+ */
+void TelemetrySession::setRootCA(const char* rootCA) {
+  close();
+  this->rootCA = rootCA;
+  secureClient.setCACert(rootCA); //Forgets the TLS session, it was verified against the former root CA
+}
+
+/**
+ * Sets the time a post may take. Half of it is given to the TCP connect, the rest to the response.
+ * The TLS handshake gets the connect time as well, rounded up to full seconds.
+ * @param deadline The deadline in milli seconds.
+ */
+void TelemetrySession::setDeadline(uint16_t deadline) {
+  connectTimeout = deadline / 2;
+  readTimeout = deadline - connectTimeout;
+  http.setConnectTimeout(connectTimeout);
+  http.setTimeout(readTimeout);
+  secureClient.setHandshakeTimeout((connectTimeout + 999) / 1000);
+}
+
+/**
+ * Gives the connection to the web server of the url.
+ * @return The plain or the TLS connection.
+ */
+WiFiClient& TelemetrySession::link() {
+  if(secure) {
+    return secureClient;
+  }
+  return client;
+}
+
+/**
+ * Opens a new connection to the web server and does the TLS handshake for a HTTPS url.
+ * @return
+ *  -true: On success.
+ *  -false: If the server could not be reached or the handshake failed.
+ */
+bool TelemetrySession::open() {
+  uint32_t start = micros();
+  //Connects the concrete client, the one with timeout is not virtual
+  bool opened = secure? secureClient.connect(host.c_str(), port, connectTimeout) :
+                        client.connect(host.c_str(), port, connectTimeout);
+  if(!opened) {
+    return false;
+  }
+  lastOpen = micros() - start;
+  if(lastOpen > maxOpen) {
+    maxOpen = lastOpen;
+  }
+  sumOpen += lastOpen;
+  connections++;
+  if(secure && secureClient.isResumed()) {
+    resumptions++;
+    sumResumedOpen += lastOpen;
+  }
+  return true;
+}
+
+/**
+ * Posts data and reads the complete response.
+ * Uses the kept connection if there is one, otherwise opens a new one.
+ * @param data The data. May be binary.
+ * @param contentType The content type of the data.
+ * @param[out] response The response body. Not stored if nullptr.
+ * @return The HTTP status code, a negative HTTPClient error code or HTTP_ERROR_NO_ROOT_CA.
+ */
+int TelemetrySession::post(const String& data, const char* contentType, String* response) {
+  if(secure && rootCA[0] == '\0') {
+    failures++; //Never send the data to a server which can't be verified
+    return HTTP_ERROR_NO_ROOT_CA;
+  }
+  int code = HTTPC_ERROR_CONNECTION_REFUSED;
+  uint32_t postStart = millis();
+  http.setTimeout(readTimeout);
+  for(uint8_t attempt = 0; attempt < 2; attempt++) {
+    bool reused = link().connected();
+    if(attempt > 0) {
+      //The repeated request opens a new connection and only gets what is left of the deadline
+      uint32_t elapsed = millis() - postStart;
+      if(elapsed + HTTP_RETRY_MIN_TIMEOUT > readTimeout) {
+        break;
+      }
+      http.setTimeout(readTimeout - elapsed);
+      retries++;
+    }
+    uint32_t start = micros();
+    //HTTPClient uses an already connected client as is, so the handshake is only done on a new connection
+    if(!reused && !open()) {
+      code = HTTPC_ERROR_CONNECTION_REFUSED;
+      break;
+    }
+    http.begin(link(), url);
+    http.addHeader("Content-Type", contentType);
+    code = http.POST(data);
+    if(code > 0) {
+      //Drain the response, otherwise the connection can't be used for the next request
+      String body = http.getString();
+      http.end(); //Keeps the connection open if the server agreed to
+      recordRoundTrip(micros() - start);
+      if(response) {
+        *response = body;
+      }
+      if(code < 200 || code >= 300) {
+        failures++; //The server refused the data
+      }
+      return code;
+    }
+    http.end();
+    link().stop();
+    if(!reused) {
+      break; //A new connection failed, trying again won't help
+    }
+    //Once the request was written completely the server may have processed it, so it is not sent twice
+    if(code != HTTPC_ERROR_SEND_HEADER_FAILED && code != HTTPC_ERROR_SEND_PAYLOAD_FAILED) {
+      break;
+    }
+    //The server closed the kept connection before the request was written
+  }
+  failures++;
+  return code;
+}
+
+/**
+ * Closes the kept connection.
+ */
+void TelemetrySession::close() {
+  http.end();
+  client.stop();
+  secureClient.stop();
+}
+
+/**
+ * Gives the name of the transport.
+ * @return The name.
+ */
+const char* TelemetrySession::getName() const {
+  return secure? "https" : "http";
+}
+
+/**
+ * Does nothing. The connection is opened by the first request.
+ * @return
+ *  -true: Always.
+ */
+bool TelemetrySession::connect() {
+  return true;
+}
+
+/**
+ * Posts data to the url.
+ * @param topic Unused. The url says what the data is.
+ * @param payload The data. May be binary.
+ * @param contentType The content type of the data.
+ * @return
+ *  -true: If the server accepted the data with a 2xx status.
+ *  -false: otherwise.
+ */
+bool TelemetrySession::publish(const char* topic, const String& payload, const char* contentType) {
+  (void)topic;
+  lastCode = post(payload, contentType);
+  return lastCode >= 200 && lastCode < 300;
+}
+
+/**
+ * Does nothing. HTTP has no traffic between the requests.
+ */
+void TelemetrySession::poll() {
+}
+
+/**
+ * Checks whether the transport can publish.
+ * HTTP needs no session, the reachability of the web server is probed by the health monitor.
+ * @return
+ *  -true: Always.
+ */
+bool TelemetrySession::isConnected() {
+  return true;
+}
+
+/**
+ * Closes the kept connection.
+ */
+void TelemetrySession::disconnect() {
+  close();
+}
+
+/**
+ * Gives the HTTP status code or the error of the last request.
+ * @return The description.
+ */
+String TelemetrySession::getLastResult() const {
+  if(lastCode > 0) {
+    return "HTTP " + String(lastCode);
+  }
+  if(lastCode == HTTP_ERROR_NO_ROOT_CA) {
+    return "no root CA";
+  }
+  return HTTPClient::errorToString(lastCode);
+}
+
+/**
+ * Records the round trip time of a successful request.
+ * @param roundTrip The round trip time in micro seconds.
+ */
+void TelemetrySession::recordRoundTrip(uint32_t roundTrip) {
+  lastRoundTrip = roundTrip;
+  if(roundTrip < minRoundTrip) {
+    minRoundTrip = roundTrip;
+  }
+  if(roundTrip > maxRoundTrip) {
+    maxRoundTrip = roundTrip;
+  }
+  sumRoundTrip += roundTrip;
+  requests++;
+}
+
+/**
+ * Prints the request counters, round trip times and the times to open a connection over serial.
+ * For HTTPS the resumed TLS sessions are shown as well.
+ */
+void TelemetrySession::printStats() const {
+  Serial.printf(" >> Telemetry requests: %lu, failed %lu, connections %lu, retries %lu\n",
+                (unsigned long)requests, (unsigned long)failures,
+                (unsigned long)connections, (unsigned long)retries);
+  if(requests) {
+    Serial.printf(" >> Telemetry round trip (last/min/avg/max): %lu/%lu/%lu/%lu us\n",
+                  (unsigned long)lastRoundTrip, (unsigned long)minRoundTrip,
+                  (unsigned long)(sumRoundTrip / requests), (unsigned long)maxRoundTrip);
+  }
+  if(connections) {
+    Serial.printf(" >> Telemetry %s connect (last/avg/max): %lu/%lu/%lu us\n", secure? "TLS" : "TCP",
+                  (unsigned long)lastOpen, (unsigned long)(sumOpen / connections), (unsigned long)maxOpen);
+  }
+  if(secure && connections) {
+    Serial.printf(" >> Telemetry TLS sessions resumed %lu of %lu, avg %lu us full, %lu us resumed\n",
+                  (unsigned long)resumptions, (unsigned long)connections,
+                  (unsigned long)(connections > resumptions? (sumOpen - sumResumedOpen) / (connections - resumptions) : 0),
+                  (unsigned long)(resumptions? sumResumedOpen / resumptions : 0));
+  }
+}
+
+/**
+ * Resets the request counters, round trip times and the times to open a connection.
+ */
+void TelemetrySession::resetStats() {
+  lastRoundTrip = 0;
+  minRoundTrip = UINT32_MAX;
+  maxRoundTrip = 0;
+  sumRoundTrip = 0;
+  requests = 0;
+  connections = 0;
+  lastOpen = 0;
+  maxOpen = 0;
+  sumOpen = 0;
+  resumptions = 0;
+  sumResumedOpen = 0;
+  retries = 0;
+  failures = 0;
+}
@@ -0,0 +1,197 @@
+#pragma once
+/*************************************************************
+  A keep-alive HTTP or HTTPS session to post telemetry to the web server.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include <WiFiClient.h>
+#include <HTTPClient.h>
+#include "resumable_tls_client.h"
+#include "transport.h"
+
+//===========================================================
+// Definitions
+#define HTTP_CONNECT_TIMEOUT_DEFAULT 5000 //< Timeout of the TCP connect until a deadline is set in milli seconds.
+#define HTTP_READ_TIMEOUT_DEFAULT 5000    //< Timeout for the response until a deadline is set in milli seconds.
+#define HTTP_RETRY_MIN_TIMEOUT 100        //< Least time left for the response which is worth sending a request again in milli seconds.
+#define HTTP_ERROR_NO_ROOT_CA (-100)      //< Error code of a HTTPS post without root CA to verify the server against.
+
+//===========================================================
+// Data Types
+
+/**
+ * The HTTP transport.
+ * Posts data to the web server over one HTTP/1.1 connection which is kept alive between the requests.
+ * An "https://" url uses a TLS connection. It is kept alive the same way, so the expensive
+ * handshake is only done when a new connection is opened. A new connection resumes the TLS
+ * session of the former one if the server agrees, which saves most of the handshake.
+ * The time to open a connection, including the handshake, is recorded.
+ * The certificate of the server is verified against the root CA. Without root CA every HTTPS post fails.
+ * Every response is read completely, so the connection stays usable for the next request.
+ * If a kept connection turns out to be closed by the server while the request is written,
+ * the request is sent once more over a new connection. A request which was written completely
+ * is never sent twice, since the server may have processed it already.
+ * Only a 2xx status counts as success.
+ * The HTTP client waits for each response, so consecutive posts follow each other on the
+ * same connection but are not pipelined.
+ * A post including the repeated request never takes much longer than the deadline.
+ */
+class TelemetrySession: public Transport {
+  private:
+    WiFiClient client;                  //< The TCP connection to a HTTP web server.
+    ResumableTlsClient secureClient;    //< The TLS connection to a HTTPS web server.
+    HTTPClient http;                    //< The HTTP client using the connection.
+    String url = "";                    //< Url the data is posted to.
+    String host = "";                   //< Host of the url.
+    uint16_t port = 80;                 //< Port of the url.
+    bool secure = false;                //< If the url is a HTTPS one.
+    const char* rootCA;                 //< PEM of the root CA the certificate of the HTTPS web server is verified against.
+    uint32_t lastRoundTrip = 0;         //< Round trip time of the last successful request in micro seconds.
+    uint32_t minRoundTrip = UINT32_MAX; //< Lowest round trip time in micro seconds.
+    uint32_t maxRoundTrip = 0;          //< Highest round trip time in micro seconds.
+    uint64_t sumRoundTrip = 0;          //< Sum of all round trip times in micro seconds.
+    uint32_t requests = 0;              //< Number of requests the server answered.
+    uint32_t connections = 0;           //< Number of opened connections.
+    uint32_t lastOpen = 0;              //< Time to open the last connection including the TLS handshake in micro seconds.
+    uint32_t maxOpen = 0;               //< Highest time to open a connection in micro seconds.
+    uint64_t sumOpen = 0;               //< Sum of all times to open a connection in micro seconds.
+    uint32_t resumptions = 0;           //< Number of opened connections which resumed the TLS session.
+    uint64_t sumResumedOpen = 0;        //< Sum of the times to open a connection which resumed the TLS session in micro seconds.
+    uint32_t retries = 0;               //< Number of requests sent again after a kept connection was closed.
+    uint32_t failures = 0;              //< Number of failed or refused requests.
+    int lastCode = 0;                   //< HTTP status code or HTTPClient error code of the last request.
+    uint16_t connectTimeout = HTTP_CONNECT_TIMEOUT_DEFAULT; //< Timeout of the TCP connect in milli seconds.
+    uint16_t readTimeout = HTTP_READ_TIMEOUT_DEFAULT;       //< Timeout for the response in milli seconds.
+
+    /**
+     * Records the round trip time of a successful request.
+     * @param roundTrip The round trip time in micro seconds.
+     */
+    void recordRoundTrip(uint32_t roundTrip);
+
+    /**
+     * Gives the connection to the web server of the url.
+     * @return The plain or the TLS connection.
+     */
+    WiFiClient& link();
+
+    /**
+     * Opens a new connection to the web server and does the TLS handshake for a HTTPS url.
+     * @return
+     *  -true: On success.
+     *  -false: If the server could not be reached or the handshake failed.
+     */
+    bool open();
+
+  public:
+    /**
+     * Constructs a TelemetrySession without url.
+     */
+    TelemetrySession();
+
+    /**
+     * Sets the url the data is posted to. Closes the connection to a former url.
+     * The TLS session is kept if the host and the port stay the same.
+     * @param url The url.
+     */
+    void setUrl(const String& url);
+
+    /**
+     * Sets the root CA the certificate of a HTTPS web server is verified against. Defaults to HTTPS_ROOT_CA.
+     * Closes the connection and forgets the TLS session.
+     * @param rootCA The PEM of the root CA. Has to stay valid. Empty refuses all HTTPS posts.
+     */
+    void setRootCA(const char* rootCA);
+
+    /**
+     * Sets the time a post may take. Half of it is given to the TCP connect, the rest to the response.
+     * The TLS handshake gets the connect time as well, rounded up to full seconds.
+     * @param deadline The deadline in milli seconds.
+     */
+    void setDeadline(uint16_t deadline);
+
+    /**
+     * Posts data and reads the complete response.
+     * Uses the kept connection if there is one, otherwise opens a new one.
+     * @param data The data. May be binary.
+     * @param contentType The content type of the data.
+     * @param[out] response The response body. Not stored if nullptr.
+     * @return The HTTP status code, a negative HTTPClient error code or HTTP_ERROR_NO_ROOT_CA.
+     */
+    int post(const String& data, const char* contentType, String* response = nullptr);
+
+    /**
+     * Closes the kept connection.
+     */
+    void close();
+
+    /**
+     * Gives the name of the transport.
+     * @return The name.
+     */
+    const char* getName() const override;
+
+    /**
+     * Does nothing. The connection is opened by the first request.
+     * @return
+     *  -true: Always.
+     */
+    bool connect() override;
+
+    /**
+     * Posts data to the url.
+     * @param topic Unused. The url says what the data is.
+     * @param payload The data. May be binary.
+     * @param contentType The content type of the data.
+     * @return
+     *  -true: If the server accepted the data with a 2xx status.
+     *  -false: otherwise.
+     */
+    bool publish(const char* topic, const String& payload, const char* contentType) override;
+
+    /**
+     * Does nothing. HTTP has no traffic between the requests.
+     */
+    void poll() override;
+
+    /**
+     * Checks whether the transport can publish.
+     * HTTP needs no session, the reachability of the web server is probed by the health monitor.
+     * @return
+     *  -true: Always.
+     */
+    bool isConnected() override;
+
+    /**
+     * Closes the kept connection.
+     */
+    void disconnect() override;
+
+    /**
+     * Gives the HTTP status code or the error of the last request.
+     * @return The description.
+     */
+    String getLastResult() const override;
+
+    /**
+     * Gives the round trip time of the last successful request.
+     * That is the time from sending the request until the response is read completely.
+     * @return The round trip time in micro seconds.
+     */
+    uint32_t getLastRoundTrip() const;
+
+    /**
+     * Prints the request counters, round trip times and the times to open a connection over serial.
+     * For HTTPS the resumed TLS sessions are shown as well.
+     */
+    void printStats() const override;
+
+    /**
+     * Resets the request counters, round trip times and the times to open a connection.
+     */
+    void resetStats() override;
+};
+
+#include "telemetry_session_inline.h"
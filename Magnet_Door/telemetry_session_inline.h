@@ -0,0 +1,15 @@
+//===========================================================
+// included dependencies
+#include "telemetry_session.h"
+
+//===========================================================
+// Inline member function implementations
+
+/**
+ * Gives the round trip time of the last successful request.
+ * That is the time from sending the request until the response is read completely.
+ * @return The round trip time in micro seconds.
+ */
+inline uint32_t TelemetrySession::getLastRoundTrip() const {
+  return lastRoundTrip;
+}
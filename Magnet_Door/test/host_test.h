@@ -0,0 +1,34 @@
+#pragma once
+/*************************************************************
+  A minimal check macro for the host tests.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include <cstdio>
+
+//===========================================================
+// Static data
+
+static int failedChecks = 0;    //< Number of failed checks of the test.
+
+//===========================================================
+// Definitions
+
+/**
+ * Checks a condition and prints its location if it does not hold.
+ * The test keeps running, so all failed checks are reported.
+ */
+#define CHECK(condition) \
+  do { \
+    if(!(condition)) { \
+      std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      failedChecks++; \
+    } \
+  } while(false)
+
+/**
+ * Ends a test. Prints the result and gives the exit code.
+ */
+#define TEST_RESULT() \
+  (std::printf("%s: %d failed checks\n", __FILE__, failedChecks), failedChecks? 1 : 0)
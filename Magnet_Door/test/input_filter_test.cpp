@@ -0,0 +1,144 @@
+/*************************************************************
+  Host test of the input filter.
+  Feeds raw samples and level changes with made up timestamps
+  into the integrating and the stable time mode.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "host_test.h"
+#include "input_filter.h"
+#include "Arduino.h"
+
+//===========================================================
+// Definitions
+#define TEST_SAMPLES 4            //< Samples the integrating filter needs to change its level.
+#define TEST_STABLE_TIME 2000     //< Debounce time of the stable time filter in micro seconds.
+#define TEST_SAMPLE_PERIOD 1000   //< Time between two samples in micro seconds.
+#define TEST_PIN 5                //< The pin of the tested digital input.
+
+//===========================================================
+// Static function implementations
+
+/**
+ * Checks that bouncing raw levels do not change the stable level in both modes.
+ */
+static void testBounceRejection() {
+  InputEdge edge;
+
+  //Integrating: alternating samples never saturate the count
+  InputFilter integrating({DebounceMode::integrating, TEST_SAMPLES, TEST_SAMPLE_PERIOD}, false);
+  uint32_t now = 0;
+  for(uint8_t i = 0; i < 20; i++) {
+    CHECK(!integrating.sample(i % 2 == 0, now, edge));
+    now += TEST_SAMPLE_PERIOD;
+  }
+  CHECK(!integrating.getLevel());
+
+  //Stable time: every change restarts the debounce time
+  InputFilter stable({DebounceMode::stableTime, TEST_STABLE_TIME, 0}, false);
+  CHECK(!stable.sample(true, 0, edge));
+  CHECK(!stable.sample(false, 1500, edge)); //Back to the stable level before the time is over
+  CHECK(!stable.poll(2500, edge));
+  CHECK(!stable.sample(true, 3000, edge));
+  CHECK(!stable.poll(4999, edge));
+  CHECK(!stable.getLevel());
+  CHECK(stable.poll(5000, edge));
+  CHECK(edge.level && edge.timestamp == 3000);
+}
+
+/**
+ * Checks the edge of the stable time mode at the end of the debounce time,
+ * its timestamp, a change reported by the next sample and a wrapping clock.
+ */
+static void testStableTimeEdge() {
+  InputEdge edge;
+  InputFilter filter({DebounceMode::stableTime, TEST_STABLE_TIME, 0}, false);
+  CHECK(!filter.poll(100000, edge)); //No change, no edge
+
+  CHECK(!filter.sample(true, 1000, edge));
+  CHECK(!filter.poll(1000 + TEST_STABLE_TIME - 1, edge));
+  CHECK(filter.poll(1000 + TEST_STABLE_TIME, edge));
+  CHECK(edge.level && edge.timestamp == 1000); //Delayed edge, but not its timestamp
+  CHECK(!filter.poll(1000 + TEST_STABLE_TIME + 1, edge)); //Reported once
+
+  //The next change first reports the level which became stable before it
+  CHECK(!filter.sample(false, 10000, edge));
+  CHECK(filter.sample(true, 13000, edge));
+  CHECK(!edge.level && edge.timestamp == 10000);
+  CHECK(filter.poll(15000, edge));
+  CHECK(edge.level && edge.timestamp == 13000);
+
+  //A sample stamped before the last change is not taken as stable
+  CHECK(!filter.sample(false, 20000, edge));
+  CHECK(!filter.poll(19000, edge));
+
+  //The micro second clock wraps after about 71 minutes
+  InputFilter wrapping({DebounceMode::stableTime, TEST_STABLE_TIME, 0}, true);
+  uint32_t start = UINT32_MAX - 500;
+  CHECK(!wrapping.sample(false, start, edge));
+  CHECK(!wrapping.poll(start + TEST_STABLE_TIME - 1, edge));
+  CHECK(wrapping.poll(start + TEST_STABLE_TIME, edge));
+  CHECK(!edge.level && edge.timestamp == start);
+}
+
+/**
+ * Checks that the mode decides between counting samples and measuring time
+ * and that reset() and the digital input follow the configured mode.
+ */
+static void testModeSwitch() {
+  InputEdge edge;
+  InputFilter integrating({DebounceMode::integrating, TEST_SAMPLES, TEST_SAMPLE_PERIOD}, false);
+  InputFilter stable({DebounceMode::stableTime, TEST_SAMPLES, TEST_SAMPLE_PERIOD}, false);
+
+  //The same threshold counts samples in one mode and micro seconds in the other
+  uint32_t now = 0;
+  for(uint8_t i = 1; i < TEST_SAMPLES; i++) {
+    CHECK(!integrating.sample(true, now, edge));
+    now++;
+  }
+  CHECK(integrating.sample(true, now, edge));
+  CHECK(edge.level && edge.timestamp == 0);
+  CHECK(!stable.sample(true, 0, edge));
+  CHECK(!stable.sample(true, TEST_SAMPLES - 1, edge));
+  CHECK(stable.sample(true, TEST_SAMPLES, edge));
+  CHECK(edge.level && edge.timestamp == 0);
+
+  //Integrating only changes by samples, polling does nothing
+  CHECK(!integrating.sample(false, 100, edge));
+  CHECK(!integrating.poll(1000000, edge));
+  CHECK(integrating.getLevel());
+
+  //The timestamp is the time of the first sample which left the stable level
+  for(uint8_t i = 1; i < TEST_SAMPLES - 1; i++) {
+    CHECK(!integrating.sample(false, 100 + i, edge));
+  }
+  CHECK(integrating.sample(false, 100 + TEST_SAMPLES - 1, edge));
+  CHECK(!edge.level && edge.timestamp == 100);
+
+  //reset() sets the level without an edge in both modes
+  integrating.reset(true);
+  stable.reset(false);
+  CHECK(integrating.getLevel() && !stable.getLevel());
+  CHECK(!integrating.sample(true, 200, edge));
+  CHECK(!stable.poll(1000000, edge));
+
+  //A digital input feeds its pin into the filter
+  hostPinLevels[TEST_PIN] = LOW;
+  DigitalInput input(TEST_PIN, {DebounceMode::integrating, 1, 0});
+  CHECK(!input.getLevel());
+  CHECK(!input.update(edge));
+  hostPinLevels[TEST_PIN] = HIGH;
+  CHECK(input.update(edge));
+  CHECK(edge.level && input.getLevel());
+}
+
+//===========================================================
+// Function implementations
+
+int main() {
+  testBounceRejection();
+  testStableTimeEdge();
+  testModeSwitch();
+  return TEST_RESULT();
+}
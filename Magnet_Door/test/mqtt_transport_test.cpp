@@ -0,0 +1,423 @@
+/*************************************************************
+  Host test of the MQTT transport.
+  Publishes to a minimal broker on the loopback interface, which
+  accepts every session, answers pings and acknowledges QoS 1
+  messages, unless it is told to miss some acknowledgements.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "host_test.h"
+#include "mqtt_transport.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//===========================================================
+// Definitions
+#define TEST_DEADLINE 200                 //< Deadline of the transport in the tests in milli seconds.
+#define TEST_WAIT 3000                    //< Longest wait for the transport in milli seconds.
+
+//===========================================================
+// Data Types
+
+/**
+ * A message as the broker received it.
+ */
+struct ReceivedMessage {
+  bool dup;           //< If the DUP flag was set.
+  uint8_t qos;        //< The quality of service.
+  uint16_t packetId;  //< The packet id. 0 with QoS 0.
+  std::string topic;  //< The topic.
+  std::string payload; //< The payload.
+};
+
+/**
+ * A broker which serves one session at a time on an ephemeral port.
+ */
+class TestBroker {
+  int listener = -1;
+  int session = -1;
+  uint16_t port = 0;
+  std::thread thread;
+  std::atomic<bool> stopping{false};
+  std::mutex lock;
+  std::vector<ReceivedMessage> messages;
+
+  /**
+   * Reads bytes of the session. Gives up once the broker stops.
+   */
+  bool readExact(uint8_t* data, size_t length) {
+    size_t count = 0;
+    while(count < length) {
+      pollfd waiting = {session, POLLIN, 0};
+      if(stopping) {
+        return false;
+      }
+      if(::poll(&waiting, 1, 20) != 1) {
+        continue;
+      }
+      ssize_t result = recv(session, data + count, length - count, 0);
+      if(result <= 0) {
+        return false;
+      }
+      count += result;
+    }
+    return true;
+  }
+
+  /**
+   * Writes bytes to the session.
+   */
+  void writeAll(const uint8_t* data, size_t length) {
+    send(session, data, length, MSG_NOSIGNAL);
+  }
+
+  /**
+   * Serves a session until the client or the broker ends it.
+   */
+  void serve() {
+    while(true) {
+      uint8_t header;
+      if(!readExact(&header, 1)) {
+        return;
+      }
+      uint32_t length = 0;
+      uint8_t shift = 0;
+      uint8_t digit;
+      do {
+        if(!readExact(&digit, 1)) {
+          return;
+        }
+        length |= uint32_t(digit & 0x7F) << shift;
+        shift += 7;
+      } while(digit & 0x80);
+      std::vector<uint8_t> body(length);
+      if(length && !readExact(body.data(), length)) {
+        return;
+      }
+
+      switch(header & 0xF0) {
+        case 0x10: { //CONNECT
+          const uint8_t connack[] = {0x20, 0x02, 0x00, 0x00};
+          writeAll(connack, sizeof(connack));
+          break;
+        }
+        case 0x30: { //PUBLISH
+          ReceivedMessage message;
+          message.dup = header & 0x08;
+          message.qos = (header >> 1) & 0x03;
+          size_t topicLength = body[0] << 8 | body[1];
+          message.topic.assign(reinterpret_cast<const char*>(&body[2]), topicLength);
+          size_t position = 2 + topicLength;
+          message.packetId = 0;
+          if(message.qos) {
+            message.packetId = body[position] << 8 | body[position + 1];
+            position += 2;
+          }
+          message.payload.assign(reinterpret_cast<const char*>(body.data()) + position, length - position);
+          {
+            std::lock_guard<std::mutex> guard(lock);
+            messages.push_back(message);
+          }
+          if(closeOnPublish) {
+            closeOnPublish = false;
+            return;
+          }
+          if(message.qos == 0) {
+            break;
+          }
+          if(missedAcks > 0) {
+            missedAcks--;
+            break;
+          }
+          const uint8_t puback[] = {0x40, 0x02, uint8_t(message.packetId >> 8), uint8_t(message.packetId)};
+          if(splitAcks) {
+            for(uint8_t byte: puback) {
+              writeAll(&byte, 1);
+              std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+          }
+          else {
+            writeAll(puback, sizeof(puback));
+          }
+          break;
+        }
+        case 0xC0: { //PINGREQ
+          const uint8_t pingresp[] = {0xD0, 0x00};
+          writeAll(pingresp, sizeof(pingresp));
+          break;
+        }
+        case 0xE0: //DISCONNECT
+          return;
+      }
+    }
+  }
+
+  /**
+   * Accepts sessions until the broker stops.
+   */
+  void run() {
+    while(!stopping) {
+      pollfd waiting = {listener, POLLIN, 0};
+      if(::poll(&waiting, 1, 20) != 1) {
+        continue;
+      }
+      session = accept(listener, nullptr, nullptr);
+      if(session < 0) {
+        continue;
+      }
+      serve();
+      close(session);
+      session = -1;
+    }
+  }
+
+  public:
+    std::atomic<int> missedAcks{0};       //< Number of QoS 1 messages which are not acknowledged.
+    std::atomic<bool> splitAcks{false};   //< If acknowledgements are written byte by byte.
+    std::atomic<bool> closeOnPublish{false}; //< If the connection is closed on the next message.
+
+    TestBroker() {
+      listener = socket(AF_INET, SOCK_STREAM, 0);
+      int reuse = 1;
+      setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+      sockaddr_in address = {};
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      socklen_t length = sizeof(address);
+      bind(listener, reinterpret_cast<sockaddr*>(&address), length);
+      listen(listener, 1);
+      getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+      port = ntohs(address.sin_port);
+      thread = std::thread(&TestBroker::run, this);
+    }
+
+    ~TestBroker() {
+      stopping = true;
+      thread.join();
+      close(listener);
+    }
+
+    /**
+     * Gives the url of the broker.
+     */
+    String getUrl(const char* query) const {
+      return String("mqtt://127.0.0.1:" + std::to_string(port) + "/ubis" + query);
+    }
+
+    /**
+     * Gives the received messages.
+     */
+    std::vector<ReceivedMessage> getMessages() {
+      std::lock_guard<std::mutex> guard(lock);
+      return messages;
+    }
+};
+
+//===========================================================
+// Static function implementations
+
+/**
+ * Polls the transport until a condition holds.
+ * @param transport The transport.
+ * @param condition The condition.
+ * @return
+ *  -true: If the condition holds.
+ *  -false: If it did not hold within TEST_WAIT.
+ */
+static bool pollUntil(MqttTransport& transport, const std::function<bool()>& condition) {
+  uint32_t start = millis();
+  while(!condition()) {
+    if(millis() - start > TEST_WAIT) {
+      return false;
+    }
+    transport.poll();
+    delay(1);
+  }
+  return true;
+}
+
+/**
+ * Sets up a transport with an established session to the broker.
+ * @param transport The transport.
+ * @param broker The broker.
+ * @param query The query of the url, e.g. "?qos=1".
+ * @return
+ *  -true: If the session is established.
+ *  -false: otherwise.
+ */
+static bool connectTo(MqttTransport& transport, TestBroker& broker, const char* query) {
+  transport.setDeadline(TEST_DEADLINE);
+  return transport.setUrl(broker.getUrl(query)) && transport.connect() &&
+         pollUntil(transport, [&] { return transport.isConnected(); });
+}
+
+//===========================================================
+// Tests
+
+/**
+ * Checks that a QoS 1 message is acknowledged without waiting in publish().
+ */
+static void testAcknowledged() {
+  TestBroker broker;
+  MqttTransport transport;
+  CHECK(connectTo(transport, broker, "?qos=1"));
+
+  CHECK(transport.publish("room", "first", nullptr));
+  CHECK(transport.isInFlight());
+  CHECK(transport.getLastResult() == "waiting for acknowledgement");
+  CHECK(!transport.publish("room", "second", nullptr)); //One message in flight at a time
+  CHECK(transport.getLastResult() == "last message not acknowledged yet");
+  CHECK(pollUntil(transport, [&] { return !transport.isInFlight(); }));
+  CHECK(transport.getLastResult() == "acknowledged");
+  CHECK(transport.publish("room", "second", nullptr));
+  CHECK(pollUntil(transport, [&] { return !transport.isInFlight(); }));
+
+  std::vector<ReceivedMessage> messages = broker.getMessages();
+  CHECK(messages.size() == 2);
+  if(messages.size() == 2) {
+    CHECK(!messages[0].dup && messages[0].qos == 1 && messages[0].packetId == 1);
+    CHECK(messages[0].topic == "ubis/room" && messages[0].payload == "first");
+    CHECK(!messages[1].dup && messages[1].packetId == 2 && messages[1].payload == "second");
+  }
+}
+
+/**
+ * Checks that publish() returns before the broker answers.
+ */
+static void testNotBlocking() {
+  TestBroker broker;
+  broker.missedAcks = 1;
+  MqttTransport transport;
+  CHECK(connectTo(transport, broker, "?qos=1"));
+
+  uint32_t start = millis();
+  CHECK(transport.publish("room", "data", nullptr));
+  transport.poll();
+  CHECK(millis() - start < TEST_DEADLINE / 2);
+  CHECK(transport.isInFlight());
+  CHECK(pollUntil(transport, [&] { return !transport.isInFlight(); }));
+}
+
+/**
+ * Checks that a message is sent again with DUP once its acknowledgement is missing for the deadline.
+ */
+static void testRetransmit() {
+  TestBroker broker;
+  broker.missedAcks = 2;
+  MqttTransport transport;
+  CHECK(connectTo(transport, broker, "?qos=1"));
+
+  uint32_t start = millis();
+  CHECK(transport.publish("room", "data", nullptr));
+  CHECK(pollUntil(transport, [&] { return !transport.isInFlight(); }));
+  CHECK(millis() - start >= 2 * TEST_DEADLINE);
+  CHECK(transport.isConnected());
+
+  std::vector<ReceivedMessage> messages = broker.getMessages();
+  CHECK(messages.size() == 3);
+  for(size_t i = 0; i < messages.size(); i++) {
+    CHECK(messages[i].dup == (i > 0));
+    CHECK(messages[i].packetId == 1 && messages[i].payload == "data");
+  }
+}
+
+/**
+ * Checks that the session is dropped if the broker never acknowledges
+ * and that the message is kept for the next session.
+ */
+static void testRetransmitLimit() {
+  TestBroker broker;
+  broker.missedAcks = MQTT_MAX_RETRANSMITS + 1;
+  MqttTransport transport;
+  CHECK(connectTo(transport, broker, "?qos=1"));
+
+  CHECK(transport.publish("room", "data", nullptr));
+  CHECK(pollUntil(transport, [&] { return !transport.isConnected(); }));
+  CHECK(transport.isInFlight());
+  CHECK(broker.getMessages().size() == MQTT_MAX_RETRANSMITS + 1);
+
+  transport.disconnect();
+  CHECK(transport.connect());
+  CHECK(pollUntil(transport, [&] { return !transport.isInFlight(); }));
+  std::vector<ReceivedMessage> messages = broker.getMessages();
+  CHECK(messages.size() == MQTT_MAX_RETRANSMITS + 2);
+  CHECK(messages.back().dup && messages.back().packetId == 1);
+}
+
+/**
+ * Checks that a message in flight is sent again with DUP after the connection was lost.
+ */
+static void testResendAfterReconnect() {
+  TestBroker broker;
+  broker.closeOnPublish = true;
+  MqttTransport transport;
+  CHECK(connectTo(transport, broker, "?qos=1"));
+
+  CHECK(transport.publish("room", "data", nullptr));
+  CHECK(pollUntil(transport, [&] { return !transport.isConnected(); }));
+  CHECK(transport.isInFlight());
+  CHECK(!transport.publish("room", "other", nullptr));
+
+  transport.disconnect(); //Skips the retry interval
+  CHECK(transport.connect());
+  CHECK(pollUntil(transport, [&] { return !transport.isInFlight(); }));
+  std::vector<ReceivedMessage> messages = broker.getMessages();
+  CHECK(messages.size() == 2);
+  if(messages.size() == 2) {
+    CHECK(!messages[0].dup && messages[1].dup);
+    CHECK(messages[1].packetId == messages[0].packetId && messages[1].payload == "data");
+  }
+}
+
+/**
+ * Checks that an acknowledgement which arrives over several polls is read.
+ */
+static void testSplitAcknowledgement() {
+  TestBroker broker;
+  broker.splitAcks = true;
+  MqttTransport transport;
+  CHECK(connectTo(transport, broker, "?qos=1"));
+
+  CHECK(transport.publish("room", "data", nullptr));
+  CHECK(pollUntil(transport, [&] { return !transport.isInFlight(); }));
+  CHECK(broker.getMessages().size() == 1);
+  CHECK(transport.isConnected());
+}
+
+/**
+ * Checks that a QoS 0 message is sent without waiting for the broker.
+ */
+static void testQos0() {
+  TestBroker broker;
+  MqttTransport transport;
+  CHECK(connectTo(transport, broker, ""));
+
+  CHECK(transport.publish("room", "first", nullptr));
+  CHECK(!transport.isInFlight());
+  CHECK(transport.getLastResult() == "sent");
+  CHECK(transport.publish("room", "second", nullptr));
+  CHECK(pollUntil(transport, [&] { return broker.getMessages().size() == 2; }));
+  std::vector<ReceivedMessage> messages = broker.getMessages();
+  if(messages.size() == 2) {
+    CHECK(messages[0].qos == 0 && messages[0].packetId == 0 && messages[0].payload == "first");
+    CHECK(messages[1].payload == "second");
+  }
+}
+
+//===========================================================
+// Main
+
+int main() {
+  testAcknowledged();
+  testNotBlocking();
+  testRetransmit();
+  testRetransmitLimit();
+  testResendAfterReconnect();
+  testSplitAcknowledgement();
+  testQos0();
+  return TEST_RESULT();
+}
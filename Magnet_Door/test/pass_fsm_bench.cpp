@@ -0,0 +1,66 @@
+/*************************************************************
+  Host benchmark of the door passing state machine.
+  Steps the transition table and the former switch through the same
+  pseudo random detector codes and prints the steps per second of both.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "pass_fsm.h"
+#include "pass_fsm_reference.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+//===========================================================
+// Definitions
+#define BENCH_CODES 4096           //< Number of pseudo random detector codes.
+#define BENCH_ROUNDS 20000         //< Number of times the codes are stepped through.
+
+//===========================================================
+// Static function implementations
+
+/**
+ * Measures the steps per second of a step function.
+ * @param name The name printed with the result.
+ * @param codes The detector codes.
+ * @param step The step function. Takes a code and gives the event.
+ */
+template <typename Step>
+static void measure(const char* name, const std::vector<uint8_t>& codes, Step step) {
+  uint32_t events = 0;
+  auto start = std::chrono::steady_clock::now();
+  for(uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+    for(uint8_t code: codes) {
+      events += static_cast<uint8_t>(step(code));
+    }
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  double steps = (double)BENCH_ROUNDS * codes.size();
+  std::printf("%-8s %8.1f M steps/s (%.2f ns/step, checksum %u)\n",
+              name, steps / seconds / 1e6, seconds / steps * 1e9, events);
+}
+
+//===========================================================
+// Function implementations
+
+int main() {
+  //Random walks over the codes, so all transitions are taken
+  std::vector<uint8_t> codes(BENCH_CODES);
+  uint32_t seed = 1;
+  for(uint8_t& code: codes) {
+    seed = seed * 1664525 + 1013904223;
+    code = (seed >> 24) & PASS_CODE_BOTH;
+  }
+
+  PassFsm fsm;
+  measure("table", codes, [&fsm](uint8_t code) { return fsm.step(code); });
+
+  PassState state = PassState::idle;
+  measure("switch", codes, [&state](uint8_t code) {
+    PassTransition t = referenceStep(state, code);
+    state = t.next;
+    return t.event;
+  });
+  return 0;
+}
@@ -0,0 +1,108 @@
+#pragma once
+/*************************************************************
+  The switch based door passing state machine the transition table replaced.
+  Kept for the host tests and the benchmark of the table.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "pass_fsm.h"
+
+//===========================================================
+// Function implementations
+
+/**
+ * Determines the next state like the former switch of RoomLoadSystem::doDoorPassingCheck.
+ * The former error messages are returned as error events. Entered and left are
+ * registered once the state is reached and are left to idle on the next step.
+ * @param state The current state.
+ * @param code The detector code.
+ * @return The transition.
+ */
+inline PassTransition referenceStep(PassState state, uint8_t code) {
+  bool outer = code == PASS_CODE_OUTER;
+  bool inner = code == PASS_CODE_INNER;
+  bool both = code == PASS_CODE_BOTH;
+  bool none = code == PASS_CODE_NONE;
+  switch(state) {
+    case PassState::idle:
+      if(outer) {
+        return {PassState::startEntering, PassEvent::none};
+      }
+      else if(inner) {
+        return {PassState::startLeaving, PassEvent::none};
+      }
+      break;
+    case PassState::startEntering:
+      if(both) {
+        return {PassState::entering1, PassEvent::none};
+      }
+      else if(none) {
+        return {PassState::idle, PassEvent::none};
+      }
+      else if(inner) {
+        return {PassState::idle, PassEvent::enteringError};
+      }
+      break;
+    case PassState::entering1:
+      if(inner) {
+        return {PassState::entering2, PassEvent::none};
+      }
+      else if(outer) {
+        return {PassState::startEntering, PassEvent::none};
+      }
+      else if(none) {
+        return {PassState::idle, PassEvent::enteringError};
+      }
+      break;
+    case PassState::entering2:
+      if(none) {
+        return {PassState::entered, PassEvent::entered};
+      }
+      else if(both) {
+        return {PassState::entering1, PassEvent::none};
+      }
+      else if(outer) {
+        return {PassState::idle, PassEvent::enteringError};
+      }
+      break;
+    case PassState::entered:
+      return {PassState::idle, PassEvent::none};
+    case PassState::startLeaving:
+      if(both) {
+        return {PassState::leaving1, PassEvent::none};
+      }
+      else if(none) {
+        return {PassState::idle, PassEvent::none};
+      }
+      else if(outer) {
+        return {PassState::idle, PassEvent::leavingError};
+      }
+      break;
+    case PassState::leaving1:
+      if(outer) {
+        return {PassState::leaving2, PassEvent::none};
+      }
+      else if(inner) {
+        return {PassState::startLeaving, PassEvent::none};
+      }
+      else if(none) {
+        return {PassState::idle, PassEvent::leavingError};
+      }
+      break;
+    case PassState::leaving2:
+      if(none) {
+        return {PassState::left, PassEvent::left};
+      }
+      else if(both) {
+        return {PassState::leaving1, PassEvent::none};
+      }
+      else if(inner) {
+        return {PassState::idle, PassEvent::leavingError};
+      }
+      break;
+    case PassState::left:
+      return {PassState::idle, PassEvent::none};
+  }
+  return {state, PassEvent::none};
+}
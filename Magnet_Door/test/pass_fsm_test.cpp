@@ -0,0 +1,91 @@
+/*************************************************************
+  Host test of the door passing state machine.
+  Compares the transition table against the former switch on every pair of state and detector code.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "host_test.h"
+#include "pass_fsm.h"
+#include "pass_fsm_reference.h"
+
+//===========================================================
+// Definitions
+#define PASS_STATE_COUNT 9        //< Number of door passing states.
+
+//===========================================================
+// Static function implementations
+
+/**
+ * Checks whether two transitions are equal.
+ * @param a The first transition.
+ * @param b The second transition.
+ * @return
+ *  -true: If equal.
+ *  -false: otherwise.
+ */
+static bool isEqual(const PassTransition& a, const PassTransition& b) {
+  return a.next == b.next && a.event == b.event;
+}
+
+/**
+ * Compares the table against the switch on every pair of state and detector code.
+ * The switch needed an extra step from entered and left to idle. The table takes
+ * that step right away, so it has to match the switch after the extra step.
+ */
+static void testTableMatchesSwitch() {
+  for(uint8_t s = 0; s < PASS_STATE_COUNT; s++) {
+    PassState state = static_cast<PassState>(s);
+    for(uint8_t code = 0; code <= PASS_CODE_BOTH; code++) {
+      PassTransition expected = referenceStep(state, code);
+      if(state == PassState::entered || state == PassState::left) {
+        expected = referenceStep(expected.next, code);
+      }
+      PassTransition actual = PassFsm::transition(state, code);
+      if(!isEqual(actual, expected)) {
+        std::printf("state %u, code %u: table %u/%u, switch %u/%u\n", s, code,
+                    (unsigned)actual.next, (unsigned)actual.event, (unsigned)expected.next, (unsigned)expected.event);
+      }
+      CHECK(isEqual(actual, expected));
+    }
+  }
+}
+
+/**
+ * Walks an entering, a leaving and a stepped back passing through the FSM.
+ */
+static void testPassings() {
+  PassFsm fsm;
+  const uint8_t entering[] = {PASS_CODE_OUTER, PASS_CODE_BOTH, PASS_CODE_INNER, PASS_CODE_NONE};
+  PassEvent event = PassEvent::none;
+  for(uint8_t code: entering) {
+    event = fsm.step(code);
+  }
+  CHECK(event == PassEvent::entered);
+
+  const uint8_t leaving[] = {PASS_CODE_INNER, PASS_CODE_BOTH, PASS_CODE_OUTER, PASS_CODE_NONE};
+  for(uint8_t code: leaving) {
+    event = fsm.step(code);
+  }
+  CHECK(event == PassEvent::left);
+
+  const uint8_t steppedBack[] = {PASS_CODE_OUTER, PASS_CODE_BOTH, PASS_CODE_OUTER, PASS_CODE_NONE};
+  for(uint8_t code: steppedBack) {
+    CHECK(fsm.step(code) == PassEvent::none);
+  }
+  CHECK(fsm.getState() == PassState::idle);
+
+  CHECK(PassFsm::encode(false, true) == PASS_CODE_OUTER);
+  CHECK(PassFsm::encode(true, false) == PASS_CODE_INNER);
+  CHECK(PassFsm::encode(false, false) == PASS_CODE_BOTH);
+  CHECK(PassFsm::encode(true, true) == PASS_CODE_NONE);
+}
+
+//===========================================================
+// Function implementations
+
+int main() {
+  testTableMatchesSwitch();
+  testPassings();
+  return TEST_RESULT();
+}
@@ -0,0 +1,266 @@
+/*************************************************************
+  Host test of the tracker of overlapping door passings.
+  Checks hand written edge scenarios and the counting accuracy
+  in a simulation of persons walking through one lane.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "host_test.h"
+#include "pass_tracker.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+//===========================================================
+// Definitions
+#define BEAM_SPACING 0.15          //< Distance between the outer and the inner beam in meters.
+#define FOLLOW_GAP 0.05            //< Minimum distance between two persons in meters.
+#define SIM_PERSONS 2000           //< Number of persons per simulation run.
+#define STEP_BACK_SHARE 0.03       //< Share of persons who step back before reaching the second beam.
+#define MIN_ACCURACY 0.97          //< Share of persons the tracker has to count correctly.
+
+//===========================================================
+// Data Types
+
+/**
+ * A detector edge fed into the tracker.
+ */
+struct Edge {
+  uint32_t time;                   //< Time of the edge in micro seconds.
+  uint8_t code;                    //< The detector, PASS_CODE_OUTER or PASS_CODE_INNER.
+  bool level;                      //< Level after the edge. Low means the beam is broken.
+};
+
+/**
+ * Sums up the results of the tracker.
+ */
+struct Totals {
+  uint32_t entered = 0;            //< Number of counted entering persons.
+  uint32_t left = 0;               //< Number of counted leaving persons.
+  uint32_t lost = 0;               //< Number of lost passings.
+  uint32_t aborted = 0;            //< Number of aborted passings.
+
+  /**
+   * Adds a result of the tracker.
+   * @param result The result.
+   */
+  void add(const PassTrackResult& result) {
+    entered += result.entered;
+    left += result.left;
+    lost += result.lost;
+    aborted += result.aborted;
+  }
+};
+
+//===========================================================
+// Static function implementations
+
+/**
+ * Feeds edges into a tracker, each 100 ms after the former one.
+ * @param tracker The tracker.
+ * @param edges The edges as pairs of detector code and level.
+ * @param[in,out] time The time of the last edge in micro seconds.
+ * @param[out] totals The results.
+ */
+static void feed(PassTracker& tracker, const std::vector<std::pair<uint8_t, bool>>& edges, uint32_t& time, Totals& totals) {
+  for(const auto& edge: edges) {
+    time += 100000;
+    totals.add(tracker.onEdge(edge.first, edge.second, time));
+  }
+}
+
+/**
+ * Checks single, overlapping and stepped back passings.
+ */
+static void testScenarios() {
+  const uint8_t O = PASS_CODE_OUTER;
+  const uint8_t I = PASS_CODE_INNER;
+  const bool BREAK = false;
+  const bool RELEASE = true;
+
+  { //One person enters
+    PassTracker tracker;
+    Totals totals;
+    uint32_t time = 0;
+    feed(tracker, {{O, BREAK}, {I, BREAK}, {O, RELEASE}, {I, RELEASE}}, time, totals);
+    CHECK(totals.entered == 1 && totals.left == 0);
+    CHECK(tracker.getTrackCount() == 0);
+  }
+  { //One person leaves
+    PassTracker tracker;
+    Totals totals;
+    uint32_t time = 0;
+    feed(tracker, {{I, BREAK}, {O, BREAK}, {I, RELEASE}, {O, RELEASE}}, time, totals);
+    CHECK(totals.entered == 0 && totals.left == 1);
+  }
+  { //Someone steps back before reaching the inner beam
+    PassTracker tracker;
+    Totals totals;
+    uint32_t time = 0;
+    feed(tracker, {{O, BREAK}, {O, RELEASE}}, time, totals);
+    CHECK(totals.entered == 0 && totals.left == 0);
+    CHECK(tracker.getTrackCount() == 0);
+  }
+  { //The second person breaks the outer beam while the first one still breaks the inner beam
+    PassTracker tracker;
+    Totals totals;
+    uint32_t time = 0;
+    feed(tracker, {{O, BREAK}, {I, BREAK}, {O, RELEASE}, {O, BREAK}, {I, RELEASE}}, time, totals);
+    CHECK(totals.entered == 0); //Could still be the first person stepping back
+    feed(tracker, {{I, BREAK}}, time, totals);
+    CHECK(totals.entered == 1);
+    feed(tracker, {{O, RELEASE}, {I, RELEASE}}, time, totals);
+    CHECK(totals.entered == 2);
+  }
+  { //A passed person is followed by someone who steps back
+    PassTracker tracker;
+    Totals totals;
+    uint32_t time = 0;
+    feed(tracker, {{O, BREAK}, {I, BREAK}, {O, RELEASE}, {O, BREAK}, {I, RELEASE}, {O, RELEASE}}, time, totals);
+    CHECK(totals.entered == 0 && totals.left == 0); //One of them stepped back, the other one came back out
+    CHECK(tracker.getTrackCount() == 0);
+  }
+  { //A passed person is registered once the settle time is over
+    PassTracker tracker;
+    Totals totals;
+    uint32_t time = 0;
+    feed(tracker, {{O, BREAK}, {I, BREAK}, {O, RELEASE}, {O, BREAK}, {I, RELEASE}}, time, totals);
+    totals.add(tracker.update(time + PASS_TRACKER_SETTLE_TIME - 1));
+    CHECK(totals.entered == 0);
+    totals.add(tracker.update(time + PASS_TRACKER_SETTLE_TIME));
+    CHECK(totals.entered == 1);
+  }
+  { //A person is still in the door when it closes. The release is not seen, since edges are discarded.
+    PassTracker tracker;
+    Totals totals;
+    uint32_t time = 0;
+    feed(tracker, {{O, BREAK}, {I, BREAK}, {O, RELEASE}}, time, totals);
+    totals.add(tracker.finish());
+    CHECK(totals.aborted == 1 && tracker.getTrackCount() == 0);
+    //After the door opened again someone leaves. Its release must not finish the former passing.
+    feed(tracker, {{I, BREAK}, {O, BREAK}, {I, RELEASE}, {O, RELEASE}}, time, totals);
+    CHECK(totals.entered == 0 && totals.left == 1);
+  }
+  { //The door closes while a passed person waits for the registration
+    PassTracker tracker;
+    Totals totals;
+    uint32_t time = 0;
+    feed(tracker, {{O, BREAK}, {I, BREAK}, {O, RELEASE}, {O, BREAK}, {I, RELEASE}}, time, totals);
+    totals.add(tracker.finish());
+    CHECK(totals.entered == 1 && totals.aborted == 1);
+  }
+}
+
+/**
+ * Simulates persons walking through one lane and gives the share the tracker counted correctly.
+ * The persons have a body depth of 25 to 40 cm, walk with 1.0 to 1.6 m/s and keep
+ * at least FOLLOW_GAP to the person in front. Opposing persons wait until the lane is free.
+ * STEP_BACK_SHARE of the persons step 5 to 12 cm into the door and back out again.
+ * @param rate The mean number of persons per second.
+ * @param enteringShare The share of entering persons.
+ * @param seed The seed of the random numbers.
+ * @return The accuracy between 0 and 1.
+ */
+static double simulate(double rate, double enteringShare, uint32_t seed) {
+  std::mt19937 random(seed);
+  std::uniform_real_distribution<double> depthOf(0.25, 0.40);
+  std::uniform_real_distribution<double> speedOf(1.0, 1.6);
+  std::exponential_distribution<double> interval(rate);
+  std::bernoulli_distribution isEntering(enteringShare);
+  std::bernoulli_distribution isSteppingBack(STEP_BACK_SHARE);
+  std::uniform_real_distribution<double> reachOf(0.05, 0.12);
+
+  //Times a beam is broken, indexed by the detector code
+  std::vector<std::pair<double, double>> breaks[PASS_CODE_BOTH + 1];
+  uint32_t enteringPersons = 0;
+  uint32_t leavingPersons = 0;
+  double arrival = 1.0;
+  double lastEnd = 0;              //Time the lane is free of the former person
+  bool lastEntering = true;
+  double lastFirstEnd = 0;         //Time the former person releases its first beam
+  double lastSecondEnd = 0;        //Time the former person releases its second beam
+  for(uint32_t i = 0; i < SIM_PERSONS; i++) {
+    bool entering = isEntering(random);
+    double depth = depthOf(random);
+    double speed = speedOf(random);
+    arrival += interval(random);
+    double start = arrival;
+    if(i > 0) {
+      if(entering == lastEntering) {
+        //Keep the gap at both beams, a faster person catches up within the door
+        start = std::max(start, lastFirstEnd + FOLLOW_GAP / speed);
+        start = std::max(start, lastSecondEnd + FOLLOW_GAP / speed - BEAM_SPACING / speed);
+      }
+      else {
+        start = std::max(start, lastEnd + FOLLOW_GAP / speed);
+      }
+    }
+    arrival = start;
+    uint8_t first = entering? PASS_CODE_OUTER : PASS_CODE_INNER;
+    uint8_t second = entering? PASS_CODE_INNER : PASS_CODE_OUTER;
+    if(isSteppingBack(random)) {
+      //Only the first beam is broken, until the front came back out
+      double end = start + 2 * reachOf(random) / speed;
+      breaks[first].push_back({start, end});
+      lastEntering = !entering; //The next person waits until the lane is free
+      lastEnd = end;
+      continue;
+    }
+    double firstEnd = start + depth / speed;
+    double secondStart = start + BEAM_SPACING / speed;
+    double secondEnd = secondStart + depth / speed;
+    breaks[first].push_back({start, firstEnd});
+    breaks[second].push_back({secondStart, secondEnd});
+    enteringPersons += entering? 1 : 0;
+    leavingPersons += entering? 0 : 1;
+    lastEntering = entering;
+    lastFirstEnd = firstEnd;
+    lastSecondEnd = secondEnd;
+    lastEnd = secondEnd;
+  }
+
+  std::vector<Edge> edges;
+  for(uint8_t code: {(uint8_t)PASS_CODE_OUTER, (uint8_t)PASS_CODE_INNER}) {
+    for(const auto& interval: breaks[code]) {
+      edges.push_back({(uint32_t)std::lround(interval.first * 1e6), code, false});
+      edges.push_back({(uint32_t)std::lround(interval.second * 1e6), code, true});
+    }
+  }
+  std::stable_sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.time < b.time; });
+
+  PassTracker tracker;
+  Totals totals;
+  for(const Edge& edge: edges) {
+    totals.add(tracker.onEdge(edge.code, edge.level, edge.time));
+  }
+  totals.add(tracker.update(edges.back().time + PASS_TRACKER_SETTLE_TIME));
+
+  uint32_t errors = std::abs((int32_t)totals.entered - (int32_t)enteringPersons) +
+                    std::abs((int32_t)totals.left - (int32_t)leavingPersons);
+  double accuracy = 1.0 - (double)errors / SIM_PERSONS;
+  std::printf("%.1f persons/s, %3.0f%% entering: entered %u/%u, left %u/%u, lost %u, accuracy %.1f%%\n",
+              rate, enteringShare * 100, totals.entered, enteringPersons, totals.left, leavingPersons,
+              totals.lost, accuracy * 100);
+  return accuracy;
+}
+
+/**
+ * Checks the counting accuracy for one and both directions at several rates.
+ */
+static void testSimulation() {
+  for(double rate: {1.0, 2.0, 3.0}) {
+    CHECK(simulate(rate, 1.0, 1) >= MIN_ACCURACY);
+    CHECK(simulate(rate, 0.7, 2) >= MIN_ACCURACY);
+  }
+}
+
+//===========================================================
+// Function implementations
+
+int main() {
+  testScenarios();
+  testSimulation();
+  return TEST_RESULT();
+}
@@ -0,0 +1,185 @@
+#pragma once
+/*************************************************************
+  The part of the Arduino core the host tests need.
+  String keeps its text in a std::string, so it can hold zero bytes like the original.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+//===========================================================
+// Definitions
+#define portMUX_INITIALIZER_UNLOCKED {}                 //< An unlocked spinlock.
+#define portENTER_CRITICAL(mux) ((mux)->mutex.lock())   //< Takes a spinlock.
+#define portEXIT_CRITICAL(mux) ((mux)->mutex.unlock())  //< Gives a spinlock back.
+#define INPUT 0x01                                      //< Pin mode of an input.
+#define LOW 0x0                                         //< Low level of a pin.
+#define HIGH 0x1                                        //< High level of a pin.
+
+//===========================================================
+// Data Types
+
+/**
+ * A FreeRTOS spinlock. A mutex on the host.
+ */
+struct portMUX_TYPE {
+  std::mutex mutex;
+};
+
+/**
+ * The Arduino string.
+ */
+class String {
+  std::string text;
+
+  public:
+    String() {}
+    String(const char* text): text(text? text : "") {}
+    String(const std::string& text): text(text) {}
+    explicit String(int value): text(std::to_string(value)) {}
+
+    const char* c_str() const { return text.c_str(); }
+    unsigned int length() const { return text.size(); }
+    bool reserve(unsigned int size) { text.reserve(size); return true; }
+    bool isEmpty() const { return text.empty(); }
+    bool startsWith(const String& prefix) const { return text.compare(0, prefix.text.size(), prefix.text) == 0; }
+    long toInt() const { return atol(text.c_str()); }
+    bool concat(const char* data, unsigned int length) { text.append(data, length); return true; }
+    bool concat(const String& other) { text += other.text; return true; }
+    bool concat(char c) { text += c; return true; }
+    String& operator+=(const String& other) { concat(other); return *this; }
+    String& operator+=(const char* other) { text += other; return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+    char operator[](unsigned int index) const { return text[index]; }
+    bool operator==(const String& other) const { return text == other.text; }
+    bool operator==(const char* other) const { return text == other; }
+    bool operator!=(const String& other) const { return text != other.text; }
+    bool operator!=(const char* other) const { return text != other; }
+
+    int indexOf(char c, unsigned int from = 0) const {
+      size_t index = text.find(c, from);
+      return index == std::string::npos? -1 : static_cast<int>(index);
+    }
+    int indexOf(const char* s, unsigned int from = 0) const {
+      size_t index = text.find(s, from);
+      return index == std::string::npos? -1 : static_cast<int>(index);
+    }
+    int lastIndexOf(char c) const {
+      size_t index = text.rfind(c);
+      return index == std::string::npos? -1 : static_cast<int>(index);
+    }
+    String substring(unsigned int from) const {
+      return from < text.size()? String(text.substr(from)) : String();
+    }
+    String substring(unsigned int from, unsigned int to) const {
+      return from < to && from < text.size()? String(text.substr(from, to - from)) : String();
+    }
+};
+
+inline String operator+(const char* left, const String& right) {
+  String result(left);
+  result += right;
+  return result;
+}
+
+/**
+ * An IPv4 address. The first octet is the lowest byte, like on the ESP32.
+ */
+class IPAddress {
+  uint32_t address = 0;
+
+  public:
+    IPAddress() {}
+    IPAddress(uint32_t address): address(address) {}
+
+    operator uint32_t() const { return address; }
+    String toString() const {
+      char text[16];
+      snprintf(text, sizeof(text), "%u.%u.%u.%u", unsigned(address & 0xFF), unsigned(address >> 8 & 0xFF),
+               unsigned(address >> 16 & 0xFF), unsigned(address >> 24));
+      return String(text);
+    }
+};
+
+/**
+ * The serial port. Prints to stdout.
+ */
+struct HostSerial {
+  void print(const char* text) { fputs(text, stdout); }
+  void print(const String& text) { print(text.c_str()); }
+  void print(long value) { printf("%ld", value); }
+  void print(double value) { printf("%.2f", value); }
+  void println() { fputs("\n", stdout); }
+  template <typename T>
+  void println(const T& value) { print(value); println(); }
+  int printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    va_list args;
+    va_start(args, format);
+    int length = vprintf(format, args);
+    va_end(args);
+    return length;
+  }
+};
+
+inline HostSerial Serial;
+
+/**
+ * The chip. Gives a fixed MAC address.
+ */
+struct HostEsp {
+  uint64_t getEfuseMac() { return 0x0000A1B2C3D4E5F6ULL; }
+};
+
+inline HostEsp ESP;
+
+//===========================================================
+// Function implementations
+
+/**
+ * Gives the time since the first call in milli seconds.
+ */
+inline unsigned long millis() {
+  static const auto start = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Gives the time since the first call in micro seconds.
+ */
+inline unsigned long micros() {
+  static const auto start = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * The levels digitalRead() gives per pin. Set by the tests.
+ */
+inline int hostPinLevels[64];
+
+/**
+ * Sets the mode of a pin. Nothing to do on the host.
+ */
+inline void pinMode(uint8_t, uint8_t) {}
+
+/**
+ * Gives the level of a pin as set in hostPinLevels.
+ */
+inline int digitalRead(uint8_t pin) {
+  return hostPinLevels[pin];
+}
+
+/**
+ * Sleeps for some milli seconds.
+ */
+inline void delay(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
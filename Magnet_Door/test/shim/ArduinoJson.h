@@ -0,0 +1,536 @@
+#pragma once
+/*************************************************************
+  The part of ArduinoJson 7 the host tests need.
+  A small tree of nodes behind the same handle types. serializeJson() and
+  serializeMsgPack() follow the output rules of ArduinoJson: compact json,
+  the shortest integer forms and single precision for floats.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//===========================================================
+// Data Types
+
+/**
+ * A value of a json document.
+ */
+struct JsonNode {
+  enum class Kind: uint8_t {null, boolean, unsignedInt, signedInt, real, text, array, object};
+
+  Kind kind = Kind::null;
+  bool boolean = false;
+  uint64_t unsignedInt = 0;
+  int64_t signedInt = 0;
+  double real = 0;
+  bool single = false;                                                        //< If the real was given as float.
+  std::string text;
+  std::vector<std::unique_ptr<JsonNode>> elements;                            //< The elements of an array.
+  std::vector<std::pair<std::string, std::unique_ptr<JsonNode>>> members;     //< The members of an object.
+
+  void reset(Kind newKind) {
+    kind = newKind;
+    text.clear();
+    elements.clear();
+    members.clear();
+  }
+
+  void set(std::nullptr_t) { reset(Kind::null); }
+  void set(bool value) { reset(Kind::boolean); boolean = value; }
+  void set(float value) { reset(Kind::real); real = value; single = true; }
+  void set(double value) { reset(Kind::real); real = value; single = false; }
+  void set(const char* value) {
+    if(!value) {
+      reset(Kind::null);
+      return;
+    }
+    reset(Kind::text);
+    text = value;
+  }
+  void set(const String& value) { reset(Kind::text); text.assign(value.c_str(), value.length()); }
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value>::type set(T value) {
+    if(value < 0) {
+      reset(Kind::signedInt);
+      signedInt = value;
+    }
+    else {
+      reset(Kind::unsignedInt);
+      unsignedInt = value;
+    }
+  }
+
+  JsonNode* add() {
+    elements.emplace_back(new JsonNode());
+    return elements.back().get();
+  }
+
+  JsonNode* member(const char* key) {
+    for(auto& pair: members) {
+      if(pair.first == key) {
+        return pair.second.get();
+      }
+    }
+    members.emplace_back(key, std::unique_ptr<JsonNode>(new JsonNode()));
+    return members.back().second.get();
+  }
+};
+
+class JsonString {
+  const std::string* text;
+
+  public:
+    explicit JsonString(const std::string* text = nullptr): text(text) {}
+    const char* c_str() const { return text? text->c_str() : nullptr; }
+    size_t size() const { return text? text->size() : 0; }
+};
+
+class JsonObject;
+class JsonArray;
+class JsonObjectConst;
+class JsonArrayConst;
+
+class JsonVariantConst {
+  protected:
+    const JsonNode* node;
+
+  public:
+    explicit JsonVariantConst(const JsonNode* node = nullptr): node(node) {}
+    const JsonNode* getNode() const { return node; }
+    bool isNull() const { return !node || node->kind == JsonNode::Kind::null; }
+    template <typename T> bool is() const;
+    template <typename T> T as() const;
+};
+
+class JsonPairConst {
+  const std::pair<std::string, std::unique_ptr<JsonNode>>* pair;
+
+  public:
+    explicit JsonPairConst(const std::pair<std::string, std::unique_ptr<JsonNode>>* pair): pair(pair) {}
+    JsonString key() const { return JsonString(&pair->first); }
+    JsonVariantConst value() const { return JsonVariantConst(pair->second.get()); }
+};
+
+/**
+ * Iterates the elements of an array or the members of an object.
+ */
+template <typename Item, typename Entry>
+class JsonIterator {
+  const Entry* entry;
+
+  public:
+    explicit JsonIterator(const Entry* entry): entry(entry) {}
+    Item operator*() const { return make(entry); }
+    JsonIterator& operator++() { entry++; return *this; }
+    bool operator!=(const JsonIterator& other) const { return entry != other.entry; }
+
+  private:
+    static JsonVariantConst make(const std::unique_ptr<JsonNode>* element) { return JsonVariantConst(element->get()); }
+    static JsonPairConst make(const std::pair<std::string, std::unique_ptr<JsonNode>>* member) { return JsonPairConst(member); }
+};
+
+class JsonArrayConst: public JsonVariantConst {
+  public:
+    typedef JsonIterator<JsonVariantConst, std::unique_ptr<JsonNode>> iterator;
+
+    explicit JsonArrayConst(const JsonNode* node = nullptr): JsonVariantConst(node) {}
+    size_t size() const { return node? node->elements.size() : 0; }
+    iterator begin() const { return iterator(node? node->elements.data() : nullptr); }
+    iterator end() const { return iterator(node? node->elements.data() + node->elements.size() : nullptr); }
+};
+
+class JsonObjectConst: public JsonVariantConst {
+  public:
+    typedef JsonIterator<JsonPairConst, std::pair<std::string, std::unique_ptr<JsonNode>>> iterator;
+
+    explicit JsonObjectConst(const JsonNode* node = nullptr): JsonVariantConst(node) {}
+    size_t size() const { return node? node->members.size() : 0; }
+    iterator begin() const { return iterator(node? node->members.data() : nullptr); }
+    iterator end() const { return iterator(node? node->members.data() + node->members.size() : nullptr); }
+};
+
+class JsonVariant {
+  protected:
+    JsonNode* node;
+
+  public:
+    explicit JsonVariant(JsonNode* node = nullptr): node(node) {}
+    template <typename T>
+    JsonVariant& operator=(const T& value) { node->set(value); return *this; }
+    JsonVariant& operator=(const char* value) { node->set(value); return *this; }
+    JsonVariant operator[](const char* key) {
+      if(node->kind != JsonNode::Kind::object) {
+        node->reset(JsonNode::Kind::object);
+      }
+      return JsonVariant(node->member(key));
+    }
+    template <typename T> T to();
+    template <typename T> T add();
+    operator JsonVariantConst() const { return JsonVariantConst(node); }
+};
+
+class JsonObject: public JsonVariant {
+  public:
+    explicit JsonObject(JsonNode* node = nullptr): JsonVariant(node) {}
+    size_t size() const { return node? node->members.size() : 0; }
+};
+
+class JsonArray: public JsonVariant {
+  public:
+    explicit JsonArray(JsonNode* node = nullptr): JsonVariant(node) {}
+    size_t size() const { return node? node->elements.size() : 0; }
+    template <typename T>
+    bool add(const T& value) { node->add()->set(value); return true; }
+    template <typename T>
+    T add() { return JsonVariant(node->add()).to<T>(); }
+};
+
+template <typename T>
+inline T JsonVariant::to() {
+  if(std::is_same<T, JsonArray>::value) {
+    node->reset(JsonNode::Kind::array);
+  }
+  else if(std::is_same<T, JsonObject>::value) {
+    node->reset(JsonNode::Kind::object);
+  }
+  else {
+    node->reset(JsonNode::Kind::null);
+  }
+  return T(node);
+}
+
+template <typename T>
+inline T JsonVariant::add() {
+  if(node->kind != JsonNode::Kind::array) {
+    node->reset(JsonNode::Kind::array);
+  }
+  return JsonVariant(node->add()).to<T>();
+}
+
+template <typename T>
+inline bool JsonVariantConst::is() const {
+  if(!node) {
+    return false;
+  }
+  switch(node->kind) {
+    case JsonNode::Kind::boolean:
+      return std::is_same<T, bool>::value;
+    case JsonNode::Kind::unsignedInt:
+      if constexpr(std::is_floating_point<T>::value) {
+        return true;
+      }
+      else if constexpr(std::is_integral<T>::value && !std::is_same<T, bool>::value) {
+        return node->unsignedInt <= static_cast<uint64_t>(std::numeric_limits<T>::max());
+      }
+      return false;
+    case JsonNode::Kind::signedInt:
+      if constexpr(std::is_floating_point<T>::value) {
+        return true;
+      }
+      else if constexpr(std::is_integral<T>::value && std::is_signed<T>::value) {
+        return node->signedInt >= static_cast<int64_t>(std::numeric_limits<T>::min());
+      }
+      return false;
+    case JsonNode::Kind::real:
+      return std::is_floating_point<T>::value;
+    case JsonNode::Kind::text:
+      return std::is_same<T, JsonString>::value || std::is_same<T, const char*>::value;
+    case JsonNode::Kind::array:
+      return std::is_same<T, JsonArrayConst>::value;
+    case JsonNode::Kind::object:
+      return std::is_same<T, JsonObjectConst>::value;
+    default:
+      return false;
+  }
+}
+
+namespace JsonShim {
+  template <typename T>
+  inline T number(const JsonNode* node) {
+    switch(node? node->kind : JsonNode::Kind::null) {
+      case JsonNode::Kind::boolean:
+        return static_cast<T>(node->boolean);
+      case JsonNode::Kind::unsignedInt:
+        return static_cast<T>(node->unsignedInt);
+      case JsonNode::Kind::signedInt:
+        return static_cast<T>(node->signedInt);
+      case JsonNode::Kind::real:
+        return static_cast<T>(node->real);
+      default:
+        return T();
+    }
+  }
+}
+
+template <typename T>
+inline T JsonVariantConst::as() const {
+  return JsonShim::number<T>(node);
+}
+
+template <>
+inline JsonString JsonVariantConst::as<JsonString>() const {
+  return node && node->kind == JsonNode::Kind::text? JsonString(&node->text) : JsonString();
+}
+
+template <>
+inline const char* JsonVariantConst::as<const char*>() const {
+  return as<JsonString>().c_str();
+}
+
+template <>
+inline JsonArrayConst JsonVariantConst::as<JsonArrayConst>() const {
+  return JsonArrayConst(node && node->kind == JsonNode::Kind::array? node : nullptr);
+}
+
+template <>
+inline JsonObjectConst JsonVariantConst::as<JsonObjectConst>() const {
+  return JsonObjectConst(node && node->kind == JsonNode::Kind::object? node : nullptr);
+}
+
+template <>
+inline JsonVariantConst JsonVariantConst::as<JsonVariantConst>() const {
+  return *this;
+}
+
+/**
+ * Owns the root of the tree.
+ */
+class JsonDocument {
+  std::unique_ptr<JsonNode> root{new JsonNode()};
+
+  public:
+    JsonDocument() {}
+    JsonDocument(const JsonDocument&) = delete;
+    JsonDocument& operator=(const JsonDocument&) = delete;
+
+    template <typename T>
+    T to() { return JsonVariant(root.get()).to<T>(); }
+    template <typename T>
+    T as() const { return JsonVariantConst(root.get()).as<T>(); }
+    JsonVariant operator[](const char* key) { return JsonVariant(root.get())[key]; }
+    JsonVariant getVariant() { return JsonVariant(root.get()); }
+    void clear() { root->reset(JsonNode::Kind::null); }
+};
+
+//===========================================================
+// Function implementations
+
+namespace JsonShim {
+  /**
+   * Writes a float with the fewest digits which give back the same float.
+   */
+  inline void writeReal(String& out, const JsonNode& node) {
+    char buffer[32];
+    if(!std::isfinite(node.real)) {
+      out.concat("null", 4);
+      return;
+    }
+    int length = 0;
+    for(int digits = 1; digits <= 17; digits++) {
+      length = snprintf(buffer, sizeof(buffer), "%.*g", digits, node.real);
+      double parsed = strtod(buffer, nullptr);
+      if(node.single? static_cast<float>(parsed) == static_cast<float>(node.real) : parsed == node.real) {
+        break;
+      }
+    }
+    out.concat(buffer, length);
+  }
+
+  inline void writeJsonText(String& out, const std::string& text) {
+    out.concat('"');
+    for(char c: text) {
+      switch(c) {
+        case '"': out.concat("\\\"", 2); break;
+        case '\\': out.concat("\\\\", 2); break;
+        case '\n': out.concat("\\n", 2); break;
+        case '\r': out.concat("\\r", 2); break;
+        case '\t': out.concat("\\t", 2); break;
+        default:
+          if(static_cast<uint8_t>(c) < 0x20) {
+            char buffer[8];
+            out.concat(buffer, snprintf(buffer, sizeof(buffer), "\\u%04x", c));
+          }
+          else {
+            out.concat(c);
+          }
+      }
+    }
+    out.concat('"');
+  }
+
+  inline void writeJson(String& out, const JsonNode& node) {
+    char buffer[24];
+    switch(node.kind) {
+      case JsonNode::Kind::boolean:
+        node.boolean? out.concat("true", 4) : out.concat("false", 5);
+        break;
+      case JsonNode::Kind::unsignedInt:
+        out.concat(buffer, snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(node.unsignedInt)));
+        break;
+      case JsonNode::Kind::signedInt:
+        out.concat(buffer, snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(node.signedInt)));
+        break;
+      case JsonNode::Kind::real:
+        writeReal(out, node);
+        break;
+      case JsonNode::Kind::text:
+        writeJsonText(out, node.text);
+        break;
+      case JsonNode::Kind::array:
+        out.concat('[');
+        for(size_t i = 0; i < node.elements.size(); i++) {
+          if(i > 0) {
+            out.concat(',');
+          }
+          writeJson(out, *node.elements[i]);
+        }
+        out.concat(']');
+        break;
+      case JsonNode::Kind::object:
+        out.concat('{');
+        for(size_t i = 0; i < node.members.size(); i++) {
+          if(i > 0) {
+            out.concat(',');
+          }
+          writeJsonText(out, node.members[i].first);
+          out.concat(':');
+          writeJson(out, *node.members[i].second);
+        }
+        out.concat('}');
+        break;
+      default:
+        out.concat("null", 4);
+    }
+  }
+
+  /**
+   * Writes a MessagePack type byte followed by a big endian value of 'bytes' bytes.
+   */
+  inline void writeMsgPackHead(String& out, uint8_t type, uint64_t value, uint8_t bytes) {
+    char buffer[9];
+    buffer[0] = type;
+    for(uint8_t i = 0; i < bytes; i++) {
+      buffer[bytes - i] = static_cast<char>(value >> (8 * i));
+    }
+    out.concat(buffer, bytes + 1);
+  }
+
+  /**
+   * Writes the head of a string, an array or a map in the shortest form.
+   */
+  inline void writeMsgPackSize(String& out, size_t size, uint8_t fixType, size_t fixMax, uint8_t type8, uint8_t type16) {
+    if(size <= fixMax) {
+      out.concat(static_cast<char>(fixType | size));
+    }
+    else if(type8 && size <= 0xFF) {
+      writeMsgPackHead(out, type8, size, 1);
+    }
+    else if(size <= 0xFFFF) {
+      writeMsgPackHead(out, type16, size, 2);
+    }
+    else {
+      writeMsgPackHead(out, type16 + 1, size, 4);
+    }
+  }
+
+  inline void writeMsgPack(String& out, const JsonNode& node) {
+    switch(node.kind) {
+      case JsonNode::Kind::boolean:
+        out.concat(static_cast<char>(node.boolean? 0xC3 : 0xC2));
+        break;
+      case JsonNode::Kind::unsignedInt: {
+        uint64_t value = node.unsignedInt;
+        if(value < 0x80) {
+          out.concat(static_cast<char>(value));
+        }
+        else if(value <= 0xFF) {
+          writeMsgPackHead(out, 0xCC, value, 1);
+        }
+        else if(value <= 0xFFFF) {
+          writeMsgPackHead(out, 0xCD, value, 2);
+        }
+        else if(value <= 0xFFFFFFFF) {
+          writeMsgPackHead(out, 0xCE, value, 4);
+        }
+        else {
+          writeMsgPackHead(out, 0xCF, value, 8);
+        }
+        break;
+      }
+      case JsonNode::Kind::signedInt: {
+        int64_t value = node.signedInt;
+        if(value >= -32) {
+          out.concat(static_cast<char>(value));
+        }
+        else if(value >= INT8_MIN) {
+          writeMsgPackHead(out, 0xD0, value, 1);
+        }
+        else if(value >= INT16_MIN) {
+          writeMsgPackHead(out, 0xD1, value, 2);
+        }
+        else if(value >= INT32_MIN) {
+          writeMsgPackHead(out, 0xD2, value, 4);
+        }
+        else {
+          writeMsgPackHead(out, 0xD3, value, 8);
+        }
+        break;
+      }
+      case JsonNode::Kind::real:
+        if(node.single || static_cast<double>(static_cast<float>(node.real)) == node.real) {
+          float value = static_cast<float>(node.real);
+          uint32_t bits;
+          memcpy(&bits, &value, sizeof(bits));
+          writeMsgPackHead(out, 0xCA, bits, 4);
+        }
+        else {
+          uint64_t bits;
+          memcpy(&bits, &node.real, sizeof(bits));
+          writeMsgPackHead(out, 0xCB, bits, 8);
+        }
+        break;
+      case JsonNode::Kind::text:
+        writeMsgPackSize(out, node.text.size(), 0xA0, 31, 0xD9, 0xDA);
+        out.concat(node.text.data(), node.text.size());
+        break;
+      case JsonNode::Kind::array:
+        writeMsgPackSize(out, node.elements.size(), 0x90, 15, 0, 0xDC);
+        for(const auto& element: node.elements) {
+          writeMsgPack(out, *element);
+        }
+        break;
+      case JsonNode::Kind::object:
+        writeMsgPackSize(out, node.members.size(), 0x80, 15, 0, 0xDE);
+        for(const auto& member: node.members) {
+          writeMsgPackSize(out, member.first.size(), 0xA0, 31, 0xD9, 0xDA);
+          out.concat(member.first.data(), member.first.size());
+          writeMsgPack(out, *member.second);
+        }
+        break;
+      default:
+        out.concat(static_cast<char>(0xC0));
+    }
+  }
+}
+
+inline size_t serializeJson(const JsonDocument& doc, String& out) {
+  out = "";
+  const JsonNode* root = doc.as<JsonVariantConst>().getNode();
+  JsonShim::writeJson(out, *root);
+  return out.length();
+}
+
+inline size_t serializeMsgPack(const JsonDocument& doc, String& out) {
+  out = "";
+  const JsonNode* root = doc.as<JsonVariantConst>().getNode();
+  JsonShim::writeMsgPack(out, *root);
+  return out.length();
+}
@@ -0,0 +1,168 @@
+#pragma once
+/*************************************************************
+  The part of the Arduino HTTPClient the host tests need.
+  Posts over a connected client and keeps the connection like
+  the original: only if reuse is set and the server agrees.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include "WiFiClient.h"
+#include <string>
+
+//===========================================================
+// Definitions
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+//===========================================================
+// Data Types
+
+/**
+ * A HTTP/1.1 client. Only POST with a Content-Length response is supported.
+ */
+class HTTPClient {
+  WiFiClient* client = nullptr;
+  std::string host;
+  std::string path;
+  std::string headers;
+  uint16_t timeout = 5000;
+  bool reuse = false;
+  bool keepAlive = false;
+  long contentLength = 0;
+
+  /**
+   * Reads a line of the response without the line break.
+   * @return 0 on success or a negative error code.
+   */
+  int readLine(std::string& line) {
+    line.clear();
+    uint32_t start = millis();
+    while(true) {
+      if(client->available()) {
+        char c = client->read();
+        if(c == '\n') {
+          if(!line.empty() && line.back() == '\r') {
+            line.pop_back();
+          }
+          return 0;
+        }
+        line += c;
+      }
+      else if(!client->connected()) {
+        return HTTPC_ERROR_CONNECTION_LOST;
+      }
+      else if(millis() - start > timeout) {
+        return HTTPC_ERROR_READ_TIMEOUT;
+      }
+      else {
+        delay(1);
+      }
+    }
+  }
+
+  public:
+    void setReuse(bool reuse) { this->reuse = reuse; }
+    void setConnectTimeout(int32_t) {}
+    void setTimeout(uint16_t timeout) { this->timeout = timeout; }
+
+    bool begin(WiFiClient& client, const String& url) {
+      this->client = &client;
+      std::string text = url.c_str();
+      size_t hostStart = text.find("://");
+      hostStart = hostStart == std::string::npos? 0 : hostStart + 3;
+      size_t pathStart = text.find('/', hostStart);
+      host = text.substr(hostStart, pathStart - hostStart);
+      path = pathStart == std::string::npos? "/" : text.substr(pathStart);
+      headers.clear();
+      return true;
+    }
+
+    void addHeader(const String& name, const String& value) {
+      headers += std::string(name.c_str()) + ": " + value.c_str() + "\r\n";
+    }
+
+    int POST(const String& payload) {
+      if(!client || !client->connected()) {
+        return HTTPC_ERROR_NOT_CONNECTED;
+      }
+      std::string request = "POST " + path + " HTTP/1.1\r\nHost: " + host + "\r\n" +
+                            "Connection: " + (reuse? "keep-alive" : "close") + "\r\n" + headers +
+                            "Content-Length: " + std::to_string(payload.length()) + "\r\n\r\n";
+      if(client->write(reinterpret_cast<const uint8_t*>(request.data()), request.size()) != request.size()) {
+        return HTTPC_ERROR_SEND_HEADER_FAILED;
+      }
+      if(payload.length() && client->write(reinterpret_cast<const uint8_t*>(payload.c_str()), payload.length()) != payload.length()) {
+        return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+      }
+
+      std::string line;
+      int error = readLine(line);
+      if(error) {
+        return error;
+      }
+      if(line.compare(0, 5, "HTTP/") != 0 || line.size() < 12) {
+        return HTTPC_ERROR_CONNECTION_LOST;
+      }
+      int code = atoi(line.c_str() + 9);
+      keepAlive = reuse && line.compare(0, 8, "HTTP/1.1") == 0;
+      contentLength = 0;
+      while((error = readLine(line)) == 0 && !line.empty()) {
+        if(line.compare(0, 16, "Content-Length: ") == 0) {
+          contentLength = atol(line.c_str() + 16);
+        }
+        else if(line == "Connection: close") {
+          keepAlive = false;
+        }
+      }
+      return error? error : code;
+    }
+
+    String getString() {
+      std::string body;
+      uint32_t start = millis();
+      while((long)body.size() < contentLength && millis() - start <= timeout) {
+        if(client->available()) {
+          body += char(client->read());
+        }
+        else if(!client->connected()) {
+          break;
+        }
+        else {
+          delay(1);
+        }
+      }
+      return String(body);
+    }
+
+    void end() {
+      if(client && !keepAlive) {
+        client->stop();
+      }
+      keepAlive = false;
+    }
+
+    static String errorToString(int error) {
+      switch(error) {
+        case HTTPC_ERROR_CONNECTION_REFUSED:
+          return "connection refused";
+        case HTTPC_ERROR_SEND_HEADER_FAILED:
+          return "send header failed";
+        case HTTPC_ERROR_SEND_PAYLOAD_FAILED:
+          return "send payload failed";
+        case HTTPC_ERROR_NOT_CONNECTED:
+          return "not connected";
+        case HTTPC_ERROR_CONNECTION_LOST:
+          return "connection lost";
+        case HTTPC_ERROR_READ_TIMEOUT:
+          return "read Timeout";
+        default:
+          return String();
+      }
+    }
+};
@@ -0,0 +1,31 @@
+#pragma once
+/*************************************************************
+  The part of the WiFi library the host tests need.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include "WiFiClient.h"
+
+//===========================================================
+// Data Types
+
+/**
+ * The WiFi station. Resolves host names with the resolver of the host.
+ */
+struct HostWiFi {
+  int hostByName(const char* host, IPAddress& address) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    addrinfo* result = nullptr;
+    if(getaddrinfo(host, nullptr, &hints, &result) != 0 || !result) {
+      return 0;
+    }
+    address = IPAddress(reinterpret_cast<sockaddr_in*>(result->ai_addr)->sin_addr.s_addr);
+    freeaddrinfo(result);
+    return 1;
+  }
+};
+
+inline HostWiFi WiFi;
@@ -0,0 +1,140 @@
+#pragma once
+/*************************************************************
+  A WiFiClient on top of a POSIX TCP socket for the host tests.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+//===========================================================
+// Data Types
+
+/**
+ * A TCP connection. Host names are resolved to IPv4 addresses.
+ * The reading and writing methods are virtual like the ones of the Arduino core,
+ * so the HTTP client can use a TLS connection through a reference to the base class.
+ */
+class WiFiClient {
+  protected:
+    int fd = -1;
+
+    /**
+     * Gives the number of received bytes of the socket.
+     */
+    int pendingBytes() const {
+      int count = 0;
+      if(fd < 0 || ioctl(fd, FIONREAD, &count) != 0) {
+        return 0;
+      }
+      return count;
+    }
+
+    /**
+     * Checks whether the socket is still open.
+     */
+    bool socketOpen() const {
+      if(fd < 0) {
+        return false;
+      }
+      if(pendingBytes()) {
+        return true;
+      }
+      uint8_t value;
+      ssize_t result = recv(fd, &value, 1, MSG_PEEK | MSG_DONTWAIT);
+      return result != 0 && (result > 0 || errno == EAGAIN);
+    }
+
+  public:
+    virtual ~WiFiClient() { WiFiClient::stop(); }
+
+    int connect(IPAddress ip, uint16_t port, int32_t timeout) {
+      stop();
+      sockaddr_in address = {};
+      address.sin_family = AF_INET;
+      address.sin_port = htons(port);
+      address.sin_addr.s_addr = uint32_t(ip);
+      fd = socket(AF_INET, SOCK_STREAM, 0);
+      if(fd < 0) {
+        return 0;
+      }
+      fcntl(fd, F_SETFL, O_NONBLOCK);
+      if(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        pollfd waiting = {fd, POLLOUT, 0};
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if(errno != EINPROGRESS || ::poll(&waiting, 1, timeout) != 1 ||
+           getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+          stop();
+          return 0;
+        }
+      }
+      return 1;
+    }
+
+    int connect(const char* host, uint16_t port, int32_t timeout) {
+      addrinfo hints = {};
+      hints.ai_family = AF_INET;
+      hints.ai_socktype = SOCK_STREAM;
+      addrinfo* result = nullptr;
+      if(getaddrinfo(host, nullptr, &hints, &result) != 0 || !result) {
+        return 0;
+      }
+      uint32_t address = reinterpret_cast<sockaddr_in*>(result->ai_addr)->sin_addr.s_addr;
+      freeaddrinfo(result);
+      return connect(IPAddress(address), port, timeout);
+    }
+
+    void setNoDelay(bool noDelay) {
+      int flag = noDelay;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    }
+
+    virtual size_t write(const uint8_t* data, size_t length) {
+      size_t written = 0;
+      while(fd >= 0 && written < length) {
+        ssize_t result = send(fd, data + written, length - written, MSG_NOSIGNAL);
+        if(result > 0) {
+          written += result;
+        }
+        else if(result < 0 && errno == EAGAIN) {
+          pollfd waiting = {fd, POLLOUT, 0};
+          ::poll(&waiting, 1, 100);
+        }
+        else {
+          break;
+        }
+      }
+      return written;
+    }
+
+    virtual int available() {
+      return pendingBytes();
+    }
+
+    virtual int read() {
+      uint8_t value;
+      return fd >= 0 && recv(fd, &value, 1, 0) == 1? value : -1;
+    }
+
+    virtual uint8_t connected() {
+      return socketOpen();
+    }
+
+    virtual void stop() {
+      if(fd >= 0) {
+        close(fd);
+        fd = -1;
+      }
+    }
+};
@@ -0,0 +1,181 @@
+#pragma once
+/*************************************************************
+  A WiFiClientSecure on top of OpenSSL for the host tests.
+  Follows the Arduino core: the certificate of the server is verified against the CA
+  certificate and its host name, and setPlainStart() postpones the handshake to startTLS().
+  Like the mbedtls configuration of the ESP32 it speaks TLS 1.2.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "WiFiClient.h"
+#include <memory>
+#include <string>
+#include <mbedtls/ssl.h>
+#include <openssl/err.h>
+#include <openssl/x509v3.h>
+
+//===========================================================
+// Data Types
+
+/**
+ * The TLS state of a connection, as in ssl_client.h of the Arduino core.
+ */
+struct sslclient_context {
+  mbedtls_ssl_context ssl_ctx;
+};
+
+/**
+ * A TLS connection.
+ */
+class WiFiClientSecure: public WiFiClient {
+  std::string caCert;
+  std::string hostName;
+  uint32_t handshakeTimeout = 120;
+  bool plainStart = false;
+  int peeked = -1;
+
+  /**
+   * Gives the verification of each certificate to the verify callback of the connection.
+   */
+  static int onVerify(int preverified, X509_STORE_CTX* store) {
+    SSL* ssl = static_cast<SSL*>(X509_STORE_CTX_get_ex_data(store, SSL_get_ex_data_X509_STORE_CTX_idx()));
+    mbedtls_ssl_context* context = static_cast<mbedtls_ssl_context*>(SSL_get_app_data(ssl));
+    uint32_t flags = preverified? 0 : 1;
+    if(context->verify && context->verify(context->verifyArg, nullptr, X509_STORE_CTX_get_error_depth(store), &flags) != 0) {
+      return 0;
+    }
+    return flags == 0;
+  }
+
+  /**
+   * Creates the TLS connection on the open socket.
+   */
+  bool setUp() {
+    SSL_CTX* config = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_max_proto_version(config, TLS1_2_VERSION);
+    BIO* pem = BIO_new_mem_buf(caCert.data(), caCert.size());
+    X509* ca = PEM_read_bio_X509(pem, nullptr, nullptr, nullptr);
+    BIO_free(pem);
+    if(!ca) {
+      SSL_CTX_free(config);
+      return false;
+    }
+    X509_STORE_add_cert(SSL_CTX_get_cert_store(config), ca);
+    X509_free(ca);
+    SSL* ssl = SSL_new(config);
+    SSL_CTX_free(config); //Held by the connection
+    SSL_set_fd(ssl, fd);
+    SSL_set_tlsext_host_name(ssl, hostName.c_str());
+    SSL_set1_host(ssl, hostName.c_str());
+    SSL_set_verify(ssl, SSL_VERIFY_PEER, onVerify);
+    SSL_set_app_data(ssl, &sslclient->ssl_ctx);
+    sslclient->ssl_ctx = mbedtls_ssl_context();
+    sslclient->ssl_ctx.ssl = ssl;
+    return true;
+  }
+
+  /**
+   * Does the handshake.
+   */
+  bool handshake() {
+    timeval timeout = {time_t(handshakeTimeout), 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    bool success = SSL_connect(sslclient->ssl_ctx.ssl) == 1;
+    ERR_clear_error();
+    return success;
+  }
+
+  protected:
+    std::shared_ptr<sslclient_context> sslclient = std::make_shared<sslclient_context>();
+
+  public:
+    ~WiFiClientSecure() override { WiFiClientSecure::stop(); }
+
+    void setCACert(const char* rootCA) { caCert = rootCA? rootCA : ""; }
+    void setHandshakeTimeout(unsigned long seconds) { handshakeTimeout = seconds; }
+    void setPlainStart() { plainStart = true; }
+    bool stillInPlainStart() { return plainStart; }
+
+    int connect(const char* host, uint16_t port, int32_t timeout) {
+      stop();
+      if(!WiFiClient::connect(host, port, timeout)) {
+        return 0;
+      }
+      fcntl(fd, F_SETFL, 0); //Blocking with timeouts like the Arduino core
+      hostName = host;
+      if(!setUp() || (!plainStart && !handshake())) {
+        stop();
+        return 0;
+      }
+      return 1;
+    }
+
+    int startTLS() {
+      if(!plainStart) {
+        return 1;
+      }
+      plainStart = false;
+      if(!handshake()) {
+        stop();
+        return 0;
+      }
+      return 1;
+    }
+
+    size_t write(const uint8_t* data, size_t length) override {
+      if(!sslclient->ssl_ctx.ssl || length == 0) {
+        return 0;
+      }
+      size_t written = 0;
+      return SSL_write_ex(sslclient->ssl_ctx.ssl, data, length, &written) == 1? written : 0;
+    }
+
+    int available() override {
+      SSL* ssl = sslclient->ssl_ctx.ssl;
+      if(!ssl) {
+        return 0;
+      }
+      if(peeked < 0 && SSL_pending(ssl) == 0 && pendingBytes()) {
+        //Read one byte to get the record decrypted, records may hold no data
+        uint8_t value;
+        size_t count = 0;
+        if(SSL_read_ex(ssl, &value, 1, &count) == 1 && count == 1) {
+          peeked = value;
+        }
+        ERR_clear_error();
+      }
+      return (peeked >= 0) + SSL_pending(ssl);
+    }
+
+    int read() override {
+      if(!available()) {
+        return -1;
+      }
+      if(peeked >= 0) {
+        int value = peeked;
+        peeked = -1;
+        return value;
+      }
+      uint8_t value;
+      size_t count = 0;
+      return SSL_read_ex(sslclient->ssl_ctx.ssl, &value, 1, &count) == 1? value : -1;
+    }
+
+    uint8_t connected() override {
+      return sslclient->ssl_ctx.ssl && (peeked >= 0 || SSL_pending(sslclient->ssl_ctx.ssl) || socketOpen());
+    }
+
+    void stop() override {
+      if(sslclient->ssl_ctx.ssl) {
+        //Closes without close notify like the Arduino core. OpenSSL would take the session as broken otherwise.
+        SSL_set_quiet_shutdown(sslclient->ssl_ctx.ssl, 1);
+        SSL_shutdown(sslclient->ssl_ctx.ssl);
+        SSL_free(sslclient->ssl_ctx.ssl);
+        sslclient->ssl_ctx.ssl = nullptr;
+      }
+      peeked = -1;
+      WiFiClient::stop();
+    }
+};
@@ -0,0 +1,70 @@
+#pragma once
+/*************************************************************
+  The part of the mbedtls TLS interface the sketch uses, on top of OpenSSL.
+  The sessions are OpenSSL sessions, so they are resumed by a real TLS stack.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include <cstdint>
+#include <openssl/ssl.h>
+
+//===========================================================
+// Data Types
+
+/**
+ * A certificate. Only passed to the verify callback, never looked into.
+ */
+struct mbedtls_x509_crt;
+
+/**
+ * A TLS session which can be resumed.
+ */
+struct mbedtls_ssl_session {
+  SSL_SESSION* session;
+};
+
+/**
+ * A TLS connection.
+ */
+struct mbedtls_ssl_context {
+  SSL* ssl = nullptr;
+  int (*verify)(void*, mbedtls_x509_crt*, int, uint32_t*) = nullptr; //< Called for each certificate of the server.
+  void* verifyArg = nullptr;
+};
+
+//===========================================================
+// Function implementations
+
+inline void mbedtls_ssl_session_init(mbedtls_ssl_session* session) {
+  session->session = nullptr;
+}
+
+inline void mbedtls_ssl_session_free(mbedtls_ssl_session* session) {
+  SSL_SESSION_free(session->session);
+  session->session = nullptr;
+}
+
+inline int mbedtls_ssl_get_session(const mbedtls_ssl_context* ssl, mbedtls_ssl_session* session) {
+  SSL_SESSION* current = SSL_get1_session(ssl->ssl);
+  if(!current) {
+    return -1;
+  }
+  SSL_SESSION_free(session->session);
+  session->session = current;
+  return 0;
+}
+
+inline int mbedtls_ssl_set_session(mbedtls_ssl_context* ssl, const mbedtls_ssl_session* session) {
+  return SSL_set_session(ssl->ssl, session->session) == 1? 0 : -1;
+}
+
+inline int mbedtls_ssl_close_notify(mbedtls_ssl_context* ssl) {
+  return SSL_shutdown(ssl->ssl) >= 0? 0 : -1;
+}
+
+inline void mbedtls_ssl_set_verify(mbedtls_ssl_context* ssl, int (*verify)(void*, mbedtls_x509_crt*, int, uint32_t*),
+                                   void* verifyArg) {
+  ssl->verify = verify;
+  ssl->verifyArg = verifyArg;
+}
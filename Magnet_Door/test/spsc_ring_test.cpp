@@ -0,0 +1,94 @@
+/*************************************************************
+  Host test of the single producer single consumer ring buffer.
+  A producer and a consumer thread hand over a sequence of numbers
+  through a small ring, so both of them hit a full and an empty ring often.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "host_test.h"
+#include "spsc_ring.h"
+#include <cstdint>
+#include <thread>
+
+//===========================================================
+// Definitions
+#define STRESS_ITEMS 5000000      //< Number of elements handed over by the stress test.
+
+//===========================================================
+// Static function implementations
+
+/**
+ * Checks the behaviour of a full and an empty ring within one thread.
+ */
+static void testSingleThread() {
+  SpscRing<uint32_t, 4> ring;
+  uint32_t item = 0;
+  CHECK(ring.isEmpty());
+  CHECK(!ring.pop(item));
+  CHECK(!ring.peek(item));
+  for(uint32_t i = 0; i < 4; i++) {
+    CHECK(ring.push(i));
+  }
+  CHECK(ring.size() == 4);
+  CHECK(!ring.push(4)); //full
+  CHECK(ring.peek(item) && item == 0);
+  CHECK(ring.size() == 4); //peek keeps the element
+  for(uint32_t i = 0; i < 4; i++) {
+    CHECK(ring.pop(item) && item == i);
+  }
+  CHECK(ring.isEmpty());
+
+  //Wrap around the end of the buffer several times
+  for(uint32_t i = 0; i < 10; i++) {
+    CHECK(ring.push(i) && ring.push(i + 100));
+    CHECK(ring.pop(item) && item == i);
+    CHECK(ring.pop(item) && item == i + 100);
+  }
+}
+
+/**
+ * Hands over STRESS_ITEMS numbers from a producer to a consumer thread.
+ * Every number has to arrive exactly once and in order.
+ */
+static void testStress() {
+  static SpscRing<uint64_t, 64> ring;
+  std::thread producer([]() {
+    for(uint64_t i = 0; i < STRESS_ITEMS;) {
+      if(ring.push(i)) {
+        i++;
+      }
+      else {
+        std::this_thread::yield(); //Lets the consumer run if both share a core
+      }
+    }
+  });
+
+  uint64_t expected = 0;
+  uint64_t outOfOrder = 0;
+  while(expected < STRESS_ITEMS) {
+    uint64_t item;
+    if(ring.pop(item)) {
+      if(item != expected) {
+        outOfOrder++;
+      }
+      expected = item + 1;
+    }
+    else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  CHECK(outOfOrder == 0);
+  CHECK(expected == STRESS_ITEMS);
+  CHECK(ring.isEmpty());
+}
+
+//===========================================================
+// Function implementations
+
+int main() {
+  testSingleThread();
+  testStress();
+  return TEST_RESULT();
+}
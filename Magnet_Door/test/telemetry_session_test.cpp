@@ -0,0 +1,399 @@
+/*************************************************************
+  Host test of the HTTPS path of the telemetry session.
+  Posts to a HTTPS server on the loopback interface, which runs on
+  OpenSSL with a certificate made for the test, and checks from the
+  server side which handshakes resumed the TLS session.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "host_test.h"
+#include "telemetry_session.h"
+#include <atomic>
+#include <csignal>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//===========================================================
+// Data Types
+
+/**
+ * A certificate with its key, which signs itself.
+ */
+struct TestCertificate {
+  EVP_PKEY* key = nullptr;  //< The key.
+  X509* cert = nullptr;     //< The certificate.
+  std::string pem;          //< The certificate as PEM.
+
+  /**
+   * Makes a certificate for localhost and 127.0.0.1.
+   * @param name The common name. Tells the certificates apart.
+   */
+  explicit TestCertificate(const char* name) {
+    key = EVP_EC_gen("P-256");
+    cert = X509_new();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), -3600);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME* subject = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(subject, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>(name), -1, -1, 0);
+    X509_set_issuer_name(cert, subject);
+    X509V3_CTX context;
+    X509V3_set_ctx_nodb(&context);
+    X509V3_set_ctx(&context, cert, cert, nullptr, nullptr, 0);
+    const char* extensions[][2] = {{"basicConstraints", "critical,CA:TRUE"},
+                                   {"subjectAltName", "DNS:localhost,IP:127.0.0.1"}};
+    for(auto& extension: extensions) {
+      X509_EXTENSION* added = X509V3_EXT_conf(nullptr, &context, extension[0], extension[1]);
+      X509_add_ext(cert, added, -1);
+      X509_EXTENSION_free(added);
+    }
+    X509_sign(cert, key, EVP_sha256());
+    BIO* out = BIO_new(BIO_s_mem());
+    PEM_write_bio_X509(out, cert);
+    char* data;
+    long length = BIO_get_mem_data(out, &data);
+    pem.assign(data, length);
+    BIO_free(out);
+  }
+
+  ~TestCertificate() {
+    X509_free(cert);
+    EVP_PKEY_free(key);
+  }
+};
+
+/**
+ * A HTTPS server which serves one connection at a time on an ephemeral port.
+ * Answers every request with 200 and keeps the connection alive.
+ */
+class TestServer {
+  SSL_CTX* context;
+  int listener = -1;
+  uint16_t port = 0;
+  std::thread thread;
+  std::atomic<bool> stopping{false};
+  std::mutex lock;
+  std::vector<bool> handshakes;
+  std::vector<std::string> bodies;
+  int failedHandshakes = 0;
+
+  /**
+   * Reads one byte of the connection. Gives up once the server stops or the client closed.
+   */
+  bool readByte(SSL* ssl, int socket, char& value) {
+    while(!SSL_pending(ssl)) {
+      pollfd waiting = {socket, POLLIN, 0};
+      if(stopping) {
+        return false;
+      }
+      if(::poll(&waiting, 1, 20) == 1) {
+        break;
+      }
+    }
+    size_t count = 0;
+    return SSL_read_ex(ssl, &value, 1, &count) == 1;
+  }
+
+  /**
+   * Answers the requests of a connection until the client closes it.
+   */
+  void serve(SSL* ssl, int socket) {
+    while(true) {
+      std::string head;
+      char value;
+      while(head.size() < 4 || head.compare(head.size() - 4, 4, "\r\n\r\n") != 0) {
+        if(!readByte(ssl, socket, value)) {
+          return;
+        }
+        head += value;
+      }
+      size_t lengthStart = head.find("Content-Length: ");
+      size_t length = lengthStart == std::string::npos? 0 : atol(head.c_str() + lengthStart + 16);
+      std::string body;
+      while(body.size() < length) {
+        if(!readByte(ssl, socket, value)) {
+          return;
+        }
+        body += value;
+      }
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        bodies.push_back(body);
+      }
+      const char response[] = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: keep-alive\r\n\r\nok";
+      size_t written;
+      if(SSL_write_ex(ssl, response, sizeof(response) - 1, &written) != 1) {
+        return;
+      }
+    }
+  }
+
+  /**
+   * Accepts connections until the server stops.
+   */
+  void run() {
+    while(!stopping) {
+      pollfd waiting = {listener, POLLIN, 0};
+      if(::poll(&waiting, 1, 20) != 1) {
+        continue;
+      }
+      int socket = accept(listener, nullptr, nullptr);
+      if(socket < 0) {
+        continue;
+      }
+      timeval timeout = {2, 0};
+      setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+      SSL* ssl = SSL_new(context);
+      SSL_set_fd(ssl, socket);
+      bool accepted = SSL_accept(ssl) == 1;
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        if(accepted) {
+          handshakes.push_back(SSL_session_reused(ssl));
+        }
+        else {
+          failedHandshakes++;
+        }
+      }
+      if(accepted) {
+        serve(ssl, socket);
+        SSL_shutdown(ssl);
+      }
+      SSL_free(ssl);
+      close(socket);
+    }
+  }
+
+  public:
+    /**
+     * Starts a server.
+     * @param certificate The certificate of the server.
+     * @param tickets If the server issues session tickets.
+     * @param cache If the server keeps sessions by id.
+     */
+    TestServer(const TestCertificate& certificate, bool tickets, bool cache) {
+      context = SSL_CTX_new(TLS_server_method());
+      SSL_CTX_use_certificate(context, certificate.cert);
+      SSL_CTX_use_PrivateKey(context, certificate.key);
+      SSL_CTX_set_session_id_context(context, reinterpret_cast<const unsigned char*>("test"), 4);
+      if(!tickets) {
+        SSL_CTX_set_options(context, SSL_OP_NO_TICKET);
+      }
+      if(!cache) {
+        SSL_CTX_set_session_cache_mode(context, SSL_SESS_CACHE_OFF);
+      }
+
+      listener = socket(AF_INET, SOCK_STREAM, 0);
+      int reuse = 1;
+      setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+      sockaddr_in address = {};
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      socklen_t length = sizeof(address);
+      bind(listener, reinterpret_cast<sockaddr*>(&address), length);
+      listen(listener, 1);
+      getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+      port = ntohs(address.sin_port);
+      thread = std::thread(&TestServer::run, this);
+    }
+
+    ~TestServer() {
+      stopping = true;
+      thread.join();
+      close(listener);
+      SSL_CTX_free(context);
+    }
+
+    /**
+     * Gives the port of the server.
+     */
+    uint16_t getPort() const {
+      return port;
+    }
+
+    /**
+     * Gives a url of the server.
+     * @param host The host, "localhost" or "127.0.0.1".
+     * @param path The path.
+     */
+    String getUrl(const char* host, const char* path = "/live-data/") const {
+      return String("https://" + std::string(host) + ":" + std::to_string(port) + path);
+    }
+
+    /**
+     * Gives for each successful handshake whether it resumed a session.
+     */
+    std::vector<bool> getHandshakes() {
+      std::lock_guard<std::mutex> guard(lock);
+      return handshakes;
+    }
+
+    /**
+     * Waits until the server finished a number of handshakes, since a client may be done with its part first.
+     * @param count The number of successful and failed handshakes.
+     * @return
+     *  -true: If the server finished them.
+     *  -false: If it did not within a second.
+     */
+    bool waitForHandshakes(size_t count) {
+      for(uint16_t i = 0; i < 1000; i++) {
+        {
+          std::lock_guard<std::mutex> guard(lock);
+          if(handshakes.size() + failedHandshakes >= count) {
+            return true;
+          }
+        }
+        delay(1);
+      }
+      return false;
+    }
+
+    /**
+     * Gives the number of failed handshakes.
+     */
+    int getFailedHandshakes() {
+      std::lock_guard<std::mutex> guard(lock);
+      return failedHandshakes;
+    }
+
+    /**
+     * Gives the bodies of the received requests.
+     */
+    std::vector<std::string> getBodies() {
+      std::lock_guard<std::mutex> guard(lock);
+      return bodies;
+    }
+};
+
+//===========================================================
+// Static data
+
+static TestCertificate serverCertificate("UBIS test server");
+static TestCertificate otherCertificate("UBIS other CA");
+
+//===========================================================
+// Tests
+
+/**
+ * Checks that consecutive posts share one connection with one full handshake.
+ */
+static void testKeepAlive() {
+  TestServer server(serverCertificate, true, true);
+  TelemetrySession session;
+  session.setRootCA(serverCertificate.pem.c_str());
+  session.setUrl(server.getUrl("localhost"));
+
+  CHECK(session.post("first", "application/json") == 200);
+  CHECK(session.publish("telemetry", "second", "application/json"));
+  CHECK(session.getLastResult() == "HTTP 200");
+  CHECK(server.getHandshakes() == std::vector<bool>({false}));
+  CHECK(server.getBodies() == std::vector<std::string>({"first", "second"}));
+}
+
+/**
+ * Checks that a new connection resumes the session by ticket, by session id
+ * and not at all if the server keeps no sessions.
+ */
+static void testResumption() {
+  const bool variants[][2] = {{true, true}, {true, false}, {false, true}, {false, false}};
+  for(auto& variant: variants) {
+    bool tickets = variant[0];
+    bool cache = variant[1];
+    TestServer server(serverCertificate, tickets, cache);
+    TelemetrySession session;
+    session.setRootCA(serverCertificate.pem.c_str());
+    session.setUrl(server.getUrl("localhost"));
+
+    for(uint8_t i = 0; i < 3; i++) {
+      CHECK(session.post("data", "application/json") == 200);
+      session.close();
+    }
+    bool resumable = tickets || cache;
+    CHECK(server.getHandshakes() == std::vector<bool>({false, resumable, resumable}));
+    CHECK(server.getBodies().size() == 3);
+  }
+}
+
+/**
+ * Checks that the session is kept for a new path of the same server and forgotten for another host.
+ */
+static void testUrlChange() {
+  TestServer server(serverCertificate, true, true);
+  TelemetrySession session;
+  session.setRootCA(serverCertificate.pem.c_str());
+  session.setUrl(server.getUrl("localhost"));
+  CHECK(session.post("data", "application/json") == 200);
+
+  session.setUrl(server.getUrl("localhost", "/other/"));
+  CHECK(session.post("data", "application/json") == 200);
+  session.setUrl(server.getUrl("127.0.0.1"));
+  CHECK(session.post("data", "application/json") == 200);
+  CHECK(server.getHandshakes() == std::vector<bool>({false, true, false}));
+}
+
+/**
+ * Checks that nothing is sent without root CA or to a server with a certificate of another CA.
+ */
+static void testVerification() {
+  TestServer server(serverCertificate, true, true);
+  TelemetrySession session;
+  session.setUrl(server.getUrl("localhost"));
+  CHECK(session.post("data", "application/json") == HTTP_ERROR_NO_ROOT_CA);
+  CHECK(!session.publish("telemetry", "data", "application/json"));
+  CHECK(session.getLastResult() == "no root CA");
+
+  session.setRootCA(otherCertificate.pem.c_str());
+  CHECK(session.post("data", "application/json") < 0);
+
+  session.setRootCA(serverCertificate.pem.c_str());
+  CHECK(session.post("data", "application/json") == 200);
+  CHECK(server.getBodies() == std::vector<std::string>({"data"}));
+  CHECK(server.getFailedHandshakes() == 1);
+}
+
+/**
+ * Checks the client directly: it tells a resumed handshake apart and forgets its session.
+ */
+static void testClient() {
+  TestServer server(serverCertificate, true, true);
+  ResumableTlsClient client;
+  client.setCACert(serverCertificate.pem.c_str());
+  CHECK(client.connect("localhost", server.getPort(), 1000));
+  CHECK(!client.isResumed());
+  client.stop();
+  CHECK(client.connect("localhost", server.getPort(), 1000));
+  CHECK(client.isResumed());
+  client.stop();
+  client.forgetSession();
+  CHECK(client.connect("localhost", server.getPort(), 1000));
+  CHECK(!client.isResumed());
+  client.stop();
+
+  //A new CA certificate drops the session, which would skip the verification
+  client.setCACert(otherCertificate.pem.c_str());
+  CHECK(!client.connect("localhost", server.getPort(), 1000));
+  client.setCACert(serverCertificate.pem.c_str());
+  CHECK(client.connect("localhost", server.getPort(), 1000));
+  CHECK(!client.isResumed());
+  client.stop();
+  CHECK(server.waitForHandshakes(5));
+  CHECK(server.getHandshakes() == std::vector<bool>({false, true, false, false}));
+  CHECK(server.getFailedHandshakes() == 1);
+}
+
+//===========================================================
+// Main
+
+int main() {
+  signal(SIGPIPE, SIG_IGN); //A write to a closed connection fails instead
+  testKeepAlive();
+  testResumption();
+  testUrlChange();
+  testVerification();
+  testClient();
+  return TEST_RESULT();
+}
@@ -0,0 +1,63 @@
+/*************************************************************
+  Host report of the sizes of the wire formats.
+  Serializes a single record and a default telemetry batch as json,
+  MessagePack and CBOR and prints the bytes per record of each format.
+  The CBOR encoder is the one of the sketch. Json and MessagePack are
+  written by the ArduinoJson shim of the host tests, which follows the
+  output rules of ArduinoJson, so their sizes match the device.
+  The shim says nothing about the speed of ArduinoJson, so the times
+  are measured on the device by the serializeTelemetry profile point.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "telemetry_batcher.h"
+#include <cstdio>
+
+//===========================================================
+// Static function implementations
+
+/**
+ * Prints the bytes and the bytes per record of a wire format.
+ * @param batcher The batcher holding the records.
+ * @param format The wire format.
+ */
+static void measure(const TelemetryBatcher& batcher, WireFormat format) {
+  String out;
+  uint8_t records = batcher.serialize("Room 1", format, out);
+  std::printf("%-8s %6u bytes %6.1f bytes/record\n",
+              wireFormatName(format), out.length(), (double)out.length() / records);
+}
+
+/**
+ * Prints the sizes of all wire formats.
+ * @param batcher The batcher holding the records.
+ */
+static void measureAll(const TelemetryBatcher& batcher) {
+  std::printf("%u record(s) per batch\n", batcher.getCount());
+  measure(batcher, WireFormat::json);
+  measure(batcher, WireFormat::msgpack);
+  measure(batcher, WireFormat::cbor);
+}
+
+//===========================================================
+// Function implementations
+
+int main() {
+  //A single event, as uploaded right away in the on change mode
+  TelemetryBatcher single;
+  single.add({36000000, "personEntered", true, 12, false, 21.5f, TelemetryMode::onChange});
+  measureAll(single);
+
+  //A default batch of periodic samples and events, as recorded over a day
+  TelemetryBatcher batcher;
+  uint32_t timestamp = 36000000;
+  for(uint8_t i = 0; i < TELEMETRY_BATCH_SIZE_DEFAULT; i++) {
+    bool event = i % 3 == 0;
+    batcher.add({timestamp, event? "personEntered" : nullptr, i % 2 == 0, static_cast<uint16_t>(12 + i),
+                 false, 21.5f + 0.1f * i, event? TelemetryMode::onChange : TelemetryMode::periodic});
+    timestamp += 5000;
+  }
+  measureAll(batcher);
+  return 0;
+}
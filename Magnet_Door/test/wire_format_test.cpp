@@ -0,0 +1,270 @@
+/*************************************************************
+  Host test of the CBOR wire format.
+  Decodes what the sketch encodes with an independent decoder
+  and compares it with the document, and checks the encoding
+  of known values byte by byte.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "host_test.h"
+#include "telemetry_batcher.h"
+#include <string>
+
+//===========================================================
+// Static function implementations
+
+/**
+ * Decodes one CBOR data item into a json value.
+ * Only the items the sketch writes are known: integers, text strings, arrays, maps,
+ * false, true, null and single precision floats.
+ * @param[in,out] data The next byte to read. Moved behind the item.
+ * @param end The end of the data.
+ * @param value The json value to write to.
+ * @return
+ *  -true: On success.
+ *  -false: If the data is truncated or holds an unknown item.
+ */
+static bool decodeCbor(const uint8_t*& data, const uint8_t* end, JsonVariant value) {
+  if(data >= end) {
+    return false;
+  }
+  uint8_t major = *data >> 5;
+  uint8_t info = *data & 0x1F;
+  data++;
+  uint64_t argument = info;
+  if(info >= 24) {
+    if(info > 27) {
+      return false;
+    }
+    uint8_t bytes = 1 << (info - 24);
+    if(end - data < bytes) {
+      return false;
+    }
+    argument = 0;
+    for(uint8_t i = 0; i < bytes; i++) { //Big endian
+      argument = argument << 8 | *data++;
+    }
+  }
+  switch(major) {
+    case 0:
+      value = argument;
+      return true;
+    case 1:
+      value = -1 - static_cast<int64_t>(argument);
+      return true;
+    case 3: {
+      if(static_cast<uint64_t>(end - data) < argument) {
+        return false;
+      }
+      value = String(std::string(reinterpret_cast<const char*>(data), argument));
+      data += argument;
+      return true;
+    }
+    case 4: {
+      JsonArray array = value.to<JsonArray>();
+      for(uint64_t i = 0; i < argument; i++) {
+        if(!decodeCbor(data, end, array.add<JsonVariant>())) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case 5: {
+      JsonObject object = value.to<JsonObject>();
+      for(uint64_t i = 0; i < argument; i++) {
+        JsonDocument key;
+        if(!decodeCbor(data, end, key.getVariant()) || !key.as<JsonVariantConst>().is<JsonString>()) {
+          return false;
+        }
+        if(!decodeCbor(data, end, object[key.as<const char*>()])) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case 7:
+      switch(info) {
+        case 20:
+          value = false;
+          return true;
+        case 21:
+          value = true;
+          return true;
+        case 22:
+          value = nullptr;
+          return true;
+        case 26: {
+          uint32_t bits = argument;
+          float number;
+          memcpy(&number, &bits, sizeof(number));
+          value = number;
+          return true;
+        }
+        default:
+          return false;
+      }
+    default:
+      return false;
+  }
+}
+
+/**
+ * Decodes CBOR data which has to hold exactly one data item.
+ * @param data The CBOR data.
+ * @param[out] doc The decoded document.
+ * @return
+ *  -true: On success.
+ *  -false: If the data is not one valid data item.
+ */
+static bool decodeCbor(const String& data, JsonDocument& doc) {
+  const uint8_t* begin = reinterpret_cast<const uint8_t*>(data.c_str());
+  const uint8_t* end = begin + data.length();
+  return decodeCbor(begin, end, doc.getVariant()) && begin == end;
+}
+
+/**
+ * Gives the bytes of data as hex text.
+ * @param data The data.
+ * @return The hex text, e.g. "a16161".
+ */
+static std::string toHex(const String& data) {
+  static const char digits[] = "0123456789abcdef";
+  std::string hex;
+  for(unsigned int i = 0; i < data.length(); i++) {
+    uint8_t byte = data[i];
+    hex += digits[byte >> 4];
+    hex += digits[byte & 0x0F];
+  }
+  return hex;
+}
+
+/**
+ * Encodes a document as CBOR, decodes it again and checks that the decoded document is the same.
+ * @param doc The document.
+ */
+static void checkRoundTrip(const JsonDocument& doc) {
+  String cbor;
+  size_t length = serializeWireFormat(doc, WireFormat::cbor, cbor);
+  CHECK(length == cbor.length());
+  JsonDocument decoded;
+  CHECK(decodeCbor(cbor, decoded));
+  String expected;
+  String actual;
+  serializeJson(doc, expected);
+  serializeJson(decoded, actual);
+  CHECK(actual == expected);
+}
+
+//===========================================================
+// Tests
+
+/**
+ * Checks the encoding against values worked out by hand from RFC 8949.
+ */
+static void testKnownEncoding() {
+  JsonDocument doc;
+  JsonArray values = doc["a"].to<JsonArray>();
+  values.add(1);
+  values.add(-1);
+  values.add(1000000);
+  values.add(true);
+  values.add(nullptr);
+  values.add(1.5f);
+  String cbor;
+  serializeWireFormat(doc, WireFormat::cbor, cbor);
+  CHECK(toHex(cbor) == "a161618601201a000f4240f5f6fa3fc00000");
+}
+
+/**
+ * Checks every length of the item head on both sides of its limits.
+ */
+static void testHeadLimits() {
+  JsonDocument doc;
+  JsonArray values = doc.to<JsonArray>();
+  const uint64_t unsignedLimits[] = {0, 23, 24, 255, 256, 65535, 65536, 4294967295ULL, 4294967296ULL, UINT64_MAX};
+  for(uint64_t value: unsignedLimits) {
+    values.add(value);
+  }
+  const int64_t signedLimits[] = {-1, -24, -25, -256, -257, -65536, -65537, -4294967296LL, -4294967297LL, INT64_MIN};
+  for(int64_t value: signedLimits) {
+    values.add(value);
+  }
+  values.add(false);
+  values.add("");
+  values.add(std::string(23, 'x').c_str());
+  values.add(std::string(24, 'x').c_str());
+  values.add(std::string(300, 'x').c_str());
+  values.add(-0.1f);
+  checkRoundTrip(doc);
+
+  String cbor;
+  serializeWireFormat(doc, WireFormat::cbor, cbor);
+  CHECK(toHex(cbor).compare(0, 22, "981a" "00" "17" "1818" "18ff" "190100") == 0); //Array of 26 items, then 0, 23, 24, 255, 256
+}
+
+/**
+ * Checks a batch of telemetry records as the sketch uploads it.
+ */
+static void testTelemetryBatch() {
+  TelemetryBatcher batcher;
+  batcher.add({0, nullptr, false, 0, false, 21.5f, TelemetryMode::periodic});
+  batcher.add({70000, "doorOpened", true, 300, false, -3.25f, TelemetryMode::onChange});
+  batcher.add({UINT32_MAX, "roomFull", true, UINT16_MAX, true, 19.1f, TelemetryMode::onChange});
+
+  String cbor;
+  CHECK(batcher.serialize("Room 1", WireFormat::cbor, cbor) == 3);
+  JsonDocument decoded;
+  CHECK(decodeCbor(cbor, decoded));
+  CHECK(decoded.as<JsonArrayConst>().size() == 3);
+
+  JsonDocument doc;
+  JsonArray batch = doc.to<JsonArray>();
+  for(uint8_t i = 0; i < batcher.getCount(); i++) {
+    serializeTelemetryRecord(batch, "Room 1", batcher.getRecord(i));
+  }
+  checkRoundTrip(doc);
+  String json;
+  String decodedJson;
+  serializeJson(doc, json);
+  serializeJson(decoded, decodedJson);
+  CHECK(decodedJson == json);
+}
+
+/**
+ * Checks the bytes of a record as the server gets them.
+ * predictions/tests.py decodes the same bytes with cbor2.
+ */
+static void testServerRecord() {
+  TelemetryBatcher batcher;
+  batcher.add({70000, "personEntered", true, 12, false, 21.5f, TelemetryMode::onChange});
+  String cbor;
+  batcher.serialize("Room 1", WireFormat::cbor, cbor);
+  CHECK(toHex(cbor) == "81a864726f6f6d66526f6f6d2031686c6f675f74696d651a00011170656576656e746d706572736f6e456e74657265646a646f6f725f7374617465f56c70656f706c655f636f756e740c69726f6f6d5f66756c6cf46b74656d7065726174757265fa41ac0000646d6f6465666368616e6765");
+}
+
+/**
+ * Checks that truncated data is not taken as a valid document.
+ */
+static void testTruncated() {
+  TelemetryBatcher batcher;
+  batcher.add({1000, nullptr, false, 5, false, 20.0f, TelemetryMode::periodic});
+  String cbor;
+  batcher.serialize("Room 1", WireFormat::cbor, cbor);
+  for(unsigned int length = 0; length < cbor.length(); length++) {
+    JsonDocument decoded;
+    CHECK(!decodeCbor(cbor.substring(0, length), decoded));
+  }
+}
+
+//===========================================================
+// Main
+
+int main() {
+  testKnownEncoding();
+  testHeadLimits();
+  testTelemetryBatch();
+  testServerRecord();
+  testTruncated();
+  return TEST_RESULT();
+}
@@ -0,0 +1,81 @@
+#pragma once
+/*************************************************************
+  The interface of the transports the data is sent to the servers over.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+
+//===========================================================
+// Data Types
+
+/**
+ * A way to send messages to a server.
+ * A transport is connected with connect() and kept alive by calling poll() regularly.
+ * Neither of them waits for the server. publish() may wait for the server to accept the message.
+ * All methods are called by one task.
+ */
+class Transport {
+  public:
+    virtual ~Transport() {}
+
+    /**
+     * Gives the name of the transport.
+     * @return The name.
+     */
+    virtual const char* getName() const = 0;
+
+    /**
+     * Starts to connect to the server, if not connected or connecting yet.
+     * @return
+     *  -true: If the transport is connected or connecting.
+     *  -false: If connecting could not be started.
+     */
+    virtual bool connect() = 0;
+
+    /**
+     * Sends a message to the server.
+     * @param topic What the message is about, e.g. the name of an event.
+     * @param payload The message. May be binary.
+     * @param contentType The content type of the payload.
+     * @return
+     *  -true: If the server accepted the message.
+     *  -false: otherwise.
+     */
+    virtual bool publish(const char* topic, const String& payload, const char* contentType) = 0;
+
+    /**
+     * Processes the traffic from the server and keeps the connection alive.
+     */
+    virtual void poll() = 0;
+
+    /**
+     * Checks whether the transport can publish.
+     * @return
+     *  -true: If yes.
+     *  -false: otherwise.
+     */
+    virtual bool isConnected() = 0;
+
+    /**
+     * Closes the connection to the server.
+     */
+    virtual void disconnect() = 0;
+
+    /**
+     * Gives a description of the result of the last publish.
+     * @return The description.
+     */
+    virtual String getLastResult() const = 0;
+
+    /**
+     * Prints the message counters and round trip times over serial.
+     */
+    virtual void printStats() const = 0;
+
+    /**
+     * Resets the message counters and round trip times.
+     */
+    virtual void resetStats() = 0;
+};
@@ -0,0 +1,212 @@
+/*************************************************************
+  The implementation of the wire formats telemetry can be uploaded in.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "wire_format.h"
+
+//===========================================================
+// Static function implementations
+
+/**
+ * Appends the head of a CBOR data item.
+ * The argument is stored in the shortest possible form.
+ * @param[out] out The serialized data.
+ * @param major The major type.
+ * @param value The argument. The value, length or number of elements.
+ */
+static void writeCborHead(String& out, uint8_t major, uint64_t value) {
+  uint8_t buffer[9];
+  uint8_t length;
+  if(value < 24) {
+    buffer[0] = major << 5 | value;
+    length = 1;
+  }
+  else {
+    uint8_t bytes;
+    if(value <= 0xFF) {
+      buffer[0] = major << 5 | 24;
+      bytes = 1;
+    }
+    else if(value <= 0xFFFF) {
+      buffer[0] = major << 5 | 25;
+      bytes = 2;
+    }
+    else if(value <= 0xFFFFFFFF) {
+      buffer[0] = major << 5 | 26;
+      bytes = 4;
+    }
+    else {
+      buffer[0] = major << 5 | 27;
+      bytes = 8;
+    }
+    for(uint8_t i = 0; i < bytes; i++) { //Big endian
+      buffer[bytes - i] = value >> (8 * i);
+    }
+    length = bytes + 1;
+  }
+  out.concat(reinterpret_cast<const char*>(buffer), length);
+}
+
+/**
+ * Appends a text string as CBOR data item.
+ * @param[out] out The serialized data.
+ * @param text The text.
+ * @param length The length of the text in bytes.
+ */
+static void writeCborText(String& out, const char* text, size_t length) {
+  writeCborHead(out, 3, length);
+  out.concat(text, length);
+}
+
+/**
+ * Appends a json value as CBOR data item. Objects and arrays are written recursively.
+ * Floating point numbers are written in single precision, which is all the sensors deliver.
+ * @param[out] out The serialized data.
+ * @param value The json value.
+ */
+static void writeCbor(String& out, JsonVariantConst value) {
+  if(value.is<JsonObjectConst>()) {
+    JsonObjectConst object = value.as<JsonObjectConst>();
+    writeCborHead(out, 5, object.size());
+    for(JsonPairConst pair : object) {
+      writeCborText(out, pair.key().c_str(), pair.key().size());
+      writeCbor(out, pair.value());
+    }
+  }
+  else if(value.is<JsonArrayConst>()) {
+    JsonArrayConst array = value.as<JsonArrayConst>();
+    writeCborHead(out, 4, array.size());
+    for(JsonVariantConst element : array) {
+      writeCbor(out, element);
+    }
+  }
+  else if(value.is<bool>()) {
+    out.concat(value.as<bool>()? "\xF5" : "\xF4", 1);
+  }
+  else if(value.is<uint64_t>()) {
+    writeCborHead(out, 0, value.as<uint64_t>());
+  }
+  else if(value.is<int64_t>()) {
+    writeCborHead(out, 1, -1 - value.as<int64_t>()); //Negative integers are stored as -1 - n
+  }
+  else if(value.is<float>()) {
+    float number = value.as<float>();
+    uint32_t bits;
+    memcpy(&bits, &number, sizeof(bits));
+    uint8_t buffer[5] = {0xFA, uint8_t(bits >> 24), uint8_t(bits >> 16), uint8_t(bits >> 8), uint8_t(bits)};
+    out.concat(reinterpret_cast<const char*>(buffer), sizeof(buffer));
+  }
+  else if(value.is<JsonString>()) {
+    JsonString text = value.as<JsonString>();
+    writeCborText(out, text.c_str(), text.size());
+  }
+  else {
+    out.concat("\xF6", 1); //null
+  }
+}
+
+//===========================================================
+// Function implementations
+
+/**
+ * Gives the name of a wire format as used in the server url.
+ * @param format The wire format.
+ * @return The name.
+ */
+const char* wireFormatName(WireFormat format) {
+  switch(format) {
+    case WireFormat::msgpack:
+      return "msgpack";
+    case WireFormat::cbor:
+      return "cbor";
+    default:
+      return "json";
+  }
+}
+
+/**
+ * Gives the HTTP content type of a wire format.
+ * @param format The wire format.
+ * @return The content type.
+ */
+const char* wireFormatContentType(WireFormat format) {
+  switch(format) {
+    case WireFormat::msgpack:
+      return "application/msgpack";
+    case WireFormat::cbor:
+      return "application/cbor";
+    default:
+      return "application/json";
+  }
+}
+
+/**
+ * Parses the name of a wire format.
+ * @param name The name. One of "json", "msgpack" or "cbor".
+ * @param[out] format The wire format.
+ * @return
+ *  -true: On success.
+ *  -false: If the name is unknown.
+ */
+bool parseWireFormat(const String& name, WireFormat& format) {
+  if(name == "json") {
+    format = WireFormat::json;
+  }
+  else if(name == "msgpack") {
+    format = WireFormat::msgpack;
+  }
+  else if(name == "cbor") {
+    format = WireFormat::cbor;
+  }
+  else {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Splits a server url into the url the data is posted to and the wire format.
+ * The wire format is appended to the url after WIRE_FORMAT_SEPARATOR. Json is used if there is none.
+ * @param url The configured server url.
+ * @param[out] target The url without the wire format.
+ * @param[out] format The wire format.
+ * @return
+ *  -true: On success.
+ *  -false: If the wire format is unknown. Json is given back then.
+ */
+bool splitServerUrl(const String& url, String& target, WireFormat& format) {
+  format = WireFormat::json;
+  int separator = url.lastIndexOf(WIRE_FORMAT_SEPARATOR);
+  if(separator < 0) {
+    target = url;
+    return true;
+  }
+  target = url.substring(0, separator);
+  if(!parseWireFormat(url.substring(separator + 1), format)) {
+    format = WireFormat::json;
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Serializes a json document in a wire format.
+ * @param doc The document.
+ * @param format The wire format.
+ * @param[out] out The serialized data. May contain zero bytes for the binary formats.
+ * @return The number of bytes written.
+ */
+size_t serializeWireFormat(const JsonDocument& doc, WireFormat format, String& out) {
+  out = "";
+  switch(format) {
+    case WireFormat::msgpack:
+      return serializeMsgPack(doc, out);
+    case WireFormat::cbor:
+      writeCbor(out, doc.as<JsonVariantConst>());
+      return out.length();
+    default:
+      return serializeJson(doc, out);
+  }
+}
@@ -0,0 +1,76 @@
+#pragma once
+/*************************************************************
+  The wire formats telemetry can be uploaded in.
+*************************************************************/
+
+//===========================================================
+// included dependencies
+#include "Arduino.h"
+#include <ArduinoJson.h>
+
+//===========================================================
+// Definitions
+#define WIRE_FORMAT_SEPARATOR '#'   //< Separates the wire format from the server url, e.g. "http://host/live-data/#msgpack".
+
+//===========================================================
+// Data Types
+
+/**
+ * The encodings telemetry can be uploaded in.
+ * All of them carry the same document. The binary formats are about a quarter smaller than json,
+ * since the keys repeated in every record dominate, and need no number formatting on the device.
+ * test/wire_format_bench measures both.
+ */
+enum class WireFormat: uint8_t {
+  json,                             //< Json text. The default.
+  msgpack,                          //< MessagePack.
+  cbor                              //< CBOR (RFC 8949).
+};
+
+//===========================================================
+// Function Declarations
+
+/**
+ * Gives the name of a wire format as used in the server url.
+ * @param format The wire format.
+ * @return The name.
+ */
+const char* wireFormatName(WireFormat format);
+
+/**
+ * Gives the HTTP content type of a wire format.
+ * @param format The wire format.
+ * @return The content type.
+ */
+const char* wireFormatContentType(WireFormat format);
+
+/**
+ * Parses the name of a wire format.
+ * @param name The name. One of "json", "msgpack" or "cbor".
+ * @param[out] format The wire format.
+ * @return
+ *  -true: On success.
+ *  -false: If the name is unknown.
+ */
+bool parseWireFormat(const String& name, WireFormat& format);
+
+/**
+ * Splits a server url into the url the data is posted to and the wire format.
+ * The wire format is appended to the url after WIRE_FORMAT_SEPARATOR. Json is used if there is none.
+ * @param url The configured server url.
+ * @param[out] target The url without the wire format.
+ * @param[out] format The wire format.
+ * @return
+ *  -true: On success.
+ *  -false: If the wire format is unknown. Json is given back then.
+ */
+bool splitServerUrl(const String& url, String& target, WireFormat& format);
+
+/**
+ * Serializes a json document in a wire format.
+ * @param doc The document.
+ * @param format The wire format.
+ * @param[out] out The serialized data. May contain zero bytes for the binary formats.
+ * @return The number of bytes written.
+ */
+size_t serializeWireFormat(const JsonDocument& doc, WireFormat format, String& out);
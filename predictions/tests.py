@@ -1,3 +1,125 @@
+import json
+import os
+import tempfile
+from unittest import mock
+
 from django.test import TestCase
 
-# Create your tests here.
+from . import views
+
+
+def record(log_time, people_count, replayed=False):
+    data = {
+        'room': 'Room 1',
+        'log_time': log_time,
+        'door_state': 1,
+        'people_count': people_count,
+        'room_full': 0,
+        'temperature': 21.5,
+        'mode': 'periodic',
+    }
+    if replayed:
+        data['boot'] = 1
+        data['replayed'] = True
+    return data
+
+
+class StorageTestCase(TestCase):
+    def setUp(self):
+        # Keep the files of the running server untouched
+        self.directory = tempfile.TemporaryDirectory()
+        self.current_path = os.path.join(self.directory.name, 'esp_data.json')
+        self.history_path = os.path.join(self.directory.name, 'esp_history.jsonl')
+        patches = [
+            mock.patch.object(views, 'CURRENT_STATE_PATH', self.current_path),
+            mock.patch.object(views, 'HISTORY_PATH', self.history_path),
+        ]
+        for patch in patches:
+            patch.start()
+            self.addCleanup(patch.stop)
+        self.addCleanup(self.directory.cleanup)
+
+
+class LiveDataTests(StorageTestCase):
+    def post(self, records):
+        return self.client.post('/live-data/', json.dumps(records), content_type='application/json')
+
+    def read_history(self):
+        with open(self.history_path) as history_file:
+            return [json.loads(line) for line in history_file]
+
+    def read_current(self):
+        with open(self.current_path) as json_file:
+            return json.load(json_file)
+
+    def test_live_batch_is_stored(self):
+        response = self.post([record(100, 3), record(110, 4)])
+
+        self.assertEqual(response.status_code, 200)
+        self.assertEqual(response.json()['records'], 2)
+        self.assertEqual(self.read_history(), [record(100, 3), record(110, 4)])
+        self.assertEqual(self.read_current(), record(110, 4))
+
+    def test_replayed_batch_is_stored_without_changing_the_current_state(self):
+        self.post([record(500, 7)])
+        response = self.post([record(200, 1, replayed=True), record(210, 2, replayed=True)])
+
+        self.assertEqual(response.status_code, 200)
+        self.assertEqual(self.read_history(),
+                         [record(500, 7), record(200, 1, replayed=True), record(210, 2, replayed=True)])
+        self.assertEqual(self.read_current(), record(500, 7))
+
+    def test_replayed_batch_alone_creates_no_current_state(self):
+        self.post([record(200, 1, replayed=True)])
+
+        self.assertEqual(len(self.read_history()), 1)
+        self.assertFalse(os.path.exists(self.current_path))
+        self.assertEqual(self.client.get('/live-data/').status_code, 404)
+
+    def test_mixed_batch_takes_the_newest_live_record(self):
+        self.post([record(300, 5), record(200, 1, replayed=True)])
+
+        self.assertEqual(len(self.read_history()), 2)
+        self.assertEqual(self.read_current(), record(300, 5))
+        self.assertEqual(self.client.get('/live-data/').json(), record(300, 5))
+
+    def test_empty_batch_is_rejected(self):
+        response = self.post([])
+
+        self.assertEqual(response.status_code, 400)
+        self.assertFalse(os.path.exists(self.history_path))
+
+
+# A record as the ESP encodes it, taken from Magnet_Door/test/wire_format_test.cpp
+DEVICE_RECORD = {
+    'room': 'Room 1',
+    'log_time': 70000,
+    'event': 'personEntered',
+    'door_state': True,
+    'people_count': 12,
+    'room_full': False,
+    'temperature': 21.5,
+    'mode': 'change',
+}
+DEVICE_CBOR = bytes.fromhex(
+    '81a864726f6f6d66526f6f6d2031686c6f675f74696d651a00011170656576656e746d706572736f6e456e74657265646a646f6f725f7374617465f56c70656f706c655f636f756e740c69726f6f6d5f66756c6cf46b74656d7065726174757265fa41ac0000646d6f6465666368616e6765')
+DEVICE_MSGPACK = bytes.fromhex(
+    '9188a4726f6f6da6526f6f6d2031a86c6f675f74696d65ce00011170a56576656e74ad706572736f6e456e7465726564aa646f6f725f7374617465c3ac70656f706c655f636f756e740ca9726f6f6d5f66756c6cc2ab74656d7065726174757265ca41ac0000a46d6f6465a66368616e6765')
+
+
+class WireFormatTests(StorageTestCase):
+    def check_upload(self, body, content_type):
+        response = self.client.post('/live-data/', body, content_type=content_type)
+
+        self.assertEqual(response.status_code, 200)
+        with open(self.current_path) as json_file:
+            self.assertEqual(json.load(json_file), DEVICE_RECORD)
+
+    def test_cbor(self):
+        self.check_upload(DEVICE_CBOR, 'application/cbor')
+
+    def test_msgpack(self):
+        self.check_upload(DEVICE_MSGPACK, 'application/msgpack')
+
+    def test_json(self):
+        self.check_upload(json.dumps([DEVICE_RECORD]), 'application/json')
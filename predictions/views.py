@@ -164,25 +164,50 @@ def charts(request):
 
     return render(request, 'predictions/charts.html', {"charts_data": charts_data})
 
+# The latest live record of the ESP
+CURRENT_STATE_PATH = os.path.join('predictions', 'esp_data.json')
+# All received records, one json object per line. Only appended to.
+HISTORY_PATH = os.path.join('predictions', 'esp_history.jsonl')
+
+def decode_payload(request):
+    # The ESP uploads in the wire format selected by its server url
+    content_type = request.content_type
+    if content_type in ('application/msgpack', 'application/x-msgpack'):
+        import msgpack
+        return msgpack.unpackb(request.body, raw=False)
+    if content_type == 'application/cbor':
+        import cbor2
+        return cbor2.loads(request.body)
+    return json.loads(request.body)
+
 @csrf_exempt
 def live_data(request):
     if request.method == 'POST':
         try:
-            data = json.loads(request.body)
-            file_path = os.path.join('predictions', 'esp_data.json')
-
-            with open(file_path, 'w') as json_file:
-                json.dump(data, json_file)
-
-            return JsonResponse({'status': 'success', 'message': 'Data received'})
+            data = decode_payload(request)
+            # The ESP uploads its records in batches as an array, ordered by time
+            records = data if isinstance(data, list) else [data]
+            if not records:
+                return JsonResponse({'status': 'error', 'message': 'Empty batch'}, status=400)
+            # Every record is kept in the history, including the ones replayed after the ESP was offline
+            with open(HISTORY_PATH, 'a') as history_file:
+                for record in records:
+                    history_file.write(json.dumps(record) + '\n')
+
+            # The newest live record is the current state. Replayed records are older than what was already received.
+            live_records = [record for record in records if not record.get('replayed')]
+            if live_records:
+                with open(CURRENT_STATE_PATH, 'w') as json_file:
+                    json.dump(live_records[-1], json_file)
+
+            return JsonResponse({'status': 'success', 'message': 'Data received', 'records': len(records)})
         except Exception as e:
             return JsonResponse({'status': 'error', 'message': str(e)}, status=400)
 
     elif request.method == 'GET':
         try:
-            file_path = os.path.join('predictions', 'esp_data.json')
-            if os.path.exists(file_path):
-                with open(file_path, 'r') as json_file:
+            if os.path.exists(CURRENT_STATE_PATH):
+                with open(CURRENT_STATE_PATH, 'r') as json_file:
                     data = json.load(json_file)
                 return JsonResponse(data)
             else: